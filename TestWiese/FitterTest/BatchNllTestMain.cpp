@@ -0,0 +1,213 @@
+// STL
+#include <string>
+#include <vector>
+#include <memory>
+
+// ROOT
+#include "TMath.h"
+#include "TRandom3.h"
+
+// RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooArgList.h"
+#include "RooRealVar.h"
+#include "RooCategory.h"
+#include "RooGaussian.h"
+#include "RooFitResult.h"
+#include "RooLinkedList.h"
+#include "RooGlobalFunc.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/fitter/easyfit/EasyFit.h"
+#include "doofit/roofit/pdfs/DooCubicSplinePdf.h"
+#include "doofit/roofit/functions/CPCoefficient.h"
+#include "doofit/roofit/functions/BatchData.h"
+#include "doofit/roofit/functions/BatchNll.h"
+#include "doofit/roofit/functions/AbsBatchEvaluation.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::fitter::easyfit;
+using namespace doofit::roofit::functions;
+using doofit::roofit::pdfs::DooCubicSplinePdf;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Compare batch evaluation of a function with getVal() event by event
+ */
+void CompareValues(const std::string& name, const RooAbsReal& function, const RooAbsData& data, const RooArgSet& observables, TestResult& result) {
+  BatchData batch_data(data, observables);
+  std::vector<double> values(batch_data.size());
+  AbsBatchEvaluation::Evaluate(function, batch_data, 0, batch_data.size(), NULL, values.data());
+
+  double max_diff = 0.0;
+  for (std::size_t i=0; i<batch_data.size(); ++i) {
+    batch_data.Load(i);
+    max_diff = TMath::Max(max_diff, TMath::Abs(values[i]-function.getVal()));
+  }
+  result.CheckClose(name + ": max. difference to getVal()", max_diff, 0.0, 1e-12);
+}
+
+/**
+ *  @brief Compare BatchNll with the RooFit likelihood
+ *
+ *  Both are evaluated again after changing a parameter to check that the
+ *  batch likelihood follows parameter changes.
+ */
+void CompareNll(const std::string& name, RooAbsPdf& pdf, RooAbsData& data, RooRealVar& parameter, TestResult& result) {
+  BatchNll batch_nll(name+"_batch_nll", pdf, data);
+  RooAbsReal* nll = pdf.createNLL(data);
+  result.CheckClose(name + ": batch NLL", batch_nll.getVal(), nll->getVal(), 1e-8*TMath::Abs(nll->getVal()));
+
+  double value = parameter.getVal();
+  parameter.setVal(1.01*value);
+  result.CheckClose(name + ": batch NLL after changing " + parameter.GetName(), batch_nll.getVal(), nll->getVal(), 1e-8*TMath::Abs(nll->getVal()));
+  parameter.setVal(value);
+  delete nll;
+}
+
+/**
+ *  @brief Fit with and without batch evaluation and compare minima and timing
+ *
+ *  @param batchable whether batch evaluation is expected to be used (refused otherwise)
+ */
+void CompareFits(const std::string& name, RooAbsPdf& pdf, RooDataSet& data, RooArgSet& parameters, const RooArgSet& start_values,
+                 bool batchable, double& time_default, double& time_batch, TestResult& result) {
+  parameters = start_values;
+  EasyFit fit_default(name+"_default");
+  fit_default.SetPdfAndDataSet(&pdf, &data);
+  fit_default.SetPrintLevel(-1).SetMinos(false).SetTimer(false);
+  fit_default.Fit();
+  double fcn_default = fit_default.GetFitResult()->minNll();
+
+  parameters = start_values;
+  EasyFit fit_batch(name+"_batch");
+  fit_batch.SetPdfAndDataSet(&pdf, &data);
+  fit_batch.SetPrintLevel(-1).SetMinos(false).SetTimer(false).SetBatchEvaluation(true);
+  fit_batch.Fit();
+
+  time_default += fit_default.FitTime().first;
+  time_batch   += fit_batch.FitTime().first;
+
+  // only fits via the batch likelihood count FCN calls
+  if (result.Check(batchable == (fit_batch.FcnCalls().first > 0), name + (batchable ? ": batch evaluation used" : ": batch evaluation refused")) &&
+      result.Check(fit_batch.GetFitResult() != NULL && fit_batch.GetFitResult()->status() == 0, name + ": fit with batch evaluation converges")) {
+    result.CheckClose(name + ": min. NLL with batch evaluation", fit_batch.GetFitResult()->minNll(), fcn_default, 1e-2);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  TestResult result("TestBatchNll");
+  TRandom3 random(4711);
+
+  // tagging calibration with OS and SS taggers
+  RooCategory tag_os("tag_os", "tag_os");
+  tag_os.defineType("B", 1);
+  tag_os.defineType("Bbar", -1);
+  tag_os.defineType("untagged", 0);
+  RooCategory tag_ss("tag_ss", "tag_ss");
+  tag_ss.defineType("B", 1);
+  tag_ss.defineType("Bbar", -1);
+  tag_ss.defineType("untagged", 0);
+  RooRealVar eta_os("eta_os", "eta_os", 0.0, 0.5);
+  RooRealVar eta_ss("eta_ss", "eta_ss", 0.0, 0.5);
+
+  RooArgSet tagging_observables(tag_os, tag_ss, eta_os, eta_ss);
+  RooDataSet tagging_data("tagging_data", "tagging_data", tagging_observables);
+  for (int i=0; i<10000; ++i) {
+    tag_os.setIndex(random.Integer(3)-1);
+    tag_ss.setIndex(random.Integer(3)-1);
+    eta_os.setVal(random.Uniform(0.0, 0.5));
+    eta_ss.setVal(random.Uniform(0.0, 0.5));
+    tagging_data.add(tagging_observables);
+  }
+
+  RooRealVar cp_coeff("cp_coeff", "cp_coeff", 0.7);
+  RooRealVar p0_os("p0_os", "p0_os", 0.38);
+  RooRealVar p1_os("p1_os", "p1_os", 1.1);
+  RooRealVar meaneta_os("meaneta_os", "meaneta_os", 0.37);
+  RooRealVar dp0_os("dp0_os", "dp0_os", 0.01);
+  RooRealVar dp1_os("dp1_os", "dp1_os", 0.05);
+  RooRealVar p0_ss("p0_ss", "p0_ss", 0.44);
+  RooRealVar p1_ss("p1_ss", "p1_ss", 0.9);
+  RooRealVar meaneta_ss("meaneta_ss", "meaneta_ss", 0.43);
+  RooRealVar dp0_ss("dp0_ss", "dp0_ss", -0.02);
+  RooRealVar dp1_ss("dp1_ss", "dp1_ss", 0.03);
+  RooRealVar prod_asym("prod_asym", "prod_asym", -0.01);
+
+  CPCoefficient::CoeffType types[4] = {CPCoefficient::kCosh, CPCoefficient::kSin, CPCoefficient::kCos, CPCoefficient::kSinh};
+  for (int i=0; i<4; ++i) {
+    std::string suffix = std::to_string(i);
+    CPCoefficient coeff_os("coeff_os_"+suffix, cp_coeff, tag_os, p0_os, p1_os, meaneta_os, eta_os, dp0_os, dp1_os, prod_asym, types[i]);
+    CPCoefficient coeff_combo("coeff_combo_"+suffix, cp_coeff, tag_os, p0_os, p1_os, meaneta_os, eta_os, dp0_os, dp1_os,
+                              tag_ss, p0_ss, p1_ss, meaneta_ss, eta_ss, dp0_ss, dp1_ss, prod_asym, types[i]);
+    CompareValues(coeff_os.GetName(), coeff_os, tagging_data, tagging_observables, result);
+    CompareValues(coeff_combo.GetName(), coeff_combo, tagging_data, tagging_observables, result);
+  }
+
+  // Gaussian (no batch interface, refused by EasyFit) and cubic spline (batch interface)
+  RooRealVar mass("mass", "mass", 5200.0, 5500.0);
+  RooRealVar mean("mean", "mean", 5370.0, 5300.0, 5400.0);
+  RooRealVar sigma("sigma", "sigma", 10.0, 1.0, 50.0);
+  RooGaussian gauss("gauss", "gauss", mass, mean, sigma);
+
+  RooRealVar decay_time("decay_time", "decay_time", 0.0, 10.0);
+  std::vector<double> knots = {0.0, 2.5, 5.0, 7.5, 10.0};
+  RooArgList coefficients;
+  std::vector<std::unique_ptr<RooRealVar> > coefficient_vars;
+  double truth[] = {1.0, 1.4, 1.8, 1.2, 0.8, 0.6};
+  for (unsigned int i=0; i<6; ++i) {
+    std::string coef_name = "coef_" + std::to_string(i);
+    coefficient_vars.emplace_back(new RooRealVar(coef_name.c_str(), coef_name.c_str(), truth[i], 0.0, 10.0));
+    coefficients.add(*coefficient_vars.back());
+  }
+  coefficient_vars[0]->setConstant();
+  DooCubicSplinePdf spline("spline", decay_time, knots, coefficients);
+
+  const int num_toys = 5;
+  double time_default[2] = {0.0, 0.0};
+  double time_batch[2]   = {0.0, 0.0};
+  std::string names[2]   = {"gauss", "spline"};
+  RooAbsPdf* pdfs[2]     = {&gauss, &spline};
+  RooRealVar* observables[2] = {&mass, &decay_time};
+  RooRealVar* changed[2] = {&sigma, coefficient_vars[2].get()};
+  bool batchable[2]      = {false, true};
+
+  for (int j=0; j<2; ++j) {
+    RooArgSet* parameters = pdfs[j]->getParameters(*observables[j]);
+    RooArgSet* start_values = dynamic_cast<RooArgSet*>(parameters->snapshot());
+    for (int i=0; i<num_toys; ++i) {
+      *parameters = *start_values;
+      RooDataSet* data = pdfs[j]->generate(*observables[j], 20000);
+      CompareNll(names[j], *pdfs[j], *data, *changed[j], result);
+      CompareFits(names[j], *pdfs[j], *data, *parameters, *start_values, batchable[j], time_default[j], time_batch[j], result);
+      delete data;
+    }
+    *parameters = *start_values;
+    delete start_values;
+    delete parameters;
+
+    sinfo << names[j] << ": mean wall time per fit " << time_default[j]/num_toys << " ms (fitTo), "
+          << time_batch[j]/num_toys << " ms (batch evaluation)." << endmsg;
+  }
+
+  // weighted events enter with their weight
+  RooRealVar weight("weight", "weight", 0.0, 10.0);
+  RooArgSet weighted_observables(decay_time, weight);
+  RooDataSet* data = spline.generate(decay_time, 20000);
+  RooDataSet weighted_data("weighted_data", "weighted_data", weighted_observables, RooFit::WeightVar(weight));
+  for (int i=0; i<data->numEntries(); ++i) {
+    decay_time.setVal(data->get(i)->getRealValue("decay_time"));
+    weighted_data.add(RooArgSet(decay_time), random.Uniform(0.5, 1.5));
+  }
+  delete data;
+  CompareNll("spline_weighted", spline, weighted_data, *coefficient_vars[2], result);
+
+  return result.Finish();
+}
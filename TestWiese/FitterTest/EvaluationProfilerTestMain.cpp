@@ -0,0 +1,108 @@
+// STL
+#include <string>
+#include <fstream>
+
+// ROOT
+#include "TMath.h"
+
+// RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooExponential.h"
+#include "RooAddPdf.h"
+#include "RooFitResult.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/fitter/easyfit/EasyFit.h"
+#include "doofit/fitter/easyfit/EvaluationProfiler.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::fitter::easyfit;
+using doofit::testwiese::TestResult;
+
+int main(int argc, char *argv[]) {
+  RooRealVar mass("mass", "mass", 5200.0, 5500.0);
+  RooRealVar mean("mean", "mean", 5370.0, 5300.0, 5400.0);
+  RooRealVar sigma("sigma", "sigma", 10.0, 1.0, 50.0);
+  RooRealVar tau("tau", "tau", -0.005, -0.1, 0.0);
+  RooRealVar frac("frac", "frac", 0.3, 0.0, 1.0);
+  RooGaussian sig("sig", "sig", mass, mean, sigma);
+  RooExponential bkg("bkg", "bkg", mass, tau);
+  RooAddPdf pdf("pdf", "pdf", sig, bkg, frac);
+
+  RooArgSet* parameters = pdf.getParameters(mass);
+  RooArgSet* truth = dynamic_cast<RooArgSet*>(parameters->snapshot());
+  RooDataSet* data = pdf.generate(mass, 10000);
+  TestResult result("TestEvaluationProfiler");
+
+  // reference fit without profiling
+  EasyFit fit_plain("fit_plain");
+  fit_plain.SetPdfAndDataSet(&pdf, data);
+  fit_plain.SetPrintLevel(-1).SetMinos(false);
+  fit_plain.Fit();
+  double fcn_plain = fit_plain.GetFitResult()->minNll();
+
+  // profiled fit, sampling every 10th FCN call with 500 events
+  *parameters = *truth;
+  EasyFit fit_profiled("fit_profiled");
+  fit_profiled.SetPdfAndDataSet(&pdf, data);
+  fit_profiled.SetPrintLevel(-1).SetMinos(false).SetEvaluationProfiling(true, "fit_profiled", 10, 500);
+  fit_profiled.Fit();
+
+  // profiling must not change the fit
+  result.CheckClose("min. NLL of profiled fit", fit_profiled.GetFitResult()->minNll(), fcn_plain, 1e-6);
+  result.Check(fit_profiled.FcnCalls().first < 0, "profiled fit runs via fitTo");
+
+  const EvaluationProfiler* profiler = fit_profiled.GetEvaluationProfiler();
+  if (result.Check(profiler != NULL && profiler->nodes().size() == 3, "profile of three nodes (pdf, sig, bkg)")) {
+    // evaluation order: servers before clients, top node last
+    const EvaluationProfiler::Node& top = profiler->nodes().back();
+    double time_exclusive = 0.0;
+    for (const EvaluationProfiler::Node& node : profiler->nodes()) {
+      time_exclusive += node.time_exclusive;
+      result.Check(node.calls > 0, std::string("calls of ") + node.arg->GetName() + " profiled");
+      if (&node != &top) {
+        result.Check(node.descendants.empty() && node.stack == std::string("pdf;") + node.arg->GetName(), 
+                     std::string("leaf node ") + node.arg->GetName() + " below top node");
+      }
+    }
+    result.Check(std::string(top.arg->GetName()) == "pdf" && top.descendants.size() == 2 && top.stack == "pdf", "top node pdf above both components");
+    result.CheckClose("inclusive time of top node", top.time_inclusive, time_exclusive, 1e-9*time_exclusive);
+    result.Check(profiler->scale() > 1.0, "sampled calls and events scaled up to whole minimisation");
+  }
+
+  std::ifstream folded("fit_profiled_profile.folded");
+  std::string line;
+  int num_lines = 0;
+  bool lines_valid = true;
+  while (std::getline(folded, line)) {
+    if (line.compare(0, 4, "pdf;") != 0 && line.compare(0, 4, "pdf ") != 0) {
+      serr << "Unexpected flame graph line: " << line << endmsg;
+      lines_valid = false;
+    }
+    ++num_lines;
+  }
+  result.Check(lines_valid, "flame graph lines start at top node");
+  result.Check(num_lines > 0 && num_lines <= 3, "one flame graph line per node with time");
+
+  std::ifstream report("fit_profiled_profile.txt");
+  int num_nodes_report = 0;
+  while (std::getline(report, line)) {
+    if (!line.empty() && line[0] != '#') ++num_nodes_report;
+  }
+  result.Check(num_nodes_report == 3, "report lists all nodes");
+
+  delete data;
+  delete truth;
+  delete parameters;
+
+  return result.Finish();
+}
@@ -25,7 +25,6 @@
 #include "RooExponential.h"
 #include "RooDecay.h"
 #include "RooMinimizer.h"
-#include "RooMinimizerFcn2.h"
 
 // from DooCore
 #include "doocore/io/MsgStream.h"
@@ -42,6 +41,7 @@
 #include "doofit/plotting/Plot/Plot.h"
 
 #include "doofit/builder/EasyPdf/EasyPdf.h"
+#include "doofit/fitter/easyfit/MinimizerFcn.h"
 
 using namespace boost::assign;
 using namespace ROOT;
@@ -214,10 +214,9 @@ void TestFitter(int argc, char *argv[]) {
 
     sinfo << "Fitting myself..." << endmsg;
     RooAbsReal* nll(pdf.createNLL(*data));
-    RooMinimizer minimizer(*nll);
 
     ROOT::Fit::Fitter fitter;
-    RooMinimizerFcn2 fcn(nll, &minimizer);
+    doofit::fitter::easyfit::MinimizerFcn fcn(nll);
     
     fitter.Config().MinimizerOptions().SetTolerance(1.0);
     // default max number of calls
@@ -0,0 +1,190 @@
+// STL
+#include <string>
+#include <vector>
+#include <memory>
+
+// ROOT
+#include "TMath.h"
+#include "TIterator.h"
+
+// RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooArgList.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooFitResult.h"
+#include "RooMinimizer.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/fitter/easyfit/EasyFit.h"
+#include "doofit/fitter/easyfit/MinimizerFcn.h"
+#include "doofit/roofit/pdfs/DooCubicSplinePdf.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::fitter::easyfit;
+using doofit::roofit::pdfs::DooCubicSplinePdf;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Count FCN calls of a fit with numerical derivatives (as in fitTo(...))
+ */
+int NumericalFcnCalls(RooAbsPdf& pdf, RooDataSet& data, RooArgSet& parameters, const RooArgSet& start_values) {
+  parameters = start_values;
+  RooAbsReal* nll = pdf.createNLL(data);
+  int num_fcn_calls = 0;
+  {
+    RooMinimizer minimizer(*nll);
+    minimizer.setMinimizerType("Minuit2");
+    minimizer.setPrintLevel(-1);
+    minimizer.migrad();
+    minimizer.hesse();
+    num_fcn_calls = minimizer.evalCounter();
+  }
+  delete nll;
+  return num_fcn_calls;
+}
+
+/**
+ *  @brief Compare analytic gradient of the likelihood with central differences
+ */
+void CompareGradient(const std::string& name, RooAbsPdf& pdf, RooDataSet& data, RooArgSet& parameters, const RooArgSet& start_values,
+                     TestResult& result) {
+  parameters = start_values;
+  RooAbsReal* nll = pdf.createNLL(data);
+  {
+    MinimizerFcn fcn(nll);
+    fcn.SetAnalyticGradient(pdf, data, NULL);
+    result.Check(fcn.NumAnalyticDerivatives() > 0, name + ": analytic derivatives available");
+
+    std::vector<double> x(fcn.NDim()), grad(fcn.NDim());
+    for (unsigned int i=0; i<fcn.NDim(); ++i) {
+      x[i] = dynamic_cast<RooRealVar*>(fcn.GetFloatParamList()->at(i))->getVal();
+    }
+    fcn.Gradient(x.data(), grad.data());
+
+    double max_deviation = 0.0;
+    for (unsigned int i=0; i<fcn.NDim(); ++i) {
+      std::vector<double> x_up(x), x_down(x);
+      double step = 1e-5*(1.0+TMath::Abs(x[i]));
+      x_up[i]   += step;
+      x_down[i] -= step;
+      double derivative = (fcn(x_up.data())-fcn(x_down.data()))/(2.0*step);
+      max_deviation = TMath::Max(max_deviation, TMath::Abs(grad[i]-derivative)/(1.0+TMath::Abs(derivative)));
+    }
+    result.CheckClose(name + ": max. relative deviation of gradient from central differences", max_deviation, 0.0, 1e-4);
+  }
+  delete nll;
+  parameters = start_values;
+}
+
+/**
+ *  @brief Fit one dataset with both backends and compare minima, timing and calls
+ */
+void CompareBackends(const std::string& name, RooAbsPdf& pdf, RooDataSet& data, RooArgSet& parameters, const RooArgSet& start_values,
+                     double& time_fitto, double& time_gradient, double& calls_numerical, double& calls_gradient, double& calls_gradient_grad,
+                     TestResult& result) {
+  calls_numerical += NumericalFcnCalls(pdf, data, parameters, start_values);
+
+  parameters = start_values;
+  EasyFit fit_fitto(name+"_fitto");
+  fit_fitto.SetPdfAndDataSet(&pdf, &data);
+  fit_fitto.SetPrintLevel(-1).SetMinos(false).SetTimer(false);
+  fit_fitto.Fit();
+  RooArgSet* values_fitto = dynamic_cast<RooArgSet*>(parameters.snapshot());
+  double fcn_fitto = fit_fitto.GetFitResult()->minNll();
+
+  parameters = start_values;
+  EasyFit fit_gradient(name+"_gradient");
+  fit_gradient.SetPdfAndDataSet(&pdf, &data);
+  fit_gradient.SetPrintLevel(-1).SetMinos(false).SetTimer(false).SetMinimizerBackend(EasyFit::kBackendAnalyticGradient);
+  fit_gradient.Fit();
+
+  time_fitto    += fit_fitto.FitTime().first;
+  time_gradient += fit_gradient.FitTime().first;
+  calls_gradient      += fit_gradient.FcnCalls().first;
+  calls_gradient_grad += fit_gradient.FcnCalls().second;
+
+  if (result.Check(fit_gradient.FcnCalls().second > 0, name + ": fit uses analytic gradients") &&
+      result.Check(fit_gradient.GetFitResult() != NULL && fit_gradient.GetFitResult()->status() == 0, name + ": fit with analytic gradients converges") &&
+      result.CheckClose(name + ": min. NLL with analytic gradients", fit_gradient.GetFitResult()->minNll(), fcn_fitto, 1e-2)) {
+    bool parameters_match = true;
+    TIterator* it = parameters.createIterator();
+    RooRealVar* par = NULL;
+    while ((par = dynamic_cast<RooRealVar*>(it->Next())) != NULL) {
+      RooRealVar* par_fitto = dynamic_cast<RooRealVar*>(values_fitto->find(par->GetName()));
+      if (!par->isConstant() && TMath::Abs(par->getVal()-par_fitto->getVal()) > 0.1*par_fitto->getError()) {
+        serr << name << ": " << par->GetName() << " differs (fitTo: " << par_fitto->getVal() << ", gradient: " << par->getVal() << ")." << endmsg;
+        parameters_match = false;
+      }
+    }
+    delete it;
+    result.Check(parameters_match, name + ": parameters agree with fitTo");
+  }
+  delete values_fitto;
+}
+
+int main(int argc, char *argv[]) {
+  TestResult result("GradientBenchmark");
+  const int num_toys = 5;
+
+  // Gaussian
+  RooRealVar mass("mass", "mass", 5200.0, 5500.0);
+  RooRealVar mean("mean", "mean", 5370.0, 5300.0, 5400.0);
+  RooRealVar sigma("sigma", "sigma", 10.0, 1.0, 50.0);
+  RooGaussian gauss("gauss", "gauss", mass, mean, sigma);
+
+  // cubic spline with first coefficient fixed for normalisation
+  RooRealVar decay_time("decay_time", "decay_time", 0.0, 10.0);
+  std::vector<double> knots = {0.0, 2.5, 5.0, 7.5, 10.0};
+  RooArgList coefficients;
+  std::vector<std::unique_ptr<RooRealVar> > coefficient_vars;
+  double truth[] = {1.0, 1.4, 1.8, 1.2, 0.8, 0.6};
+  for (unsigned int i=0; i<6; ++i) {
+    std::string coef_name = "coef_" + std::to_string(i);
+    coefficient_vars.emplace_back(new RooRealVar(coef_name.c_str(), coef_name.c_str(), truth[i], 0.0, 10.0));
+    coefficients.add(*coefficient_vars.back());
+  }
+  coefficient_vars[0]->setConstant();
+  DooCubicSplinePdf spline("spline", decay_time, knots, coefficients);
+
+  double time_fitto[2]    = {0.0, 0.0};
+  double time_gradient[2] = {0.0, 0.0};
+  double calls_numerical[2]     = {0.0, 0.0};
+  double calls_gradient[2]      = {0.0, 0.0};
+  double calls_gradient_grad[2] = {0.0, 0.0};
+  std::string names[2]    = {"gauss", "spline"};
+  RooAbsPdf* pdfs[2]      = {&gauss, &spline};
+  RooRealVar* observables[2] = {&mass, &decay_time};
+
+  for (int j=0; j<2; ++j) {
+    RooArgSet* parameters = pdfs[j]->getParameters(*observables[j]);
+    RooArgSet* start_values = dynamic_cast<RooArgSet*>(parameters->snapshot());
+    for (int i=0; i<num_toys; ++i) {
+      *parameters = *start_values;
+      RooDataSet* data = pdfs[j]->generate(*observables[j], 20000);
+      if (i == 0) {
+        CompareGradient(names[j], *pdfs[j], *data, *parameters, *start_values, result);
+      }
+      CompareBackends(names[j], *pdfs[j], *data, *parameters, *start_values, time_fitto[j], time_gradient[j],
+                      calls_numerical[j], calls_gradient[j], calls_gradient_grad[j], result);
+      delete data;
+    }
+    *parameters = *start_values;
+    delete start_values;
+    delete parameters;
+
+    sinfo << names[j] << ": mean wall time per fit " << time_fitto[j]/num_toys << " ms (fitTo), "
+          << time_gradient[j]/num_toys << " ms (analytic gradient)." << endmsg;
+    sinfo << names[j] << ": mean calls per fit " << calls_numerical[j]/num_toys << " FCN (numerical derivatives), "
+          << calls_gradient[j]/num_toys << " FCN and " << calls_gradient_grad[j]/num_toys << " gradient (analytic gradient)." << endmsg;
+  }
+
+  return result.Finish();
+}
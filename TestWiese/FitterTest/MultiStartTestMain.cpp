@@ -0,0 +1,114 @@
+// STL
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
+// ROOT
+#include "TMath.h"
+
+// RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooAddPdf.h"
+#include "RooFitResult.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/fitter/easyfit/EasyFit.h"
+#include "doofit/fitter/easyfit/MultiStartSummary.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace RooFit;
+using namespace doocore::io;
+using namespace doofit::fitter::easyfit;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Check that start values of a parameter are in distinct strata of its range
+ */
+void CheckLatinHypercube(const MultiStartSummary& summary, const RooRealVar& par, TestResult& result) {
+  const unsigned int num_starts = summary.minima().size();
+  std::set<int> strata;
+  for (const auto& minimum : summary.minima()) {
+    auto it = minimum.start_values.find(par.GetName());
+    if (it == minimum.start_values.end()) continue;
+    strata.insert(static_cast<int>((it->second-par.getMin())/(par.getMax()-par.getMin())*num_starts));
+  }
+  result.Check(strata.size() == num_starts, std::string("start values of ") + par.GetName() + " in distinct strata");
+}
+
+int main(int argc, char *argv[]) {
+  // two well separated peaks: fits starting near the wrong peak may end in
+  // a local minimum
+  RooRealVar mass("mass", "mass", 0.0, 100.0);
+  RooRealVar mean_1("mean_1", "mean_1", 30.0, 0.0, 100.0);
+  RooRealVar mean_2("mean_2", "mean_2", 70.0, 0.0, 100.0);
+  RooRealVar sigma("sigma", "sigma", 3.0);
+  RooRealVar frac("frac", "frac", 0.6, 0.0, 1.0);
+  RooGaussian gauss_1("gauss_1", "gauss_1", mass, mean_1, sigma);
+  RooGaussian gauss_2("gauss_2", "gauss_2", mass, mean_2, sigma);
+  RooAddPdf pdf("pdf", "pdf", gauss_1, gauss_2, frac);
+
+  RooDataSet* data = pdf.generate(mass, 5000);
+
+  TestResult result("TestMultiStart");
+
+  // Latin hypercube start points in two processes
+  mean_1.setVal(90.0);
+  mean_2.setVal(10.0);
+  EasyFit fit_lhs("fit_lhs");
+  fit_lhs.SetPdfAndDataSet(&pdf, data);
+  fit_lhs.SetMultiStart(8, EasyFit::kMultiStartLatinHypercube, 4711).SetMultiStartNumProcesses(2).SetPrintLevel(-1);
+  fit_lhs.Fit();
+
+  const RooFitResult* fit_result = fit_lhs.GetFitResult();
+  const MultiStartSummary& summary = fit_lhs.GetMultiStartSummary();
+  if (result.Check(fit_result != NULL && summary.minima().size() == 8 && summary.best_index() >= 0, "multi-start fit delivers eight minima")) {
+    bool best_is_lowest = true;
+    for (const auto& minimum : summary.minima()) {
+      if (minimum.valid && minimum.status == 0 && minimum.min_nll < fit_result->minNll()-1e-6) {
+        serr << "Start " << minimum.index << " found a lower minimum than the best result." << endmsg;
+        best_is_lowest = false;
+      }
+    }
+    result.Check(best_is_lowest, "best result is the lowest converged minimum");
+    result.CheckClose("min. NLL of best start", summary.minima()[summary.best_index()].min_nll, fit_result->minNll(), 1e-6);
+    result.Check(summary.NumConverged() > 0 && summary.NumDistinctMinima() >= 1, "converged minima counted");
+
+    CheckLatinHypercube(summary, mean_1, result);
+    CheckLatinHypercube(summary, mean_2, result);
+    CheckLatinHypercube(summary, frac, result);
+
+    // label switching of both peaks is an equally good minimum
+    result.CheckClose("lower mean", TMath::Min(mean_1.getVal(), mean_2.getVal()), 30.0, 1.0);
+    result.CheckClose("higher mean", TMath::Max(mean_1.getVal(), mean_2.getVal()), 70.0, 1.0);
+  }
+
+  // user-provided start points, fitted serially
+  std::vector<std::map<std::string,double> > start_points(2);
+  start_points[0]["mean_1"] = 25.0;
+  start_points[0]["mean_2"] = 75.0;
+  start_points[1]["mean_1"] = 50.0;
+  start_points[1]["mean_2"] = 50.0;
+  EasyFit fit_user("fit_user");
+  fit_user.SetPdfAndDataSet(&pdf, data);
+  fit_user.SetMultiStartPoints(start_points).SetPrintLevel(-1);
+  fit_user.Fit();
+  const MultiStartSummary& summary_user = fit_user.GetMultiStartSummary();
+  if (result.Check(fit_user.GetFitResult() != NULL && summary_user.minima().size() == 2, "multi-start fit with user start points delivers two minima")) {
+    result.Check(summary_user.minima()[0].start_values.at("mean_1") == 25.0 &&
+                 summary_user.minima()[1].start_values.at("mean_2") == 50.0, "user start points used");
+    result.CheckClose("min. NLL of best user start", summary_user.minima()[summary_user.best_index()].min_nll, fit_user.GetFitResult()->minNll(), 1e-6);
+  }
+
+  delete data;
+
+  return result.Finish();
+}
@@ -0,0 +1,101 @@
+// STL
+#include <string>
+
+// ROOT
+#include "TMath.h"
+
+// RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooExponential.h"
+#include "RooAddPdf.h"
+#include "RooFitResult.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/fitter/easyfit/EasyFit.h"
+#include "doofit/fitter/easyfit/WarmStartCache.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace RooFit;
+using namespace doocore::io;
+using namespace doofit::fitter::easyfit;
+using doofit::testwiese::TestResult;
+
+int main(int argc, char *argv[]) {
+  RooRealVar mass("mass", "mass", 5200.0, 5500.0);
+  RooRealVar mean("mean", "mean", 5370.0, 5300.0, 5400.0);
+  RooRealVar sigma("sigma", "sigma", 10.0, 1.0, 50.0);
+  RooRealVar tau("tau", "tau", -0.005, -0.1, 0.0);
+  RooRealVar frac("frac", "frac", 0.3, 0.0, 1.0);
+  RooGaussian sig("sig", "sig", mass, mean, sigma);
+  RooExponential bkg("bkg", "bkg", mass, tau);
+  RooAddPdf pdf("pdf", "pdf", sig, bkg, frac);
+
+  RooArgSet* parameters = pdf.getParameters(mass);
+  RooArgSet* truth = dynamic_cast<RooArgSet*>(parameters->snapshot());
+
+  WarmStartCache cache;
+  TestResult result("TestWarmStart");
+  const int num_toys = 5;
+  for (int i=0; i<num_toys; ++i) {
+    const std::string toy = "toy " + std::to_string(i) + ": ";
+    *parameters = *truth;
+    RooDataSet* data = pdf.generate(mass, 10000);
+
+    // reference fit without warm start from the true values
+    *parameters = *truth;
+    EasyFit fit_cold("fit_cold");
+    fit_cold.SetPdfAndDataSet(&pdf, data);
+    fit_cold.SetPrintLevel(-1).SetMinos(false);
+    fit_cold.Fit();
+    double mean_cold = mean.getVal();
+    double fcn_cold  = fit_cold.GetFitResult()->minNll();
+
+    // warm-started fit from deliberately displaced values
+    mean.setVal(5320.0);
+    sigma.setVal(30.0);
+    EasyFit fit_warm("fit_warm");
+    fit_warm.SetPdfAndDataSet(&pdf, data);
+    fit_warm.SetPrintLevel(-1).SetMinos(false).SetWarmStartCache(&cache);
+    fit_warm.Fit();
+
+    const WarmStartCache::FitInfo& info = fit_warm.GetWarmStartInfo();
+    if (result.Check(fit_warm.GetFitResult() != NULL && info.num_fcn_calls > 0, toy + "warm-start fit counts FCN calls")) {
+      result.Check(info.seeded == (i > 0), toy + "seeded from cache after first fit");
+      result.CheckClose(toy + "min. NLL of warm-started fit", fit_warm.GetFitResult()->minNll(), fcn_cold, 1e-3);
+      result.CheckClose(toy + "mean of warm-started fit", mean.getVal(), mean_cold, 0.01);
+      if (i > 0) {
+        result.Check(info.num_fcn_calls_saved() > 0, toy + "seeded fit needs fewer FCN calls than the cold fit");
+      }
+    }
+    delete data;
+  }
+
+  // different floating parameters are a different fit, i.e. no seeding
+  *parameters = *truth;
+  sigma.setConstant(true);
+  RooDataSet* data = pdf.generate(mass, 10000);
+  EasyFit fit_fixed("fit_fixed");
+  fit_fixed.SetPdfAndDataSet(&pdf, data);
+  fit_fixed.SetPrintLevel(-1).SetMinos(false).SetWarmStartCache(&cache);
+  fit_fixed.Fit();
+  result.Check(fit_fixed.GetFitResult() != NULL && !fit_fixed.GetWarmStartInfo().seeded, "fit with other floating parameters not seeded");
+  sigma.setConstant(false);
+  delete data;
+
+  cache.Print();
+  result.Check(cache.num_seeded_fits() == num_toys-1 && cache.num_cold_fits() == 2 && cache.size() == 2, "cache counters");
+  result.Check(cache.num_fcn_calls_saved() > 0, "cache saved FCN calls");
+
+  delete truth;
+  delete parameters;
+
+  return result.Finish();
+}
@@ -0,0 +1,129 @@
+#ifndef TESTWIESE_TESTRESULT_H
+#define TESTWIESE_TESTRESULT_H
+
+// STL
+#include <string>
+#include <cmath>
+
+// ROOT
+#include "TMath.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+namespace doofit {
+namespace testwiese {
+  /** @class TestResult
+   *  @brief Bookkeeping of checks in TestWiese executables
+   *
+   *  Each check is reported on failure and counted. The return value of
+   *  Finish() is meant to be returned from main():
+   *
+   *  @code
+   *  TestResult result("BinnedSampler");
+   *  result.Check(sampler.IsValid(), "sampler is valid");
+   *  result.CheckClose("mean", mean, 1.0, 0.02);
+   *  result.CheckProbability("bin contents", chi2, ndf, 1e-3);
+   *  return result.Finish();
+   *  @endcode
+   */
+  class TestResult {
+   public:
+    /**
+     *  @brief Constructor for TestResult
+     *
+     *  @param name name of the test executable for the summary
+     */
+    TestResult(const std::string& name) : name_(name), num_checks_(0), num_failed_(0) {}
+
+    /**
+     *  @brief Check a condition
+     *
+     *  @param condition condition that must hold
+     *  @param description what is checked (printed on failure)
+     *  @return condition
+     */
+    bool Check(bool condition, const std::string& description) {
+      using namespace doocore::io;
+      ++num_checks_;
+      if (!condition) {
+        ++num_failed_;
+        serr << name_ << ": Check failed: " << description << endmsg;
+      }
+      return condition;
+    }
+
+    /**
+     *  @brief Check a value against its expectation with absolute tolerance
+     *
+     *  @param description name of the value
+     *  @param value value to check
+     *  @param expected expected value
+     *  @param tolerance maximum absolute deviation
+     *  @return whether the value is within tolerance
+     */
+    bool CheckClose(const std::string& description, double value, double expected, double tolerance) {
+      using namespace doocore::io;
+      sinfo << name_ << ": " << description << " = " << value << " (expected " << expected << " +/- " << tolerance << ")" << endmsg;
+      return Check(std::abs(value-expected) <= tolerance && !std::isnan(value), description + " deviates from expectation");
+    }
+
+    /**
+     *  @brief Check a chi2 goodness of fit via its p-value
+     *
+     *  @param description name of the distribution
+     *  @param chi2 chi2 value
+     *  @param ndf number of degrees of freedom
+     *  @param min_prob minimum acceptable p-value
+     *  @return whether ndf is positive and the p-value is above min_prob
+     */
+    bool CheckProbability(const std::string& description, double chi2, int ndf, double min_prob) {
+      using namespace doocore::io;
+      double prob = ndf > 0 ? TMath::Prob(chi2, ndf) : 0.0;
+      sinfo << name_ << ": " << description << ": chi2/ndf = " << chi2 << "/" << ndf << ", p = " << prob << endmsg;
+      return Check(ndf > 0 && prob > min_prob, description + " incompatible with expectation");
+    }
+
+    /**
+     *  @brief Whether all checks so far passed
+     */
+    bool success() const { return num_failed_ == 0; }
+
+    /**
+     *  @brief Print summary
+     *
+     *  A test without any checks is considered failed.
+     *
+     *  @return exit code for main() (0 if all checks passed, 1 otherwise)
+     */
+    int Finish() const {
+      using namespace doocore::io;
+      if (num_checks_ > 0 && num_failed_ == 0) {
+        sinfo << name_ << ": All " << num_checks_ << " tests passed." << endmsg;
+        return 0;
+      } else {
+        serr << name_ << ": " << num_failed_ << " of " << num_checks_ << " tests failed." << endmsg;
+        return 1;
+      }
+    }
+
+   private:
+    /**
+     *  @brief Name of the test executable
+     */
+    std::string name_;
+
+    /**
+     *  @brief Number of checks
+     */
+    int num_checks_;
+
+    /**
+     *  @brief Number of failed checks
+     */
+    int num_failed_;
+  };
+} // namespace testwiese
+} // namespace doofit
+
+#endif // TESTWIESE_TESTRESULT_H
@@ -0,0 +1,114 @@
+// STL
+#include <string>
+
+// ROOT
+#include "TMath.h"
+
+// from RooFit
+#include "RooRealVar.h"
+#include "RooCategory.h"
+#include "RooGaussian.h"
+#include "RooExponential.h"
+#include "RooExtendPdf.h"
+#include "RooAddPdf.h"
+#include "RooSimultaneous.h"
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooArgList.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/config/CommonConfig.h"
+#include "doofit/config/DiscreteProbabilityDistribution.h"
+#include "doofit/toy/ToyFactoryStd/ToyFactoryStd.h"
+#include "doofit/toy/ToyFactoryStd/ToyFactoryStdConfig.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Compare a sum of weights with its expectation
+ */
+void CheckSum(RooDataSet& data, const std::string& cut, double expected, double tolerance, TestResult& result) {
+  double sum = cut.length() > 0 ? data.sumEntries(cut.c_str()) : data.sumEntries();
+  result.CheckClose("sum of weights" + (cut.length() > 0 ? " for " + cut : std::string("")), sum, expected, tolerance*expected);
+}
+
+int main(int argc, char *argv[]) {
+  config::CommonConfig cfg_com("common");
+  cfg_com.InitializeOptions(argc, argv);
+  ToyFactoryStdConfig cfg_tfac("toyfac");
+  cfg_tfac.InitializeOptions(cfg_com);
+  cfg_com.CheckHelpFlagAndPrintHelp();
+
+  RooRealVar mass("mass", "mass", 5200.0, 5400.0);
+  mass.setBins(50);
+  RooCategory sample("sample", "sample");
+  sample.defineType("a", 0);
+  sample.defineType("b", 1);
+  RooCategory tag("tag", "tag");
+  tag.defineType("Bbar", -1);
+  tag.defineType("B", 1);
+
+  RooRealVar mean("mean", "mean", 5280.0);
+  RooRealVar sigma("sigma", "sigma", 10.0);
+  RooRealVar lambda("lambda", "lambda", -0.002);
+  RooGaussian sig("sig", "sig", mass, mean, sigma);
+  RooExponential bkg("bkg", "bkg", mass, lambda);
+
+  RooRealVar n_sig_a("n_sig_a", "n_sig_a", 10000.0);
+  RooRealVar n_bkg_a("n_bkg_a", "n_bkg_a", 5000.0);
+  RooRealVar n_sig_b("n_sig_b", "n_sig_b", 2000.0);
+  RooRealVar n_bkg_b("n_bkg_b", "n_bkg_b", 8000.0);
+  RooExtendPdf sig_a("sig_a", "sig_a", sig, n_sig_a);
+  RooExtendPdf bkg_a("bkg_a", "bkg_a", bkg, n_bkg_a);
+  RooExtendPdf sig_b("sig_b", "sig_b", sig, n_sig_b);
+  RooExtendPdf bkg_b("bkg_b", "bkg_b", bkg, n_bkg_b);
+  RooAddPdf pdf_a("pdf_a", "pdf_a", RooArgList(sig_a, bkg_a));
+  RooAddPdf pdf_b("pdf_b", "pdf_b", RooArgList(sig_b, bkg_b));
+
+  RooSimultaneous pdf("pdf", "pdf", sample);
+  pdf.addPdf(pdf_a, "a");
+  pdf.addPdf(pdf_b, "b");
+
+  RooArgSet observables(mass, sample, tag);
+  cfg_tfac.set_generation_pdf(&pdf);
+  cfg_tfac.set_argset_generation_observables(&observables);
+  config::CommaSeparatedPair<std::string> bins;
+  bins = "mass,40";
+  cfg_tfac.AddObservableBins(bins);
+  config::DiscreteProbabilityDistribution tag_probabilities;
+  tag_probabilities.Parse("tag,-1,0.3,1,1.0");
+  cfg_tfac.AddDiscreteProbability(tag_probabilities);
+
+  ToyFactoryStd tfac(cfg_com, cfg_tfac);
+  RooDataSet* data = tfac.GenerateAsimov();
+
+  TestResult result("TestAsimov");
+  result.Check(data->isWeighted(), "Asimov dataset is weighted");
+  result.Check(data->numEntries() == 40*2*2, "one entry per bin");
+  CheckSum(*data, "", 25000.0, 1e-6, result);
+  CheckSum(*data, "sample==0", 15000.0, 1e-6, result);
+  CheckSum(*data, "sample==1", 10000.0, 1e-6, result);
+  CheckSum(*data, "tag==-1", 0.3*25000.0, 1e-6, result);
+  CheckSum(*data, "sample==1&&tag==1", 0.7*10000.0, 1e-6, result);
+
+  // bin contents are integrals of the PDFs over the bins (bins of 5 MeV,
+  // the window covers four bins)
+  double fraction_sig = (TMath::Freq((5290.0-5280.0)/10.0) - TMath::Freq((5270.0-5280.0)/10.0))/
+                        (TMath::Freq((5400.0-5280.0)/10.0) - TMath::Freq((5200.0-5280.0)/10.0));
+  double fraction_bkg = (TMath::Exp(-0.002*5290.0) - TMath::Exp(-0.002*5270.0))/
+                        (TMath::Exp(-0.002*5400.0) - TMath::Exp(-0.002*5200.0));
+  CheckSum(*data, "sample==0&&mass>5270&&mass<5290", 10000.0*fraction_sig + 5000.0*fraction_bkg, 1e-4, result);
+  CheckSum(*data, "sample==1&&mass>5270&&mass<5290", 2000.0*fraction_sig + 8000.0*fraction_bkg, 1e-4, result);
+  delete data;
+
+  return result.Finish();
+}
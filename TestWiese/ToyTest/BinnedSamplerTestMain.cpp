@@ -0,0 +1,152 @@
+// STL
+#include <vector>
+#include <string>
+
+// ROOT
+#include "TRandom3.h"
+#include "TMath.h"
+
+// from RooFit
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/toy/ToyFactoryStd/BinnedSampler.h"
+#include "doofit/toy/ToyFactoryStd/ColumnarDataset.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Compare bin probabilities with analytical Gaussian integrals
+ */
+void TestProbabilities(const BinnedSampler& sampler, const RooRealVar& x, double mean, double sigma, TestResult& result) {
+  // bin probabilities are normalised to the range of x
+  double norm = TMath::Freq((x.getMax()-mean)/sigma) - TMath::Freq((x.getMin()-mean)/sigma);
+  double max_deviation = 0.0;
+  double sum_probabilities = 0.0;
+  for (int bin=0; bin<x.getBins(); ++bin) {
+    double low  = x.getBinning().binLow(bin);
+    double high = x.getBinning().binHigh(bin);
+    double expected = (TMath::Freq((high-mean)/sigma) - TMath::Freq((low-mean)/sigma))/norm;
+    max_deviation = TMath::Max(max_deviation, TMath::Abs(sampler.probability(bin)-expected));
+    sum_probabilities += sampler.probability(bin);
+  }
+  result.Check(sampler.num_bins() == static_cast<unsigned long long>(x.getBins()), "number of bins");
+  result.CheckClose("maximum deviation of bin probabilities", max_deviation, 0.0, 1e-6);
+  result.CheckClose("sum of bin probabilities", sum_probabilities, 1.0, 1e-9);
+}
+
+/**
+ *  @brief Check total and per bin contents of generated samples
+ */
+void TestGeneration(const BinnedSampler& sampler, bool extended, TRandom& random, TestResult& result) {
+  const double yield     = 1e6;
+  const int num_samples  = 200;
+  const std::string name = extended ? "Poisson samples" : "multinomial samples";
+  bool totals_exact = true;
+
+  std::vector<double> sum_contents(sampler.num_bins(), 0.0);
+  double sum_total   = 0.0;
+  double sum_total_2 = 0.0;
+  for (int i=0; i<num_samples; ++i) {
+    RooDataSet* data = sampler.Generate(yield, extended, random);
+    double total = data->sumEntries();
+    if (!extended && total != yield) {
+      serr << "Multinomial sample contains " << total << " events instead of " << yield << endmsg;
+      totals_exact = false;
+    }
+    sum_total   += total;
+    sum_total_2 += total*total;
+
+    // entries are at the bin centres, one entry per non-empty bin
+    const RooRealVar* x = dynamic_cast<const RooRealVar*>(data->get()->first());
+    for (int j=0; j<data->numEntries(); ++j) {
+      data->get(j);
+      sum_contents[x->getBin()] += data->weight();
+    }
+    delete data;
+  }
+
+  double mean_total     = sum_total/num_samples;
+  double variance_total = sum_total_2/num_samples - mean_total*mean_total;
+  if (extended) {
+    // total is Poisson distributed with mean and variance yield
+    result.CheckClose(name + ": mean total", mean_total, yield, 5*TMath::Sqrt(yield/num_samples));
+    result.CheckClose(name + ": variance of total", variance_total, yield, 0.4*yield);
+  } else {
+    result.Check(totals_exact, name + ": total equals yield");
+  }
+
+  // mean bin contents vs. yield times bin probability, with variance
+  // yield*p (Poisson) or yield*p*(1-p) (binomial marginal of multinomial)
+  double chi2 = 0.0;
+  int ndf = extended ? 0 : -1;
+  for (unsigned long long bin=0; bin<sampler.num_bins(); ++bin) {
+    double probability = sampler.probability(bin);
+    if (yield*probability*num_samples < 25.0) continue;
+    double variance = yield*probability*(extended ? 1.0 : 1.0-probability)/num_samples;
+    double residual = sum_contents[bin]/num_samples - yield*probability;
+    chi2 += residual*residual/variance;
+    ++ndf;
+  }
+  result.CheckProbability(name + ": mean bin contents", chi2, ndf, 1e-3);
+}
+
+/**
+ *  @brief Check expansion of a binned sample into events (for products)
+ */
+void TestUnbin(const BinnedSampler& sampler, TRandom& random, TestResult& result) {
+  const double yield = 1e5;
+  RooDataSet* data = sampler.Generate(yield, false, random);
+  ColumnarDataset columns(*data);
+  columns.Unbin(random);
+  RooDataSet* events = columns.ToDataSet();
+
+  result.Check(!columns.weighted() && !events->isWeighted(), "expanded sample is unweighted");
+  result.Check(columns.num_entries() == yield, "expanded sample contains one event per unit weight");
+  result.CheckClose("mean of expanded sample", events->mean(*dynamic_cast<RooRealVar*>(events->get()->first())),
+                    data->mean(*dynamic_cast<RooRealVar*>(data->get()->first())), 1e-6);
+
+  // events are shuffled, i.e. not ordered by bin
+  const RooRealVar* x = dynamic_cast<const RooRealVar*>(events->get()->first());
+  long num_descending = 0;
+  double last = -TMath::Infinity();
+  for (int j=0; j<events->numEntries(); ++j) {
+    events->get(j);
+    if (x->getVal() < last) ++num_descending;
+    last = x->getVal();
+  }
+  result.Check(num_descending > events->numEntries()/4, "expanded events are shuffled");
+  delete events;
+  delete data;
+}
+
+int main(int argc, char *argv[]) {
+  TRandom3 random(4711);
+
+  RooRealVar x("x", "x", -5.0, 5.0);
+  x.setBins(200);
+  RooRealVar mean("mean", "mean", 0.3);
+  RooRealVar sigma("sigma", "sigma", 1.2);
+  RooGaussian gauss("gauss", "gauss", x, mean, sigma);
+
+  BinnedSampler sampler(gauss, RooArgSet(x));
+  TestResult result("TestBinnedSampler");
+  if (result.Check(sampler.IsValid(), "sampler is valid")) {
+    TestProbabilities(sampler, x, mean.getVal(), sigma.getVal(), result);
+    TestGeneration(sampler, false, random, result);
+    TestGeneration(sampler, true, random, result);
+    TestUnbin(sampler, random, result);
+  }
+  return result.Finish();
+}
@@ -0,0 +1,91 @@
+// STL
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <sstream>
+
+// ROOT
+#include "TRandom3.h"
+
+// from RooFit
+#include "RooRealVar.h"
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+#include "doocore/lutils/lutils.h"
+
+// from DooFit
+#include "doofit/toy/ToyStudyStd/ColumnStatistics.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Compare windows and quantiles of ColumnStatistics for one sample
+ *
+ *  The window of ColumnStatistics::MedianLimits() must match
+ *  doocore::lutils::MedianLimitsForTuple() on the same dataset, quantiles
+ *  must match linear interpolation in the sorted values.
+ */
+void TestSample(const std::string& label, const std::vector<double>& values, TestResult& result) {
+  RooRealVar x("x", "x", 0.0);
+  RooDataSet data("data", "data", RooArgSet(x));
+  for (auto value : values) {
+    x.setVal(value);
+    data.add(RooArgSet(x));
+  }
+
+  ColumnStatistics statistics;
+  statistics.Extract(data, std::vector<std::string>{"x", "y"});
+  result.Check(statistics.Column("x") != nullptr && statistics.Column("x")->size() == values.size(), label + ": column extracted");
+  result.Check(statistics.Column("y") == nullptr, label + ": unknown column ignored");
+
+  std::pair<double,double> limits(statistics.MedianLimits("x"));
+  std::pair<double,double> limits_doocore(doocore::lutils::MedianLimitsForTuple(data, "x"));
+  double tolerance = 1e-12*std::max(1.0, std::abs(limits_doocore.second - limits_doocore.first));
+  result.CheckClose(label + ": lower limit", limits.first, limits_doocore.first, tolerance);
+  result.CheckClose(label + ": upper limit", limits.second, limits_doocore.second, tolerance);
+
+  std::vector<double> sorted(values);
+  std::sort(sorted.begin(), sorted.end());
+  const ColumnSummary& summary = statistics.Summary("x");
+  for (auto p : summary.probabilities) {
+    double position = p*(sorted.size()-1);
+    std::size_t k = static_cast<std::size_t>(position);
+    double expected = sorted[k];
+    if (k+1 < sorted.size()) expected += (position-k)*(sorted[k+1]-sorted[k]);
+    std::stringstream description;
+    description << label << ": quantile " << p;
+    result.CheckClose(description.str(), summary.Quantile(p), expected, 1e-12*std::max(1.0, std::abs(expected)));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  TestResult result("TestColumnStatistics");
+  TRandom3 random(42);
+
+  const std::vector<int> sizes{1, 2, 7, 100, 1001, 20000};
+  for (auto size : sizes) {
+    std::vector<double> gauss, expo, discrete;
+    for (int i=0; i<size; ++i) {
+      gauss.push_back(random.Gaus(0.3, 1.2));
+      expo.push_back(random.Exp(2.0));
+      discrete.push_back(random.Integer(3));
+    }
+    std::stringstream label;
+    label << size << " entries";
+    TestSample("Gaussian, " + label.str(), gauss, result);
+    TestSample("exponential, " + label.str(), expo, result);
+    TestSample("discrete, " + label.str(), discrete, result);
+  }
+  TestSample("constant", std::vector<double>(50, 1.5), result);
+
+  return result.Finish();
+}
@@ -0,0 +1,114 @@
+// STL
+#include <string>
+
+// ROOT
+#include "TRandom3.h"
+#include "TMath.h"
+#include "TMatrixDSym.h"
+
+// from RooFit
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooMultiVarGaussian.h"
+#include "RooLandau.h"
+#include "RooArgSet.h"
+#include "RooArgList.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/toy/ToyFactoryStd/ConstraintSampler.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Mean of a Gaussian truncated to values above a lower limit
+ */
+double TruncatedMean(double mean, double sigma, double lower) {
+  double alpha = (lower-mean)/sigma;
+  return mean + sigma*TMath::Gaus(alpha, 0.0, 1.0, true)/(1.0-TMath::Freq(alpha));
+}
+
+/**
+ *  @brief Draw and compare the mean of c with the truncated Gaussian
+ */
+void CheckTruncatedMean(ConstraintSampler& sampler, const RooRealVar& c, double mean, double sigma, TRandom& random, TestResult& result) {
+  const int num_draws = 200000;
+  double sum_c = 0.0;
+  bool drawn = true, in_range = true;
+  for (int i=0; i<num_draws; ++i) {
+    drawn &= sampler.Draw(random);
+    sum_c += c.getVal();
+    in_range &= c.getVal() >= c.getMin();
+  }
+  std::string name = "mean(c) for sigma " + std::to_string(sigma);
+  result.Check(drawn, name + ": all draws succeed");
+  result.Check(in_range, name + ": c drawn inside its range");
+  result.CheckClose(name, sum_c/num_draws, TruncatedMean(mean, sigma, c.getMin()), 0.01*sigma);
+}
+
+int main(int argc, char *argv[]) {
+  TRandom3 random(4711);
+
+  // correlated pair constrained by a multivariate Gaussian
+  RooRealVar a("a", "a", 0.0, -100.0, 100.0);
+  RooRealVar b("b", "b", 0.0, -100.0, 100.0);
+  RooRealVar mean_a("mean_a", "mean_a", 1.0);
+  RooRealVar mean_b("mean_b", "mean_b", 2.0);
+  TMatrixDSym covariance(2);
+  covariance(0,0) = 4.0;
+  covariance(1,1) = 1.0;
+  covariance(0,1) = covariance(1,0) = 1.2;
+  RooMultiVarGaussian constr_ab("constr_ab", "constr_ab", RooArgList(a, b), RooArgList(mean_a, mean_b), covariance);
+
+  // single parameter constrained by a Gaussian with range
+  RooRealVar c("c", "c", 0.5, 0.0, 100.0);
+  RooRealVar mean_c("mean_c", "mean_c", 0.5);
+  RooRealVar sigma_c("sigma_c", "sigma_c", 1.0);
+  RooGaussian constr_c("constr_c", "constr_c", c, mean_c, sigma_c);
+
+  // not supported, left to RooFit
+  RooRealVar d("d", "d", 1.0, 0.0, 100.0);
+  RooRealVar mpv_d("mpv_d", "mpv_d", 1.0);
+  RooRealVar width_d("width_d", "width_d", 0.1);
+  RooLandau constr_d("constr_d", "constr_d", d, mpv_d, width_d);
+
+  ConstraintSampler sampler(RooArgSet(constr_ab, constr_c, constr_d), RooArgSet(a, b, c, d));
+  TestResult result("TestConstraintSampler");
+  result.Check(sampler.supported_pdfs().getSize() == 2 && sampler.parameters().getSize() == 3, "Gaussian constraints supported");
+  result.Check(sampler.unsupported_pdfs().getSize() == 1 && sampler.unsupported_pdfs().find("constr_d") != NULL, "Landau constraint not supported");
+
+  const int num_draws = 200000;
+  double sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0;
+  bool drawn = true;
+  for (int i=0; i<num_draws; ++i) {
+    drawn &= sampler.Draw(random);
+    sum_a  += a.getVal();
+    sum_b  += b.getVal();
+    sum_aa += a.getVal()*a.getVal();
+    sum_bb += b.getVal()*b.getVal();
+    sum_ab += a.getVal()*b.getVal();
+  }
+  double mean_a_drawn = sum_a/num_draws;
+  double mean_b_drawn = sum_b/num_draws;
+  result.Check(drawn, "all draws succeed");
+  result.Check(d.getVal() == 1.0, "unsupported constraint not drawn");
+  result.CheckClose("mean(a)", mean_a_drawn, 1.0, 0.02);
+  result.CheckClose("mean(b)", mean_b_drawn, 2.0, 0.01);
+  result.CheckClose("var(a)", sum_aa/num_draws-mean_a_drawn*mean_a_drawn, 4.0, 0.05);
+  result.CheckClose("var(b)", sum_bb/num_draws-mean_b_drawn*mean_b_drawn, 1.0, 0.02);
+  result.CheckClose("cov(a,b)", sum_ab/num_draws-mean_a_drawn*mean_b_drawn, 1.2, 0.03);
+
+  // c is truncated at 0, changing the width needs a new Cholesky factor
+  CheckTruncatedMean(sampler, c, 0.5, 1.0, random, result);
+  sigma_c.setVal(2.0);
+  CheckTruncatedMean(sampler, c, 0.5, 2.0, random, result);
+
+  return result.Finish();
+}
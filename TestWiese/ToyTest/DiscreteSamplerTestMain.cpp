@@ -0,0 +1,112 @@
+// STL
+#include <vector>
+#include <utility>
+
+// ROOT
+#include "TRandom3.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/toy/ToyFactoryStd/DiscreteSampler.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Index drawn by a linear walk through cumulative probabilities
+ */
+int LinearWalk(const std::vector<std::pair<double,double> >& probabilities, double r) {
+  for (unsigned int j=0; j<probabilities.size(); ++j) {
+    if (r < probabilities[j].second) return j;
+  }
+  return -1;
+}
+
+/**
+ *  @brief Build cumulative probabilities (like DiscreteProbabilityDistribution)
+ */
+std::vector<std::pair<double,double> > Cumulate(const std::vector<double>& probs) {
+  std::vector<std::pair<double,double> > probabilities;
+  double cumulated_prob = 0.0;
+  for (unsigned int j=0; j<probs.size(); ++j) {
+    cumulated_prob += probs[j];
+    probabilities.push_back(std::make_pair(static_cast<double>(j), cumulated_prob));
+  }
+  return probabilities;
+}
+
+/**
+ *  @brief Compare sampler with linear walk for random and boundary values
+ */
+void TestDistribution(const std::vector<double>& probs, TRandom& random, TestResult& result) {
+  std::vector<std::pair<double,double> > probabilities = Cumulate(probs);
+  DiscreteSampler sampler(probabilities);
+
+  bool values_match = (sampler.num_values() == static_cast<int>(probabilities.size()));
+  for (int j=0; values_match && j<sampler.num_values(); ++j) {
+    values_match = (sampler.value(j) == probabilities[j].first);
+  }
+  result.Check(values_match, "values of sampler match distribution");
+
+  std::vector<double> rs;
+  for (int i=0; i<200000; ++i) {
+    rs.push_back(random.Rndm());
+  }
+  rs.push_back(0.0);
+  for (unsigned int j=0; j<probabilities.size(); ++j) {
+    rs.push_back(probabilities[j].second);
+  }
+  for (unsigned int k=0; k<=probabilities.size(); ++k) {
+    rs.push_back(static_cast<double>(k)/probabilities.size());
+  }
+
+  for (auto r : rs) {
+    if (r >= 1.0 || r < 0.0) continue;
+    int expected = LinearWalk(probabilities, r);
+    int drawn    = sampler.Sample(r);
+    if (expected != drawn) {
+      serr << "Sampler drew index " << drawn << " for r = " << r << ", linear walk gives " << expected << endmsg;
+      result.Check(false, "sampler reproduces linear walk");
+      return;
+    }
+  }
+  result.Check(true, "sampler reproduces linear walk");
+}
+
+int main() {
+  TRandom3 random(4357);
+
+  std::vector<std::vector<double> > distributions;
+  distributions.push_back({1.0});
+  distributions.push_back({0.5, 0.5});
+  distributions.push_back({0.0, 0.3, 0.0, 0.7});
+  distributions.push_back({0.1, 0.2, 0.3});                 // not summing up to 1
+  distributions.push_back({0.3, -0.1, 0.8});                // not monotonic
+  distributions.push_back({0.97, 0.01, 0.01, 0.01});
+  std::vector<double> tagging;
+  for (int j=0; j<25; ++j) tagging.push_back(1.0/25);
+  distributions.push_back(tagging);
+  std::vector<double> random_bins;
+  double sum = 0.0;
+  for (int j=0; j<40; ++j) {
+    random_bins.push_back(random.Exp(1.0));
+    sum += random_bins.back();
+  }
+  for (auto& prob : random_bins) prob /= sum;
+  distributions.push_back(random_bins);
+
+  TestResult result("TestDiscreteSampler");
+  for (auto distribution : distributions) {
+    TestDistribution(distribution, random, result);
+  }
+
+  DiscreteSampler sampler_empty((std::vector<std::pair<double,double> >()));
+  result.Check(sampler_empty.num_values() == 0 && sampler_empty.Sample(0.5) == -1, "empty distribution draws no value");
+  return result.Finish();
+}
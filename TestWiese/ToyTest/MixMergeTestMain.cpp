@@ -0,0 +1,135 @@
+// STL
+#include <vector>
+#include <map>
+
+// ROOT
+#include "TRandom3.h"
+#include "TMath.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from DooFit
+#include "doofit/toy/ToyFactoryStd/ToyFactoryStd.h"
+
+// from TestWiese
+#include "TestResult.h"
+
+using namespace doocore::io;
+using namespace doofit::toy;
+using doofit::testwiese::TestResult;
+
+/**
+ *  @brief Check number of selected positions for each draw
+ */
+void TestNumberOfPositions(TRandom& random, TestResult& result) {
+  const int num_trials = 1000;
+  bool counts_match = true;
+  for (int num_master=0; num_master<30; ++num_master) {
+    for (int num_slave=0; num_slave<=num_master; ++num_slave) {
+      for (int i=0; i<num_trials/30; ++i) {
+        std::vector<bool> positions = ToyFactoryStd::DrawMixPositions(num_master, num_slave, random);
+        int num_selected = 0;
+        for (auto position : positions) {
+          if (position) ++num_selected;
+        }
+        if (static_cast<int>(positions.size()) != num_master || num_selected != num_slave) {
+          serr << "Drew " << num_selected << " of " << positions.size() << " positions, expected " << num_slave << " of " << num_master << endmsg;
+          counts_match = false;
+        }
+      }
+    }
+  }
+  result.Check(counts_match, "number of selected positions");
+}
+
+/**
+ *  @brief Check that every position is taken with probability num_slave/num_master
+ */
+void TestPositionFrequencies(TRandom& random, TestResult& result) {
+  const int num_master = 20;
+  const int num_slave  = 7;
+  const int num_trials = 200000;
+
+  std::vector<int> counts(num_master, 0);
+  for (int i=0; i<num_trials; ++i) {
+    std::vector<bool> positions = ToyFactoryStd::DrawMixPositions(num_master, num_slave, random);
+    for (int j=0; j<num_master; ++j) {
+      if (positions[j]) ++counts[j];
+    }
+  }
+
+  // binomial per position
+  double p        = static_cast<double>(num_slave)/num_master;
+  double expected = num_trials*p;
+  double variance = num_trials*p*(1.0-p);
+  double chi2     = 0.0;
+  for (auto count : counts) {
+    chi2 += (count-expected)*(count-expected)/variance;
+  }
+  // counts are anti-correlated (fixed total per draw): the scaled sum is 
+  // chi2 distributed with num_master-1 degrees of freedom
+  chi2 *= static_cast<double>(num_master-1)/num_master;
+  result.CheckProbability("position frequencies", chi2, num_master-1, 1e-4);
+}
+
+/**
+ *  @brief Check that every subset of positions is equally likely
+ */
+void TestSubsetFrequencies(TRandom& random, TestResult& result) {
+  const int num_master = 6;
+  const int num_slave  = 3;
+  const int num_trials = 200000;
+
+  std::map<int, int> counts;
+  for (int i=0; i<num_trials; ++i) {
+    std::vector<bool> positions = ToyFactoryStd::DrawMixPositions(num_master, num_slave, random);
+    int subset = 0;
+    for (int j=0; j<num_master; ++j) {
+      if (positions[j]) subset |= (1 << j);
+    }
+    ++counts[subset];
+  }
+
+  int num_subsets = static_cast<int>(TMath::Binomial(num_master, num_slave)+0.5);
+  if (!result.Check(static_cast<int>(counts.size()) == num_subsets, "number of different subsets")) {
+    return;
+  }
+
+  double expected = static_cast<double>(num_trials)/num_subsets;
+  double chi2     = 0.0;
+  for (auto count : counts) {
+    chi2 += (count.second-expected)*(count.second-expected)/expected;
+  }
+  result.CheckProbability("subset frequencies", chi2, num_subsets-1, 1e-4);
+}
+
+/**
+ *  @brief Check edge cases (no positions, all positions, more slaves than positions)
+ */
+void TestEdgeCases(TRandom& random, TestResult& result) {
+  result.Check(ToyFactoryStd::DrawMixPositions(0, 0, random).empty(), "no positions for empty master");
+
+  std::vector<bool> positions_all = ToyFactoryStd::DrawMixPositions(10, 10, random);
+  std::vector<bool> positions_none = ToyFactoryStd::DrawMixPositions(10, 0, random);
+  std::vector<bool> positions_clamped = ToyFactoryStd::DrawMixPositions(10, 15, random);
+  bool all = true, none = true, clamped = true;
+  for (int i=0; i<10; ++i) {
+    all     &= positions_all[i];
+    none    &= !positions_none[i];
+    clamped &= positions_clamped[i];
+  }
+  result.Check(all, "all positions taken for equal sizes");
+  result.Check(none, "no position taken without slaves");
+  result.Check(positions_clamped.size() == 10 && clamped, "all positions taken for more slaves than positions");
+}
+
+int main() {
+  TRandom3 random(4357);
+  TestResult result("TestMixMerge");
+  TestNumberOfPositions(random, result);
+  TestPositionFrequencies(random, result);
+  TestSubsetFrequencies(random, result);
+  TestEdgeCases(random, result);
+  return result.Finish();
+}
@@ -138,7 +138,7 @@ IF (ROOT_FOUND)
 #  REMOVE_FROM_LIST(root_flags "${root_libs_all}" "${root_library}")
 
   SET(ROOT_LIBRARIES ${root_flags})
-  SET(ROOFIT_LIBRARIES "-lRooFit -lRooFitCore -lRooStats -lHtml -lMinuit -lThread -lFoam -lMatrix -lMathMore")
+  SET(ROOFIT_LIBRARIES "-lRooFit -lRooFitCore -lRooStats -lHtml -lMinuit -lMinuit2 -lThread -lFoam -lMatrix -lMathMore")
 
   # Make variables changeble to the advanced user
   MARK_AS_ADVANCED( ROOT_LIBRARY_DIR ROOT_INCLUDE_DIR ROOT_DEFINITIONS)
@@ -0,0 +1,49 @@
+// STL
+#include <string>
+#include <cstdlib>
+
+// Boost
+
+// ROOT
+
+// RooFit
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from Project
+#include "doofit/toy/ToyStudyStd/FitResultShards.h"
+
+using namespace doofit;
+using namespace doocore::io;
+
+int main(int argc, char* argv[]){
+  std::string usage = std::string("Usage: ") + argv[0] + " <result_file> <tree_name> [--keep-shards] [--branch-name <name>]";
+  if (argc < 3) {
+    serr << usage << endmsg;
+    serr << "Merges all shards <result_file>.shard-*.root into <result_file>." << endmsg;
+    serr << "The result branch name (default: fit_results) is used to describe the merged file in its manifest." << endmsg;
+    return 1;
+  }
+
+  std::string filename(argv[1]);
+  std::string treename(argv[2]);
+  std::string branch_name("fit_results");
+  bool remove_shards = true;
+  for (int i=3; i<argc; ++i) {
+    std::string option(argv[i]);
+    if (option == "--keep-shards") {
+      remove_shards = false;
+    } else if (option == "--branch-name" && i+1 < argc) {
+      branch_name = argv[++i];
+    } else {
+      serr << "Unknown option " << option << endmsg;
+      serr << usage << endmsg;
+      return 1;
+    }
+  }
+
+  long long num_results = toy::FitResultShards::Merge(filename, treename, branch_name, true, remove_shards);
+
+  return num_results < 0 ? 1 : 0;
+}
@@ -256,13 +256,16 @@ void doofit::plotting::profiles::FeldmanCousinsProfiler::ReadFitResultsToy(doofi
     const EasyFitResult* fr1(std::get<1>(efit_results));
     ++p;
 
-    num_ignored += ProcessToyFitResult(*fr0, *fr1);
+    if (fr0 != nullptr && fr1 != nullptr) {
+      num_ignored += ProcessToyFitResult(*fr0, *fr1);
+    }
 
     while (toy_study.NumberOfAvailableEasyFitResults() > 0) {
       efit_results = toy_study.GetEasyFitResult();
 
       fr0 = std::get<0>(efit_results);
       fr1 = std::get<1>(efit_results);
+      if (fr0 == nullptr || fr1 == nullptr) break;
 
       num_ignored += ProcessToyFitResult(*fr0, *fr1);
       ++p;
@@ -3,12 +3,20 @@
 // from STL + friends
 #include <chrono>
 #include <ctime>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include <memory>
 
 // from boost
 #include <boost/foreach.hpp>
 
 // from ROOT
 // #include "Fit/Fitter.h"
+#include "TIterator.h"
+#include "TRandom3.h"
+#include "Fit/Fitter.h"
 
 // from RooFit
 #include "RooAbsData.h"
@@ -16,18 +24,31 @@
 #include "RooFit.h"
 #include "RooFitResult.h"
 #include "RooWorkspace.h"
+#include "RooRealVar.h"
+#include "RooArgList.h"
+#include "RooAbsReal.h"
+#include "RooMinimizer.h"
+#include "RooRealProxy.h"
 // #include "RooMinimizer.h"
 // #include "RooMinimizerFcn.h"
 
 // from project - Utils
 #include <doocore/io/MsgStream.h>
 
+// from project
+#include "doofit/fitter/easyfit/MinimizerFcn.h"
+#include "doofit/fitter/easyfit/EvaluationProfiler.h"
+#include "doofit/roofit/functions/BatchNll.h"
+#include "doofit/roofit/functions/AbsBatchEvaluation.h"
+#include "doofit/tools/workers/ForkedWorkers.h"
+
 using std::set;
 using std::string;
 using std::cout;
 using std::endl;
 using std::map;
 using doocore::io::sinfo;
+using doocore::io::swarn;
 using doocore::io::serr;
 using doocore::io::endmsg;
 
@@ -35,6 +56,39 @@ namespace doofit {
 namespace fitter {
 namespace easyfit {
 
+namespace {
+/// Likelihood wrapper timing each evaluation for an evaluation profiler. 
+/// RooMinimizer runs on it exactly as on the likelihood itself.
+class ProfiledLikelihood : public RooAbsReal {
+ public:
+  ProfiledLikelihood(RooAbsReal& nll, EvaluationProfiler& profiler)
+      : RooAbsReal((std::string(nll.GetName())+"_profiled").c_str(), nll.GetTitle())
+      , nll_("nll", "nll", this, nll)
+      , profiler_(&profiler)
+  {}
+  ProfiledLikelihood(const ProfiledLikelihood& other, const char* name=0)
+      : RooAbsReal(other, name)
+      , nll_("nll", this, other.nll_)
+      , profiler_(other.profiler_)
+  {}
+  virtual TObject* clone(const char* newname) const { return new ProfiledLikelihood(*this, newname); }
+  virtual Double_t defaultErrorLevel() const { return nll_.arg().defaultErrorLevel(); }
+
+ protected:
+  virtual Double_t evaluate() const {
+    auto t_start = std::chrono::high_resolution_clock::now();
+    Double_t value = nll_;
+    auto t_end = std::chrono::high_resolution_clock::now();
+    profiler_->Sample(std::chrono::duration<double>(t_end - t_start).count());
+    return value;
+  }
+
+ private:
+  RooRealProxy nll_;
+  EvaluationProfiler* profiler_;
+};
+} // namespace
+
 EasyFit::EasyFit(const string& fit_name) 
     : fit_name_(fit_name)
     , prepared_(false)
@@ -43,6 +97,10 @@ EasyFit::EasyFit(const string& fit_name)
     , pdf_(NULL)
     , data_(NULL)
     , fit_result_(NULL)
+    , multistart_summary_()
+    , warm_start_info_()
+    , profiler_(NULL)
+    , fcn_calls_(-1, -1)
     , minimizer_combs_()
     , fc_map_()
     , fc_linklist_()
@@ -73,6 +131,18 @@ EasyFit::EasyFit(const string& fit_name)
     , fc_printlevel_(1)
     , fc_numevalerr_(10)
     , fc_timer_(true)
+    , fc_multistart_num_(0)
+    , fc_multistart_mode_(kMultiStartRandom)
+    , fc_multistart_seed_(0)
+    , fc_multistart_points_()
+    , fc_multistart_num_processes_(1)
+    , fc_warm_start_cache_(NULL)
+    , fc_minimizer_backend_(kBackendFitTo)
+    , fc_batch_evaluation_(false)
+    , fc_profiling_(false)
+    , fc_profiling_prefix_()
+    , fc_profiling_interval_(1)
+    , fc_profiling_max_events_(0)
 {
   // define allowed combinations of minimizer type and algo
   string OldMinuit[]={"migrad","simplex","minimize","migradimproved"};
@@ -92,6 +162,7 @@ EasyFit::EasyFit(const string& fit_name)
 }
 
 EasyFit::~EasyFit() {
+  delete profiler_;
   // if (fit_result_ != nullptr) {
   //   delete fit_result_;
   // }
@@ -162,12 +233,19 @@ void EasyFit::PrepareFit() {
     fc_map_["MinosSet"]    = RooFit::Minos(*fc_minos_pars_);
   }
   
-  fc_map_["Save"]          = RooFit::Save(fc_save_);
+  // multi-start and warm-started fits need the results to compare resp. 
+  // cache minima
+  fc_map_["Save"]          = RooFit::Save(fc_save_ || fc_multistart_num_ > 0 || fc_warm_start_cache_ != NULL);
   fc_map_["Verbose"]       = RooFit::Verbose(fc_verbose_);
   fc_map_["Warnings"]      = RooFit::Warnings(fc_warnings_);
   fc_map_["PrintLevel"]    = RooFit::PrintLevel(fc_printlevel_);
   fc_map_["PrintEvalErrs"] = RooFit::PrintEvalErrors(fc_numevalerr_);
   fc_map_["Timer"]         = RooFit::Timer(fc_timer_);
+
+  // batch evaluation only pays off if the PDF itself is evaluated in batches
+  if (fc_batch_evaluation_ && !BatchEvaluationSupported()) {
+    fc_batch_evaluation_ = false;
+  }
   
 
 
@@ -226,18 +304,407 @@ void EasyFit::ExecuteFit() {
 
     // fit_result_ = minimizer.save(pdf_->GetName(), pdf_->GetTitle());
 
-    fit_result_ = pdf_->fitTo(*data_,fc_linklist_);
+    if (fc_multistart_num_ > 0) {
+      fit_result_ = ExecuteMultiStart();
+    } else if (fc_warm_start_cache_ != NULL) {
+      fit_result_ = ExecuteWarmStart();
+    } else {
+      fit_result_ = Minimize();
+    }
     
     std::clock_t c_end = std::clock();
     auto t_end = std::chrono::high_resolution_clock::now();
     
     time_real_ = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
     time_cpu_  = 1000.0 * (c_end-c_start) / CLOCKS_PER_SEC;
+
+    if (profiler_ != NULL) {
+      profiler_->Print();
+      profiler_->Write(fc_profiling_prefix_.empty() ? fit_name_ : fc_profiling_prefix_);
+    }
     
     fitted_ = true;
   }
 }
 
+RooFitResult* EasyFit::ExecuteMultiStart() {
+  RooArgSet* parameters = pdf_->getParameters(data_);
+  RooArgSet* initial_values = dynamic_cast<RooArgSet*>(parameters->snapshot());
+
+  RooArgList floating_parameters;
+  FloatingParameters(*parameters, floating_parameters);
+
+  std::vector<std::map<string,double> > start_points = MultiStartPoints(floating_parameters);
+  std::vector<RooFitResult*> results(start_points.size(), NULL);
+
+  auto fit_from_start = [&](unsigned int i) -> RooFitResult* {
+    *parameters = *initial_values;
+    for (const auto& start_value : start_points[i]) {
+      RooRealVar* par = dynamic_cast<RooRealVar*>(floating_parameters.find(start_value.first.c_str()));
+      if (par != NULL) {
+        par->setVal(start_value.second);
+      } else {
+        swarn << "Fit " << fit_name_ << ": Start value for " << start_value.first << " does not belong to a floating parameter." << endmsg;
+      }
+    }
+    return Minimize();
+  };
+
+  unsigned int num_processes = std::min<std::size_t>(std::max(fc_multistart_num_processes_, 1), start_points.size());
+  sinfo << "EasyFit::ExecuteMultiStart(): Fit " << fit_name_ << " from " << start_points.size() 
+        << " start points in " << num_processes << " processes." << endmsg;
+
+  if (num_processes > 1) {
+    // each process fits an interleaved subset of start points on its own 
+    // copy of PDF and likelihood
+    using namespace doofit::tools::workers;
+    RunInWorkers(start_points.size(), num_processes, 
+                 [&fit_from_start](std::size_t i) {
+                   std::unique_ptr<RooFitResult> fit_result(fit_from_start(i));
+                   return fit_result ? SerialiseObject(*fit_result) : std::vector<char>();
+                 },
+                 [&results](std::size_t i, std::vector<char>& bytes) {
+                   if (results[i] == NULL) results[i] = DeserialiseObject<RooFitResult>(bytes);
+                 });
+  }
+
+  // serial fits (also for anything the processes did not deliver)
+  for (unsigned int i=0; i<start_points.size(); ++i) {
+    if (results[i] == NULL) {
+      if (num_processes > 1) {
+        swarn << "Fit " << fit_name_ << ": No fit result for start point " << i << " from fit process. Fitting serially." << endmsg;
+      }
+      results[i] = fit_from_start(i);
+    }
+  }
+
+  multistart_summary_ = MultiStartSummary();
+  for (unsigned int i=0; i<start_points.size(); ++i) {
+    multistart_summary_.AddMinimum(i, start_points[i], results[i]);
+  }
+  multistart_summary_.Print();
+
+  int best = multistart_summary_.best_index();
+  RooFitResult* best_result = NULL;
+  *parameters = *initial_values;
+  if (best >= 0) {
+    best_result = results[best];
+    parameters->assignValueOnly(best_result->floatParsFinal());
+  } else {
+    serr << "Fit " << fit_name_ << ": No start point of multi-start fit delivered a fit result." << endmsg;
+  }
+  for (unsigned int i=0; i<results.size(); ++i) {
+    if (static_cast<int>(i) != best) delete results[i];
+  }
+
+  delete initial_values;
+  delete parameters;
+  return best_result;
+}
+
+std::vector<std::map<std::string,double> > EasyFit::MultiStartPoints(const RooArgList& floating_parameters) const {
+  if (fc_multistart_mode_ == kMultiStartUser) {
+    return fc_multistart_points_;
+  }
+
+  unsigned int num_starts = fc_multistart_num_;
+  std::vector<std::map<string,double> > start_points(num_starts);
+  TRandom3 random(fc_multistart_seed_);
+
+  TIterator* it = floating_parameters.createIterator();
+  RooRealVar* par = NULL;
+  while ((par = dynamic_cast<RooRealVar*>(it->Next())) != NULL) {
+    if (!par->hasMin() || !par->hasMax()) {
+      swarn << "Fit " << fit_name_ << ": Parameter " << par->GetName() << " has no limits. Starting all fits at " << par->getVal() << "." << endmsg;
+      for (auto& start_point : start_points) {
+        start_point[par->GetName()] = par->getVal();
+      }
+      continue;
+    }
+
+    // Latin hypercube: each of num_starts equally sized strata of each 
+    // parameter is used by exactly one start point
+    std::vector<unsigned int> strata(num_starts);
+    std::iota(strata.begin(), strata.end(), 0);
+    if (fc_multistart_mode_ == kMultiStartLatinHypercube) {
+      for (unsigned int i=num_starts; i>1; --i) {
+        std::swap(strata[i-1], strata[random.Integer(i)]);
+      }
+    }
+
+    for (unsigned int i=0; i<num_starts; ++i) {
+      double fraction = random.Rndm();
+      if (fc_multistart_mode_ == kMultiStartLatinHypercube) {
+        fraction = (strata[i] + fraction)/num_starts;
+      }
+      start_points[i][par->GetName()] = par->getMin() + fraction*(par->getMax()-par->getMin());
+    }
+  }
+  delete it;
+
+  return start_points;
+}
+
+RooFitResult* EasyFit::ExecuteWarmStart() {
+  RooArgSet* parameters = pdf_->getParameters(data_);
+  RooArgList floating_parameters;
+  FloatingParameters(*parameters, floating_parameters);
+  std::string key = WarmStartCache::Key(*pdf_, floating_parameters);
+
+  const WarmStartCache::Entry* entry = fc_warm_start_cache_->Seed(key, floating_parameters);
+  warm_start_info_.seeded             = (entry != NULL);
+  warm_start_info_.num_fcn_calls      = -1;
+  warm_start_info_.num_fcn_calls_cold = (entry != NULL) ? entry->num_fcn_calls_cold : -1;
+
+  RooFitResult* fit_result = NULL;
+  if (UseMinimizerFcn() || (entry != NULL && !fc_sumw2err_ && fc_minimizer_type_ == "Minuit2")) {
+    fit_result = ExecuteFcnFit(&warm_start_info_.num_fcn_calls, entry);
+  } else if (fc_sumw2err_ || fc_minimizer_type_ == "OldMinuit") {
+    // only available via fitTo(...), FCN calls cannot be counted
+    fit_result = pdf_->fitTo(*data_,fc_linklist_);
+  } else {
+    fit_result = ExecuteMinimizerFit(&warm_start_info_.num_fcn_calls);
+  }
+
+  if (fit_result != NULL) {
+    fc_warm_start_cache_->Store(key, *fit_result, warm_start_info_.num_fcn_calls);
+  }
+  fc_warm_start_cache_->Count(warm_start_info_);
+
+  if (warm_start_info_.seeded) {
+    sinfo << "Fit " << fit_name_ << ": Warm-started from cached minimum with " << warm_start_info_.num_fcn_calls 
+          << " FCN calls (" << warm_start_info_.num_fcn_calls_saved() << " saved)." << endmsg;
+  } else {
+    sinfo << "Fit " << fit_name_ << ": No cached minimum, cold start with " << warm_start_info_.num_fcn_calls << " FCN calls." << endmsg;
+  }
+
+  if (!fc_save_) {
+    delete fit_result;
+    fit_result = NULL;
+  }
+  delete parameters;
+  return fit_result;
+}
+
+void EasyFit::FloatingParameters(const RooArgSet& parameters, RooArgList& floating_parameters) const {
+  TIterator* it = parameters.createIterator();
+  RooAbsArg* arg = NULL;
+  while ((arg = dynamic_cast<RooAbsArg*>(it->Next())) != NULL) {
+    RooRealVar* par = dynamic_cast<RooRealVar*>(arg);
+    if (par != NULL && !par->isConstant()) {
+      floating_parameters.add(*par);
+    }
+  }
+  delete it;
+}
+
+RooFitResult* EasyFit::Minimize() {
+  if (UseMinimizerFcn()) {
+    return ExecuteFcnFit();
+  } else if (fc_profiling_ && !fc_sumw2err_ && fc_minimizer_type_ != "OldMinuit") {
+    return ExecuteMinimizerFit();
+  } else {
+    return pdf_->fitTo(*data_,fc_linklist_);
+  }
+}
+
+RooFitResult* EasyFit::ExecuteMinimizerFit(int* num_fcn_calls) {
+  RooLinkedList nll_linklist;
+  FillNllCmdList(nll_linklist);
+
+  RooAbsReal* nll = pdf_->createNLL(*data_, nll_linklist);
+  RooAbsReal* fcn = nll;
+  if (fc_profiling_) {
+    if (profiler_ == NULL) {
+      profiler_ = new EvaluationProfiler(*pdf_, *data_, fc_conditional_observables_set_ ? fc_conditional_observables_ : NULL, 
+                                         fc_profiling_interval_, fc_profiling_max_events_);
+    }
+    fcn = new ProfiledLikelihood(*nll, *profiler_);
+  }
+
+  RooFitResult* fit_result = NULL;
+  {
+    // same steps as fitTo(...)
+    RooMinimizer minimizer(*fcn);
+    minimizer.setMinimizerType(fc_minimizer_type_.c_str());
+    minimizer.setStrategy(fc_strategy_);
+    minimizer.setPrintLevel(fc_printlevel_);
+    minimizer.setVerbose(fc_verbose_);
+    minimizer.setProfile(fc_timer_);
+    minimizer.setPrintEvalErrors(fc_numevalerr_);
+    if (!fc_warnings_) minimizer.setNoWarn();
+    minimizer.optimizeConst(fc_optimize_);
+
+    if (fc_hesse_init_) minimizer.hesse();
+    minimizer.minimize(fc_minimizer_type_.c_str(), fc_minimizer_algo_.c_str());
+    if (fc_hesse_) minimizer.hesse();
+    if (fc_minos_wpars_) {
+      minimizer.minos(*fc_minos_pars_);
+    } else if (fc_minos_) {
+      minimizer.minos();
+    }
+
+    // multi-start and warm-started fits need the results (see PrepareFit())
+    if (fc_save_ || fc_multistart_num_ > 0 || fc_warm_start_cache_ != NULL) {
+      fit_result = minimizer.save(pdf_->GetName(), pdf_->GetTitle());
+    }
+    if (num_fcn_calls != NULL) *num_fcn_calls = minimizer.evalCounter();
+  }
+  if (fcn != nll) delete fcn;
+  delete nll;
+
+  return fit_result;
+}
+
+RooFitResult* EasyFit::ExecuteFcnFit(int* num_fcn_calls, const WarmStartCache::Entry* seed) {
+  if (fc_sumw2err_ || fc_minimizer_type_ != "Minuit2") {
+    swarn << "Fit " << fit_name_ << ": Analytic gradients and batch evaluation need Minuit2 without sum-of-weights correction. Fitting via fitTo(...)." << endmsg;
+    return pdf_->fitTo(*data_,fc_linklist_);
+  }
+
+  bool batch = fc_batch_evaluation_;
+  if (batch && (fc_constrained_ || fc_constrained_externally_ || fc_offset_)) {
+    swarn << "Fit " << fit_name_ << ": Batch evaluation does not support constraints and offsetting. Using RooFit likelihood." << endmsg;
+    batch = false;
+  }
+
+  RooAbsReal* nll = NULL;
+  if (batch) {
+    if (fc_num_cpu_ > 1) {
+      swarn << "Fit " << fit_name_ << ": Batch evaluation runs in a single process. Ignoring NumCPU." << endmsg;
+    }
+    nll = new doofit::roofit::functions::BatchNll(fit_name_+"_nll", *pdf_, *data_, 
+                                                  fc_conditional_observables_set_ ? fc_conditional_observables_ : NULL, 
+                                                  fc_extended_);
+  } else {
+    RooLinkedList nll_linklist;
+    FillNllCmdList(nll_linklist);
+    nll = pdf_->createNLL(*data_, nll_linklist);
+  }
+
+  RooFitResult* fit_result = NULL;
+  bool fitted = false;
+  {
+    MinimizerFcn fcn(nll, fc_verbose_);
+    fcn.SetPrintEvalErrors(fc_numevalerr_);
+
+    ROOT::Fit::Fitter fitter;
+    ROOT::Math::MinimizerOptions& options = fitter.Config().MinimizerOptions();
+    options.SetStrategy(fc_strategy_);
+    options.SetPrintLevel(fc_printlevel_+1);
+    options.SetTolerance(1.0);
+    options.SetMaxFunctionCalls(500*fcn.NDim());
+    options.SetMaxIterations(500*fcn.NDim());
+    options.SetErrorDef(nll->defaultErrorLevel());
+    fitter.Config().SetMinimizer(fc_minimizer_type_.c_str(), fc_minimizer_algo_.c_str());
+    fitter.Config().SetParabErrors(fc_hesse_);
+
+    if (fc_optimize_) {
+      RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::CollectErrors);
+      nll->constOptimizeTestStatistic(RooAbsArg::Activate, fc_optimize_ > 1);
+      RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::PrintErrors);
+    }
+    fcn.Synchronize(fitter.Config().ParamsSettings(), fc_optimize_, fc_verbose_);
+
+    if (fc_profiling_) {
+      if (profiler_ == NULL) {
+        profiler_ = new EvaluationProfiler(*pdf_, *data_, fc_conditional_observables_set_ ? fc_conditional_observables_ : NULL, 
+                                           fc_profiling_interval_, fc_profiling_max_events_);
+      }
+      fcn.SetProfiler(profiler_);
+    }
+
+    // derivatives of extended terms and constraints are not implemented
+    bool gradient = (fc_minimizer_backend_ == kBackendAnalyticGradient);
+    if (gradient && !fc_extended_ && !fc_constrained_ && !fc_constrained_externally_) {
+      fcn.SetAnalyticGradient(*pdf_, *data_, fc_conditional_observables_set_ ? fc_conditional_observables_ : NULL);
+    }
+
+    // without analytic derivatives, only the analytic gradient backend alone falls back to fitTo(...)
+    bool fit_fcn = !gradient || batch || seed != NULL || fcn.NumAnalyticDerivatives() > 0;
+    if (gradient && fcn.NumAnalyticDerivatives() == 0) {
+      if (fit_fcn) {
+        swarn << "Fit " << fit_name_ << ": No analytic derivatives available for " << pdf_->GetName() << ". Using numerical derivatives." << endmsg;
+      } else {
+        swarn << "Fit " << fit_name_ << ": No analytic derivatives available for " << pdf_->GetName() << ". Fitting via fitTo(...)." << endmsg;
+      }
+    }
+    if (fit_fcn) {
+      TMatrixDSym seed_covariance;
+      if (seed != NULL && !WarmStartCache::Covariance(*seed, *fcn.GetFloatParamList(), seed_covariance)) {
+        seed = NULL;
+      }
+      if (fc_hesse_init_ && seed == NULL) {
+        swarn << "Fit " << fit_name_ << ": Initial HESSE is not supported with analytic gradients. Skipping it." << endmsg;
+      }
+      std::vector<unsigned int> minos_indices;
+      for (unsigned int i=0; i<fcn.NDim(); ++i) {
+        if (fc_minos_wpars_ ? fc_minos_pars_->find(fcn.GetFloatParamList()->at(i)->GetName()) != NULL : fc_minos_) {
+          minos_indices.push_back(i);
+        }
+      }
+      if (fc_minos_wpars_) {
+        fitter.Config().SetMinosErrors(minos_indices);
+      } else {
+        fitter.Config().SetMinosErrors(fc_minos_);
+      }
+
+      RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::CollectErrors);
+      RooAbsReal::clearEvalErrorLog();
+      RooFitResult* seeded_result = NULL;
+      if (seed != NULL) {
+        // ROOT::Fit::Fitter cannot pass the covariance matrix to Minuit2
+        seeded_result = fcn.MinimizeSeeded(fitter.Config().ParamsSettings(), seed_covariance, options, fc_hesse_, 
+                                           minos_indices, pdf_->GetName(), pdf_->GetTitle());
+      }
+      if (seeded_result == NULL) {
+        if (fcn.NumAnalyticDerivatives() > 0) {
+          fitter.FitFCN(static_cast<const ROOT::Math::IMultiGradFunction&>(fcn));
+        } else {
+          // Minuit2 computes the derivatives itself
+          fitter.FitFCN(static_cast<const ROOT::Math::IBaseFunctionMultiDim&>(fcn));
+        }
+      }
+      RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::PrintErrors);
+      if (seeded_result == NULL) {
+        fcn.BackProp(fitter.Result());
+      }
+
+      sinfo << "Fit " << fit_name_ << ": Minimised " << (batch ? "batch " : "") << "likelihood with " 
+            << fcn.evalCounter() << " FCN calls and " << fcn.gradientCounter() << " gradient calls (" 
+            << fcn.NumAnalyticDerivatives() << " of " << fcn.NDim() << " derivatives analytic)." << endmsg;
+      if (num_fcn_calls != NULL) *num_fcn_calls = fcn.evalCounter();
+      fcn_calls_.first  = std::max(fcn_calls_.first, 0) + fcn.evalCounter();
+      fcn_calls_.second = std::max(fcn_calls_.second, 0) + fcn.gradientCounter();
+
+      // multi-start and warm-started fits need the results (see PrepareFit())
+      if (seeded_result != NULL) {
+        fit_result = seeded_result;
+      } else if (fc_save_ || fc_multistart_num_ > 0 || fc_warm_start_cache_ != NULL) {
+        fit_result = fcn.Save(fitter.Result(), pdf_->GetName(), pdf_->GetTitle());
+      }
+      fitted = true;
+    }
+  }
+  delete nll;
+
+  if (!fitted) {
+    fit_result = pdf_->fitTo(*data_,fc_linklist_);
+  }
+  return fit_result;
+}
+
+void EasyFit::FillNllCmdList(RooLinkedList& nll_linklist) {
+  // likelihood options of fitTo(...), the others are set on the minimizer
+  const char* nll_options[] = {"NumCPU", "Extended", "Contrained", "ExternalConstraints", "ConditionalObservables", "Offset"};
+  for (const char* nll_option : nll_options) {
+    std::map<std::string,RooCmdArg>::iterator it_option = fc_map_.find(nll_option);
+    if (it_option != fc_map_.end()) {
+      nll_linklist.Add(dynamic_cast<TObject*>(&(it_option->second)));
+    }
+  }
+}
+
 void EasyFit::FinalizeFit() {
   if (!prepared_ || !fitted_ || finalized_){
     // something went wrong
@@ -481,6 +948,86 @@ EasyFit& EasyFit::SetTimer(bool fc_timer) {
   return *this;
 }
 
+EasyFit& EasyFit::SetMultiStart(int fc_multistart_num, MultiStartMode fc_multistart_mode, unsigned int fc_multistart_seed) {
+  if (CheckSettingOptionsOk()) {
+    if (fc_multistart_mode == kMultiStartUser) {
+      serr << "Fit " << fit_name_ << ": Use SetMultiStartPoints(...) to provide start points." << endmsg;
+    } else if (fc_multistart_num < 0) {
+      serr << "Fit " << fit_name_ << ": Cannot set number of start points < 0." << endmsg;
+    } else {
+      fc_multistart_num_  = fc_multistart_num;
+      fc_multistart_mode_ = fc_multistart_mode;
+      fc_multistart_seed_ = fc_multistart_seed;
+    }
+  }
+  return *this;
+}
+
+EasyFit& EasyFit::SetMultiStartPoints(const std::vector<std::map<std::string,double> >& fc_multistart_points) {
+  if (CheckSettingOptionsOk()) {
+    fc_multistart_num_    = fc_multistart_points.size();
+    fc_multistart_mode_   = kMultiStartUser;
+    fc_multistart_points_ = fc_multistart_points;
+  }
+  return *this;
+}
+
+EasyFit& EasyFit::SetMultiStartNumProcesses(int fc_multistart_num_processes) {
+  if (CheckSettingOptionsOk()) {
+    if (fc_multistart_num_processes > 0) {
+      fc_multistart_num_processes_ = fc_multistart_num_processes;
+    } else {
+      serr << "Fit " << fit_name_ << ": Cannot set number of multi-start processes < 1." << endmsg;
+    }
+  }
+  return *this;
+}
+
+EasyFit& EasyFit::SetWarmStartCache(WarmStartCache* fc_warm_start_cache) {
+  if (CheckSettingOptionsOk()) {
+    fc_warm_start_cache_ = fc_warm_start_cache;
+  }
+  return *this;
+}
+
+EasyFit& EasyFit::SetMinimizerBackend(MinimizerBackend fc_minimizer_backend) {
+  if (CheckSettingOptionsOk()) {
+    fc_minimizer_backend_ = fc_minimizer_backend;
+  }
+  return *this;
+}
+
+EasyFit& EasyFit::SetBatchEvaluation(bool fc_batch_evaluation) {
+  if (CheckSettingOptionsOk()) {
+    fc_batch_evaluation_ = fc_batch_evaluation && (pdf_ == NULL || BatchEvaluationSupported());
+  }
+  return *this;
+}
+
+bool EasyFit::BatchEvaluationSupported() const {
+  if (dynamic_cast<const doofit::roofit::functions::AbsBatchEvaluation*>(pdf_) == NULL) {
+    swarn << "Fit " << fit_name_ << ": PDF " << (pdf_ != NULL ? pdf_->GetName() : "") << " (" << (pdf_ != NULL ? pdf_->ClassName() : "no PDF") 
+          << ") cannot be evaluated in batches. Refusing batch evaluation." << endmsg;
+    return false;
+  }
+  return true;
+}
+
+EasyFit& EasyFit::SetEvaluationProfiling(bool fc_profiling, const std::string& fc_profiling_prefix, 
+                                         int fc_profiling_interval, int fc_profiling_max_events) {
+  if (CheckSettingOptionsOk()) {
+    if (fc_profiling_interval < 1 || fc_profiling_max_events < 0) {
+      serr << "Fit " << fit_name_ << ": Cannot set profiling interval < 1 or maximum number of events < 0." << endmsg;
+    } else {
+      fc_profiling_            = fc_profiling;
+      fc_profiling_prefix_     = fc_profiling_prefix;
+      fc_profiling_interval_   = fc_profiling_interval;
+      fc_profiling_max_events_ = fc_profiling_max_events;
+    }
+  }
+  return *this;
+}
+
 
 } // namespace easyfit
 } // namespace fitter
@@ -5,6 +5,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 // from ROOT
 #include "TStopwatch.h"
@@ -14,11 +15,24 @@
 #include "RooCmdArg.h"
 #include "RooLinkedList.h"
 
+// from project
+#include "doofit/fitter/easyfit/MultiStartSummary.h"
+#include "doofit/fitter/easyfit/WarmStartCache.h"
+
 // forward declarations - RooFit
 class RooAbsData;
 class RooAbsPdf;
 class RooFitResult;
 class RooWorkspace;
+class RooArgList;
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+class EvaluationProfiler;
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
 
 /** @namespace doofit::fitter::easyfit 
  *  @brief Namespace for the EasyFit framework. 
@@ -33,6 +47,22 @@ class RooWorkspace;
  *  configuration of the fit behaviour of one single fit with all the special
  *  fit options that RooFit offers (see the <a href="http://root.cern.ch/root/html/RooAbsPdf.html#RooAbsPdf:fitTo">RooFit documentation</a>).
  *  
+ *  For likelihoods with several local minima, a multi-start mode is 
+ *  available (see @ref MultiStartOptions): the fit is run from several start 
+ *  points (in parallel processes) and the best result is kept.
+ *  
+ *  Repeated fits of the same PDF (e.g. in toy loops or scans) can be 
+ *  warm-started from the previous minimum via a WarmStartCache (see 
+ *  @ref WarmStartOptions).
+ *  
+ *  Instead of fitTo, the fit can run Minuit2 in gradient mode with analytic 
+ *  derivatives of the likelihood (see @ref MinimizerBackendOptions). The 
+ *  likelihood can be evaluated in batches of events (see 
+ *  @ref BatchEvaluationOptions).
+ *  
+ *  To find slow nodes of the PDF, calls and time per node can be profiled 
+ *  during the minimisation (see @ref EvaluationProfilingOptions).
+ *  
  *  @author Julian Wishahi 
  *  @date 2012-05-28
  */ 
@@ -44,6 +74,21 @@ namespace easyfit {
 class EasyFit
 {
  public:
+  /** @brief Generation of start points for multi-start fits
+   */
+  enum MultiStartMode {
+    kMultiStartRandom,          ///< uniformly random within parameter limits
+    kMultiStartLatinHypercube,  ///< Latin hypercube within parameter limits
+    kMultiStartUser             ///< start points given by the user
+  };
+
+  /** @brief Minimizer backend running the fit
+   */
+  enum MinimizerBackend {
+    kBackendFitTo,              ///< RooAbsPdf::fitTo(...)
+    kBackendAnalyticGradient    ///< Minuit2 with analytic gradients (see MinimizerFcn)
+  };
+
   EasyFit(const std::string& fit_name);
   ~EasyFit();
 
@@ -85,6 +130,39 @@ class EasyFit
    *  @return timing information as pair containing real (first) and CPU (second) time
    */
   std::pair<double, double> FitTime() const;
+
+  /**
+   *  @brief Get number of likelihood and gradient evaluations of the fit
+   *
+   *  Only counted for fits via MinimizerFcn (see SetMinimizerBackend(...)). 
+   *  FCN calls include the likelihood evaluations of numerical derivatives 
+   *  in gradient calls. Calls of all minimisations of a multi-start fit are 
+   *  added up.
+   *
+   *  @return FCN calls (first) and gradient calls (second), both -1 if not counted
+   */
+  std::pair<int, int> FcnCalls() const { return fcn_calls_; }
+
+  /**
+   *  @brief Get summary of all minima of a multi-start fit
+   *
+   *  @return the summary (empty if no multi-start fit was run)
+   */
+  const MultiStartSummary& GetMultiStartSummary() const { return multistart_summary_; }
+
+  /**
+   *  @brief Get warm-start information of the fit
+   *
+   *  @return whether the fit was seeded and FCN calls made and saved (all 0 if no warm-start cache is used)
+   */
+  const WarmStartCache::FitInfo& GetWarmStartInfo() const { return warm_start_info_; }
+
+  /**
+   *  @brief Get the evaluation profile of the fit
+   *
+   *  @return the profiler (NULL if profiling is disabled or no fit was profiled)
+   */
+  const EvaluationProfiler* GetEvaluationProfiler() const { return profiler_; }
   
   /** @name FitOptionSetters
    *
@@ -251,12 +329,235 @@ class EasyFit
   EasyFit& SetTimer(bool fc_timer);
   /**@}*/
 
+  /** @name MultiStartOptions
+   *
+   *  Functions to configure multi-start fits. The fit is run once from each 
+   *  start point and the result with the lowest FCN value (among converged 
+   *  fits) is kept as fit result. Parameters are set to its final values. 
+   *  All minima are summarised in GetMultiStartSummary().
+   *
+   *  As RooFit is not thread-safe, fits run concurrently in forked processes, 
+   *  each on its own copy of the PDF and likelihood.
+   */
+  /**@{*/
+
+  /** @brief Enable multi-start fit from generated start points.
+   *
+   *  Start values of all floating parameters are drawn within their limits 
+   *  (parameters without limits start at their current values). A seed of 0 
+   *  gives a random seed. Default is no multi-start fit.
+   */
+  EasyFit& SetMultiStart(int fc_multistart_num, MultiStartMode fc_multistart_mode=kMultiStartRandom, unsigned int fc_multistart_seed=0);
+
+  /** @brief Enable multi-start fit from user-provided start points.
+   *
+   *  Each start point maps parameter names to start values. Parameters not 
+   *  in a start point start at their current values.
+   */
+  EasyFit& SetMultiStartPoints(const std::vector<std::map<std::string,double> >& fc_multistart_points);
+
+  /** @brief Sets the number of processes running multi-start fits concurrently.
+   *
+   *  Each process runs its fits with @ref fc_num_cpu_ CPUs. Default is 1.
+   */
+  EasyFit& SetMultiStartNumProcesses(int fc_multistart_num_processes);
+  /**@}*/
+
+  /** @name WarmStartOptions
+   *
+   *  Functions to configure warm-started fits. If a WarmStartCache is set, 
+   *  the fit starts at the last cached minimum of the same PDF and floating 
+   *  parameters and MIGRAD is seeded with the cached covariance matrix. The 
+   *  minimum of the fit is stored in the cache for following fits.
+   *
+   *  Seeded fits run Minuit2 via MinimizerFcn, which skips the initial HESSE 
+   *  (the cached matrix replaces it). Unseeded fits run their own 
+   *  RooMinimizer (or MinimizerFcn with the analytic gradient backend or 
+   *  batch evaluation). Both count FCN calls (see GetWarmStartInfo()); the 
+   *  counts are not attached to the RooFitResult. Fits with sum-of-weights 
+   *  correction or OldMinuit are only seeded with values and parabolic 
+   *  errors and run via fitTo(...) without counting. Multi-start fits are 
+   *  not warm-started.
+   */
+  /**@{*/
+
+  /** @brief Sets the warm-start cache (not owned, NULL to disable).
+   *
+   *  Default is no warm start.
+   */
+  EasyFit& SetWarmStartCache(WarmStartCache* fc_warm_start_cache);
+  /**@}*/
+
+  /** @name MinimizerBackendOptions
+   *
+   *  Functions to select the minimizer backend. With the analytic gradient 
+   *  backend, the likelihood is minimised by Minuit2 via MinimizerFcn, which 
+   *  provides the gradient to Minuit2. Derivatives are analytic for 
+   *  parameters of PDFs implementing 
+   *  doofit::roofit::functions::AbsAnalyticGradient (and RooGaussian) and 
+   *  numerical otherwise.
+   *
+   *  Only the fitted PDF itself is differentiated: analytic derivatives are 
+   *  available if it is a bare DooCubicSplinePdf or RooGaussian. There is no 
+   *  chain rule through RooAddPdf, RooProdPdf or RooBDecay, so fits of 
+   *  composite PDFs do not benefit and fall back to fitTo(...).
+   *
+   *  Analytic derivatives are only used for plain (not extended, not 
+   *  constrained) likelihoods. Fits with sum-of-weights correction, other 
+   *  minimizer types than Minuit2 or without any analytic derivative run via 
+   *  fitTo(...). An initial HESSE is not supported.
+   */
+  /**@{*/
+
+  /** @brief Sets the minimizer backend.
+   *
+   *  Default is kBackendFitTo.
+   */
+  EasyFit& SetMinimizerBackend(MinimizerBackend fc_minimizer_backend);
+  /**@}*/
+
+  /** @name BatchEvaluationOptions
+   *
+   *  Functions to configure the batch evaluation of the likelihood. With 
+   *  batch evaluation, the likelihood is a 
+   *  doofit::roofit::functions::BatchNll which evaluates the PDF for 
+   *  batches of events from contiguous copies of the dataset columns. 
+   *
+   *  Only PDFs implementing doofit::roofit::functions::AbsBatchEvaluation 
+   *  themselves (e.g. DooCubicSplinePdf, RectangularPdf) are evaluated in 
+   *  batches. RooAddPdf, RooProdPdf and RooBDecay have no batch path and 
+   *  would be evaluated event by event, which is slower than fitTo(...). 
+   *  Batch evaluation is therefore refused (with a warning) if the fitted 
+   *  PDF does not implement the interface, and the fit runs as without it.
+   *
+   *  The likelihood is minimised by Minuit2 via MinimizerFcn (with analytic 
+   *  gradients if the analytic gradient backend is selected). Fits with 
+   *  constraints or offsetting use the RooFit likelihood instead, fits with 
+   *  sum-of-weights correction or other minimizer types than Minuit2 run 
+   *  via fitTo(...). The batch likelihood is evaluated in a single process, 
+   *  @ref fc_num_cpu_ is ignored.
+   */
+  /**@{*/
+
+  /** @brief Sets whether to evaluate the likelihood in batches.
+   *
+   *  Refused if the PDF is already set and cannot be evaluated in batches 
+   *  (otherwise checked when the fit is prepared). Default is false.
+   */
+  EasyFit& SetBatchEvaluation(bool fc_batch_evaluation);
+  /**@}*/
+
+  /** @name EvaluationProfilingOptions
+   *
+   *  Functions to configure the per-node evaluation profiling (see 
+   *  EvaluationProfiler). Profiling does not change the fit: fits otherwise 
+   *  run via fitTo(...) run the same steps via RooMinimizer on a likelihood 
+   *  wrapper which times each FCN call, fits via MinimizerFcn (analytic 
+   *  gradients, batch evaluation) time the calls there. After sampled FCN 
+   *  calls, each node of the PDF is evaluated again for (a subset of) the 
+   *  events, and calls and exclusive/inclusive times are recorded. The 
+   *  numbers are estimates from this replay of the unoptimised graph. 
+   *  After the fit, the nodes with the largest exclusive time are printed, 
+   *  and a report and a flame graph file (collapsed stacks) are written.
+   *
+   *  Profiling every FCN call with all events roughly doubles the fit time. 
+   *  With a sampling interval of e.g. 100 and 1000 events per sample, the 
+   *  overhead is negligible for production jobs. Fits with sum-of-weights 
+   *  correction or other minimizer types than Minuit2 are not profiled, 
+   *  multi-start fits only in the main process.
+   */
+  /**@{*/
+
+  /** @brief Sets whether to profile the evaluation of the PDF nodes.
+   *
+   *  Default is no profiling.
+   *
+   *  @param fc_profiling whether to profile
+   *  @param fc_profiling_prefix prefix of the output files (prefix + "_profile.txt" and prefix + "_profile.folded"), fit name if empty
+   *  @param fc_profiling_interval profile every fc_profiling_interval-th FCN call
+   *  @param fc_profiling_max_events maximum number of events per profiled FCN call (0 for all)
+   */
+  EasyFit& SetEvaluationProfiling(bool fc_profiling, const std::string& fc_profiling_prefix="", 
+                                  int fc_profiling_interval=1, int fc_profiling_max_events=0);
+  /**@}*/
+
 
  private:
   void PrepareFit();
   void ExecuteFit();
   void FinalizeFit();
 
+  /**
+   *  @brief Run the fit from all multi-start points and keep the best result
+   *
+   *  @return the best fit result (or NULL if no fit succeeded)
+   */
+  RooFitResult* ExecuteMultiStart();
+
+  /**
+   *  @brief Start points for multi-start fit
+   *
+   *  @param floating_parameters floating parameters of the fit
+   *  @return start values by parameter name for each start point
+   */
+  std::vector<std::map<std::string,double> > MultiStartPoints(const RooArgList& floating_parameters) const;
+
+  /**
+   *  @brief Run the fit seeded from the warm-start cache and update the cache
+   *
+   *  @return the fit result (or NULL if the fit result is not saved)
+   */
+  RooFitResult* ExecuteWarmStart();
+
+  /**
+   *  @brief Collect all floating RooRealVars of a parameter set
+   *
+   *  @param parameters all parameters
+   *  @param floating_parameters list to add floating parameters to
+   */
+  void FloatingParameters(const RooArgSet& parameters, RooArgList& floating_parameters) const;
+
+  /**
+   *  @brief Run one minimisation with the configured backend
+   *
+   *  @return the fit result (or NULL if the fit result is not saved)
+   */
+  RooFitResult* Minimize();
+
+  /**
+   *  @brief Run the fit via RooMinimizer with the same steps as fitTo(...)
+   *
+   *  With evaluation profiling, RooMinimizer runs on a wrapper of the 
+   *  likelihood which only times each evaluation, i.e. the fit is the same.
+   *
+   *  @param num_fcn_calls if not NULL, set to the number of FCN calls
+   *  @return the fit result (or NULL if the fit result is not saved)
+   */
+  RooFitResult* ExecuteMinimizerFit(int* num_fcn_calls=NULL);
+
+  /**
+   *  @brief Run the fit via MinimizerFcn (analytic gradients and/or batch evaluation)
+   *
+   *  With a warm-start cache entry, MIGRAD is seeded with the cached 
+   *  covariance matrix (see MinimizerFcn::MinimizeSeeded(...)).
+   *
+   *  @param num_fcn_calls if not NULL, set to the number of FCN calls (unchanged on fallback to fitTo)
+   *  @param seed warm-start cache entry to seed the fit with (NULL for none)
+   *  @return the fit result (or NULL if the fit result is not saved)
+   */
+  RooFitResult* ExecuteFcnFit(int* num_fcn_calls=NULL, const WarmStartCache::Entry* seed=NULL);
+
+  /**
+   *  @brief Whether the fit runs via MinimizerFcn (see ExecuteFcnFit())
+   */
+  bool UseMinimizerFcn() const { return fc_minimizer_backend_ == kBackendAnalyticGradient || fc_batch_evaluation_; }
+
+  /**
+   *  @brief Add the likelihood options of fitTo(...) to a command list for createNLL(...)
+   */
+  void FillNllCmdList(RooLinkedList& nll_linklist);
+
+  bool BatchEvaluationSupported() const; ///< Helper function to check (with warning) if @ref pdf_ can be evaluated in batches.
   bool PdfAndDataReady(); ///< Helper function to check that @ref pdf_ and @ref data_ are set.
   bool CheckSettingOptionsOk(); ///< Helper function to check if setting or changing an option is allowed in the current state of the object.
   bool CheckMinimizerCombiOk(const std::string& type, const std::string& algo); ///< Helper function to check allowed combinations of minimizer type and algo (using @ref minimizer_combs_).
@@ -270,6 +571,10 @@ class EasyFit
   RooAbsPdf* pdf_;            ///< PDF to be used for fit.
   RooAbsData* data_;          ///< Dataset to be fitted.
   RooFitResult* fit_result_;  ///< RooFitResult of the fit.
+  MultiStartSummary multistart_summary_; ///< Summary of all minima of a multi-start fit.
+  WarmStartCache::FitInfo warm_start_info_; ///< Warm-start information of the fit.
+  EvaluationProfiler* profiler_; ///< Evaluation profiler of the fit (owned, NULL if not profiled).
+  std::pair<int, int> fcn_calls_; ///< FCN and gradient calls of fits via MinimizerFcn (-1 if not counted).
 
   std::map<std::string,std::set<std::string> > minimizer_combs_; ///< Defines allowed combination of minimizer type and algo.
 
@@ -374,6 +679,40 @@ class EasyFit
   bool fc_timer_;       ///< Time CPU and wall clock consumption (true by default).
   /**@}*/
 
+  /** @name MultiStartMembers
+   *  
+   *  These members control multi-start fits (see @ref MultiStartOptions).
+   */
+  /**@{*/
+  int fc_multistart_num_;            ///< Number of start points (0 for a single fit, default).
+  MultiStartMode fc_multistart_mode_; ///< Generation of start points (random by default).
+  unsigned int fc_multistart_seed_;  ///< Seed for generated start points (0 for random seed, default).
+  std::vector<std::map<std::string,double> > fc_multistart_points_; ///< User-provided start points.
+  int fc_multistart_num_processes_;  ///< Number of concurrent fit processes (1 by default).
+  /**@}*/
+
+  /** @name WarmStartMembers
+   *  
+   *  These members control warm-started fits (see @ref WarmStartOptions).
+   */
+  /**@{*/
+  WarmStartCache* fc_warm_start_cache_; ///< Cache of previous minima (not owned, NULL by default).
+  /**@}*/
+
+  MinimizerBackend fc_minimizer_backend_; ///< Minimizer backend (kBackendFitTo by default).
+  bool fc_batch_evaluation_; ///< Evaluate the likelihood in batches (false by default).
+
+  /** @name EvaluationProfilingMembers
+   *  
+   *  These members control the evaluation profiling (see @ref EvaluationProfilingOptions).
+   */
+  /**@{*/
+  bool fc_profiling_;                ///< Profile the evaluation of the PDF nodes (false by default).
+  std::string fc_profiling_prefix_;  ///< Prefix of the profile output files (fit name if empty, default).
+  int fc_profiling_interval_;        ///< Profile every n-th FCN call (1 by default).
+  int fc_profiling_max_events_;      ///< Maximum number of events per profiled FCN call (0 for all, default).
+  /**@}*/
+
 }; // class EasyFit
 
 } // namespace easyfit
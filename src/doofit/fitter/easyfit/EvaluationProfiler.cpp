@@ -0,0 +1,246 @@
+#include "EvaluationProfiler.h"
+
+// from STL
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+// from ROOT
+#include "TIterator.h"
+
+// from RooFit
+#include "RooAbsArg.h"
+#include "RooAbsReal.h"
+#include "RooAbsCategory.h"
+#include "RooAbsPdf.h"
+#include "RooAbsData.h"
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+
+using doocore::io::sinfo;
+using doocore::io::swarn;
+using doocore::io::endmsg;
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+EvaluationProfiler::EvaluationProfiler(RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables,
+                                       int sampling_interval, int max_events)
+    : nodes_()
+    , reals_()
+    , categories_()
+    , nsets_()
+    , data_(&data)
+    , observables_()
+    , nset_()
+    , sampling_interval_(std::max(sampling_interval, 1))
+    , max_events_(std::max(max_events, 0))
+    , num_fcn_calls_(0)
+    , num_samples_(0)
+    , num_events_profiled_(0)
+    , time_fcn_(0.0)
+    , time_profiling_(0.0)
+{
+  RooArgSet* observables = pdf.getObservables(data);
+  observables_.add(*observables);
+  nset_.add(*observables);
+  if (conditional_observables != NULL) {
+    nset_.remove(*conditional_observables, kFALSE, kTRUE);
+  }
+  delete observables;
+
+  std::map<const RooAbsArg*, unsigned int> indices;
+  AddNode(&pdf, "", &nset_, indices);
+}
+
+EvaluationProfiler::~EvaluationProfiler() {}
+
+void EvaluationProfiler::AddNode(RooAbsArg* arg, const std::string& stack, const RooArgSet* nset, std::map<const RooAbsArg*, unsigned int>& indices) {
+  if (indices.find(arg) != indices.end()) return;
+  // placeholder until the node is added, RooFit graphs have no cycles
+  indices[arg] = nodes_.size();
+
+  Node node;
+  node.arg            = arg;
+  node.stack          = stack.empty() ? arg->GetName() : stack + ";" + arg->GetName();
+  node.calls          = 0;
+  node.time_exclusive = 0.0;
+  node.time_inclusive = 0.0;
+
+  // servers first, leaves (variables, constants) are not profiled
+  bool is_pdf = (dynamic_cast<RooAbsPdf*>(arg) != NULL);
+  TIterator* it = arg->serverIterator();
+  RooAbsArg* server = NULL;
+  std::vector<const RooAbsArg*> branch_servers;
+  while ((server = dynamic_cast<RooAbsArg*>(it->Next())) != NULL) {
+    if (!server->isDerived()) continue;
+    if (dynamic_cast<RooAbsReal*>(server) == NULL && dynamic_cast<RooAbsCategory*>(server) == NULL) continue;
+
+    // normalisation set the client passes to this server
+    std::unique_ptr<RooArgSet> server_nset;
+    if (is_pdf && nset != NULL) {
+      if (dynamic_cast<RooAbsPdf*>(server) != NULL) {
+        server_nset.reset(server->getObservables(*nset));
+      } else {
+        server_nset.reset(new RooArgSet(*nset));
+      }
+    }
+    AddNode(server, node.stack, server_nset.get(), indices);
+    branch_servers.push_back(server);
+  }
+  delete it;
+
+  for (const RooAbsArg* branch_server : branch_servers) {
+    unsigned int index = indices[branch_server];
+    node.descendants.push_back(index);
+    node.descendants.insert(node.descendants.end(), nodes_[index].descendants.begin(), nodes_[index].descendants.end());
+  }
+  std::sort(node.descendants.begin(), node.descendants.end());
+  node.descendants.erase(std::unique(node.descendants.begin(), node.descendants.end()), node.descendants.end());
+
+  indices[arg] = nodes_.size();
+  nodes_.push_back(node);
+  reals_.push_back(dynamic_cast<RooAbsReal*>(arg));
+  categories_.push_back(reals_.back() == NULL ? dynamic_cast<RooAbsCategory*>(arg) : NULL);
+  nsets_.emplace_back(nset != NULL ? new RooArgSet(*nset) : NULL);
+}
+
+void EvaluationProfiler::Sample(double fcn_time) {
+  ++num_fcn_calls_;
+  time_fcn_ += fcn_time;
+  if ((num_fcn_calls_-1) % sampling_interval_ != 0) return;
+
+  auto t_start = std::chrono::high_resolution_clock::now();
+  ++num_samples_;
+
+  // the replay must not show up in the error log of the likelihood
+  RooAbsReal::ErrorLoggingMode logging_mode = RooAbsReal::evalErrorLoggingMode();
+  RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::Ignore);
+  std::unique_ptr<RooArgSet> observable_values(dynamic_cast<RooArgSet*>(observables_.snapshot(kFALSE)));
+
+  const long num_entries = data_->numEntries();
+  const long num_events  = (max_events_ > 0 && num_entries > max_events_) ? max_events_ : num_entries;
+  std::vector<double> times(nodes_.size());
+  for (long k=0; k<num_events; ++k) {
+    const RooArgSet* row = data_->get(k*num_entries/num_events);
+    if (data_->weight() == 0.0) continue;
+    observables_.assignValueOnly(*row);
+    ProfileEvent(times);
+    ++num_events_profiled_;
+  }
+
+  observables_.assignValueOnly(*observable_values);
+  RooAbsPdf::clearEvalError();
+  RooAbsReal::setEvalErrorLoggingMode(logging_mode);
+
+  auto t_end = std::chrono::high_resolution_clock::now();
+  time_profiling_ += std::chrono::duration<double>(t_end - t_start).count();
+}
+
+void EvaluationProfiler::ProfileEvent(std::vector<double>& times) {
+  // servers are clean when a node is evaluated, so only the node itself is
+  // calculated
+  for (unsigned int i=0; i<nodes_.size(); ++i) {
+    times[i] = 0.0;
+    if (!nodes_[i].arg->isValueDirty()) continue;
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    if (reals_[i] != NULL) {
+      reals_[i]->getVal(nsets_[i].get());
+    } else {
+      categories_[i]->getIndex();
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+
+    times[i] = std::chrono::duration<double>(t_end - t_start).count();
+    ++nodes_[i].calls;
+  }
+
+  for (unsigned int i=0; i<nodes_.size(); ++i) {
+    Node& node = nodes_[i];
+    node.time_exclusive += times[i];
+    node.time_inclusive += times[i];
+    for (unsigned int index : node.descendants) {
+      node.time_inclusive += times[index];
+    }
+  }
+}
+
+double EvaluationProfiler::scale() const {
+  if (num_events_profiled_ == 0) return 0.0;
+  return static_cast<double>(num_fcn_calls_)*data_->numEntries()/num_events_profiled_;
+}
+
+std::vector<unsigned int> EvaluationProfiler::SortedNodes() const {
+  std::vector<unsigned int> sorted(nodes_.size());
+  for (unsigned int i=0; i<sorted.size(); ++i) sorted[i] = i;
+  std::stable_sort(sorted.begin(), sorted.end(), [this](unsigned int a, unsigned int b) {
+    return nodes_[a].time_exclusive > nodes_[b].time_exclusive;
+  });
+  return sorted;
+}
+
+void EvaluationProfiler::Print(unsigned int num_nodes) const {
+  double time_nodes = 0.0;
+  for (const Node& node : nodes_) time_nodes += node.time_exclusive;
+
+  sinfo << "Evaluation profile (estimated from replay of unoptimised graph): " << num_fcn_calls_ << " FCN calls (" << num_samples_ << " sampled, "
+        << num_events_profiled_ << " events profiled), FCN time " << time_fcn_ << " s, profiling time "
+        << time_profiling_ << " s." << endmsg;
+  std::vector<unsigned int> sorted = SortedNodes();
+  for (unsigned int i=0; i<sorted.size() && i<num_nodes; ++i) {
+    const Node& node = nodes_[sorted[i]];
+    sinfo << "  " << node.arg->GetName() << " (" << node.arg->ClassName() << "): "
+          << static_cast<long>(node.calls*scale()) << " calls, exclusive " << node.time_exclusive*scale() << " s ("
+          << (time_nodes > 0.0 ? 100.0*node.time_exclusive/time_nodes : 0.0) << "%), inclusive "
+          << node.time_inclusive*scale() << " s" << endmsg;
+  }
+}
+
+bool EvaluationProfiler::Write(const std::string& prefix) const {
+  double time_nodes = 0.0;
+  for (const Node& node : nodes_) time_nodes += node.time_exclusive;
+
+  std::ofstream report(prefix + "_profile.txt");
+  report << "# FCN calls: " << num_fcn_calls_ << ", sampled: " << num_samples_ << " (every " << sampling_interval_
+         << ". call), events profiled: " << num_events_profiled_ << " (of " << data_->numEntries() << " per call)" << std::endl;
+  report << "# FCN time: " << time_fcn_ << " s, profiling time: " << time_profiling_ << " s" << std::endl;
+  report << "# estimate: calls and times of a replay of the unoptimised graph (without constant term optimisation)," << std::endl;
+  report << "# scaled from sampled FCN calls and events to the whole minimisation" << std::endl;
+  report << "# " << std::left << std::setw(38) << "node" << std::setw(28) << "class" << std::right
+         << std::setw(14) << "calls" << std::setw(16) << "exclusive [s]" << std::setw(16) << "inclusive [s]"
+         << std::setw(12) << "excl. [%]" << std::endl;
+  for (unsigned int index : SortedNodes()) {
+    const Node& node = nodes_[index];
+    report << "  " << std::left << std::setw(38) << node.arg->GetName() << std::setw(28) << node.arg->ClassName() << std::right
+           << std::setw(14) << static_cast<long>(node.calls*scale())
+           << std::setw(16) << node.time_exclusive*scale() << std::setw(16) << node.time_inclusive*scale()
+           << std::setw(12) << std::fixed << std::setprecision(2) << (time_nodes > 0.0 ? 100.0*node.time_exclusive/time_nodes : 0.0)
+           << std::defaultfloat << std::setprecision(6) << std::endl;
+  }
+  report.close();
+
+  // collapsed stacks in microseconds, e.g. for flamegraph.pl
+  std::ofstream folded(prefix + "_profile.folded");
+  for (const Node& node : nodes_) {
+    long time = static_cast<long>(node.time_exclusive*scale()*1e6);
+    if (time > 0) folded << node.stack << " " << time << std::endl;
+  }
+  folded.close();
+
+  bool success = !report.fail() && !folded.fail();
+  if (success) {
+    sinfo << "Evaluation profile written to " << prefix << "_profile.txt and " << prefix << "_profile.folded." << endmsg;
+  } else {
+    swarn << "Cannot write evaluation profile to " << prefix << "_profile.txt and " << prefix << "_profile.folded." << endmsg;
+  }
+  return success;
+}
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
@@ -0,0 +1,245 @@
+#ifndef DOOFIT_FITTER_EASYFIT_EVALUATIONPROFILER_H
+#define DOOFIT_FITTER_EASYFIT_EVALUATIONPROFILER_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+// from ROOT
+
+// from RooFit
+#include "RooArgSet.h"
+
+// forward declarations
+class RooAbsArg;
+class RooAbsReal;
+class RooAbsCategory;
+class RooAbsPdf;
+class RooAbsData;
+
+/** @class doofit::fitter::easyfit::EvaluationProfiler
+ *  @brief Per-node evaluation profile of a PDF during minimisation
+ *
+ *  After sampled FCN calls (see Sample(double)), the PDF is evaluated again
+ *  for (a subset of) the events of the dataset at the current parameter
+ *  values. The graph is evaluated bottom-up, i.e. each node is only
+ *  evaluated after all of its servers. This way, only nodes which would be
+ *  recalculated (value dirty) are evaluated and each measured time is the
+ *  exclusive time of the node. Normalisation integrals are accounted to
+ *  their PDF. Inclusive times add up the exclusive times of all nodes
+ *  below a node.
+ *
+ *  Each node is evaluated with the normalisation set its client passes: 
+ *  PDFs below PDFs are normalised over their observables in the client's 
+ *  set (as in RooProdPdf, RooAddPdf), functions below PDFs get the 
+ *  client's set (as via RooRealProxy) and PDFs below functions are not 
+ *  normalised. Nodes with several clients use the set of the first client 
+ *  found from the top node.
+ *
+ *  All numbers are estimates: the replay evaluates the original PDF 
+ *  without RooFit's constant term optimisation and caching of the 
+ *  likelihood, and times and call counts of the samples are scaled to the 
+ *  whole minimisation by the fraction of sampled FCN calls and events. 
+ *  Only the total FCN time is measured for every call.
+ *
+ *  The report (see Write(const std::string&)) lists all nodes sorted by
+ *  exclusive time. The flame graph file contains one line per node in the
+ *  collapsed stack format ("top;...;node microseconds"). Nodes with several
+ *  clients appear under the first client found from the top node.
+ */
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+class EvaluationProfiler {
+ public:
+  /**
+   *  @brief Profile of one node
+   */
+  struct Node {
+    /**
+     *  @brief The node in the graph (not owned)
+     */
+    RooAbsArg* arg;
+
+    /**
+     *  @brief Stack of node names from the top node ("top;...;node")
+     */
+    std::string stack;
+
+    /**
+     *  @brief Indices (in nodes()) of all nodes below this node
+     */
+    std::vector<unsigned int> descendants;
+
+    /**
+     *  @brief Evaluations in sampled FCN calls
+     */
+    long calls;
+
+    /**
+     *  @brief Exclusive time in sampled FCN calls (in seconds)
+     */
+    double time_exclusive;
+
+    /**
+     *  @brief Inclusive time in sampled FCN calls (in seconds)
+     */
+    double time_inclusive;
+  };
+
+  /**
+   *  @brief Constructor analysing the graph of the PDF
+   *
+   *  @param pdf the PDF to profile (not owned)
+   *  @param data the dataset (not owned)
+   *  @param conditional_observables conditional observables (not normalised over, can be NULL)
+   *  @param sampling_interval profile every sampling_interval-th FCN call
+   *  @param max_events maximum number of (equally spaced) events per sample (0 for all)
+   */
+  EvaluationProfiler(RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables,
+                     int sampling_interval=1, int max_events=0);
+
+  /**
+   *  @brief Destructor
+   */
+  ~EvaluationProfiler();
+
+  EvaluationProfiler(const EvaluationProfiler&) = delete;
+  EvaluationProfiler& operator=(const EvaluationProfiler&) = delete;
+
+  /**
+   *  @brief Count an FCN call and profile the PDF if this call is sampled
+   *
+   *  Call after the likelihood has been evaluated at the current parameter
+   *  values.
+   *
+   *  @param fcn_time time of the likelihood evaluation (in seconds)
+   */
+  void Sample(double fcn_time);
+
+  /**
+   *  @brief All nodes in evaluation order (servers before clients)
+   */
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+  /**
+   *  @brief Factor to scale sampled times and calls to the whole minimisation
+   */
+  double scale() const;
+
+  /**
+   *  @brief Print the nodes with the largest exclusive time
+   *
+   *  @param num_nodes maximum number of nodes to print
+   */
+  void Print(unsigned int num_nodes=10) const;
+
+  /**
+   *  @brief Write report and flame graph file
+   *
+   *  @param prefix files are named prefix + "_profile.txt" and prefix + "_profile.folded"
+   *  @return whether both files could be written
+   */
+  bool Write(const std::string& prefix) const;
+
+ private:
+  /**
+   *  @brief Add a node and all nodes below it in evaluation order
+   *
+   *  @param arg the node
+   *  @param stack stack of the client
+   *  @param nset normalisation set the client evaluates the node with (NULL for none)
+   *  @param indices indices (in nodes_) of nodes added so far
+   */
+  void AddNode(RooAbsArg* arg, const std::string& stack, const RooArgSet* nset, std::map<const RooAbsArg*, unsigned int>& indices);
+
+  /**
+   *  @brief Evaluate all dirty nodes for the current event and record times
+   */
+  void ProfileEvent(std::vector<double>& times);
+
+  /**
+   *  @brief Indices of nodes sorted by decreasing exclusive time
+   */
+  std::vector<unsigned int> SortedNodes() const;
+
+  /**
+   *  @brief All nodes in evaluation order
+   */
+  std::vector<Node> nodes_;
+
+  /**
+   *  @brief Nodes as RooAbsReal (NULL for categories), same order as nodes_
+   */
+  std::vector<RooAbsReal*> reals_;
+
+  /**
+   *  @brief Nodes as RooAbsCategory (NULL for reals), same order as nodes_
+   */
+  std::vector<RooAbsCategory*> categories_;
+
+  /**
+   *  @brief Normalisation sets of the nodes (NULL for none), same order as nodes_
+   */
+  std::vector<std::unique_ptr<RooArgSet> > nsets_;
+
+  /**
+   *  @brief The dataset (not owned)
+   */
+  RooAbsData* data_;
+
+  /**
+   *  @brief Observables of the PDF in the dataset
+   */
+  RooArgSet observables_;
+
+  /**
+   *  @brief Normalisation set of the top node (observables without conditional observables)
+   */
+  RooArgSet nset_;
+
+  /**
+   *  @brief Profile every sampling_interval_-th FCN call
+   */
+  int sampling_interval_;
+
+  /**
+   *  @brief Maximum number of events per sample (0 for all)
+   */
+  int max_events_;
+
+  /**
+   *  @brief Number of FCN calls
+   */
+  long num_fcn_calls_;
+
+  /**
+   *  @brief Number of sampled FCN calls
+   */
+  long num_samples_;
+
+  /**
+   *  @brief Number of profiled events summed over all samples
+   */
+  long num_events_profiled_;
+
+  /**
+   *  @brief Time of all FCN calls (in seconds)
+   */
+  double time_fcn_;
+
+  /**
+   *  @brief Time spent profiling (in seconds)
+   */
+  double time_profiling_;
+};
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
+
+#endif // DOOFIT_FITTER_EASYFIT_EVALUATIONPROFILER_H
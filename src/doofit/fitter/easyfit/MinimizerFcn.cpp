@@ -0,0 +1,906 @@
+/*****************************************************************************
+ * Project: RooFit                                                           *
+ * Package: RooFitCore                                                       *
+ * @(#)root/roofitcore:$Id$
+ * Authors:                                                                  *
+ *   AL, Alfio Lazzaro,   INFN Milan,        alfio.lazzaro@mi.infn.it        *
+ *                                                                           *
+ *                                                                           *
+ * Redistribution and use in source and binary forms,                        *
+ * with or without modification, are permitted according to the terms        *
+ * listed in LICENSE (http://roofit.sourceforge.net/license.txt)             *
+ *****************************************************************************/
+
+#include "MinimizerFcn.h"
+
+// from STL
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+// from ROOT
+#include "TIterator.h"
+#include "TClass.h"
+#include "Minuit2/MnUserParameters.h"
+#include "Minuit2/MnUserCovariance.h"
+#include "Minuit2/MnUserParameterState.h"
+#include "Minuit2/MnStrategy.h"
+#include "Minuit2/MnMigrad.h"
+#include "Minuit2/MnHesse.h"
+#include "Minuit2/MnMinos.h"
+#include "Minuit2/MinosError.h"
+#include "Minuit2/FunctionMinimum.h"
+#include "Minuit2/FCNAdapter.h"
+#include "Minuit2/FCNGradAdapter.h"
+
+// from RooFit
+#include "RooAbsArg.h"
+#include "RooAbsPdf.h"
+#include "RooAbsData.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooAbsRealLValue.h"
+#include "RooFitResult.h"
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+
+// from project
+#include "doofit/roofit/functions/AbsAnalyticGradient.h"
+#include "doofit/fitter/easyfit/EvaluationProfiler.h"
+
+using namespace std;
+using doocore::io::sinfo;
+using doocore::io::swarn;
+using doocore::io::endmsg;
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+namespace {
+/// RooFitResult setters are only accessible in derived classes.
+class FitResultBuilder : public RooFitResult {
+ public:
+  FitResultBuilder(const char* name, const char* title) : RooFitResult(name, title) {}
+
+  void Fill(MinimizerFcn& fcn, const ROOT::Fit::FitResult& results) {
+    setConstParList(*fcn.GetConstParamList());
+    setNumInvalidNLL(fcn.GetNumInvalidNLL());
+    setStatus(results.Status());
+    setCovQual(results.CovMatrixStatus());
+    setMinNLL(results.MinFcnValue());
+    setEDM(results.Edm());
+    setInitParList(*fcn.GetInitFloatParamList());
+    setFinalParList(*fcn.GetFloatParamList());
+
+    unsigned int n = fcn.NDim();
+    std::vector<double> globalCC;
+    TMatrixDSym corrs(n);
+    TMatrixDSym covs(n);
+    for (unsigned int ic=0; ic<n; ic++) {
+      globalCC.push_back(results.GlobalCC(ic));
+      for (unsigned int ii=0; ii<n; ii++) {
+        corrs(ic,ii) = results.Correlation(ic,ii);
+        covs(ic,ii)  = results.CovMatrix(ic,ii);
+      }
+    }
+    fillCorrMatrix(globalCC, corrs, covs);
+
+    std::vector<std::pair<std::string,int> > status_history;
+    status_history.push_back(std::make_pair(std::string("MINIMIZE"), results.Status()));
+    setStatusHistory(status_history);
+  }
+
+  void Fill(MinimizerFcn& fcn, const ROOT::Minuit2::FunctionMinimum& minimum, int status, int cov_status) {
+    const ROOT::Minuit2::MnUserParameterState& state = minimum.UserState();
+    setConstParList(*fcn.GetConstParamList());
+    setNumInvalidNLL(fcn.GetNumInvalidNLL());
+    setStatus(status);
+    setCovQual(cov_status);
+    setMinNLL(state.Fval());
+    setEDM(state.Edm());
+    setInitParList(*fcn.GetInitFloatParamList());
+    setFinalParList(*fcn.GetFloatParamList());
+
+    unsigned int n = fcn.NDim();
+    std::vector<double> globalCC(n, 0.0);
+    if (state.HasGlobalCC() && state.GlobalCC().IsValid()) {
+      globalCC = state.GlobalCC().GlobalCC();
+    }
+    TMatrixDSym corrs(n);
+    TMatrixDSym covs(n);
+    if (state.HasCovariance()) {
+      for (unsigned int ic=0; ic<n; ic++) {
+        for (unsigned int ii=0; ii<n; ii++) {
+          covs(ic,ii) = state.Covariance()(ic,ii);
+        }
+      }
+      for (unsigned int ic=0; ic<n; ic++) {
+        for (unsigned int ii=0; ii<n; ii++) {
+          double norm = std::sqrt(covs(ic,ic)*covs(ii,ii));
+          corrs(ic,ii) = norm > 0.0 ? covs(ic,ii)/norm : 0.0;
+        }
+      }
+    }
+    fillCorrMatrix(globalCC, corrs, covs);
+
+    std::vector<std::pair<std::string,int> > status_history;
+    status_history.push_back(std::make_pair(std::string("MINIMIZE"), status));
+    setStatusHistory(status_history);
+  }
+};
+} // namespace
+
+MinimizerFcn::MinimizerFcn(RooAbsReal *funct, bool verbose) :
+  _counters(new Counters()),
+  _funct(funct),
+  // Reset the *largest* negative log-likelihood value we have seen so far
+  _maxFCN(-1e30),
+  _printEvalErrors(10), _doEvalErrorWall(kTRUE),
+  _nDim(0), _logfile(0),
+  _verbose(verbose),
+  _gradPdf(NULL), _gradData(NULL), _gradObs(NULL), _gradObsSaved(NULL),
+  _profiler(NULL)
+{ 
+
+  _counters->evalCounter = 0 ;
+  _counters->gradientCounter = 0 ;
+  _counters->numBadNLL = 0 ;
+  
+  // Examine parameter list
+  RooArgSet* paramSet = _funct->getParameters(RooArgSet());
+  RooArgList paramList(*paramSet);
+  delete paramSet;
+
+  _floatParamList = (RooArgList*) paramList.selectByAttrib("Constant",kFALSE);
+  if (_floatParamList->getSize()>1) {
+    _floatParamList->sort();
+  }
+  _floatParamList->setName("floatParamList");
+
+  _constParamList = (RooArgList*) paramList.selectByAttrib("Constant",kTRUE);
+  if (_constParamList->getSize()>1) {
+    _constParamList->sort();
+  }
+  _constParamList->setName("constParamList");
+
+  // Remove all non-RooRealVar parameters from list (MINUIT cannot handle them)
+  TIterator* pIter = _floatParamList->createIterator();
+  RooAbsArg* arg;
+  while ((arg=(RooAbsArg*)pIter->Next())) {
+    if (!arg->IsA()->InheritsFrom(RooAbsRealLValue::Class())) {
+      swarn << "MinimizerFcn::MinimizerFcn: removing parameter " << arg->GetName()
+            << " from list because it is not of type RooRealVar" << endmsg;
+      _floatParamList->remove(*arg);
+    }
+  }
+  delete pIter;
+
+  _nDim = _floatParamList->getSize();
+
+  updateFloatVec() ;
+  
+  // Save snapshot of initial lists
+  _initFloatParamList = (RooArgList*) _floatParamList->snapshot(kFALSE) ;
+  _initConstParamList = (RooArgList*) _constParamList->snapshot(kFALSE) ;
+
+}
+
+
+
+MinimizerFcn::MinimizerFcn(const MinimizerFcn& other) : ROOT::Math::IMultiGradFunction(other), 
+  _counters(other._counters),
+  _funct(other._funct),
+  _maxFCN(other._maxFCN),
+  _printEvalErrors(other._printEvalErrors),
+  _doEvalErrorWall(other._doEvalErrorWall),
+  _nDim(other._nDim),
+  _logfile(other._logfile),
+  _verbose(other._verbose),
+  _floatParamVec(other._floatParamVec),
+  _gradPdf(other._gradPdf),
+  _gradData(other._gradData),
+  _gradObs(other._gradObs != NULL ? new RooArgSet(*other._gradObs) : NULL),
+  _gradObsSaved(other._gradObsSaved != NULL ? (RooArgSet*)other._gradObsSaved->snapshot(kFALSE) : NULL),
+  _gradNormSet(other._gradNormSet),
+  _analytic(other._analytic),
+  _gradSteps(other._gradSteps),
+  _gradX(other._gradX),
+  _grad(other._grad),
+  _profiler(other._profiler)
+{  
+  _floatParamList = new RooArgList(*other._floatParamList) ;
+  _constParamList = new RooArgList(*other._constParamList) ;
+  _initFloatParamList = (RooArgList*) other._initFloatParamList->snapshot(kFALSE) ;
+  _initConstParamList = (RooArgList*) other._initConstParamList->snapshot(kFALSE) ;  
+}
+
+
+MinimizerFcn::~MinimizerFcn()
+{
+  delete _floatParamList;
+  delete _initFloatParamList;
+  delete _constParamList;
+  delete _initConstParamList;
+  delete _gradObs;
+  delete _gradObsSaved;
+}
+
+
+ROOT::Math::IBaseFunctionMultiDim* MinimizerFcn::Clone() const 
+{  
+  return new MinimizerFcn(*this) ;
+}
+
+
+Bool_t MinimizerFcn::Synchronize(std::vector<ROOT::Fit::ParameterSettings>& parameters, 
+				 Bool_t optConst, Bool_t verbose)
+{
+
+  // Internal function to synchronize TMinimizer with current
+  // information in RooAbsReal function parameters
+  
+  Bool_t constValChange(kFALSE) ;
+  Bool_t constStatChange(kFALSE) ;
+  
+  Int_t index(0) ;
+  
+  // Handle eventual migrations from constParamList -> floatParamList
+  for(index= 0; index < _constParamList->getSize() ; index++) {
+
+    RooRealVar *par= dynamic_cast<RooRealVar*>(_constParamList->at(index)) ;
+    if (!par) continue ;
+
+    RooRealVar *oldpar= dynamic_cast<RooRealVar*>(_initConstParamList->at(index)) ;
+    if (!oldpar) continue ;
+
+    // Test if constness changed
+    if (!par->isConstant()) {      
+    
+      // Remove from constList, add to floatList
+      _constParamList->remove(*par) ;
+      _floatParamList->add(*par) ;
+      _initFloatParamList->addClone(*oldpar) ;      
+      _initConstParamList->remove(*oldpar) ;
+      constStatChange=kTRUE ;
+      _nDim++ ;
+
+      if (verbose) {
+        sinfo << "MinimizerFcn::synchronize: parameter " << par->GetName() << " is now floating." << endmsg ;
+      }
+    } 
+
+    // Test if value changed
+    if (par->getVal()!= oldpar->getVal()) {
+      constValChange=kTRUE ;      
+      if (verbose) {
+        sinfo << "MinimizerFcn::synchronize: value of constant parameter " << par->GetName() 
+              << " changed from " << oldpar->getVal() << " to " << par->getVal() << endmsg ;
+      }
+    }
+
+  }
+
+  // Update reference list
+  *_initConstParamList = *_constParamList ;
+
+  _gradSteps.assign(_nDim, 0.) ;
+  
+  // Synchronize MINUIT with function state
+  // Handle floatParamList
+  for(index= 0; index < _floatParamList->getSize(); index++) {
+    RooRealVar *par= dynamic_cast<RooRealVar*>(_floatParamList->at(index)) ;
+    
+    if (!par) continue ;
+
+    Double_t pstep(0) ;
+    Double_t pmin(0) ;
+    Double_t pmax(0) ;
+
+    if(!par->isConstant()) {
+
+      // Verify that floating parameter is indeed of type RooRealVar 
+      if (!par->IsA()->InheritsFrom(RooRealVar::Class())) {
+        swarn << "MinimizerFcn::fit: Error, non-constant parameter " << par->GetName() 
+              << " is not of type RooRealVar, skipping" << endmsg ;
+	_floatParamList->remove(*par);
+	index--;
+	_nDim--;
+	continue ;
+      }
+
+      // Set the limits, if not infinite
+      if (par->hasMin() )
+	pmin = par->getMin();
+      if (par->hasMax() )
+	pmax = par->getMax();
+      
+      // Calculate step size
+      pstep = par->getError();
+      if(pstep <= 0) {
+	// Floating parameter without error estitimate
+	if (par->hasMin() && par->hasMax()) {
+	  pstep= 0.1*(pmax-pmin);
+
+	  // Trim default choice of error if within 2 sigma of limit
+	  if (pmax - par->getVal() < 2*pstep) {
+	    pstep = (pmax - par->getVal())/2 ;
+	  } else if (par->getVal() - pmin < 2*pstep) {
+	    pstep = (par->getVal() - pmin )/2 ;	    
+	  }	  
+
+	  // If trimming results in zero error, restore default
+	  if (pstep==0) {
+	    pstep= 0.1*(pmax-pmin);
+	  }
+
+	} else {
+	  pstep=1 ;
+	}						  
+	if(verbose) {
+          swarn << "MinimizerFcn::synchronize: WARNING: no initial error estimate available for "
+                << par->GetName() << ": using " << pstep << endmsg;
+	}
+      }       
+
+      // numerical derivatives use a fraction of the initial step size
+      if (index < Int_t(_gradSteps.size())) _gradSteps[index] = 1e-3*pstep ;
+    } else {
+      pmin = par->getVal() ;
+      pmax = par->getVal() ;      
+    }
+
+    // new parameter
+    if (index>=Int_t(parameters.size())) {
+
+      if (par->hasMin() && par->hasMax()) {
+	parameters.push_back(ROOT::Fit::ParameterSettings(par->GetName(),
+							  par->getVal(),
+							  pstep,
+							  pmin,pmax));
+      }
+      else {
+	parameters.push_back(ROOT::Fit::ParameterSettings(par->GetName(),
+							  par->getVal(),
+							  pstep));
+        if (par->hasMin() ) 
+           parameters.back().SetLowerLimit(pmin);
+        else if (par->hasMax() ) 
+           parameters.back().SetUpperLimit(pmax);
+      }
+      
+      continue;
+
+    }
+
+    Bool_t oldFixed = parameters[index].IsFixed();
+    Double_t oldVar = parameters[index].Value();
+    Double_t oldVerr = parameters[index].StepSize();
+    Double_t oldVlo = parameters[index].LowerLimit();
+    Double_t oldVhi = parameters[index].UpperLimit();
+
+    if (par->isConstant() && !oldFixed) {
+
+      // Parameter changes floating -> constant : update only value if necessary
+      if (oldVar!=par->getVal()) {
+	parameters[index].SetValue(par->getVal());
+	if (verbose) {
+          sinfo << "MinimizerFcn::synchronize: value of parameter " << par->GetName() 
+                << " changed from " << oldVar << " to " << par->getVal() << endmsg ;
+	}
+      }
+      parameters[index].Fix();
+      constStatChange=kTRUE ;
+      if (verbose) {
+        sinfo << "MinimizerFcn::synchronize: parameter " << par->GetName() << " is now fixed." << endmsg ;
+      }
+
+    } else if (par->isConstant() && oldFixed) {
+      
+      // Parameter changes constant -> constant : update only value if necessary
+      if (oldVar!=par->getVal()) {
+	parameters[index].SetValue(par->getVal());
+	constValChange=kTRUE ;
+
+	if (verbose) {
+          sinfo << "MinimizerFcn::synchronize: value of fixed parameter " << par->GetName() 
+                << " changed from " << oldVar << " to " << par->getVal() << endmsg ;
+	}
+      }
+
+    } else {
+      // Parameter changes constant -> floating
+      if (!par->isConstant() && oldFixed) {
+	parameters[index].Release();
+	constStatChange=kTRUE ;
+	
+	if (verbose) {
+          sinfo << "MinimizerFcn::synchronize: parameter " << par->GetName() << " is now floating." << endmsg ;
+	}
+      } 
+
+      // Parameter changes constant -> floating : update all if necessary      
+      if (oldVar!=par->getVal() || oldVlo!=pmin || oldVhi != pmax || oldVerr!=pstep) {
+	parameters[index].SetValue(par->getVal()); 
+	parameters[index].SetStepSize(pstep);
+        if (par->hasMin() && par->hasMax() ) 
+           parameters[index].SetLimits(pmin,pmax);  
+        else if (par->hasMin() )
+           parameters[index].SetLowerLimit(pmin);  
+        else if (par->hasMax() )
+           parameters[index].SetUpperLimit(pmax);  
+      }
+
+      // Inform user about changes in verbose mode
+      if (verbose) {
+	// if ierr<0, par was moved from the const list and a message was already printed
+
+	if (oldVar!=par->getVal()) {
+          sinfo << "MinimizerFcn::synchronize: value of parameter " << par->GetName() 
+                << " changed from " << oldVar << " to " << par->getVal() << endmsg ;
+	}
+	if (oldVlo!=pmin || oldVhi!=pmax) {
+          sinfo << "MinimizerFcn::synchronize: limits of parameter " << par->GetName() 
+                << " changed from [" << oldVlo << "," << oldVhi << "] to [" << pmin << "," << pmax << "]" << endmsg ;
+	}
+
+	// If oldVerr=0, then parameter was previously fixed
+	if (oldVerr!=pstep && oldVerr!=0) {
+          sinfo << "MinimizerFcn::synchronize: error/step size of parameter " << par->GetName() 
+                << " changed from " << oldVerr << " to " << pstep << endmsg ;
+	}
+      }      
+    }
+  }
+
+  if (optConst) {
+    if (constStatChange) {
+
+      RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::CollectErrors) ;
+
+      sinfo << "MinimizerFcn::synchronize: set of constant parameters changed, rerunning const optimizer" << endmsg ;
+      _funct->constOptimizeTestStatistic(RooAbsArg::ConfigChange) ;
+    } else if (constValChange) {
+      sinfo << "MinimizerFcn::synchronize: constant parameter values changed, rerunning const optimizer" << endmsg ;
+      _funct->constOptimizeTestStatistic(RooAbsArg::ValueChange) ;
+    }
+    
+    RooAbsReal::setEvalErrorLoggingMode(RooAbsReal::PrintErrors) ;  
+
+  }
+
+  updateFloatVec() ;
+
+  return 0 ;  
+
+}
+
+Double_t MinimizerFcn::GetPdfParamVal(Int_t index)
+{
+  // Access PDF parameter value by ordinal index (needed by MINUIT)
+
+  return ((RooRealVar*)_floatParamList->at(index))->getVal() ;
+}
+
+Double_t MinimizerFcn::GetPdfParamErr(Int_t index)
+{
+  // Access PDF parameter error by ordinal index (needed by MINUIT)
+  return ((RooRealVar*)_floatParamList->at(index))->getError() ;
+}
+
+
+void MinimizerFcn::SetPdfParamErr(Int_t index, Double_t value)
+{
+  // Modify PDF parameter error by ordinal index (needed by MINUIT)
+
+  ((RooRealVar*)_floatParamList->at(index))->setError(value) ;
+}
+
+
+
+void MinimizerFcn::ClearPdfParamAsymErr(Int_t index)
+{
+  // Modify PDF parameter error by ordinal index (needed by MINUIT)
+
+  ((RooRealVar*)_floatParamList->at(index))->removeAsymError() ;
+}
+
+
+void MinimizerFcn::SetPdfParamErr(Int_t index, Double_t loVal, Double_t hiVal)
+{
+  // Modify PDF parameter error by ordinal index (needed by MINUIT)
+
+  ((RooRealVar*)_floatParamList->at(index))->setAsymError(loVal,hiVal) ;
+}
+
+
+void MinimizerFcn::BackProp(const ROOT::Fit::FitResult &results)
+{
+  // Transfer MINUIT fit results back into RooFit objects
+
+  for (Int_t index= 0; index < _nDim; index++) {
+    Double_t value = results.Value(index);
+    SetPdfParamVal(index, value);
+
+    // Set the parabolic error    
+    Double_t err = results.Error(index);
+    SetPdfParamErr(index, err);
+    
+    Double_t eminus = results.LowerError(index);
+    Double_t eplus = results.UpperError(index);
+
+    if(eplus > 0 || eminus < 0) {
+      // Store the asymmetric error, if it is available
+      SetPdfParamErr(index, eminus,eplus);
+    } else {
+      // Clear the asymmetric error
+      ClearPdfParamAsymErr(index) ;
+    }
+  }
+
+}
+
+RooFitResult* MinimizerFcn::Save(const ROOT::Fit::FitResult &results, const char* name, const char* title)
+{
+  FitResultBuilder builder(name, title);
+  builder.Fill(*this, results);
+  return new RooFitResult(builder);
+}
+
+RooFitResult* MinimizerFcn::MinimizeSeeded(const std::vector<ROOT::Fit::ParameterSettings>& parameters, const TMatrixDSym& covariance, 
+                                           const ROOT::Math::MinimizerOptions& options, bool hesse, 
+                                           const std::vector<unsigned int>& minos_indices, const char* name, const char* title)
+{
+  if (static_cast<int>(parameters.size()) != _nDim || covariance.GetNrows() != _nDim) {
+    swarn << "MinimizerFcn::MinimizeSeeded: covariance matrix does not match the floating parameters" << endmsg ;
+    return NULL;
+  }
+
+  ROOT::Minuit2::MnUserParameters user_parameters;
+  for (unsigned int i=0; i<parameters.size(); ++i) {
+    const ROOT::Fit::ParameterSettings& par = parameters[i];
+    if (par.IsFixed()) {
+      swarn << "MinimizerFcn::MinimizeSeeded: parameter " << par.Name() << " is fixed" << endmsg ;
+      return NULL;
+    }
+    user_parameters.Add(par.Name(), par.Value(), par.StepSize());
+    if (par.HasLowerLimit()) user_parameters.SetLowerLimit(i, par.LowerLimit());
+    if (par.HasUpperLimit()) user_parameters.SetUpperLimit(i, par.UpperLimit());
+  }
+
+  // the state halves the matrix for its internal metric (error definition 
+  // 1), rescale to the error definition of the likelihood
+  ROOT::Minuit2::MnUserCovariance user_covariance(_nDim);
+  for (Int_t i=0; i<_nDim; ++i) {
+    for (Int_t j=0; j<=i; ++j) {
+      user_covariance(i,j) = covariance(i,j)/options.ErrorDef();
+    }
+  }
+  ROOT::Minuit2::MnUserParameterState state(user_parameters, user_covariance);
+
+  ROOT::Minuit2::MnStrategy strategy(options.Strategy());
+  ROOT::Minuit2::FCNAdapter<ROOT::Math::IMultiGenFunction> fcn_adapter(*this, options.ErrorDef());
+  ROOT::Minuit2::FCNGradAdapter<ROOT::Math::IMultiGradFunction> grad_adapter(*this, options.ErrorDef());
+  const bool gradient = NumAnalyticDerivatives() > 0;
+  const ROOT::Minuit2::FCNBase& fcn = gradient ? static_cast<const ROOT::Minuit2::FCNBase&>(grad_adapter) : fcn_adapter;
+
+  ROOT::Minuit2::FunctionMinimum minimum = gradient 
+      ? ROOT::Minuit2::MnMigrad(grad_adapter, state, strategy)(options.MaxFunctionCalls(), options.Tolerance())
+      : ROOT::Minuit2::MnMigrad(fcn_adapter, state, strategy)(options.MaxFunctionCalls(), options.Tolerance());
+  if (hesse && minimum.IsValid()) {
+    ROOT::Minuit2::MnHesse hesse_algo(strategy);
+    hesse_algo(fcn, minimum, options.MaxFunctionCalls());
+  }
+
+  std::vector<std::pair<double,double> > minos_errors(_nDim, std::make_pair(0.0, 0.0));
+  if (minimum.IsValid()) {
+    ROOT::Minuit2::MnMinos minos(fcn, minimum, strategy);
+    for (unsigned int index : minos_indices) {
+      if (static_cast<Int_t>(index) >= _nDim) continue;
+      ROOT::Minuit2::MinosError error = minos.Minos(index, options.MaxFunctionCalls());
+      minos_errors[index] = std::make_pair(error.Lower(), error.Upper());
+    }
+  }
+
+  // status codes as in Minuit2Minimizer
+  int status = 0;
+  if (!minimum.IsValid()) {
+    status = 5;
+    if (minimum.HasMadePosDefCovar()) status = 1;
+    if (minimum.HesseFailed()) status = 2;
+    if (minimum.IsAboveMaxEdm()) status = 3;
+    if (minimum.HasReachedCallLimit()) status = 4;
+  }
+  int cov_status = -1;
+  if (minimum.HasAccurateCovar()) {
+    cov_status = 3;
+  } else if (minimum.HasMadePosDefCovar()) {
+    cov_status = 2;
+  } else if (minimum.HasValidCovariance()) {
+    cov_status = 1;
+  } else if (minimum.HasCovariance()) {
+    cov_status = 0;
+  }
+
+  // transfer results back into RooFit objects (see BackProp(...))
+  const ROOT::Minuit2::MnUserParameterState& result = minimum.UserState();
+  for (Int_t index= 0; index < _nDim; index++) {
+    SetPdfParamVal(index, result.Value(index));
+    SetPdfParamErr(index, result.Error(index));
+
+    Double_t eminus = minos_errors[index].first;
+    Double_t eplus = minos_errors[index].second;
+    if(eplus > 0 || eminus < 0) {
+      SetPdfParamErr(index, eminus,eplus);
+    } else {
+      ClearPdfParamAsymErr(index) ;
+    }
+  }
+
+  FitResultBuilder builder(name, title);
+  builder.Fill(*this, minimum, status, cov_status);
+  return new RooFitResult(builder);
+}
+
+Bool_t MinimizerFcn::SetLogFile(const char* inLogfile) 
+{
+  // Change the file name for logging of a RooMinimizer of all MINUIT steppings
+  // through the parameter space. If inLogfile is null, the current log file
+  // is closed and logging is stopped.
+
+  if (_logfile) {
+    sinfo << "MinimizerFcn::setLogFile: closing previous log file" << endmsg ;
+    _logfile->close() ;
+    delete _logfile ;
+    _logfile = 0 ;
+  }
+  _logfile = new ofstream(inLogfile) ;
+  if (!_logfile->good()) {
+    sinfo << "MinimizerFcn::setLogFile: cannot open file " << inLogfile << endmsg ;
+    _logfile->close() ;
+    delete _logfile ;
+    _logfile= 0;
+  }  
+  
+  return kFALSE ;
+
+}
+
+
+void MinimizerFcn::ApplyCovarianceMatrix(TMatrixDSym& V) 
+{
+  // Apply results of given external covariance matrix. i.e. propagate its errors
+  // to all RRV parameter representations and give this matrix instead of the
+  // HESSE matrix at the next save() call
+
+  for (Int_t i=0 ; i<_nDim ; i++) {
+    // Skip fixed parameters
+    if (_floatParamList->at(i)->isConstant()) {
+      continue ;
+    }
+    SetPdfParamErr(i, sqrt(V(i,i))) ;		  
+  }
+
+}
+
+
+Bool_t MinimizerFcn::SetPdfParamVal(const Int_t &index, const Double_t &value) const
+{
+  RooRealVar* par = (RooRealVar*)_floatParamVec[index] ;
+
+  if (par->getVal()!=value) {
+    if (_verbose) cout << par->GetName() << "=" << value << ", " ;
+    
+    par->setVal(value);
+    return kTRUE;
+  }
+
+  return kFALSE;
+}
+
+
+
+//_____________________________________________________________________________
+void MinimizerFcn::updateFloatVec() 
+{
+  _floatParamVec.clear() ;
+  RooFIter iter = _floatParamList->fwdIterator() ;
+  RooAbsArg* arg ;
+  _floatParamVec = std::vector<RooAbsArg*>(_floatParamList->getSize()) ;
+  Int_t i(0) ;
+  while((arg=iter.next())) {
+    _floatParamVec[i++] = arg ;
+  }
+}
+
+
+
+double MinimizerFcn::DoEval(const double *x) const 
+{
+
+  // Set the parameter values for this iteration
+  for (int index = 0; index < _nDim; index++) {
+    if (_logfile) (*_logfile) << x[index] << " " ;
+    SetPdfParamVal(index,x[index]);
+  }
+
+  // Calculate the function for these parameters  
+  auto t_start = std::chrono::high_resolution_clock::now();
+  RooAbsReal::setHideOffset(kFALSE) ;
+  double fvalue = _funct->getVal();
+  RooAbsReal::setHideOffset(kTRUE) ;
+  auto t_end = std::chrono::high_resolution_clock::now();
+
+  if (RooAbsPdf::evalError() || RooAbsReal::numEvalErrors()>0 || fvalue>1e30) {
+
+    if (_printEvalErrors>=0) {
+
+      if (_doEvalErrorWall) {
+        swarn << "MinimizerFcn: Minimized function has error status." << endmsg;
+        swarn << "Returning maximum FCN so far (" << _maxFCN 
+              << ") to force MIGRAD to back out of this region. Error log follows" << endmsg ;
+      } else {
+        swarn << "MinimizerFcn: Minimized function has error status but is ignored" << endmsg ;
+      } 
+
+      TIterator* iter = _floatParamList->createIterator() ;
+      RooRealVar* var ;
+      Bool_t first(kTRUE) ;
+      swarn << "Parameter values: " ;
+      while((var=(RooRealVar*)iter->Next())) {
+        if (first) { first = kFALSE ; } else swarn << ", " ;
+        swarn << var->GetName() << "=" << var->getVal() ;
+      }
+      delete iter ;
+      swarn << endmsg ;
+      
+      RooAbsReal::printEvalErrors(cout,_printEvalErrors) ;
+    } 
+
+    if (_doEvalErrorWall) {
+      fvalue = _maxFCN+1 ;
+    }
+
+    RooAbsPdf::clearEvalError() ;
+    RooAbsReal::clearEvalErrorLog() ;
+    _counters->numBadNLL++ ;
+  } else if (fvalue>_maxFCN) {
+    _maxFCN = fvalue ;
+  }
+      
+  // Optional logging
+  if (_logfile) 
+    (*_logfile) << setprecision(15) << fvalue << setprecision(4) << endl;
+  if (_verbose) {
+    cout << "\nprevFCN" << (_funct->isOffsetting()?"-offset":"") << " = " << setprecision(10) 
+         << fvalue << setprecision(4) << "  " ;
+    cout.flush() ;
+  }
+
+  _counters->evalCounter++ ;
+
+  if (_profiler) _profiler->Sample(std::chrono::duration<double>(t_end - t_start).count());
+
+  return fvalue;
+}
+
+void MinimizerFcn::SetAnalyticGradient(RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables)
+{
+  delete _gradObs;
+  delete _gradObsSaved;
+  _gradPdf  = &pdf;
+  _gradData = &data;
+  _gradObs  = pdf.getObservables(data);
+  _gradObsSaved = (RooArgSet*)_gradObs->snapshot(kFALSE);
+  _gradNormSet.removeAll();
+  _gradNormSet.add(*_gradObs);
+  if (conditional_observables != NULL) {
+    _gradNormSet.remove(*conditional_observables, kFALSE, kTRUE);
+  }
+  _gradX.clear();
+
+  // availability of derivatives only depends on the structure of the PDF, 
+  // so the first event is representative
+  _analytic.assign(_nDim, false);
+  if (data.numEntries() > 0) {
+    _gradObsSaved->assignValueOnly(*_gradObs);
+    _gradObs->assignValueOnly(*data.get(0));
+
+    doofit::roofit::functions::AbsAnalyticGradient::Prepare(pdf, *_floatParamList, &_gradNormSet);
+    doofit::roofit::functions::AbsAnalyticGradient::Gradient(pdf, *_floatParamList, &_gradNormSet, _gradEvent, _gradEventAvailable);
+    for (int index = 0; index < _nDim; index++) {
+      _analytic[index] = _gradEventAvailable[index];
+    }
+
+    _gradObs->assignValueOnly(*_gradObsSaved);
+  }
+}
+
+unsigned int MinimizerFcn::NumAnalyticDerivatives() const
+{
+  if (_gradPdf == NULL) return 0;
+  return std::count(_analytic.begin(), _analytic.end(), true);
+}
+
+void MinimizerFcn::AnalyticDerivatives(std::vector<double>& grad) const
+{
+  _gradObsSaved->assignValueOnly(*_gradObs);
+
+  // normalisation and everything else not depending on the observables
+  doofit::roofit::functions::AbsAnalyticGradient::Prepare(*_gradPdf, *_floatParamList, &_gradNormSet);
+  for (int i = 0; i < _gradData->numEntries(); ++i) {
+    _gradObs->assignValueOnly(*_gradData->get(i));
+    const double weight = _gradData->weight();
+    if (weight == 0) continue;
+
+    // d(-w log f)/dp = -w/f df/dp
+    const double value = _gradPdf->getVal(&_gradNormSet);
+    doofit::roofit::functions::AbsAnalyticGradient::Gradient(*_gradPdf, *_floatParamList, &_gradNormSet, _gradEvent, _gradEventAvailable);
+    for (int index = 0; index < _nDim; index++) {
+      if (IsAnalytic(index)) grad[index] -= weight*_gradEvent[index]/value;
+    }
+  }
+
+  _gradObs->assignValueOnly(*_gradObsSaved);
+}
+
+void MinimizerFcn::Gradient(const double* x, double* grad) const
+{
+  UpdateGradient(x);
+  std::copy(_grad.begin(), _grad.end(), grad);
+}
+
+void MinimizerFcn::UpdateGradient(const double* x) const
+{
+  if (_gradX.size() == static_cast<size_t>(_nDim) && std::equal(_gradX.begin(), _gradX.end(), x)) {
+    return;
+  }
+
+  for (int index = 0; index < _nDim; index++) {
+    SetPdfParamVal(index,x[index]);
+  }
+
+  _grad.assign(_nDim, 0.);
+  if (NumAnalyticDerivatives() > 0) {
+    AnalyticDerivatives(_grad);
+  }
+
+  // central differences for all other parameters (one-sided at limits)
+  _gradXStep.assign(x, x+_nDim);
+  for (int index = 0; index < _nDim; index++) {
+    if (IsAnalytic(index)) continue;
+
+    const RooRealVar* par = (const RooRealVar*)_floatParamVec[index];
+    const double step = (index < Int_t(_gradSteps.size()) && _gradSteps[index] > 0) ? _gradSteps[index] : 1e-6*(1.+std::abs(x[index]));
+    double x_up   = x[index]+step;
+    double x_down = x[index]-step;
+    if (par->hasMax() && x_up > par->getMax()) x_up = x[index];
+    if (par->hasMin() && x_down < par->getMin()) x_down = x[index];
+    if (x_up == x_down) continue;
+
+    _gradXStep[index] = x_up;
+    const double f_up = DoEval(&_gradXStep[0]);
+    _gradXStep[index] = x_down;
+    const double f_down = DoEval(&_gradXStep[0]);
+    _gradXStep[index] = x[index];
+    SetPdfParamVal(index,x[index]);
+
+    _grad[index] = (f_up-f_down)/(x_up-x_down);
+  }
+
+  _counters->gradientCounter++ ;
+  _gradX.assign(x, x+_nDim);
+}
+
+double MinimizerFcn::DoDerivative(const double* x, unsigned int icoord) const
+{
+  UpdateGradient(x);
+  return _grad[icoord];
+}
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
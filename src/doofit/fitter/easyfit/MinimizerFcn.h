@@ -0,0 +1,240 @@
+/*****************************************************************************
+ * Project: RooFit                                                           *
+ * Package: RooFitCore                                                       * 
+ * @(#)root/roofitcore:$Id$
+ * Authors:                                                                  *
+ *   AL, Alfio Lazzaro,   INFN Milan,        alfio.lazzaro@mi.infn.it        *
+ *                                                                           *
+ *                                                                           *
+ * Redistribution and use in source and binary forms,                        *
+ * with or without modification, are permitted according to the terms        *
+ * listed in LICENSE (http://roofit.sourceforge.net/license.txt)             *
+ *****************************************************************************/
+
+#ifndef DOOFIT_FITTER_EASYFIT_MINIMIZERFCN_H
+#define DOOFIT_FITTER_EASYFIT_MINIMIZERFCN_H
+
+// from STL
+#include <vector>
+#include <memory>
+#include <fstream>
+
+// from ROOT
+#include "Math/IFunction.h"
+#include "Fit/ParameterSettings.h"
+#include "Fit/FitResult.h"
+#include "Math/MinimizerOptions.h"
+#include "TMatrixDSym.h"
+
+// from RooFit
+#include "RooAbsReal.h"
+#include "RooArgList.h"
+#include "RooArgSet.h"
+
+// forward declarations
+class RooAbsPdf;
+class RooAbsData;
+class RooFitResult;
+
+/** @class doofit::fitter::easyfit::MinimizerFcn
+ *  @brief Minuit interface to a RooFit likelihood with analytic gradients
+ *
+ *  This is RooFit's RooMinimizerFcn turned into a gradient function for 
+ *  ROOT::Fit::Fitter. Minuit2 then runs in gradient mode and calls 
+ *  Gradient(...) instead of doing two numerical function calls per 
+ *  parameter and gradient.
+ *
+ *  After SetAnalyticGradient(...), derivatives of the negative log-likelihood 
+ *  -sum w_i log f(x_i) are calculated in one pass over the data for all 
+ *  parameters for which the PDF provides analytic derivatives (see 
+ *  doofit::roofit::functions::AbsAnalyticGradient). Only the PDF itself is 
+ *  asked for derivatives, so PDFs combined via RooAddPdf, RooProdPdf or 
+ *  RooBDecay have none. Derivatives for all other parameters are central 
+ *  differences of the likelihood (counted as FCN calls).
+ *
+ *  Counters (function and gradient calls, invalid likelihood evaluations) 
+ *  are shared with all clones, so they include calls made on the copy the 
+ *  fitter works on.
+ *
+ *  EasyFit uses this class via EasyFit::SetMinimizerBackend(...).
+ */
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+class EvaluationProfiler;
+
+class MinimizerFcn : public ROOT::Math::IMultiGradFunction {
+
+ public:
+
+  MinimizerFcn(RooAbsReal *funct, bool verbose = false);
+  MinimizerFcn(const MinimizerFcn& other);
+  virtual ~MinimizerFcn();
+
+  virtual ROOT::Math::IBaseFunctionMultiDim* Clone() const;
+  virtual unsigned int NDim() const { return _nDim; }
+
+  RooArgList* GetFloatParamList() { return _floatParamList; }
+  RooArgList* GetConstParamList() { return _constParamList; }
+  RooArgList* GetInitFloatParamList() { return _initFloatParamList; }
+  RooArgList* GetInitConstParamList() { return _initConstParamList; }
+
+  void SetEvalErrorWall(Bool_t flag) { _doEvalErrorWall = flag ; }
+  void SetPrintEvalErrors(Int_t numEvalErrors) { _printEvalErrors = numEvalErrors ; }
+  Bool_t SetLogFile(const char* inLogfile);
+  std::ofstream* GetLogFile() { return _logfile; }
+  void SetVerbose(Bool_t flag=kTRUE) { _verbose = flag ; }
+
+  Double_t& GetMaxFCN() { return _maxFCN; }
+  Int_t GetNumInvalidNLL() { return _counters->numBadNLL; }
+
+  Bool_t Synchronize(std::vector<ROOT::Fit::ParameterSettings>& parameters, 
+		     Bool_t optConst, Bool_t verbose);
+  void BackProp(const ROOT::Fit::FitResult &results);  
+  void ApplyCovarianceMatrix(TMatrixDSym& V); 
+
+  /**
+   *  @brief Create a RooFitResult from the result of the fitter
+   *
+   *  Call after BackProp(...). This is the equivalent of RooMinimizer::save().
+   *
+   *  @param results result of the fitter
+   *  @param name name of the fit result
+   *  @param title title of the fit result
+   *  @return the fit result (caller takes ownership)
+   */
+  RooFitResult* Save(const ROOT::Fit::FitResult &results, const char* name, const char* title);
+
+  /**
+   *  @brief Minimise with MIGRAD seeded with a covariance matrix
+   *
+   *  ROOT::Fit::Fitter cannot pass an initial covariance matrix to Minuit2. 
+   *  Here, MIGRAD runs directly on a ROOT::Minuit2::MnUserParameterState 
+   *  built from the parameter settings and the covariance matrix, i.e. it 
+   *  starts with the inverse of the matrix as metric instead of building 
+   *  one from the step sizes. HESSE and MINOS are run as requested. The 
+   *  result is transferred back into the RooFit parameters like BackProp(...).
+   *
+   *  @param parameters parameter settings (see Synchronize(...)), none fixed
+   *  @param covariance covariance matrix in the order of GetFloatParamList()
+   *  @param options strategy, tolerance, maximum calls and error definition
+   *  @param hesse whether to run HESSE after MIGRAD
+   *  @param minos_indices indices of parameters to run MINOS for
+   *  @param name name of the fit result
+   *  @param title title of the fit result
+   *  @return the fit result (caller takes ownership, NULL if the covariance matrix does not match the parameters)
+   */
+  RooFitResult* MinimizeSeeded(const std::vector<ROOT::Fit::ParameterSettings>& parameters, const TMatrixDSym& covariance, 
+                               const ROOT::Math::MinimizerOptions& options, bool hesse, 
+                               const std::vector<unsigned int>& minos_indices, const char* name, const char* title);
+
+  Int_t evalCounter() const { return _counters->evalCounter ; }
+  Int_t gradientCounter() const { return _counters->gradientCounter ; }
+  void zeroEvalCount() { _counters->evalCounter = 0 ; _counters->gradientCounter = 0 ; }
+
+  /**
+   *  @brief Enable analytic derivatives of -sum w_i log f(x_i)
+   *
+   *  Only call this if the minimised function is exactly the plain negative 
+   *  log-likelihood of pdf on data (no extended term or constraints, offsets 
+   *  are fine).
+   *
+   *  @param pdf the PDF
+   *  @param data the dataset
+   *  @param conditional_observables conditional observables (not normalised over, can be NULL)
+   */
+  void SetAnalyticGradient(RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables);
+
+  /**
+   *  @brief Number of parameters with analytic derivatives
+   */
+  unsigned int NumAnalyticDerivatives() const;
+
+  /**
+   *  @brief Time each FCN call and pass it to an evaluation profiler
+   *
+   *  @param profiler the profiler (not owned, NULL to disable)
+   */
+  void SetProfiler(EvaluationProfiler* profiler) { _profiler = profiler; }
+
+  virtual void Gradient(const double* x, double* grad) const;
+
+ private:
+  
+  Double_t GetPdfParamVal(Int_t index);
+  Double_t GetPdfParamErr(Int_t index);
+  void SetPdfParamErr(Int_t index, Double_t value);
+  void ClearPdfParamAsymErr(Int_t index);
+  void SetPdfParamErr(Int_t index, Double_t loVal, Double_t hiVal);
+
+  inline Bool_t SetPdfParamVal(const Int_t &index, const Double_t &value) const;
+
+  virtual double DoEval(const double * x) const;  
+  virtual double DoDerivative(const double * x, unsigned int icoord) const;
+  void updateFloatVec() ;
+
+  /**
+   *  @brief Add analytic derivatives at the current parameter values to grad
+   */
+  void AnalyticDerivatives(std::vector<double>& grad) const;
+
+  /**
+   *  @brief Calculate the gradient at x into _grad (unless already done)
+   */
+  void UpdateGradient(const double* x) const;
+
+  bool IsAnalytic(int index) const { return _gradPdf != NULL && index < static_cast<int>(_analytic.size()) && _analytic[index]; }
+
+  /**
+   *  @brief Counters shared by all clones
+   */
+  struct Counters {
+    Int_t evalCounter;
+    Int_t gradientCounter;
+    Int_t numBadNLL;
+  };
+
+private:
+
+  std::shared_ptr<Counters> _counters;
+  
+  RooAbsReal *_funct;
+
+  mutable double _maxFCN;
+  mutable int _printEvalErrors;
+  Bool_t _doEvalErrorWall;
+
+  int _nDim;
+  std::ofstream *_logfile;
+  bool _verbose;
+
+  RooArgList* _floatParamList;
+  std::vector<RooAbsArg*> _floatParamVec ;
+  RooArgList* _constParamList;
+  RooArgList* _initFloatParamList;
+  RooArgList* _initConstParamList;
+
+  RooAbsPdf* _gradPdf;                   ///< PDF for analytic derivatives (NULL if disabled)
+  RooAbsData* _gradData;                 ///< dataset for analytic derivatives
+  RooArgSet* _gradObs;                   ///< observables of _gradPdf in _gradData
+  RooArgSet* _gradObsSaved;              ///< observable values before a pass over the data
+  RooArgSet _gradNormSet;                ///< normalisation set of _gradPdf
+  std::vector<bool> _analytic;           ///< whether derivative of a parameter is analytic
+  std::vector<double> _gradSteps;        ///< step sizes for numerical derivatives
+  mutable std::vector<double> _gradX;    ///< parameters of last gradient
+  mutable std::vector<double> _grad;     ///< last gradient
+  mutable std::vector<double> _gradXStep;          ///< parameters for numerical derivatives
+  mutable std::vector<double> _gradEvent;          ///< derivatives of the PDF for one event
+  mutable std::vector<bool> _gradEventAvailable;   ///< availability of derivatives for one event
+
+  EvaluationProfiler* _profiler;         ///< profiler of FCN calls (not owned, NULL if disabled)
+
+};
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
+
+#endif // DOOFIT_FITTER_EASYFIT_MINIMIZERFCN_H
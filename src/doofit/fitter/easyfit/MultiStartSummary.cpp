@@ -0,0 +1,141 @@
+#include "MultiStartSummary.h"
+
+// from STL
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// from ROOT
+#include "TIterator.h"
+
+// from RooFit
+#include "RooFitResult.h"
+#include "RooRealVar.h"
+#include "RooArgList.h"
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+
+using doocore::io::sinfo;
+using doocore::io::endmsg;
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+MultiStartSummary::MultiStartSummary()
+    : minima_()
+{}
+
+void MultiStartSummary::AddMinimum(unsigned int index, const std::map<std::string, double>& start_values, const RooFitResult* fit_result) {
+  Minimum minimum;
+  minimum.index        = index;
+  minimum.valid        = (fit_result != NULL);
+  minimum.status       = -1;
+  minimum.cov_qual     = -1;
+  minimum.min_nll      = std::numeric_limits<double>::quiet_NaN();
+  minimum.edm          = std::numeric_limits<double>::quiet_NaN();
+  minimum.start_values = start_values;
+
+  if (fit_result != NULL) {
+    minimum.status   = fit_result->status();
+    minimum.cov_qual = fit_result->covQual();
+    minimum.min_nll  = fit_result->minNll();
+    minimum.edm      = fit_result->edm();
+
+    TIterator* it = fit_result->floatParsFinal().createIterator();
+    RooRealVar* par = NULL;
+    while ((par = dynamic_cast<RooRealVar*>(it->Next())) != NULL) {
+      minimum.final_values[par->GetName()] = par->getVal();
+    }
+    delete it;
+  }
+
+  minima_.push_back(minimum);
+}
+
+int MultiStartSummary::best_index() const {
+  int best = -1;
+  for (unsigned int i=0; i<minima_.size(); ++i) {
+    const Minimum& minimum = minima_[i];
+    if (!minimum.valid || std::isnan(minimum.min_nll)) continue;
+    if (best < 0) {
+      best = i;
+      continue;
+    }
+    // successful fits always win over failed ones
+    bool converged      = Converged(minimum);
+    bool best_converged = Converged(minima_[best]);
+    if ((converged && !best_converged) || (converged == best_converged && minimum.min_nll < minima_[best].min_nll)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+unsigned int MultiStartSummary::NumConverged() const {
+  return std::count_if(minima_.begin(), minima_.end(), Converged);
+}
+
+unsigned int MultiStartSummary::NumDistinctMinima(double tolerance) const {
+  std::vector<double> fcn_values;
+  for (const Minimum& minimum : minima_) {
+    if (Converged(minimum)) fcn_values.push_back(minimum.min_nll);
+  }
+  std::sort(fcn_values.begin(), fcn_values.end());
+
+  unsigned int num_distinct = 0;
+  for (unsigned int i=0; i<fcn_values.size(); ++i) {
+    if (i == 0 || fcn_values[i]-fcn_values[i-1] >= tolerance) ++num_distinct;
+  }
+  return num_distinct;
+}
+
+std::pair<double, double> MultiStartSummary::ParameterSpread(const std::string& name) const {
+  double sum   = 0.0;
+  double sum_2 = 0.0;
+  unsigned int num = 0;
+  for (const Minimum& minimum : minima_) {
+    if (!Converged(minimum)) continue;
+    std::map<std::string, double>::const_iterator it = minimum.final_values.find(name);
+    if (it == minimum.final_values.end()) continue;
+    sum   += it->second;
+    sum_2 += it->second*it->second;
+    ++num;
+  }
+  if (num == 0) {
+    return std::make_pair(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+  }
+  double mean = sum/num;
+  return std::make_pair(mean, std::sqrt(std::max(sum_2/num - mean*mean, 0.0)));
+}
+
+void MultiStartSummary::Print() const {
+  int best = best_index();
+  sinfo << "Multi-start fit: " << minima_.size() << " start points, " << NumConverged() << " converged, "
+        << NumDistinctMinima() << " distinct minima." << endmsg;
+  for (unsigned int i=0; i<minima_.size(); ++i) {
+    const Minimum& minimum = minima_[i];
+    sinfo << "  Start " << minimum.index << ": ";
+    if (minimum.valid) {
+      sinfo << "FCN = " << minimum.min_nll << ", status = " << minimum.status
+            << ", cov. quality = " << minimum.cov_qual << ", EDM = " << minimum.edm;
+    } else {
+      sinfo << "no result";
+    }
+    if (static_cast<int>(i) == best) sinfo << " (best)";
+    sinfo << endmsg;
+  }
+
+  if (best >= 0 && NumConverged() > 0) {
+    sinfo << "Parameter spread over converged minima (mean +/- std. dev., best):" << endmsg;
+    for (const auto& value : minima_[best].final_values) {
+      std::pair<double, double> spread = ParameterSpread(value.first);
+      sinfo << "  " << value.first << ": " << spread.first << " +/- " << spread.second << ", " << value.second << endmsg;
+    }
+  }
+}
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
@@ -0,0 +1,153 @@
+#ifndef DOOFIT_FITTER_EASYFIT_MULTISTARTSUMMARY_H
+#define DOOFIT_FITTER_EASYFIT_MULTISTARTSUMMARY_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+// from ROOT
+
+// from RooFit
+
+// forward declarations
+class RooFitResult;
+
+/** @class doofit::fitter::easyfit::MultiStartSummary
+ *  @brief Summary of all minima found in a multi-start fit
+ *
+ *  For each start point of a multi-start fit (see
+ *  EasyFit::SetMultiStart(int, EasyFit::MultiStartMode, unsigned int)), the
+ *  start values, the minimum found (FCN value, status, covariance quality,
+ *  EDM) and the final parameter values are stored. Based on these, the best
+ *  minimum, the number of distinct minima and the spread of parameters
+ *  over converged minima can be determined.
+ */
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+class MultiStartSummary {
+ public:
+  /**
+   *  @brief One minimum found from one start point
+   */
+  struct Minimum {
+    /**
+     *  @brief Index of the start point
+     */
+    unsigned int index;
+
+    /**
+     *  @brief Whether the fit delivered a result at all
+     */
+    bool valid;
+
+    /**
+     *  @brief Fit status (0 for successful minimisation)
+     */
+    int status;
+
+    /**
+     *  @brief Quality of the covariance matrix
+     */
+    int cov_qual;
+
+    /**
+     *  @brief FCN value at the minimum
+     */
+    double min_nll;
+
+    /**
+     *  @brief Estimated distance to minimum
+     */
+    double edm;
+
+    /**
+     *  @brief Start values of floating parameters
+     */
+    std::map<std::string, double> start_values;
+
+    /**
+     *  @brief Final values of floating parameters
+     */
+    std::map<std::string, double> final_values;
+  };
+
+  /**
+   *  @brief Default constructor for an empty summary
+   */
+  MultiStartSummary();
+
+  /**
+   *  @brief Add a minimum from a fit result
+   *
+   *  @param index index of the start point
+   *  @param start_values start values of floating parameters
+   *  @param fit_result the fit result (NULL if the fit failed)
+   */
+  void AddMinimum(unsigned int index, const std::map<std::string, double>& start_values, const RooFitResult* fit_result);
+
+  /**
+   *  @brief All minima ordered by start point
+   */
+  const std::vector<Minimum>& minima() const { return minima_; }
+
+  /**
+   *  @brief Index (in minima()) of the best minimum
+   *
+   *  The best minimum is the one with the lowest FCN value among successful
+   *  fits (status 0). If no fit succeeded, the lowest FCN value of all valid
+   *  fits is taken.
+   *
+   *  @return the index or -1 if there is no valid minimum
+   */
+  int best_index() const;
+
+  /**
+   *  @brief Number of successful fits (status 0)
+   */
+  unsigned int NumConverged() const;
+
+  /**
+   *  @brief Number of distinct minima among successful fits
+   *
+   *  Minima are considered the same if their FCN values differ by less than
+   *  @a tolerance.
+   *
+   *  @param tolerance maximum FCN difference of identical minima
+   */
+  unsigned int NumDistinctMinima(double tolerance=1e-3) const;
+
+  /**
+   *  @brief Spread of a parameter over successful fits
+   *
+   *  @param name name of the parameter
+   *  @return pair of mean and standard deviation of final values
+   */
+  std::pair<double, double> ParameterSpread(const std::string& name) const;
+
+  /**
+   *  @brief Print all minima and the parameter spreads
+   */
+  void Print() const;
+
+ private:
+  /**
+   *  @brief Whether a minimum counts as successful
+   */
+  static bool Converged(const Minimum& minimum) { return minimum.valid && minimum.status == 0; }
+
+  /**
+   *  @brief All minima
+   */
+  std::vector<Minimum> minima_;
+};
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
+
+#endif // DOOFIT_FITTER_EASYFIT_MULTISTARTSUMMARY_H
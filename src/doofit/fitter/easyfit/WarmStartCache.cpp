@@ -0,0 +1,135 @@
+#include "WarmStartCache.h"
+
+// from STL
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+
+// from ROOT
+#include "TIterator.h"
+
+// from RooFit
+#include "RooAbsPdf.h"
+#include "RooFitResult.h"
+#include "RooRealVar.h"
+#include "RooArgList.h"
+
+// from DooCore
+#include <doocore/io/MsgStream.h>
+
+using doocore::io::sinfo;
+using doocore::io::endmsg;
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+WarmStartCache::WarmStartCache()
+    : entries_()
+    , num_seeded_fits_(0)
+    , num_cold_fits_(0)
+    , num_fcn_calls_saved_(0)
+{}
+
+std::string WarmStartCache::Key(const RooAbsPdf& pdf, const RooArgList& floating_parameters) {
+  std::stringstream key;
+  key << &pdf << ":" << pdf.GetName();
+
+  // independent of the order of parameters
+  RooArgList parameters(floating_parameters);
+  parameters.sort();
+  TIterator* it = parameters.createIterator();
+  RooAbsArg* arg = NULL;
+  while ((arg = dynamic_cast<RooAbsArg*>(it->Next())) != NULL) {
+    key << ":" << arg->GetName();
+  }
+  delete it;
+  return key.str();
+}
+
+const WarmStartCache::Entry* WarmStartCache::Seed(const std::string& key, const RooArgList& floating_parameters) const {
+  std::map<std::string, Entry>::const_iterator it_entry = entries_.find(key);
+  if (it_entry == entries_.end()) {
+    return NULL;
+  }
+  const Entry& entry = it_entry->second;
+
+  for (unsigned int i=0; i<entry.parameter_names.size(); ++i) {
+    RooRealVar* par = dynamic_cast<RooRealVar*>(floating_parameters.find(entry.parameter_names[i].c_str()));
+    if (par == NULL) continue;
+    par->setVal(entry.values[i]);
+    // MINUIT takes initial step sizes (and thereby its initial metric) from 
+    // the parameter errors
+    if (entry.covariance(i,i) > 0.0) {
+      par->setError(std::sqrt(entry.covariance(i,i)));
+    }
+  }
+  return &entry;
+}
+
+bool WarmStartCache::Covariance(const Entry& entry, const RooArgList& parameters, TMatrixDSym& covariance) {
+  std::vector<int> indices;
+  for (int i=0; i<parameters.getSize(); ++i) {
+    std::vector<std::string>::const_iterator it_name = std::find(entry.parameter_names.begin(), entry.parameter_names.end(), 
+                                                                 parameters.at(i)->GetName());
+    if (it_name == entry.parameter_names.end()) return false;
+    indices.push_back(it_name - entry.parameter_names.begin());
+  }
+
+  covariance.ResizeTo(indices.size(), indices.size());
+  for (unsigned int i=0; i<indices.size(); ++i) {
+    for (unsigned int j=0; j<indices.size(); ++j) {
+      covariance(i,j) = entry.covariance(indices[i], indices[j]);
+    }
+  }
+  return true;
+}
+
+void WarmStartCache::Store(const std::string& key, const RooFitResult& fit_result, int num_fcn_calls) {
+  if (fit_result.status() != 0 || fit_result.covQual() < 1) {
+    return;
+  }
+
+  const RooArgList& parameters = fit_result.floatParsFinal();
+  const TMatrixDSym& covariance = fit_result.covarianceMatrix();
+  if (covariance.GetNrows() != parameters.getSize()) {
+    return;
+  }
+
+  bool cold = (entries_.find(key) == entries_.end());
+  Entry& entry = entries_[key];
+  if (cold || entry.num_fcn_calls_cold < 0) {
+    entry.num_fcn_calls_cold = num_fcn_calls;
+  }
+
+  entry.parameter_names.clear();
+  entry.values.clear();
+  TIterator* it = parameters.createIterator();
+  RooRealVar* par = NULL;
+  while ((par = dynamic_cast<RooRealVar*>(it->Next())) != NULL) {
+    entry.parameter_names.push_back(par->GetName());
+    entry.values.push_back(par->getVal());
+  }
+  delete it;
+
+  entry.covariance.ResizeTo(covariance.GetNrows(), covariance.GetNrows());
+  entry.covariance = covariance;
+}
+
+void WarmStartCache::Count(const FitInfo& fit_info) {
+  if (fit_info.seeded) {
+    ++num_seeded_fits_;
+    num_fcn_calls_saved_ += fit_info.num_fcn_calls_saved();
+  } else {
+    ++num_cold_fits_;
+  }
+}
+
+void WarmStartCache::Print() const {
+  sinfo << "Warm-start cache: " << entries_.size() << " entries, " << num_seeded_fits_ << " seeded fits, " 
+        << num_cold_fits_ << " cold fits, " << num_fcn_calls_saved_ << " FCN calls saved." << endmsg;
+}
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
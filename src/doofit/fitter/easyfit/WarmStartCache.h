@@ -0,0 +1,206 @@
+#ifndef DOOFIT_FITTER_EASYFIT_WARMSTARTCACHE_H
+#define DOOFIT_FITTER_EASYFIT_WARMSTARTCACHE_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+
+// from ROOT
+#include "TMatrixDSym.h"
+
+// from RooFit
+
+// forward declarations
+class RooAbsPdf;
+class RooArgList;
+class RooFitResult;
+
+/** @class doofit::fitter::easyfit::WarmStartCache
+ *  @brief Cache of previous minima to warm-start repeated fits
+ *
+ *  In toy loops and likelihood scans the same PDF is fitted many times and 
+ *  the minimum moves only slightly. For each PDF and set of floating 
+ *  parameters, this cache keeps the last minimum and covariance matrix. 
+ *  EasyFit (see EasyFit::SetWarmStartCache(WarmStartCache*)) starts the next 
+ *  fit of the same PDF at this minimum and passes the full covariance matrix 
+ *  to Minuit2 as its initial metric (see Covariance(...) and 
+ *  MinimizerFcn::MinimizeSeeded(...)). Fits which cannot run via Minuit2 
+ *  directly only get the parabolic errors as initial step sizes.
+ *
+ *  The cache also counts FCN calls: the number of calls of the first 
+ *  (unseeded) fit of each entry is taken as reference for the calls saved 
+ *  by all following warm-started fits. The counters are not stored in the 
+ *  RooFitResult (which has no place for them), but are available per fit 
+ *  via EasyFit::GetWarmStartInfo() and in total via the cache.
+ *
+ *  The cache is not owned by EasyFit and can be shared by any number of 
+ *  EasyFit objects. The PDF is identified by its address and name, i.e. the 
+ *  cache must be cleared if a PDF is deleted and another one with the same 
+ *  name might be created at the same address.
+ */
+
+namespace doofit {
+namespace fitter {
+namespace easyfit {
+
+class WarmStartCache {
+ public:
+  /**
+   *  @brief Last minimum of one PDF and floating parameter set
+   */
+  struct Entry {
+    /**
+     *  @brief Names of floating parameters (in order of covariance matrix)
+     */
+    std::vector<std::string> parameter_names;
+
+    /**
+     *  @brief Parameter values at the minimum
+     */
+    std::vector<double> values;
+
+    /**
+     *  @brief Covariance matrix at the minimum
+     */
+    TMatrixDSym covariance;
+
+    /**
+     *  @brief FCN calls of the first (unseeded) fit
+     */
+    int num_fcn_calls_cold;
+  };
+
+  /**
+   *  @brief Warm-start information of one fit
+   */
+  struct FitInfo {
+    /**
+     *  @brief Whether the fit was seeded from the cache
+     */
+    bool seeded;
+
+    /**
+     *  @brief FCN calls of this fit (-1 if unknown)
+     */
+    int num_fcn_calls;
+
+    /**
+     *  @brief FCN calls of the unseeded reference fit (-1 if unknown)
+     */
+    int num_fcn_calls_cold;
+
+    /**
+     *  @brief FCN calls saved with respect to the reference fit
+     */
+    int num_fcn_calls_saved() const { 
+      return (seeded && num_fcn_calls >= 0 && num_fcn_calls_cold >= 0) ? num_fcn_calls_cold-num_fcn_calls : 0;
+    }
+  };
+
+  /**
+   *  @brief Default constructor for an empty cache
+   */
+  WarmStartCache();
+
+  /**
+   *  @brief Build the key of a PDF and its floating parameters
+   */
+  static std::string Key(const RooAbsPdf& pdf, const RooArgList& floating_parameters);
+
+  /**
+   *  @brief Set floating parameters to the cached minimum
+   *
+   *  Parameter values are set to the last minimum and parameter errors to the
+   *  square root of the diagonal of the last covariance matrix. The full 
+   *  matrix is obtained via Covariance(...).
+   *
+   *  @param key key as obtained by Key(...)
+   *  @param floating_parameters floating parameters to set
+   *  @return the cache entry (NULL if there is none and nothing was set)
+   */
+  const Entry* Seed(const std::string& key, const RooArgList& floating_parameters) const;
+
+  /**
+   *  @brief Get the cached covariance matrix in the order of given parameters
+   *
+   *  @param entry the cache entry (see Seed(...))
+   *  @param parameters parameters defining rows and columns of the matrix
+   *  @param covariance matrix to fill (resized)
+   *  @return whether all parameters are in the entry (covariance unchanged otherwise)
+   */
+  static bool Covariance(const Entry& entry, const RooArgList& parameters, TMatrixDSym& covariance);
+
+  /**
+   *  @brief Store the minimum of a fit
+   *
+   *  Fits without valid covariance matrix (or failed fits) are not stored.
+   *
+   *  @param key key as obtained by Key(...)
+   *  @param fit_result result of the fit
+   *  @param num_fcn_calls FCN calls of the fit (-1 if unknown)
+   */
+  void Store(const std::string& key, const RooFitResult& fit_result, int num_fcn_calls);
+
+  /**
+   *  @brief Record the outcome of a fit in the counters
+   */
+  void Count(const FitInfo& fit_info);
+
+  /**
+   *  @brief Remove all entries (counters are kept)
+   */
+  void Clear() { entries_.clear(); }
+
+  /**
+   *  @brief Number of cached entries
+   */
+  unsigned int size() const { return entries_.size(); }
+
+  /**
+   *  @brief Number of fits seeded from the cache
+   */
+  unsigned int num_seeded_fits() const { return num_seeded_fits_; }
+
+  /**
+   *  @brief Number of fits not seeded from the cache
+   */
+  unsigned int num_cold_fits() const { return num_cold_fits_; }
+
+  /**
+   *  @brief Total FCN calls saved by seeded fits
+   */
+  long long num_fcn_calls_saved() const { return num_fcn_calls_saved_; }
+
+  /**
+   *  @brief Print counters
+   */
+  void Print() const;
+
+ private:
+  /**
+   *  @brief Entries by key
+   */
+  std::map<std::string, Entry> entries_;
+
+  /**
+   *  @brief Number of fits seeded from the cache
+   */
+  unsigned int num_seeded_fits_;
+
+  /**
+   *  @brief Number of fits not seeded from the cache
+   */
+  unsigned int num_cold_fits_;
+
+  /**
+   *  @brief Total FCN calls saved by seeded fits
+   */
+  long long num_fcn_calls_saved_;
+};
+
+} // namespace easyfit
+} // namespace fitter
+} // namespace doofit
+
+#endif // DOOFIT_FITTER_EASYFIT_WARMSTARTCACHE_H
@@ -0,0 +1,120 @@
+#include "AbsAnalyticGradient.h"
+
+// from STL
+#include <cmath>
+
+// from ROOT
+#include "TMath.h"
+
+// from RooFit
+#include "RooAbsReal.h"
+#include "RooArgList.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+void AbsAnalyticGradient::Prepare(const RooAbsReal& function, const RooArgList& parameters, const RooArgSet* nset) {
+  const AbsAnalyticGradient* analytic = dynamic_cast<const AbsAnalyticGradient*>(&function);
+  if (analytic != NULL) {
+    analytic->PrepareGradient(parameters, nset);
+  } else if (dynamic_cast<const RooGaussian*>(&function) != NULL) {
+    // servers of RooGaussian are x, mean and sigma
+    for (int i=1; i<3; ++i) {
+      const RooAbsReal* server = dynamic_cast<const RooAbsReal*>(function.findServer(i));
+      if (server != NULL) Prepare(*server, parameters, NULL);
+    }
+  }
+}
+
+void AbsAnalyticGradient::Gradient(const RooAbsReal& function, const RooArgList& parameters, const RooArgSet* nset, 
+                                   std::vector<double>& gradient, std::vector<bool>& available) {
+  const AbsAnalyticGradient* analytic = dynamic_cast<const AbsAnalyticGradient*>(&function);
+  if (analytic != NULL) {
+    gradient.assign(parameters.getSize(), 0.0);
+    available.assign(parameters.getSize(), true);
+    analytic->AnalyticalGradient(parameters, nset, gradient, available);
+    return;
+  }
+
+  if (dynamic_cast<const RooGaussian*>(&function) != NULL && 
+      GaussianGradient(function, parameters, nset, gradient, available)) {
+    return;
+  }
+
+  // only the trivial cases are known
+  gradient.assign(parameters.getSize(), 0.0);
+  available.assign(parameters.getSize(), true);
+  for (int i=0; i<parameters.getSize(); ++i) {
+    const RooAbsArg* parameter = parameters.at(i);
+    if (parameter == &function) {
+      gradient[i] = 1.0;
+    } else if (function.dependsOn(*parameter)) {
+      available[i] = false;
+    }
+  }
+}
+
+bool AbsAnalyticGradient::GaussianGradient(const RooAbsReal& gaussian, const RooArgList& parameters, const RooArgSet* nset, 
+                                           std::vector<double>& gradient, std::vector<bool>& available) {
+  // servers of RooGaussian are x, mean and sigma
+  const RooRealVar* x     = dynamic_cast<const RooRealVar*>(gaussian.findServer(0));
+  const RooAbsReal* mean  = dynamic_cast<const RooAbsReal*>(gaussian.findServer(1));
+  const RooAbsReal* sigma = dynamic_cast<const RooAbsReal*>(gaussian.findServer(2));
+  if (x == NULL || mean == NULL || sigma == NULL || parameters.find(x->GetName()) != NULL) {
+    return false;
+  }
+
+  const double m = mean->getVal();
+  const double s = sigma->getVal();
+  const double t = (x->getVal()-m)/s;
+  const double g = std::exp(-0.5*t*t);
+
+  // derivatives of exp(-(x-m)^2/(2s^2)) and of its integral over the range of x
+  double dg_dm = g*t/s;
+  double dg_ds = g*t*t/s;
+  double norm  = 1.0;
+  double dn_dm = 0.0;
+  double dn_ds = 0.0;
+  if (nset != NULL && nset->find(x->GetName()) != NULL) {
+    const double a = (x->getMin()-m)/(TMath::Sqrt2()*s);
+    const double b = (x->getMax()-m)/(TMath::Sqrt2()*s);
+    norm  = s*std::sqrt(0.5*TMath::Pi())*(TMath::Erf(b)-TMath::Erf(a));
+    dn_dm = std::exp(-a*a)-std::exp(-b*b);
+    dn_ds = norm/s - TMath::Sqrt2()*(b*std::exp(-b*b)-a*std::exp(-a*a));
+  }
+  const double value = g/norm;
+  const double df_dm = (dg_dm - value*dn_dm)/norm;
+  const double df_ds = (dg_ds - value*dn_ds)/norm;
+
+  gradient.assign(parameters.getSize(), 0.0);
+  available.assign(parameters.getSize(), true);
+
+  // mean and sigma are usually parameters themselves
+  if (dynamic_cast<const RooRealVar*>(mean) != NULL && dynamic_cast<const RooRealVar*>(sigma) != NULL) {
+    const int index_mean  = parameters.index(mean);
+    const int index_sigma = parameters.index(sigma);
+    if (index_mean >= 0)  gradient[index_mean]  += df_dm;
+    if (index_sigma >= 0) gradient[index_sigma] += df_ds;
+    return true;
+  }
+
+  // chain rule through mean and sigma
+  std::vector<double> gradient_mean, gradient_sigma;
+  std::vector<bool> available_mean, available_sigma;
+  Gradient(*mean, parameters, NULL, gradient_mean, available_mean);
+  Gradient(*sigma, parameters, NULL, gradient_sigma, available_sigma);
+
+  for (int i=0; i<parameters.getSize(); ++i) {
+    gradient[i]  = df_dm*gradient_mean[i] + df_ds*gradient_sigma[i];
+    available[i] = available_mean[i] && available_sigma[i];
+  }
+  return true;
+}
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
@@ -0,0 +1,98 @@
+#ifndef DOOFIT_ROOFIT_FUNCTIONS_ABSANALYTICGRADIENT
+#define DOOFIT_ROOFIT_FUNCTIONS_ABSANALYTICGRADIENT
+
+// from STL
+#include <vector>
+
+// forward declarations
+class RooAbsReal;
+class RooArgList;
+class RooArgSet;
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+/** @class AbsAnalyticGradient
+ *  @brief Interface for functions and PDFs providing analytic derivatives
+ *
+ *  Functions and PDFs inheriting from this class (in addition to RooAbsReal 
+ *  resp. RooAbsPdf) provide derivatives of their (normalised) values with 
+ *  respect to parameters. Minimisers can use these instead of numerical 
+ *  derivatives (see doofit::fitter::easyfit::MinimizerFcn).
+ *
+ *  Gradient(...) computes the gradient of any RooAbsReal: it uses 
+ *  AnalyticalGradient(...) if implemented and knows RooGaussian, RooRealVar 
+ *  and functions not depending on a parameter. Implementations use it for the 
+ *  chain rule through their servers.
+ *
+ *  Gradients are evaluated event by event at fixed parameter values. Before 
+ *  the first event (and after each parameter change), Prepare(...) has to be 
+ *  called, so that implementations calculate everything not depending on the 
+ *  observables (normalisation, derivatives of their coefficients) only once.
+ *
+ *  Only the function passed to Gradient(...) is differentiated. There is no 
+ *  chain rule through RooAddPdf, RooProdPdf or RooAbsAnaConvPdf (e.g. 
+ *  RooBDecay), so derivatives of PDFs built from these are not available.
+ */
+class AbsAnalyticGradient {
+ public:
+  virtual ~AbsAnalyticGradient() {}
+
+  /**
+   *  @brief Derivatives of the value at the current parameter values
+   *
+   *  @param parameters parameters to differentiate by
+   *  @param nset normalisation set (as for getVal(nset))
+   *  @param gradient derivatives of getVal(nset) (size of parameters)
+   *  @param available whether the derivative is available for a parameter 
+   *                   (size of parameters, unavailable derivatives need to be 
+   *                   determined numerically by the caller)
+   */
+  virtual void AnalyticalGradient(const RooArgList& parameters, const RooArgSet* nset, 
+                                  std::vector<double>& gradient, std::vector<bool>& available) const = 0;
+
+  /**
+   *  @brief Prepare AnalyticalGradient(...) for the current parameter values
+   *
+   *  The default implementation does nothing.
+   *
+   *  @param parameters parameters to differentiate by
+   *  @param nset normalisation set (as for getVal(nset))
+   */
+  virtual void PrepareGradient(const RooArgList& /*parameters*/, const RooArgSet* /*nset*/) const {}
+
+  /**
+   *  @brief Prepare Gradient(...) of any function for the current parameter values
+   *
+   *  Arguments as for PrepareGradient(...).
+   *
+   *  @param function function to differentiate
+   */
+  static void Prepare(const RooAbsReal& function, const RooArgList& parameters, const RooArgSet* nset);
+
+  /**
+   *  @brief Derivatives of any function at the current parameter values
+   *
+   *  Arguments as for AnalyticalGradient(...).
+   *
+   *  @param function function to differentiate
+   */
+  static void Gradient(const RooAbsReal& function, const RooArgList& parameters, const RooArgSet* nset, 
+                       std::vector<double>& gradient, std::vector<bool>& available);
+
+ private:
+  /**
+   *  @brief Derivatives of a RooGaussian
+   *
+   *  @return false if the Gaussian is not supported (arguments not changed)
+   */
+  static bool GaussianGradient(const RooAbsReal& gaussian, const RooArgList& parameters, const RooArgSet* nset, 
+                               std::vector<double>& gradient, std::vector<bool>& available);
+};
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
+
+#endif
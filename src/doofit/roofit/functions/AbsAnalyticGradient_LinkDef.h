@@ -0,0 +1,11 @@
+#ifdef __CINT__
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+// #pragma link C++ namespace doofit;
+// #pragma link C++ namespace doofit::roofit;
+#pragma link C++ nestedclass;
+#pragma link C++ nestedtypedef;
+#pragma link C++ class doofit::roofit::functions::AbsAnalyticGradient+;
+#endif
@@ -0,0 +1,68 @@
+#include "AbsBatchEvaluation.h"
+
+// from STL
+#include <algorithm>
+
+// from RooFit
+#include "RooAbsReal.h"
+#include "RooAbsCategory.h"
+#include "RooArgSet.h"
+
+// from project
+#include "BatchData.h"
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+void AbsBatchEvaluation::Evaluate(const RooAbsReal& function, const BatchData& data, std::size_t begin, std::size_t end, 
+                                  const RooArgSet* nset, double* output) {
+  const double* column = data.column(function);
+  if (column != NULL) {
+    std::copy(column+begin, column+end, output);
+    return;
+  }
+
+  if (!DependsOnData(function, data)) {
+    std::fill(output, output+(end-begin), function.getVal(nset));
+    return;
+  }
+
+  const AbsBatchEvaluation* batch = dynamic_cast<const AbsBatchEvaluation*>(&function);
+  if (batch != NULL && batch->EvaluateBatch(data, begin, end, nset, output)) {
+    return;
+  }
+
+  // event by event through RooFit
+  for (std::size_t i=begin; i<end; ++i) {
+    data.Load(i);
+    output[i-begin] = function.getVal(nset);
+  }
+}
+
+void AbsBatchEvaluation::Evaluate(const RooAbsCategory& category, const BatchData& data, std::size_t begin, std::size_t end, 
+                                  double* output) {
+  const double* column = data.column(category);
+  if (column != NULL) {
+    std::copy(column+begin, column+end, output);
+    return;
+  }
+
+  if (!DependsOnData(category, data)) {
+    std::fill(output, output+(end-begin), static_cast<double>(category.getIndex()));
+    return;
+  }
+
+  for (std::size_t i=begin; i<end; ++i) {
+    data.Load(i);
+    output[i-begin] = category.getIndex();
+  }
+}
+
+bool AbsBatchEvaluation::DependsOnData(const RooAbsArg& arg, const BatchData& data) {
+  return arg.dependsOn(data.observables());
+}
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
@@ -0,0 +1,84 @@
+#ifndef DOOFIT_ROOFIT_FUNCTIONS_ABSBATCHEVALUATION
+#define DOOFIT_ROOFIT_FUNCTIONS_ABSBATCHEVALUATION
+
+// from STL
+#include <cstddef>
+
+// forward declarations
+class RooAbsArg;
+class RooAbsReal;
+class RooAbsCategory;
+class RooArgSet;
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+class BatchData;
+
+/** @class AbsBatchEvaluation
+ *  @brief Interface for functions and PDFs evaluating many events at once
+ *
+ *  Functions and PDFs inheriting from this class (in addition to RooAbsReal 
+ *  resp. RooAbsPdf) compute their (normalised) values for a range of events 
+ *  of a BatchData in one call. Server values are read into contiguous 
+ *  buffers and the function is evaluated in plain loops over these buffers 
+ *  which the compiler can vectorise (see BatchNll for a likelihood built on 
+ *  this).
+ *
+ *  Evaluate(...) evaluates any RooAbsReal for a range of events: observables 
+ *  are copied from their columns, functions not depending on observables are 
+ *  evaluated once, functions implementing this interface are evaluated in 
+ *  batches and all others event by event via getVal(...). Implementations 
+ *  use it for their servers.
+ */
+class AbsBatchEvaluation {
+ public:
+  virtual ~AbsBatchEvaluation() {}
+
+  /**
+   *  @brief Values for a range of events
+   *
+   *  @param data the events
+   *  @param begin index of first event
+   *  @param end index after last event
+   *  @param nset normalisation set (as for getVal(nset))
+   *  @param output values of getVal(nset) for all events (size end-begin)
+   *  @return false if the function cannot be evaluated in batches for these 
+   *          events (e.g. if the normalisation would change from event to 
+   *          event), output is undefined then
+   */
+  virtual bool EvaluateBatch(const BatchData& data, std::size_t begin, std::size_t end, 
+                             const RooArgSet* nset, double* output) const = 0;
+
+  /**
+   *  @brief Values of any function for a range of events
+   *
+   *  Arguments as for EvaluateBatch(...).
+   *
+   *  @param function function to evaluate
+   */
+  static void Evaluate(const RooAbsReal& function, const BatchData& data, std::size_t begin, std::size_t end, 
+                       const RooArgSet* nset, double* output);
+
+  /**
+   *  @brief Indices of a category for a range of events
+   *
+   *  Arguments as for EvaluateBatch(...).
+   *
+   *  @param category category to evaluate
+   */
+  static void Evaluate(const RooAbsCategory& category, const BatchData& data, std::size_t begin, std::size_t end, 
+                       double* output);
+
+  /**
+   *  @brief Whether an argument depends on observables of the events
+   */
+  static bool DependsOnData(const RooAbsArg& arg, const BatchData& data);
+};
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
+
+#endif
@@ -0,0 +1,68 @@
+#include "BatchData.h"
+
+// from ROOT
+#include "TIterator.h"
+
+// from RooFit
+#include "RooAbsData.h"
+#include "RooAbsReal.h"
+#include "RooAbsCategory.h"
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+BatchData::BatchData(const RooAbsData& data, const RooArgSet& observables)
+    : data_(&data),
+      observables_(),
+      columns_(),
+      weights_(data.numEntries()),
+      sum_weights_(0.0)
+{
+  observables_.add(observables);
+
+  std::vector<std::vector<double>*> columns;
+  std::vector<std::string> names;
+  TIterator* it = observables_.createIterator();
+  RooAbsArg* arg = NULL;
+  while ((arg = (RooAbsArg*)it->Next())) {
+    if (dynamic_cast<RooAbsReal*>(arg) == NULL && dynamic_cast<RooAbsCategory*>(arg) == NULL) continue;
+    std::vector<double>& column = columns_[arg->GetName()];
+    column.resize(data.numEntries());
+    columns.push_back(&column);
+    names.push_back(arg->GetName());
+  }
+  delete it;
+
+  for (int i=0; i<data.numEntries(); ++i) {
+    const RooArgSet* row = data.get(i);
+    for (std::size_t j=0; j<columns.size(); ++j) {
+      const RooAbsArg* value = row->find(names[j].c_str());
+      const RooAbsReal* real = dynamic_cast<const RooAbsReal*>(value);
+      const RooAbsCategory* category = dynamic_cast<const RooAbsCategory*>(value);
+      if (real != NULL) {
+        (*columns[j])[i] = real->getVal();
+      } else if (category != NULL) {
+        (*columns[j])[i] = category->getIndex();
+      }
+    }
+    weights_[i]   = data.weight();
+    sum_weights_ += weights_[i];
+  }
+}
+
+const double* BatchData::column(const RooAbsArg& arg) const {
+  std::map<std::string, std::vector<double> >::const_iterator it = columns_.find(arg.GetName());
+  if (it == columns_.end() || observables_.find(arg.GetName()) != &arg) {
+    return NULL;
+  }
+  return it->second.data();
+}
+
+void BatchData::Load(std::size_t index) const {
+  observables_.assignValueOnly(*data_->get(index));
+}
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
@@ -0,0 +1,109 @@
+#ifndef DOOFIT_ROOFIT_FUNCTIONS_BATCHDATA
+#define DOOFIT_ROOFIT_FUNCTIONS_BATCHDATA
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+// from RooFit
+#include "RooArgSet.h"
+
+// forward declarations
+class RooAbsArg;
+class RooAbsData;
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+/** @class BatchData
+ *  @brief Column-wise copy of a dataset for batch evaluation
+ *
+ *  The values of all observables (indices for categories) and the event 
+ *  weights are copied once into contiguous columns. Functions implementing 
+ *  AbsBatchEvaluation read their observables from these columns instead of 
+ *  through RooFit's proxies.
+ */
+class BatchData {
+ public:
+  /**
+   *  @brief Constructor copying the dataset
+   *
+   *  @param data the dataset
+   *  @param observables observables to copy (the variables of the evaluated 
+   *                     functions, not the ones of the dataset; values are 
+   *                     set by Load(...))
+   */
+  BatchData(const RooAbsData& data, const RooArgSet& observables);
+
+  /**
+   *  @brief Number of events
+   */
+  std::size_t size() const { return weights_.size(); }
+
+  /**
+   *  @brief Column of an observable
+   *
+   *  @param arg the observable (identified by name)
+   *  @return pointer to the values of all events (NULL if arg is not an observable)
+   */
+  const double* column(const RooAbsArg& arg) const;
+
+  /**
+   *  @brief Event weights
+   */
+  const double* weights() const { return weights_.data(); }
+
+  /**
+   *  @brief Sum of event weights
+   */
+  double sum_weights() const { return sum_weights_; }
+
+  /**
+   *  @brief Observables
+   */
+  const RooArgSet& observables() const { return observables_; }
+
+  /**
+   *  @brief Set the observables to the values of an event
+   *
+   *  This is used to evaluate functions without batch evaluation event by event.
+   *
+   *  @param index index of the event
+   */
+  void Load(std::size_t index) const;
+
+ private:
+  /**
+   *  @brief The dataset
+   */
+  const RooAbsData* data_;
+
+  /**
+   *  @brief Observables (not owned, values are changed by Load(...))
+   */
+  mutable RooArgSet observables_;
+
+  /**
+   *  @brief Columns by observable name
+   */
+  std::map<std::string, std::vector<double> > columns_;
+
+  /**
+   *  @brief Event weights
+   */
+  std::vector<double> weights_;
+
+  /**
+   *  @brief Sum of event weights
+   */
+  double sum_weights_;
+};
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
+
+#endif
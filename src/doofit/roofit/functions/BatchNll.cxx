@@ -0,0 +1,93 @@
+#include "BatchNll.h"
+
+// from STL
+#include <cmath>
+#include <algorithm>
+
+// from RooFit
+#include "RooAbsPdf.h"
+#include "RooAbsData.h"
+
+// from project
+#include "AbsBatchEvaluation.h"
+
+ClassImp(doofit::roofit::functions::BatchNll)
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+BatchNll::BatchNll(const std::string& name, RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables, 
+                   bool extended, std::size_t batch_size) :
+  RooAbsReal(name.c_str(),name.c_str()),
+  parameters_("parameters","parameters",this),
+  pdf_(&pdf),
+  nset_(),
+  data_(),
+  batch_size_(std::max<std::size_t>(batch_size, 1)),
+  extended_(extended),
+  buffer_()
+{
+  RooArgSet* parameters = pdf.getParameters(data);
+  parameters_.add(*parameters);
+  delete parameters;
+
+  RooArgSet* observables = pdf.getObservables(data);
+  data_.reset(new BatchData(data, *observables));
+  nset_.add(*observables);
+  if (conditional_observables != NULL) {
+    nset_.remove(*conditional_observables, kFALSE, kTRUE);
+  }
+  delete observables;
+}
+
+BatchNll::BatchNll(const BatchNll& other, const char* name) :
+  RooAbsReal(other,name),
+  parameters_("parameters",this,other.parameters_),
+  pdf_(other.pdf_),
+  nset_(other.nset_),
+  data_(other.data_),
+  batch_size_(other.batch_size_),
+  extended_(other.extended_),
+  buffer_()
+{
+}
+
+Double_t BatchNll::evaluate() const {
+  const std::size_t num_events = data_->size();
+  const double* weights = data_->weights();
+  buffer_.resize(batch_size_);
+
+  // Kahan summation over batches
+  double nll = 0.0;
+  double carry = 0.0;
+  bool invalid = false;
+  for (std::size_t begin=0; begin<num_events; begin+=batch_size_) {
+    const std::size_t end = std::min(begin+batch_size_, num_events);
+    AbsBatchEvaluation::Evaluate(*pdf_, *data_, begin, end, &nset_, buffer_.data());
+
+    const double* values = buffer_.data();
+    double sum = 0.0;
+    for (std::size_t i=0; i<end-begin; ++i) {
+      invalid |= !(values[i] > 0.0);
+      sum -= weights[begin+i]*std::log(values[i]);
+    }
+
+    const double y = sum - carry;
+    const double t = nll + y;
+    carry = (t - nll) - y;
+    nll = t;
+  }
+
+  if (invalid) {
+    logEvalError("p.d.f. value is zero or negative for some events");
+  }
+  if (extended_) {
+    nll += pdf_->extendedTerm(data_->sum_weights(), &nset_);
+  }
+  return nll;
+}
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
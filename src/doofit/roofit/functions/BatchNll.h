@@ -0,0 +1,83 @@
+#ifndef DOOFIT_ROOFIT_FUNCTIONS_BATCHNLL
+#define DOOFIT_ROOFIT_FUNCTIONS_BATCHNLL
+
+// from STL
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// from RooFit
+#include "RooAbsReal.h"
+#include "RooListProxy.h"
+#include "RooArgSet.h"
+
+// from project
+#include "BatchData.h"
+
+// forward declarations
+class RooAbsPdf;
+class RooAbsData;
+
+namespace doofit {
+namespace roofit {
+namespace functions {
+
+/** @class BatchNll
+ *  @brief Negative log-likelihood evaluated in batches of events
+ *
+ *  The dataset is copied into a BatchData once. On each evaluation, the PDF 
+ *  is evaluated for batches of events via AbsBatchEvaluation::Evaluate(...) 
+ *  and -sum w_i log f(x_i) is accumulated with Kahan summation. PDFs (and 
+ *  their servers) implementing AbsBatchEvaluation avoid RooFit's per-event 
+ *  getVal() chain, all others are evaluated event by event. Combinators 
+ *  like RooAddPdf, RooProdPdf or RooBDecay have no batch path, so for them 
+ *  this is slower than a RooNLLVar (EasyFit refuses batch evaluation then).
+ *
+ *  Only the parameters of the PDF are servers of this function, so it can be 
+ *  minimised like a RooNLLVar (see doofit::fitter::easyfit::MinimizerFcn). 
+ *  Constraints and offsetting are not supported.
+ */
+class BatchNll : public RooAbsReal {
+ public:
+  BatchNll() : pdf_(NULL), batch_size_(0), extended_(false) {}
+
+  /**
+   *  @brief Constructor
+   *
+   *  @param name name of the likelihood
+   *  @param pdf the PDF
+   *  @param data the dataset
+   *  @param conditional_observables observables not to normalise over (can be NULL)
+   *  @param extended whether to add the extended likelihood term
+   *  @param batch_size number of events per batch
+   */
+  BatchNll(const std::string& name, RooAbsPdf& pdf, RooAbsData& data, const RooArgSet* conditional_observables=NULL, 
+           bool extended=false, std::size_t batch_size=1024);
+
+  BatchNll(const BatchNll& other, const char* name=0);
+  virtual TObject* clone(const char* newname) const { return new BatchNll(*this,newname); }
+  virtual ~BatchNll() {}
+
+  virtual Double_t defaultErrorLevel() const { return 0.5; }
+
+ protected:
+  Double_t evaluate() const;
+
+ private:
+  RooListProxy parameters_;
+  RooAbsPdf* pdf_;                            //!
+  RooArgSet nset_;                            //!
+  std::shared_ptr<const BatchData> data_;     //!
+  std::size_t batch_size_;
+  bool extended_;
+  mutable std::vector<double> buffer_;        //!
+
+  ClassDef(BatchNll,1) // negative log-likelihood evaluated in batches
+};
+
+} // namespace functions
+} // namespace roofit
+} // namespace doofit
+
+#endif
@@ -12,6 +12,7 @@
 #include "RooAbsReal.h" 
 #include "RooAbsCategory.h" 
 #include <math.h> 
+#include <vector>
 #include "TMath.h" 
 
 ClassImp(doofit::roofit::functions::CPCoefficient)
@@ -19,6 +20,22 @@ ClassImp(doofit::roofit::functions::CPCoefficient)
 namespace doofit {
 namespace roofit {
 namespace functions {
+
+namespace {
+/// calibrated mistags for true B and Bbar for a batch of events (as in CPCoefficient::evaluate())
+void CalibratedMistags(std::size_t n, const double* eta, const double* p0, const double* p1, const double* meaneta,
+                       const double* delta_p0, const double* delta_p1, double* omega_Bd, double* omega_Bdb) {
+  for (std::size_t i=0; i<n; ++i) {
+    const double deta = eta[i] - meaneta[i];
+    const double omega    = p0[i] + 0.5*delta_p0[i] + (p1[i] + 0.5*delta_p1[i])*deta;
+    const double omegabar = p0[i] - 0.5*delta_p0[i] + (p1[i] - 0.5*delta_p1[i])*deta;
+    const bool calibrated = eta[i] < 0.5;
+    const bool saturated  = (p0[i] + p1[i]*deta) > 0.5;
+    omega_Bd[i]  = !calibrated ? eta[i] : (saturated ? 0.5 : (omega    < 0. ? 0. : omega));
+    omega_Bdb[i] = !calibrated ? eta[i] : (saturated ? 0.5 : (omegabar < 0. ? 0. : omegabar));
+  }
+}
+} // namespace
   
 CPCoefficient::CPCoefficient(std::string name,
                              RooAbsReal& _par_cp_coeff,
@@ -211,6 +228,71 @@ Double_t CPCoefficient::evaluate() const {
     }
 }
 
+bool CPCoefficient::EvaluateBatch(const BatchData& data, std::size_t begin, std::size_t end, 
+                                  const RooArgSet* /*nset*/, double* output) const {
+    const std::size_t n = end - begin;
+    std::vector<double> tag_OS(n), eta_OS(n), p0_OS(n), p1_OS(n), meaneta_OS(n), delta_p0_OS(n), delta_p1_OS(n);
+    std::vector<double> omega_OS_Bd(n), omega_OS_Bdb(n), prod_asym(n), cp_coeff(n), secondsummand(n);
+
+    Evaluate(cat_tag_OS.arg(), data, begin, end, tag_OS.data());
+    Evaluate(par_eta_OS.arg(), data, begin, end, 0, eta_OS.data());
+    Evaluate(par_p0_OS.arg(), data, begin, end, 0, p0_OS.data());
+    Evaluate(par_p1_OS.arg(), data, begin, end, 0, p1_OS.data());
+    Evaluate(par_meaneta_OS.arg(), data, begin, end, 0, meaneta_OS.data());
+    Evaluate(par_delta_p0_OS.arg(), data, begin, end, 0, delta_p0_OS.data());
+    Evaluate(par_delta_p1_OS.arg(), data, begin, end, 0, delta_p1_OS.data());
+    Evaluate(par_prod_asym.arg(), data, begin, end, 0, prod_asym.data());
+    Evaluate(par_cp_coeff.arg(), data, begin, end, 0, cp_coeff.data());
+    CalibratedMistags(n, eta_OS.data(), p0_OS.data(), p1_OS.data(), meaneta_OS.data(), delta_p0_OS.data(), delta_p1_OS.data(),
+                      omega_OS_Bd.data(), omega_OS_Bdb.data());
+
+    // first summand goes to output
+    if (combo) {
+      std::vector<double> tag_SS(n), eta_SS(n), p0_SS(n), p1_SS(n), meaneta_SS(n), delta_p0_SS(n), delta_p1_SS(n);
+      std::vector<double> omega_SS_Bd(n), omega_SS_Bdb(n);
+      Evaluate(cat_tag_SS.arg(), data, begin, end, tag_SS.data());
+      Evaluate(par_eta_SS.arg(), data, begin, end, 0, eta_SS.data());
+      Evaluate(par_p0_SS.arg(), data, begin, end, 0, p0_SS.data());
+      Evaluate(par_p1_SS.arg(), data, begin, end, 0, p1_SS.data());
+      Evaluate(par_meaneta_SS.arg(), data, begin, end, 0, meaneta_SS.data());
+      Evaluate(par_delta_p0_SS.arg(), data, begin, end, 0, delta_p0_SS.data());
+      Evaluate(par_delta_p1_SS.arg(), data, begin, end, 0, delta_p1_SS.data());
+      CalibratedMistags(n, eta_SS.data(), p0_SS.data(), p1_SS.data(), meaneta_SS.data(), delta_p0_SS.data(), delta_p1_SS.data(),
+                        omega_SS_Bd.data(), omega_SS_Bdb.data());
+
+      for (std::size_t i=0; i<n; ++i) {
+        const double wOSd = omega_OS_Bd[i], wOSb = omega_OS_Bdb[i], wSSd = omega_SS_Bd[i], wSSb = omega_SS_Bdb[i];
+        const double tOS = tag_OS[i], tSS = tag_SS[i];
+        output[i]        = 1.0 + tOS*tSS*(1.0 + 2.0*(wOSd*wSSd + wOSb*wSSb) - wOSd - wOSb - wSSd - wSSb) - tOS*(wOSd - wOSb) - tSS*(wSSd - wSSb);
+        secondsummand[i] = tOS*tSS*(wOSd - wOSb + wSSd - wSSb - 2.0*(wOSd*wSSd - wOSb*wSSb)) - tOS*(1.0 - wOSd - wOSb) - tSS*(1.0 - wSSd - wSSb);
+      }
+    }
+    else {
+      for (std::size_t i=0; i<n; ++i) {
+        output[i]        = 1.0 - tag_OS[i]*(omega_OS_Bd[i] - omega_OS_Bdb[i]);
+        secondsummand[i] = - tag_OS[i]*(1.0 - omega_OS_Bd[i] - omega_OS_Bdb[i]);
+      }
+    }
+
+    switch (type_coeff) {
+      case kCosh:
+        for (std::size_t i=0; i<n; ++i) output[i] = output[i] + prod_asym[i]*secondsummand[i];
+        break;
+      case kSin:
+        for (std::size_t i=0; i<n; ++i) output[i] = cp_coeff[i]*(prod_asym[i]*output[i] + secondsummand[i]);
+        break;
+      case kCos:
+        for (std::size_t i=0; i<n; ++i) output[i] = -1.0*cp_coeff[i]*(prod_asym[i]*output[i] + secondsummand[i]);
+        break;
+      case kSinh:
+        for (std::size_t i=0; i<n; ++i) output[i] = cp_coeff[i]*(output[i] + prod_asym[i]*secondsummand[i]);
+        break;
+      default:
+        return false;
+    }
+    return true;
+}
+
 Double_t CPCoefficient::analyticalIntegral(Int_t code, const char* /*rangeName*/) const {
    
    // std::cout << "CPCoefficient::analyticalIntegral(" << code << ", ...): Called." << std::endl;
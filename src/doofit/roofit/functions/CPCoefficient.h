@@ -12,11 +12,13 @@
 #include "RooCategoryProxy.h"
 #include "RooAbsCategory.h"
 
+#include "AbsBatchEvaluation.h"
+
 namespace doofit {
 namespace roofit {
 namespace functions {
 
-class CPCoefficient : public RooAbsReal {
+class CPCoefficient : public RooAbsReal, public AbsBatchEvaluation {
 public:
   enum CoeffType {
     kCosh = 0,
@@ -60,6 +62,10 @@ public:
   virtual TObject* clone(const char* newname) const { return new CPCoefficient(*this,newname); }
   inline virtual ~CPCoefficient() { }
 
+  /// values for a range of events (same as evaluate(), servers read in batches)
+  virtual bool EvaluateBatch(const BatchData& data, std::size_t begin, std::size_t end, 
+                             const RooArgSet* nset, double* output) const;
+
 protected:
 
   RooRealProxy par_cp_coeff ;
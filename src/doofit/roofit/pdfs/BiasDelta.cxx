@@ -33,6 +33,8 @@
 #include "RooRandom.h"
 #include "RooMath.h"
 
+#include <vector>
+
 namespace doofit {
 namespace roofit {
 namespace pdfs {
@@ -65,6 +67,24 @@ Double_t BiasDelta::evaluate() const
 
 
 
+//_____________________________________________________________________________
+bool BiasDelta::EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                              const RooArgSet* nset, double* output) const
+{
+  // the normalisation is the same for all events only for a fixed mean
+  if (DependsOnData(mean.arg(), data)) return false;
+
+  const double value = 1.0/(nset ? getNorm(nset) : 1.0);
+  const double m = mean;
+  Evaluate(x.arg(), data, begin, end, 0, output);
+  for (std::size_t i=0; i<end-begin; ++i) {
+    output[i] = (output[i] == m) ? value : 0.0;
+  }
+  return true;
+}
+
+
+
 //_____________________________________________________________________________
 Int_t BiasDelta::getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* /*rangeName*/) const 
 {
@@ -19,13 +19,15 @@
 #include "RooAbsPdf.h"
 #include "RooRealProxy.h"
 
+#include "doofit/roofit/functions/AbsBatchEvaluation.h"
+
 class RooRealVar;
 
 namespace doofit {
 namespace roofit {
 namespace pdfs {
 
-class BiasDelta : public RooAbsPdf {
+class BiasDelta : public RooAbsPdf, public doofit::roofit::functions::AbsBatchEvaluation {
 public:
   BiasDelta() {} ;
   BiasDelta(const char *name, const char *title,
@@ -40,6 +42,9 @@ public:
   Int_t getGenerator(const RooArgSet& directVars, RooArgSet &generateVars, Bool_t staticInitOK=kTRUE) const;
   void generateEvent(Int_t code);
 
+  bool EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                     const RooArgSet* nset, double* output) const;
+
 protected:
 
   RooRealProxy x ;
@@ -145,9 +145,65 @@ double DooCubicSplineKnot::evaluate(double x, const RooArgList& b) const {
          + get(b,i,3)*D(x,i);
 }
 
-double DooCubicSplineKnot::analyticalIntegral(const RooArgList& b) const {
+void DooCubicSplineKnot::evaluateBatch(const double* x, std::size_t n, const std::vector<double>& b, double* output) const {
+    assert(int(b.size())-2==size());
+    // the spline is a cubic polynomial on each interval: sum up the
+    // polynomials of A,B,C,D (see fillS_jk) once for all events, expanded in
+    // x-u(i) instead of x to avoid cancellations for knots far from zero
+    typedef DooCubicSplineKnot::S_jk Sjk;
+    std::vector<double> poly(4*(size()-1));
+    for (int i=0; i < size()-1; ++i) {
+        auto v = [this,i](int k) { return u(k)-u(i); };
+        Sjk s = -Sjk(v(i+1),v(i+1),v(i+1))/P(i)*b[i  ]
+            + ( Sjk(v(i-2),v(i+1),v(i+1))/P(i)
+               +Sjk(v(i-1),v(i+1),v(i+2))/Q(i)
+               +Sjk(v(i  ),v(i+2),v(i+2))/R(i) )*b[i+1]
+            + (-Sjk(v(i-1),v(i-1),v(i+1))/Q(i)
+               -Sjk(v(i-1),v(i  ),v(i+2))/R(i)
+               -Sjk(v(i  ),v(i  ),v(i+3))/S(i) )*b[i+2]
+            + Sjk(v(i  ),v(i  ),v(i  ))/S(i)*b[i+3];
+        poly[4*i  ] =   s(0,0);
+        poly[4*i+1] = 2*s(0,1);
+        poly[4*i+2] = 4*s(0,2);
+        poly[4*i+3] = 8*s(0,3);
+    }
+    for (std::size_t k=0; k<n; ++k) {
+        const double xk = x[k];
+        if ( (_use_range) && ( (xk < _range_min) || (xk > _range_max) ) ){ output[k] = 0; continue; }
+        int i = index(xk);
+        // same extrapolation as in evaluate(x,b)
+        if (i==-1    ) { ++i; output[k] = b[i  ] - d(xk,i)*r(i  )*(b[i  ]-b[i+1]); continue; }
+        if (i==size()) { --i; output[k] = b[i+2] + d(xk,i)*r(i-1)*(b[i+2]-b[i+1]); continue; }
+        const double* p = &poly[4*i];
+        const double t = xk - u(i);
+        output[k] = p[0] + t*(p[1] + t*(p[2] + t*p[3]));
+    }
+}
+
+void DooCubicSplineKnot::basis(double x, std::vector<double>& db) const {
+    db.assign(size()+2, 0.);
+    if ( (_use_range) && ( (x < _range_min) || (x > _range_max) ) ){ return; }
+    int i = index(x);
+    assert(-1<=i && i<=size());
+    // same cases as in evaluate(x,b)
+    if (i==-1    ) { ++i; db[i] = 1 - d(x,i)*r(i  ); db[i+1] =  d(x,i)*r(i  ); return; }
+    if (i==size()) { --i; db[i+2] = 1 + d(x,i)*r(i-1); db[i+1] = -d(x,i)*r(i-1); return; }
+    db[i  ] = A(x,i);
+    db[i+1] = B(x,i);
+    db[i+2] = C(x,i);
+    db[i+3] = D(x,i);
+}
+
+void DooCubicSplineKnot::integralBasis(std::vector<double>& db) const {
+    fillIABCD();
+    db.assign(size()+2, 0.);
+    for (int i=0; i < size()-1; ++i) for (int k=0;k<4;++k) {
+        db[i+k] += DooCubicSplineKnot_aux::get(_IABCD,i,k);
+    }
+}
+
+void DooCubicSplineKnot::fillIABCD() const {
     using DooCubicSplineKnot_aux::push_back;
-    using DooCubicSplineKnot_aux::get;
     if (_IABCD.empty()) {
         // the integrals of A,B,C,D from u(i) to u(i+1) only depend on the knot vector...
         // so we create them 'on demand' and cache the result
@@ -163,6 +219,11 @@ double DooCubicSplineKnot::analyticalIntegral(const RooArgList& b) const {
                             ,   qua(h(j,j+1))/(4*S(j)) );
         }
     }
+}
+
+double DooCubicSplineKnot::analyticalIntegral(const RooArgList& b) const {
+    using DooCubicSplineKnot_aux::get;
+    fillIABCD();
     // FIXME: this assumes the integration range goes from first knot to last knot...
     assert(b.getSize()-2==size());
     double norm(0);
@@ -182,6 +243,16 @@ int DooCubicSplineKnot::index(double u) const
 
 // S matrix for i-th interval
 DooCubicSplineKnot::S_jk DooCubicSplineKnot::S_jk_sum(int i, const RooArgList& b) const
+{
+    fillS_jk();
+    using DooCubicSplineKnot_aux::get;
+    return get(_S_jk,i,0)*get(b,i,0)
+         + get(_S_jk,i,1)*get(b,i,1)
+         + get(_S_jk,i,2)*get(b,i,2)
+         + get(_S_jk,i,3)*get(b,i,3);
+}
+
+void DooCubicSplineKnot::fillS_jk() const
 {
     if (_S_jk.empty()) {
         _S_jk.reserve(size()*4);
@@ -197,11 +268,6 @@ DooCubicSplineKnot::S_jk DooCubicSplineKnot::S_jk_sum(int i, const RooArgList& b
             _S_jk.push_back(  DooCubicSplineKnot::S_jk(u(i  ),u(i  ),u(i  ))/S(i) ); // D
         }
     }
-    using DooCubicSplineKnot_aux::get;
-    return get(_S_jk,i,0)*get(b,i,0)
-         + get(_S_jk,i,1)*get(b,i,1)
-         + get(_S_jk,i,2)*get(b,i,2)
-         + get(_S_jk,i,3)*get(b,i,3);
 }
 
 // S matrix for natural extrapolation beyond the first/last knot...
@@ -41,8 +41,16 @@ public:
         return _u[std::min(std::max(0,i),size()-1)]; }
     int size() const { return _u.size(); }
     double evaluate(double _u, const RooArgList& b) const;
+    // evaluate(x[k],b) for n values x (output may be x), coefficients b 
+    // given as values
+    void evaluateBatch(const double* x, std::size_t n, const std::vector<double>& b, double* output) const;
     double analyticalIntegral(const RooArgList& b) const;
 
+    // derivatives of evaluate(u,b) resp. analyticalIntegral(b) w.r.t. all 
+    // coefficients b (both are linear in b)
+    void basis(double _u, std::vector<double>& db) const;
+    void integralBasis(std::vector<double>& db) const;
+
     void computeCoefficients(std::vector<double>& y, BoundaryConditions bc = BoundaryConditions() ) const ;
     void smooth(std::vector<double>& y, const std::vector<double>& dy, double lambda) const;
 
@@ -162,6 +170,8 @@ private:
     double S(int i) const { if (_PQRS.empty()) fillPQRS(); assert(4*i+3<int(_PQRS.size())); return  _PQRS[4*i+3]; }
 
     void fillPQRS() const;
+    void fillIABCD() const;
+    void fillS_jk() const;
 
     static double sqr(double x) { return x*x; }
     static double cub(double x) { return x*sqr(x); }
@@ -107,6 +107,88 @@ namespace pdfs {
     assert(code==1) ;
     return _aux.analyticalIntegral(_coefList);
   }
+
+  bool DooCubicSplinePdf::EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                                        const RooArgSet* nset, double* output) const
+  {
+    // the spline (and its normalisation) needs to be the same for all events
+    std::vector<double> coefficients(_coefList.getSize());
+    for (int j=0; j<_coefList.getSize(); ++j) {
+      if (DependsOnData(_coefList[j], data)) return false;
+      coefficients[j] = static_cast<const RooAbsReal&>(_coefList[j]).getVal();
+    }
+
+    const double norm = nset ? getNorm(nset) : 1.0;
+    Evaluate(_x.arg(), data, begin, end, 0, output);
+    _aux.evaluateBatch(output, end-begin, coefficients, output);
+    for (std::size_t i=0; i<end-begin; ++i) {
+      output[i] /= norm;
+    }
+    return true;
+  }
+
+  void DooCubicSplinePdf::PrepareGradient(const RooArgList& parameters, const RooArgSet* nset) const
+  {
+    // everything but the basis splines at x is the same for all events
+    const int num_coefs = _coefList.getSize();
+    const int num_pars  = parameters.getSize();
+    _gradCoefValues.resize(num_coefs);
+    _gradCoefGradients.assign(num_coefs*num_pars, 0.);
+    _gradAvailable.assign(num_pars, true);
+    for (int j=0; j<num_coefs; ++j) {
+      const RooAbsReal& coef = static_cast<const RooAbsReal&>(_coefList[j]);
+      _gradCoefValues[j] = coef.getVal();
+      Prepare(coef, parameters, 0);
+      Gradient(coef, parameters, 0, _gradCoefDerivative, _gradCoefAvailable);
+      for (int i=0; i<num_pars; ++i) {
+        _gradCoefGradients[j*num_pars+i] = _gradCoefDerivative[i];
+        _gradAvailable[i] = _gradAvailable[i] && _gradCoefAvailable[i];
+      }
+    }
+
+    // the full normalisation is the integral over x (if normalised over x)
+    // times a constant factor for further variables in nset
+    _gradNormX = (nset != 0 && nset->find(_x.arg().GetName()) != 0);
+    _gradNorm  = nset != 0 ? getNorm(nset) : 1.;
+    if (_gradNormX) {
+      _aux.integralBasis(_gradIntegralBasis);
+      _gradIntegral = _aux.analyticalIntegral(_coefList);
+    }
+  }
+
+  void DooCubicSplinePdf::AnalyticalGradient(const RooArgList& parameters, const RooArgSet* nset, 
+                                             std::vector<double>& gradient, std::vector<bool>& available) const
+  {
+    const int num_pars = parameters.getSize();
+    gradient.assign(num_pars, 0.);
+    available.assign(_gradAvailable.begin(), _gradAvailable.end());
+
+    // derivatives of the value w.r.t. the coefficients, the value is linear 
+    // in the coefficients
+    _aux.basis(_x, _gradBasis);
+    double value = 0.;
+    for (size_t j=0; j<_gradBasis.size(); ++j) {
+      value += _gradBasis[j]*_gradCoefValues[j];
+    }
+    if (_gradNormX) {
+      // normalised value v/N with N = I*c: d(v/N) = (dv - v/I*dI)/N
+      const double value_norm = value/_gradIntegral;
+      for (size_t j=0; j<_gradBasis.size(); ++j) {
+        _gradBasis[j] -= value_norm*_gradIntegralBasis[j];
+      }
+    }
+
+    // chain rule through the coefficients
+    for (size_t j=0; j<_gradBasis.size(); ++j) {
+      const double dvalue = _gradBasis[j]/_gradNorm;
+      if (dvalue == 0.) continue;
+      const double* gradient_coef = &_gradCoefGradients[j*num_pars];
+      for (int i=0; i<num_pars; ++i) {
+        gradient[i] += dvalue*gradient_coef[i];
+      }
+    }
+  }
+}
 }
 }
 }
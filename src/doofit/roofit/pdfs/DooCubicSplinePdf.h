@@ -25,6 +25,8 @@
 
 // from DooFit
 #include "DooCubicSplineKnot.h"
+#include "doofit/roofit/functions/AbsAnalyticGradient.h"
+#include "doofit/roofit/functions/AbsBatchEvaluation.h"
 
 // from LHCb P2VV
 // #include "P2VV/RooCubicSplineKnot.h"
@@ -34,7 +36,8 @@ namespace doofit {
 namespace roofit {
 namespace pdfs {
 
-class DooCubicSplinePdf : public RooAbsPdf {
+class DooCubicSplinePdf : public RooAbsPdf, public doofit::roofit::functions::AbsAnalyticGradient, 
+                          public doofit::roofit::functions::AbsBatchEvaluation {
 public:
   DooCubicSplinePdf();
 
@@ -63,6 +66,17 @@ public:
   const std::vector<double>& knots() const { return _aux.knots(); }
   const RooArgList& coefficients() const { return _coefList; }
 
+  /// derivatives w.r.t. parameters of the coefficients (value and integral are linear in the coefficients)
+  void AnalyticalGradient(const RooArgList& parameters, const RooArgSet* nset, 
+                          std::vector<double>& gradient, std::vector<bool>& available) const;
+
+  /// normalisation and derivatives of the coefficients for AnalyticalGradient(...)
+  void PrepareGradient(const RooArgList& parameters, const RooArgSet* nset) const;
+
+  /// values for a range of events (coefficients are read once, not per event)
+  bool EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                     const RooArgSet* nset, double* output) const;
+
 protected:
 
 private:
@@ -73,6 +87,18 @@ private:
   double _range_min;
   double _range_max;
 
+  // state of PrepareGradient(...) and buffers for AnalyticalGradient(...)
+  mutable std::vector<double> _gradCoefValues;     //! values of the coefficients
+  mutable std::vector<double> _gradCoefGradients;  //! derivatives of the coefficients (coefficient-major)
+  mutable std::vector<bool>   _gradAvailable;      //! whether derivatives are available
+  mutable std::vector<double> _gradIntegralBasis;  //! derivatives of the integral over x
+  mutable double              _gradIntegral;       //! integral over x
+  mutable double              _gradNorm;           //! full normalisation
+  mutable bool                _gradNormX;          //! whether normalised over x
+  mutable std::vector<double> _gradBasis;          //! basis splines at x
+  mutable std::vector<double> _gradCoefDerivative; //! buffer for derivatives of one coefficient
+  mutable std::vector<bool>   _gradCoefAvailable;  //! buffer for availability of one coefficient
+
   void init(const char* name, const std::vector<double>& heights,
             const std::vector<double>& errors, double smooth, bool constCoeffs);
 
@@ -53,6 +53,19 @@ namespace pdfs {
 
 
 
+ bool RectangularPdf::EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                                    const RooArgSet* nset, double* output) const
+ {
+   const double value = 1.0/(nset ? getNorm(nset) : 1.0);
+   Evaluate(x_.arg(), data, begin, end, 0, output);
+   for (std::size_t i=0; i<end-begin; ++i) {
+     output[i] = ((output[i] >= range_min_) && (output[i] <= range_max_)) ? value : 0.0;
+   }
+   return true;
+ }
+
+
+
  Int_t RectangularPdf::getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* /*rangeName*/) const  
  { 
    // std::printf("In %s line %u (%s): allVars = ", __func__, __LINE__, __FILE__);
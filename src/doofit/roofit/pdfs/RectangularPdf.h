@@ -17,11 +17,13 @@
 #include "RooAbsReal.h"
 #include "RooAbsCategory.h"
 
+#include "doofit/roofit/functions/AbsBatchEvaluation.h"
+
 namespace doofit {
 namespace roofit {
 namespace pdfs {
 
-class RectangularPdf : public RooAbsPdf {
+class RectangularPdf : public RooAbsPdf, public doofit::roofit::functions::AbsBatchEvaluation {
 public:
   RectangularPdf() {} ; 
   RectangularPdf(const std::string name,
@@ -35,6 +37,9 @@ public:
   Int_t getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* rangeName=0) const ;
   Double_t analyticalIntegral(Int_t code, const char* rangeName=0) const ;
 
+  bool EvaluateBatch(const doofit::roofit::functions::BatchData& data, std::size_t begin, std::size_t end, 
+                     const RooArgSet* nset, double* output) const;
+
 protected:
 
   RooRealProxy x_ ;
@@ -12,4 +12,12 @@
  *
  *  This namespace is responsible for scanning of parameters over multiple dimensions.
  *
- */
\ No newline at end of file
+ */
+ /** @namespace doofit::tools::workers
+ *
+ *  @brief Tools for forked worker processes
+ *
+ *  This namespace is responsible for running tasks in forked processes and 
+ *  for keeping background threads out of ROOT while forking.
+ *
+ */
@@ -0,0 +1,225 @@
+#ifndef DOOFIT_TOOLS_WORKERS_FORKEDWORKERS_h
+#define DOOFIT_TOOLS_WORKERS_FORKEDWORKERS_h
+
+// STL
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// POSIX/UNIX
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// BOOST
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+// ROOT
+#include "TBufferFile.h"
+#include "TObject.h"
+
+// from RooFit
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+
+namespace doofit {
+namespace tools {
+namespace workers {
+
+/** @brief Lock between background threads in ROOT/RooFit and fork()
+ *
+ *  A forked child only contains the forking thread. If any other thread is
+ *  inside ROOT or RooFit at that time (e.g. writing a TFile or creating
+ *  RooFit objects), the child inherits half-modified global state and locks
+ *  that are never released. Therefore, background threads hold a
+ *  ThreadSection while they are in ROOT or RooFit and Fork() waits until
+ *  none is held. Sections must not be held while waiting for the thread
+ *  calling Fork() (e.g. for space in a queue it consumes).
+ *
+ *  @return the process-wide mutex
+ */
+inline boost::shared_mutex& ForkMutex() {
+  static boost::shared_mutex mutex;
+  return mutex;
+}
+
+/** @brief Section of a background thread in ROOT/RooFit (see ForkMutex())
+ *
+ *  Usage: ThreadSection section(ForkMutex()); with section.unlock() and
+ *  section.lock() around waits.
+ */
+typedef boost::shared_lock<boost::shared_mutex> ThreadSection;
+
+/** @brief fork() while no other thread is in a ThreadSection
+ *
+ *  Output streams are flushed before, so that buffered output is not
+ *  written twice.
+ *
+ *  @return result of fork()
+ */
+inline pid_t Fork() {
+  boost::unique_lock<boost::shared_mutex> lock(ForkMutex());
+  std::cout.flush();
+  std::cerr.flush();
+  return fork();
+}
+
+/** @brief Write size bytes into a pipe
+ *
+ *  @return false if the pipe is closed
+ */
+inline bool WriteAll(int fd, const char* data, std::size_t size) {
+  std::size_t num_written = 0;
+  while (num_written < size) {
+    ssize_t n = write(fd, data+num_written, size-num_written);
+    if (n <= 0) return false;
+    num_written += n;
+  }
+  return true;
+}
+
+/** @brief Read size bytes from a pipe
+ *
+ *  @return false if the pipe is closed before size bytes are read
+ */
+inline bool ReadAll(int fd, char* data, std::size_t size) {
+  std::size_t num_read = 0;
+  while (num_read < size) {
+    ssize_t n = read(fd, data+num_read, size-num_read);
+    if (n <= 0) return false;
+    num_read += n;
+  }
+  return true;
+}
+
+/** @brief Serialise a ROOT object (e.g. RooFitResult, RooDataSet)
+ */
+inline std::vector<char> SerialiseObject(const TObject& object) {
+  TBufferFile buffer(TBuffer::kWrite);
+  buffer.WriteObject(&object);
+  return std::vector<char>(buffer.Buffer(), buffer.Buffer()+buffer.Length());
+}
+
+/** @brief Deserialise a ROOT object serialised by SerialiseObject()
+ *
+ *  @return the object (caller takes ownership) or NULL
+ */
+template <class T>
+T* DeserialiseObject(std::vector<char>& bytes) {
+  if (bytes.empty()) return NULL;
+  TBufferFile buffer(TBuffer::kRead, bytes.size(), bytes.data(), kFALSE);
+  return dynamic_cast<T*>(buffer.ReadObject(T::Class()));
+}
+
+/** @brief Serialise a trivially copyable value
+ */
+template <class T>
+std::vector<char> SerialisePlain(const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "SerialisePlain needs a trivially copyable type");
+  const char* data = reinterpret_cast<const char*>(&value);
+  return std::vector<char>(data, data+sizeof(T));
+}
+
+/** @brief Deserialise a value serialised by SerialisePlain()
+ *
+ *  @return false if the size does not match
+ */
+template <class T>
+bool DeserialisePlain(const std::vector<char>& bytes, T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "DeserialisePlain needs a trivially copyable type");
+  if (bytes.size() != sizeof(T)) return false;
+  std::memcpy(&value, bytes.data(), sizeof(T));
+  return true;
+}
+
+/** @brief Run tasks in forked worker processes
+ *
+ *  As RooFit is not thread-safe, tasks run concurrently in processes. Each
+ *  of @a num_workers processes is forked via Fork(), runs an interleaved
+ *  subset of the tasks on its (copy-on-write) copy of the calling process
+ *  and sends back the serialised results via a pipe. A worker stops at the
+ *  first task that throws or returns no result and leaves via _exit()
+ *  without any cleanup of the parent's state.
+ *
+ *  Results not delivered (e.g. if a worker cannot be started or fails) are
+ *  not received, i.e. the caller runs these tasks itself.
+ *
+ *  @param num_tasks number of tasks
+ *  @param num_workers number of worker processes
+ *  @param run runs a task in a worker and returns its serialised result (empty on failure)
+ *  @param receive gets index and serialised result of a task in the calling process
+ *  @return number of worker processes started
+ */
+inline unsigned int RunInWorkers(std::size_t num_tasks, unsigned int num_workers,
+                                 const std::function<std::vector<char>(std::size_t)>& run,
+                                 const std::function<void(std::size_t, std::vector<char>&)>& receive) {
+  using namespace doocore::io;
+
+  std::vector<std::pair<pid_t, int> > workers;
+  for (unsigned int index_worker=0; index_worker<num_workers && index_worker<num_tasks; ++index_worker) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      swarn << "Cannot create pipe for worker process. Running remaining tasks serially." << endmsg;
+      break;
+    }
+
+    pid_t pid = Fork();
+    if (pid < 0) {
+      swarn << "Cannot fork worker process. Running remaining tasks serially." << endmsg;
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      break;
+    } else if (pid == 0) {
+      close(pipe_fds[0]);
+      for (std::size_t i=index_worker; i<num_tasks; i+=num_workers) {
+        std::vector<char> bytes;
+        try {
+          bytes = run(i);
+        } catch (...) {
+          // leave it to the parent to rerun and report
+          break;
+        }
+        std::int64_t header[2] = {static_cast<std::int64_t>(i), static_cast<std::int64_t>(bytes.size())};
+        if (bytes.empty() ||
+            !WriteAll(pipe_fds[1], reinterpret_cast<const char*>(header), sizeof(header)) ||
+            !WriteAll(pipe_fds[1], bytes.data(), bytes.size())) {
+          break;
+        }
+      }
+      close(pipe_fds[1]);
+      _exit(0);
+    } else {
+      close(pipe_fds[1]);
+      workers.push_back(std::make_pair(pid, pipe_fds[0]));
+    }
+  }
+
+  for (auto worker : workers) {
+    std::int64_t header[2];
+    while (ReadAll(worker.second, reinterpret_cast<char*>(header), sizeof(header)) && header[1] > 0) {
+      std::vector<char> bytes(header[1]);
+      if (!ReadAll(worker.second, bytes.data(), bytes.size())) break;
+      if (header[0] >= 0 && static_cast<std::size_t>(header[0]) < num_tasks) {
+        receive(header[0], bytes);
+      }
+    }
+    close(worker.second);
+    int status = 0;
+    waitpid(worker.first, &status, 0);
+  }
+  return workers.size();
+}
+
+} // namespace workers
+} // namespace tools
+} // namespace doofit
+
+#endif // DOOFIT_TOOLS_WORKERS_FORKEDWORKERS_h
@@ -0,0 +1,178 @@
+#include "doofit/toy/ToyCampaign/ToyCampaign.h"
+
+// STL
+#include <string>
+#include <algorithm>
+
+// ROOT
+#include "TStopwatch.h"
+
+// from RooFit
+#include "RooDataSet.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "doofit/toy/ToyFactoryStd/ToyFactoryStd.h"
+#include "doofit/toy/ToyFactoryStd/ToyWorkerPool.h"
+#include "doofit/toy/ToyStudyStd/ToyStudyStd.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  ToyCampaign::ToyCampaign(ToyFactoryStd& factory, ToyStudyStd& study, FitFunction fit, unsigned int num_producers, unsigned int queue_depth, unsigned int store_queue_depth, unsigned int block_size) :
+  factory_(factory),
+  study_(study),
+  fit_(fit),
+  num_producers_(num_producers),
+  queue_depth_(queue_depth > 0 ? queue_depth : 1),
+  store_queue_depth_(store_queue_depth > 0 ? store_queue_depth : 1),
+  block_size_(block_size > 0 ? block_size : 1),
+  pool_(),
+  statistics_(),
+  failed_toys_()
+  {}
+
+  ToyCampaign::~ToyCampaign() {}
+
+  void ToyCampaign::Run(unsigned int num_toys, std::uint64_t seed, int run_id) {
+    TStopwatch sw_total;
+    sw_total.Start();
+    sinfo << "Running toy campaign for " << num_toys << " toys with " << num_producers_ << " producer processes." << endmsg;
+
+    bool parallel = false;
+    if (num_producers_ > 0 && num_toys > 0) {
+      pool_.reset(new ToyWorkerPool(factory_, num_producers_, block_size_, queue_depth_));
+      parallel = pool_->Start(num_toys, seed);
+      if (!parallel) {
+        swarn << "Cannot start producer processes. Generating serially." << endmsg;
+      }
+    }
+
+    TStopwatch sw;
+    try {
+      for (unsigned int i=0; i<num_toys; ++i) {
+        // generation stage
+        RooDataSet* data = NULL;
+        unsigned long long index = i;
+        if (parallel) {
+          unsigned int depth = pool_->num_queued();
+          statistics_.generate_queue.sum_depth += depth;
+          statistics_.generate_queue.max_depth = std::max(statistics_.generate_queue.max_depth, depth);
+          ++statistics_.generate_queue.samples;
+
+          double generation_time = 0.0;
+          sw.Start(true);
+          bool delivered = pool_->Next(index, data, generation_time);
+          sw.Stop();
+          statistics_.generate.wait_time += sw.RealTime();
+          statistics_.generate.wall_time += generation_time;
+
+          if (!delivered) {
+            serr << "Producer processes stopped unexpectedly before toy " << i << ". Cannot continue." << endmsg;
+            break;
+          }
+          ++statistics_.generate.count;
+
+          if (data == NULL) {
+            // producer crashed, the pool already reported it
+            FailedToy failed_toy = {index, factory_.ToySeed(index, seed), run_id};
+            failed_toys_.push_back(failed_toy);
+            ++statistics_.num_failed;
+            continue;
+          }
+        } else {
+          sw.Start(true);
+          factory_.PrepareToy(i, seed);
+          data = factory_.Generate();
+          sw.Stop();
+          statistics_.generate.wall_time += sw.RealTime();
+          statistics_.generate.wait_time += sw.RealTime();
+          ++statistics_.num_generated_serially;
+          ++statistics_.generate.count;
+        }
+
+        if (data == NULL) {
+          serr << "No dataset generated for toy " << i << ". Skipping fit." << endmsg;
+          continue;
+        }
+
+        // fit stage
+        TStopwatch sw_fit;
+        sw_fit.Start(true);
+        FitResults results = fit_(*data);
+        sw_fit.Stop();
+        delete data;
+        statistics_.fit.wall_time += sw_fit.RealTime();
+        ++statistics_.fit.count;
+
+        // store stage (deferred saving in ToyStudyStd)
+        unsigned int depth = study_.num_fit_results_pending();
+        statistics_.store_queue.sum_depth += depth;
+        statistics_.store_queue.max_depth = std::max(statistics_.store_queue.max_depth, depth);
+        ++statistics_.store_queue.samples;
+
+        sw.Start(true);
+        study_.WaitForPendingFitResults(store_queue_depth_-1);
+        sw.Stop();
+        statistics_.store.wait_time += sw.RealTime();
+
+        if (results.fit_result1 == NULL) {
+          serr << "No fit result for toy " << i << ". Cannot store fit result." << endmsg;
+          if (results.fit_result2 != NULL) delete results.fit_result2;
+          continue;
+        }
+
+        sw.Start(true);
+        study_.StoreFitResult(results.fit_result1, results.fit_result2, &sw_fit, NULL, static_cast<long long>(factory_.ToySeed(index, seed)), run_id);
+        sw.Stop();
+        statistics_.store.wall_time += sw.RealTime();
+        ++statistics_.store.count;
+      }
+    } catch (...) {
+      pool_.reset();
+      throw;
+    }
+    pool_.reset();
+
+    sw_total.Stop();
+    statistics_.total_time += sw_total.RealTime();
+  }
+
+  void ToyCampaign::PrintStatistics() const {
+    const Statistics& s = statistics_;
+    auto per_toy = [](double time, unsigned long long count) {
+      return count > 0 ? time/count : 0.0;
+    };
+
+    sinfo << "Toy campaign statistics for " << s.generate.count << " toys (" << s.total_time << " s wall time):" << endmsg;
+    sinfo.set_indent(sinfo.indent()+2);
+    sinfo << "Generation: " << s.generate.wall_time << " s (" << per_toy(s.generate.wall_time, s.generate.count) << " s per toy, " << num_producers_ << " producers, " << s.num_generated_serially << " toys generated serially, " << s.num_failed << " failed), fit waited " << s.generate.wait_time << " s" << endmsg;
+    sinfo << "Fit:        " << s.fit.wall_time << " s (" << per_toy(s.fit.wall_time, s.fit.count) << " s per toy)" << endmsg;
+    sinfo << "Store:      " << s.store.wall_time << " s (" << per_toy(s.store.wall_time, s.store.count) << " s per toy), fit waited " << s.store.wait_time << " s for pending fit results" << endmsg;
+    sinfo << "Queue of generated toys:   mean depth " << s.generate_queue.mean_depth() << ", max depth " << s.generate_queue.max_depth << " (limit " << queue_depth_*num_producers_ << ")" << endmsg;
+    sinfo << "Queue of pending results:  mean depth " << s.store_queue.mean_depth() << ", max depth " << s.store_queue.max_depth << " (limit " << store_queue_depth_ << ")" << endmsg;
+
+    // the fitting process is the only serial part: if it waited for
+    // another stage, that stage limits the throughput
+    std::string limit("fit");
+    double wait_threshold = 0.05*s.total_time;
+    if (s.generate.wait_time > wait_threshold && s.generate.wait_time >= s.store.wait_time) {
+      limit = "generation";
+    } else if (s.store.wait_time > wait_threshold) {
+      limit = "storage";
+    }
+    sinfo << "Throughput is limited by " << limit << "." << endmsg;
+
+    if (!failed_toys_.empty()) {
+      swarn << failed_toys_.size() << " toys failed in generation (index, seed, run id):" << endmsg;
+      for (auto& failed_toy : failed_toys_) {
+        swarn << "  " << failed_toy.index << ", " << failed_toy.seed << ", " << failed_toy.run_id << endmsg;
+      }
+    }
+    sinfo.set_indent(sinfo.indent()-2);
+  }
+} // namespace toy
+} // namespace doofit
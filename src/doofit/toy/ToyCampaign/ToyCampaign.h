@@ -0,0 +1,201 @@
+#ifndef TOYCAMPAIGN_h
+#define TOYCAMPAIGN_h
+
+// STL
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class RooDataSet;
+class RooFitResult;
+
+namespace doofit {
+namespace toy {
+  class ToyFactoryStd;
+  class ToyStudyStd;
+  class ToyWorkerPool;
+
+  /** @class ToyCampaign
+   *  @brief Pipelined generate, fit and store driver for toy studies
+   *
+   *  A toy campaign runs the three stages of a toy study overlapped instead of
+   *  one after another:
+   *
+   *   -# generation: a ToyWorkerPool of producer processes (forked from the
+   *      calling process, as RooFit is not thread-safe) generates toys with
+   *      the given ToyFactoryStd and sends them back in order via a pipe.
+   *   -# fit: the calling process fits the toys in order using the supplied
+   *      fit function while the next toys are generated.
+   *   -# store: fit results are passed to ToyStudyStd::StoreFitResult() and
+   *      saved by its deferred saver thread.
+   *
+   *  Stages are connected via bounded queues: at most @a queue_depth generated
+   *  toys per producer are kept ahead of the fit and the fit waits if the
+   *  saver has more than @a store_queue_depth fit results pending.
+   *
+   *  Each toy is prepared via ToyFactoryStd::PrepareToy() with its index, so
+   *  that the generated toys do not depend on the number of producers (with
+   *  ToyFactoryStdConfig::set_random_streams(bool) they are identical to toys
+   *  generated serially by the same toy factory). If generation of a toy
+   *  crashes its producer, the toy is skipped and listed with its index and
+   *  seed (see failed_toys() and ToyFactoryStd::ToySeed()), while the 
+   *  remaining toys are generated by new producers. With zero producers, all
+   *  stages run serially.
+   *
+   *  Wall time per stage and queue depths are counted (see statistics() and
+   *  PrintStatistics()) to identify the stage limiting the throughput.
+   *
+   *  Usage example:
+   *
+   *  @code
+   *  ToyCampaign campaign(tfac, tstudy, [&](RooDataSet& data) {
+   *    ToyCampaign::FitResults results;
+   *    results.fit_result1 = pdf->fitTo(data, RooFit::Save(true));
+   *    return results;
+   *  }, 2);
+   *  campaign.Run(100);
+   *  campaign.PrintStatistics();
+   *  tstudy.FinishFitResultSaving();
+   *  @endcode
+   */
+  class ToyCampaign {
+   public:
+    /**
+     *  @brief Fit results of one toy (ownership is passed to ToyStudyStd)
+     */
+    struct FitResults {
+      FitResults() : fit_result1(NULL), fit_result2(NULL) {}
+      const RooFitResult* fit_result1;
+      const RooFitResult* fit_result2;
+    };
+
+    /**
+     *  @brief Function fitting one toy
+     */
+    typedef std::function<FitResults(RooDataSet&)> FitFunction;
+
+    /**
+     *  @brief Counters of one pipeline stage
+     */
+    struct StageStatistics {
+      StageStatistics() : wall_time(0.0), wait_time(0.0), count(0) {}
+      /**
+       *  @brief Summed wall time spent working in this stage
+       */
+      double wall_time;
+      /**
+       *  @brief Summed wall time the fit waited for this stage
+       */
+      double wait_time;
+      /**
+       *  @brief Number of toys processed in this stage
+       */
+      unsigned long long count;
+    };
+
+    /**
+     *  @brief Counters of a queue between two stages
+     */
+    struct QueueStatistics {
+      QueueStatistics() : sum_depth(0.0), max_depth(0), samples(0) {}
+      double mean_depth() const { return samples > 0 ? sum_depth/samples : 0.0; }
+      double sum_depth;
+      unsigned int max_depth;
+      unsigned long long samples;
+    };
+
+    /**
+     *  @brief All counters of a campaign
+     */
+    struct Statistics {
+      Statistics() : total_time(0.0), num_generated_serially(0), num_failed(0) {}
+      StageStatistics generate;
+      StageStatistics fit;
+      StageStatistics store;
+      QueueStatistics generate_queue;
+      QueueStatistics store_queue;
+      double total_time;
+      unsigned long long num_generated_serially;
+      unsigned long long num_failed;
+    };
+
+    /**
+     *  @brief A toy whose generation crashed
+     */
+    struct FailedToy {
+      unsigned long long index;
+      std::uint64_t seed;
+      int run_id;
+    };
+
+    /**
+     *  @brief Constructor for ToyCampaign
+     *
+     *  @param factory toy factory to generate toys with
+     *  @param study toy study to store fit results with
+     *  @param fit function fitting a toy
+     *  @param num_producers number of producer processes (0 for serial generation)
+     *  @param queue_depth maximum number of generated toys per producer waiting to be fitted
+     *  @param store_queue_depth maximum number of fit results waiting to be saved
+     *  @param block_size number of toys generated by one producer process before it is replaced
+     */
+    ToyCampaign(ToyFactoryStd& factory, ToyStudyStd& study, FitFunction fit, unsigned int num_producers=1, unsigned int queue_depth=2, unsigned int store_queue_depth=64, unsigned int block_size=16);
+
+    /**
+     *  @brief Destructor
+     */
+    ~ToyCampaign();
+
+    /**
+     *  @brief Generate, fit and store toys
+     *
+     *  @param num_toys number of toys
+     *  @param seed base seed for toys without random streams (see ToyFactoryStd::PrepareToy())
+     *  @param run_id run id passed to ToyStudyStd::StoreFitResult()
+     *
+     *  Fit results are stored with the seed of their toy (see 
+     *  ToyFactoryStd::ToySeed()), so that (run_id, seed) is unique per toy.
+     */
+    void Run(unsigned int num_toys, std::uint64_t seed=0, int run_id=0);
+
+    /**
+     *  @brief Counters of all runs so far
+     */
+    const Statistics& statistics() const { return statistics_; }
+
+    /**
+     *  @brief Toys of all runs so far whose generation crashed
+     */
+    const std::vector<FailedToy>& failed_toys() const { return failed_toys_; }
+
+    /**
+     *  @brief Print counters and the stage limiting the throughput
+     */
+    void PrintStatistics() const;
+
+   private:
+    ToyFactoryStd& factory_;
+    ToyStudyStd& study_;
+    FitFunction fit_;
+    unsigned int num_producers_;
+    unsigned int queue_depth_;
+    unsigned int store_queue_depth_;
+    unsigned int block_size_;
+
+    std::unique_ptr<ToyWorkerPool> pool_;
+
+    Statistics statistics_;
+    std::vector<FailedToy> failed_toys_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // TOYCAMPAIGN_h
@@ -0,0 +1,290 @@
+#include "doofit/toy/ToyFactoryStd/BinnedHistogram.h"
+
+// STL
+#include <cmath>
+#include <utility>
+#include <algorithm>
+
+// ROOT
+#include "TIterator.h"
+
+// from RooFit
+#include "RooAbsPdf.h"
+#include "RooDataSet.h"
+#include "RooRealVar.h"
+#include "RooAbsRealLValue.h"
+#include "RooAbsCategoryLValue.h"
+#include "RooAbsBinning.h"
+#include "RooUniformBinning.h"
+#include "RooCatType.h"
+#include "RooGlobalFunc.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "doofit/toy/ToyFactoryStd/ColumnarDataset.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  BinnedHistogram::BinnedHistogram(const RooArgSet& observables, const std::map<std::string, int>& num_bins, const std::map<std::string, std::vector<double>>& values) :
+  observables_(observables),
+  valid_(true)
+  {
+    unsigned long long stride = 1;
+    TIterator* it = observables_.createIterator();
+    RooAbsArg* arg = NULL;
+    while ((arg = (RooAbsArg*)it->Next())) {
+      Dimension dimension;
+      dimension.name     = arg->GetName();
+      dimension.real     = dynamic_cast<RooAbsRealLValue*>(arg);
+      dimension.category = dynamic_cast<RooAbsCategoryLValue*>(arg);
+      dimension.binning  = NULL;
+
+      std::map<std::string, std::vector<double>>::const_iterator it_values = values.find(dimension.name);
+      if (it_values != values.end() && (dimension.real != NULL || dimension.category != NULL)) {
+        dimension.values = it_values->second;
+      } else if (dimension.real != NULL && dimension.real->hasMin() && dimension.real->hasMax()) {
+        std::map<std::string, int>::const_iterator it_bins = num_bins.find(dimension.name);
+        if (it_bins != num_bins.end() && it_bins->second > 0) {
+          owned_binnings_.push_back(new RooUniformBinning(dimension.real->getMin(), dimension.real->getMax(), it_bins->second));
+          dimension.binning = owned_binnings_.back();
+        } else {
+          dimension.binning = &dimension.real->getBinning();
+        }
+      } else if (dimension.category != NULL) {
+        TIterator* type_it = dimension.category->typeIterator();
+        RooCatType* type = NULL;
+        while ((type = (RooCatType*)type_it->Next())) {
+          dimension.values.push_back(type->getVal());
+        }
+        delete type_it;
+      } else {
+        serr << "BinnedHistogram: Observable " << arg->GetName() << " cannot be binned." << endmsg;
+        valid_ = false;
+      }
+
+      dimension.size   = dimension.binning != NULL ? dimension.binning->numBins() : dimension.values.size();
+      dimension.stride = stride;
+      if (dimension.size == 0) {
+        serr << "BinnedHistogram: Observable " << arg->GetName() << " has no bins." << endmsg;
+        valid_ = false;
+        dimension.size = 1;
+      }
+      stride *= dimension.size;
+      dimensions_.push_back(dimension);
+    }
+    delete it;
+
+    contents_.assign(stride, 0.0);
+  }
+
+  BinnedHistogram::~BinnedHistogram() {
+    for (auto binning : owned_binnings_) {
+      delete binning;
+    }
+  }
+
+  bool BinnedHistogram::FillFromPdf(RooAbsPdf& pdf, double yield) {
+    if (!valid_) return false;
+    RooArgSet* snapshot = dynamic_cast<RooArgSet*>(observables_.snapshot());
+
+    unsigned long long num_bins = contents_.size();
+    if (dimensions_.size() == 1 && dimensions_[0].binning != NULL) {
+      // integrals over bins from the cumulative distribution
+      RooAbsReal* cdf = pdf.createCdf(observables_);
+      RooAbsRealLValue& real = *dimensions_[0].real;
+      const RooAbsBinning& binning = *dimensions_[0].binning;
+
+      real.setVal(binning.binLow(0));
+      double cdf_low = cdf->getVal();
+      for (unsigned long long bin=0; bin<num_bins; ++bin) {
+        real.setVal(binning.binHigh(bin));
+        double cdf_high = cdf->getVal();
+        contents_[bin] = std::max(cdf_high-cdf_low, 0.0);
+        cdf_low = cdf_high;
+      }
+      delete cdf;
+    } else {
+      for (unsigned long long bin=0; bin<num_bins; ++bin) {
+        double volume = SetBin(bin);
+        contents_[bin] = std::max(pdf.getVal(&observables_)*volume, 0.0);
+      }
+    }
+
+    observables_ = *snapshot;
+    delete snapshot;
+
+    double sum = Sum();
+    if (!(sum > 0.0) || !std::isfinite(sum)) {
+      serr << "BinnedHistogram: Bin integrals of PDF " << pdf.GetName() << " cannot be normalised (sum = " << sum << ")." << endmsg;
+      contents_.assign(num_bins, 0.0);
+      return false;
+    }
+    Scale(yield/sum);
+    return true;
+  }
+
+  void BinnedHistogram::Add(const BinnedHistogram& other, double scale, bool spread) {
+    std::vector<int> other_to_this(other.dimensions_.size());
+    std::vector<bool> shared(dimensions_.size(), false);
+    for (unsigned int d=0; d<other.dimensions_.size(); ++d) {
+      other_to_this[d] = DimensionIndex(other.dimensions_[d].name);
+      if (other_to_this[d] >= 0) {
+        shared[other_to_this[d]] = true;
+      }
+    }
+
+    // all bins of dimensions missing in other (offset and fraction)
+    std::vector<std::pair<unsigned long long, double>> spread_bins(1, std::make_pair(0ULL, 1.0));
+    for (unsigned int d=0; d<dimensions_.size(); ++d) {
+      if (shared[d]) continue;
+      std::vector<std::pair<unsigned long long, double>> spread_bins_new;
+      for (auto& spread_bin : spread_bins) {
+        for (unsigned long long index=0; index<dimensions_[d].size; ++index) {
+          double fraction = spread ? Fraction(dimensions_[d], index) : 1.0;
+          spread_bins_new.push_back(std::make_pair(spread_bin.first + index*dimensions_[d].stride, spread_bin.second*fraction));
+        }
+      }
+      spread_bins.swap(spread_bins_new);
+    }
+
+    for (unsigned long long other_bin=0; other_bin<other.contents_.size(); ++other_bin) {
+      double content = other.contents_[other_bin]*scale;
+      if (content == 0.0) continue;
+
+      unsigned long long bin = 0;
+      bool found = true;
+      for (unsigned int d=0; d<other.dimensions_.size() && found; ++d) {
+        // dimensions only in other are summed over
+        if (other_to_this[d] < 0) continue;
+        const Dimension& dimension = dimensions_[other_to_this[d]];
+        long long index = MatchIndex(dimension, other.dimensions_[d], (other_bin/other.dimensions_[d].stride) % other.dimensions_[d].size);
+        if (index < 0) {
+          found = false;
+        } else {
+          bin += index*dimension.stride;
+        }
+      }
+      if (!found) continue;
+
+      for (auto& spread_bin : spread_bins) {
+        contents_[bin+spread_bin.first] += content*spread_bin.second;
+      }
+    }
+  }
+
+  bool BinnedHistogram::Multiply(const BinnedHistogram& other) {
+    std::vector<int> other_to_this(other.dimensions_.size());
+    for (unsigned int d=0; d<other.dimensions_.size(); ++d) {
+      other_to_this[d] = DimensionIndex(other.dimensions_[d].name);
+      if (other_to_this[d] < 0) {
+        return false;
+      }
+    }
+
+    for (unsigned long long bin=0; bin<contents_.size(); ++bin) {
+      unsigned long long other_bin = 0;
+      bool found = true;
+      for (unsigned int d=0; d<other.dimensions_.size() && found; ++d) {
+        const Dimension& dimension = dimensions_[other_to_this[d]];
+        long long index = MatchIndex(other.dimensions_[d], dimension, (bin/dimension.stride) % dimension.size);
+        if (index < 0) {
+          found = false;
+        } else {
+          other_bin += index*other.dimensions_[d].stride;
+        }
+      }
+      contents_[bin] *= found ? other.contents_[other_bin] : 0.0;
+    }
+    return true;
+  }
+
+  void BinnedHistogram::Scale(double scale) {
+    for (auto& content : contents_) {
+      content *= scale;
+    }
+  }
+
+  double BinnedHistogram::Sum() const {
+    double sum = 0.0;
+    for (auto content : contents_) {
+      sum += content;
+    }
+    return sum;
+  }
+
+  double BinnedHistogram::SetBin(unsigned long long bin) const {
+    double volume = 1.0;
+    for (auto& dimension : dimensions_) {
+      unsigned long long index = (bin/dimension.stride) % dimension.size;
+      if (dimension.binning != NULL) {
+        dimension.real->setVal(dimension.binning->binCenter(index));
+        volume *= dimension.binning->binWidth(index);
+      } else if (dimension.real != NULL) {
+        dimension.real->setVal(dimension.values[index]);
+      } else if (dimension.category != NULL) {
+        dimension.category->setIndex(static_cast<int>(dimension.values[index]));
+      }
+    }
+    return volume;
+  }
+
+  RooDataSet* BinnedHistogram::CreateDataSet(const std::string& name) const {
+    RooRealVar weight(ColumnarDataset::weight_name(), ColumnarDataset::weight_name(), 0.0);
+    RooArgSet vars(observables_);
+    vars.add(weight);
+    return new RooDataSet(name.c_str(), name.c_str(), vars, RooFit::WeightVar(weight));
+  }
+
+  RooDataSet* BinnedHistogram::ToDataSet(const std::string& name) const {
+    RooDataSet* data = CreateDataSet(name);
+    RooArgSet* snapshot = dynamic_cast<RooArgSet*>(observables_.snapshot());
+    for (unsigned long long bin=0; bin<contents_.size(); ++bin) {
+      if (contents_[bin] > 0.0) {
+        SetBin(bin);
+        data->add(observables_, contents_[bin]);
+      }
+    }
+    // restore through a non-owning copy as observables_ is const here
+    RooArgSet observables(observables_);
+    observables = *snapshot;
+    delete snapshot;
+    return data;
+  }
+
+  double BinnedHistogram::Fraction(const Dimension& dimension, unsigned long long index) const {
+    if (dimension.binning != NULL) {
+      return dimension.binning->binWidth(index)/(dimension.binning->highBound()-dimension.binning->lowBound());
+    } else {
+      return 1.0/dimension.size;
+    }
+  }
+
+  long long BinnedHistogram::MatchIndex(const Dimension& dimension, const Dimension& other, unsigned long long other_index) {
+    double value = other.binning != NULL ? other.binning->binCenter(other_index) : other.values[other_index];
+    if (dimension.binning != NULL) {
+      if (value < dimension.binning->lowBound() || value >= dimension.binning->highBound()) {
+        return -1;
+      }
+      return dimension.binning->binNumber(value);
+    } else {
+      for (unsigned long long index=0; index<dimension.size; ++index) {
+        if (std::abs(dimension.values[index]-value) <= 1e-9*std::max(1.0, std::abs(value))) {
+          return index;
+        }
+      }
+      return -1;
+    }
+  }
+
+  int BinnedHistogram::DimensionIndex(const std::string& name) const {
+    for (unsigned int d=0; d<dimensions_.size(); ++d) {
+      if (dimensions_[d].name == name) return static_cast<int>(d);
+    }
+    return -1;
+  }
+} // namespace toy
+} // namespace doofit
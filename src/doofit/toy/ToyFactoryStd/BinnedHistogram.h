@@ -0,0 +1,256 @@
+#ifndef BINNEDHISTOGRAM_h
+#define BINNEDHISTOGRAM_h
+
+// STL
+#include <string>
+#include <vector>
+#include <map>
+
+// ROOT
+
+// from RooFit
+#include "RooArgSet.h"
+
+// from project
+
+// forward declarations
+class RooAbsPdf;
+class RooAbsArg;
+class RooAbsRealLValue;
+class RooAbsCategoryLValue;
+class RooAbsBinning;
+class RooDataSet;
+
+namespace doofit {
+namespace toy {
+  /** @class BinnedHistogram
+   *  @brief Contents on a grid of bins in a set of observables
+   *
+   *  Each observable is one dimension of the grid:
+   *
+   *   - continuous observables (RooAbsRealLValue) are binned in their own
+   *     binning (RooRealVar::setBins(...)) or in a given number of uniform
+   *     bins in their range,
+   *   - discrete observables (RooAbsCategoryLValue) contribute all their
+   *     states,
+   *   - for both, a list of values (resp. category indices) can be given
+   *     instead, e.g. for discrete distributions of continuous variables or
+   *     to restrict a category to one state.
+   *
+   *  The contents can be filled with the bin integrals of a PDF (see
+   *  FillFromPdf()) and histograms in different sets of observables can be
+   *  combined via Add() and Multiply(). The observables are not owned; the
+   *  histogram sets their values to bin centres only temporarily.
+   *
+   *  This is the common ground of binned generation (see BinnedSampler) and
+   *  Asimov datasets (see ToyFactoryStd::GenerateAsimov()).
+   */
+  class BinnedHistogram {
+   public:
+    /**
+     *  @brief Constructor for an empty histogram
+     *
+     *  Check IsValid() before use.
+     *
+     *  @param observables the observables spanning the grid
+     *  @param num_bins number of uniform bins for continuous observables by
+     *                  name (instead of their own binnings)
+     *  @param values values for continuous observables or category indices
+     *                by name (instead of bins or all states)
+     */
+    BinnedHistogram(const RooArgSet& observables, const std::map<std::string, int>& num_bins=std::map<std::string, int>(), const std::map<std::string, std::vector<double>>& values=std::map<std::string, std::vector<double>>());
+
+    /**
+     *  @brief Destructor
+     */
+    ~BinnedHistogram();
+
+    BinnedHistogram(const BinnedHistogram&) = delete;
+    BinnedHistogram& operator=(const BinnedHistogram&) = delete;
+
+    /**
+     *  @brief Fill with integrals of a PDF over all bins
+     *
+     *  For a single binned continuous observable the bin integrals are taken
+     *  from the cumulative distribution (RooAbsPdf::createCdf(...), analytical
+     *  if supported by the PDF, numerical otherwise). In all other cases, the
+     *  PDF value in the bin centre times the bin volume is used. The contents
+     *  are then scaled to sum up to @a yield.
+     *
+     *  @param pdf the PDF
+     *  @param yield sum of contents
+     *  @return false if the PDF cannot be normalised on this grid
+     */
+    bool FillFromPdf(RooAbsPdf& pdf, double yield);
+
+    /**
+     *  @brief Add contents of another histogram
+     *
+     *  Dimensions only in @a other are summed over. Contents are spread over
+     *  dimensions only in this histogram: uniformly (by bin width, resp.
+     *  equally over values) if @a spread is true, otherwise added in full to
+     *  each bin. Shared dimensions are matched by bin index, resp. value.
+     *
+     *  @param other the histogram to add
+     *  @param scale factor for contents of @a other
+     *  @param spread spread contents over missing dimensions
+     */
+    void Add(const BinnedHistogram& other, double scale=1.0, bool spread=true);
+
+    /**
+     *  @brief Multiply with contents of a histogram in a subset of dimensions
+     *
+     *  @param other the histogram (all its dimensions must be in this one)
+     *  @return false if @a other has other dimensions (nothing is changed)
+     */
+    bool Multiply(const BinnedHistogram& other);
+
+    /**
+     *  @brief Scale all contents
+     */
+    void Scale(double scale);
+
+    /**
+     *  @brief Sum of all contents
+     */
+    double Sum() const;
+
+    /**
+     *  @brief Set observables to the centre (resp. value) of a bin
+     *
+     *  @return the volume of the bin (in binned continuous dimensions)
+     */
+    double SetBin(unsigned long long bin) const;
+
+    /**
+     *  @brief Create an empty weighted dataset in the observables
+     *
+     *  The weight variable is ColumnarDataset::weight_name().
+     *
+     *  @param name name and title of the dataset
+     *  @return the dataset (the caller takes ownership)
+     */
+    RooDataSet* CreateDataSet(const std::string& name) const;
+
+    /**
+     *  @brief Create a weighted dataset with one entry per bin with positive content
+     *
+     *  Observables keep their values.
+     *
+     *  @param name name and title of the dataset
+     *  @return the dataset (the caller takes ownership)
+     */
+    RooDataSet* ToDataSet(const std::string& name) const;
+
+    /**
+     *  @brief Whether all observables could be used as dimensions
+     */
+    bool IsValid() const { return valid_; }
+
+    /**
+     *  @brief The observables
+     */
+    const RooArgSet& observables() const { return observables_; }
+
+    /**
+     *  @brief Number of bins (product of bins in all dimensions)
+     */
+    unsigned long long num_bins() const { return contents_.size(); }
+
+    /**
+     *  @brief Content of a bin
+     */
+    double content(unsigned long long bin) const { return contents_[bin]; }
+
+    /**
+     *  @brief Set content of a bin
+     */
+    void set_content(unsigned long long bin, double content) { contents_[bin] = content; }
+
+   private:
+    /**
+     *  @brief One dimension of the grid
+     */
+    struct Dimension {
+      /**
+       *  @brief Name of the observable
+       */
+      std::string name;
+
+      /**
+       *  @brief The observable if continuous (or NULL)
+       */
+      RooAbsRealLValue* real;
+
+      /**
+       *  @brief The observable if discrete (or NULL)
+       */
+      RooAbsCategoryLValue* category;
+
+      /**
+       *  @brief Binning of a binned continuous observable (or NULL for values)
+       */
+      const RooAbsBinning* binning;
+
+      /**
+       *  @brief Values (resp. category indices) if not binned
+       */
+      std::vector<double> values;
+
+      /**
+       *  @brief Number of bins
+       */
+      unsigned long long size;
+
+      /**
+       *  @brief Index offset of this dimension in the grid
+       */
+      unsigned long long stride;
+    };
+
+    /**
+     *  @brief Fraction of a dimension covered by one of its bins
+     */
+    double Fraction(const Dimension& dimension, unsigned long long index) const;
+
+    /**
+     *  @brief Find the bin of another histogram's dimension in this dimension
+     *
+     *  @return the index or -1 if not found
+     */
+    static long long MatchIndex(const Dimension& dimension, const Dimension& other, unsigned long long other_index);
+
+    /**
+     *  @brief Index of dimension by name (or -1)
+     */
+    int DimensionIndex(const std::string& name) const;
+
+    /**
+     *  @brief Observables (not owned)
+     */
+    RooArgSet observables_;
+
+    /**
+     *  @brief Dimensions of the grid (index runs fastest in first dimension)
+     */
+    std::vector<Dimension> dimensions_;
+
+    /**
+     *  @brief Binnings created for given numbers of bins (owned)
+     */
+    std::vector<RooAbsBinning*> owned_binnings_;
+
+    /**
+     *  @brief Contents of all bins
+     */
+    std::vector<double> contents_;
+
+    /**
+     *  @brief Whether the histogram can be used
+     */
+    bool valid_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // BINNEDHISTOGRAM_h
@@ -0,0 +1,193 @@
+#include "doofit/toy/ToyFactoryStd/BinnedSampler.h"
+
+// STL
+#include <cmath>
+#include <memory>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
+
+// ROOT
+#include "TRandom.h"
+
+// from RooFit
+#include "RooAbsPdf.h"
+#include "RooArgSet.h"
+#include "RooDataSet.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  namespace {
+    /**
+     *  @brief Stirling correction ln(k!) - ln(sqrt(2 pi) (k+1)^(k+1/2) e^-(k+1))
+     */
+    double StirlingCorrection(long long k) {
+      static const double table[10] = {0.08106146679532726, 0.04134069595540929, 0.02767792568499834,
+                                       0.02079067210376509, 0.01664469118982119, 0.01387612882307075,
+                                       0.01189670994589177, 0.01041126526197209, 0.009255462182712733,
+                                       0.008330563433362871};
+      if (k < 10) return table[k];
+      double r  = 1.0/(k+1);
+      double r2 = r*r;
+      return (1.0/12 - (1.0/360 - r2/1260)*r2)*r;
+    }
+
+    /**
+     *  @brief Binomial random number drawn from TRandom
+     *
+     *  std::binomial_distribution is implementation-defined, i.e. samples 
+     *  would differ between platforms and standard libraries for the same 
+     *  seed, and TRandom::Binomial() loops over all trials. For small means, 
+     *  the distribution is inverted sequentially, otherwise the 
+     *  transformed rejection algorithm BTRD (W. Hoermann, J. Statist. Comput. 
+     *  Simul. 46 (1993) 101) is used. Both only need uniform numbers of 
+     *  TRandom::Rndm().
+     *
+     *  @param n number of trials
+     *  @param p probability of success
+     *  @param random random generator to use
+     *  @return number of successes
+     */
+    long long BinomialRandom(long long n, double p, TRandom& random) {
+      if (n <= 0 || p <= 0.0) return 0;
+      if (p >= 1.0) return n;
+      if (p > 0.5) return n - BinomialRandom(n, 1.0-p, random);
+
+      const double q = 1.0 - p;
+      if (n*p < 10.0) {
+        // inversion: subtract probabilities P(k) until u is exhausted
+        const double s = p/q;
+        const double a = (n+1)*s;
+        double r = std::pow(q, static_cast<double>(n));
+        double u = random.Rndm();
+        long long k = 0;
+        while (u > r && k < n) {
+          u -= r;
+          ++k;
+          double r_next = (a/k - s)*r;
+          // remaining probabilities are negligible
+          if (r_next < std::numeric_limits<double>::epsilon() && r_next < r) break;
+          r = r_next;
+        }
+        return k;
+      }
+
+      const long long m  = static_cast<long long>(std::floor((n+1)*p));
+      const double r     = p/q;
+      const double nr    = (n+1)*r;
+      const double npq   = n*p*q;
+      const double sqrt_npq = std::sqrt(npq);
+      const double b     = 1.15 + 2.53*sqrt_npq;
+      const double a     = -0.0873 + 0.0248*b + 0.01*p;
+      const double c     = n*p + 0.5;
+      const double alpha = (2.83 + 5.1/b)*sqrt_npq;
+      const double v_r   = 0.92 - 4.2/b;
+      const double u_rv_r = 0.86*v_r;
+
+      while (true) {
+        double u;
+        double v = random.Rndm();
+        if (v <= u_rv_r) {
+          u = v/v_r - 0.43;
+          return static_cast<long long>(std::floor((2*a/(0.5-std::fabs(u)) + b)*u + c));
+        }
+        if (v >= v_r) {
+          u = random.Rndm() - 0.5;
+        } else {
+          u = v/v_r - 0.93;
+          u = (u < 0.0 ? -0.5 : 0.5) - u;
+          v = random.Rndm()*v_r;
+        }
+
+        double us = 0.5 - std::fabs(u);
+        long long k = static_cast<long long>(std::floor((2*a/us + b)*u + c));
+        if (k < 0 || k > n) continue;
+        v = v*alpha/(a/(us*us) + b);
+        long long km = std::llabs(k - m);
+        if (km <= 15) {
+          // recursive evaluation of f(k)/f(m)
+          double f = 1.0;
+          if (m < k) {
+            for (long long i=m+1; i<=k; ++i) f *= nr/i - r;
+          } else if (m > k) {
+            for (long long i=k+1; i<=m; ++i) v *= nr/i - r;
+          }
+          if (v <= f) return k;
+        } else {
+          // squeeze and final acceptance via Stirling's formula
+          v = std::log(v);
+          double rho = (km/npq)*(((km/3.0 + 0.625)*km + 1.0/6)*km/npq + 0.5);
+          double t   = -static_cast<double>(km)*km/(2*npq);
+          if (v < t - rho) return k;
+          if (v > t + rho) continue;
+          long long nm = n - m + 1;
+          double h = (m+0.5)*std::log((m+1)/(r*nm)) + StirlingCorrection(m) + StirlingCorrection(n-m);
+          long long nk = n - k + 1;
+          if (v <= h + (n+1)*std::log(static_cast<double>(nm)/nk) + (k+0.5)*std::log(nk*r/(k+1))
+                    - StirlingCorrection(k) - StirlingCorrection(n-k)) {
+            return k;
+          }
+        }
+      }
+    }
+  }
+
+  BinnedSampler::BinnedSampler(RooAbsPdf& pdf, const RooArgSet& observables, const std::map<std::string, int>& num_bins) :
+  histogram_(*std::unique_ptr<RooArgSet>(pdf.getObservables(observables)), num_bins),
+  valid_(false)
+  {
+    valid_ = histogram_.IsValid() && histogram_.FillFromPdf(pdf, 1.0);
+    if (!valid_) {
+      serr << "BinnedSampler: Cannot compute bin probabilities of PDF " << pdf.GetName() << "." << endmsg;
+    }
+  }
+
+  BinnedSampler::~BinnedSampler() {}
+
+  RooDataSet* BinnedSampler::Generate(double yield, bool extended, TRandom& random) const {
+    RooDataSet* data = histogram_.CreateDataSet("data_binned");
+    if (!valid_) return data;
+
+    RooArgSet observables(histogram_.observables());
+    RooArgSet* snapshot = dynamic_cast<RooArgSet*>(observables.snapshot());
+    auto fill_bin = [&](unsigned long long bin, double num_events) {
+      if (num_events > 0) {
+        histogram_.SetBin(bin);
+        data->add(observables, num_events);
+      }
+    };
+
+    unsigned long long num_bins = histogram_.num_bins();
+    if (extended) {
+      for (unsigned long long bin=0; bin<num_bins; ++bin) {
+        fill_bin(bin, random.Poisson(yield*histogram_.content(bin)));
+      }
+    } else {
+      // multinomial distribution as sequence of conditional binomials
+      long long num_remaining  = std::llround(yield);
+      double prob_remaining    = 1.0;
+      for (unsigned long long bin=0; bin<num_bins && num_remaining>0; ++bin) {
+        long long num_events = num_remaining;
+        if (bin+1 < num_bins && prob_remaining > 0.0) {
+          double prob = std::min(histogram_.content(bin)/prob_remaining, 1.0);
+          num_events = BinomialRandom(num_remaining, prob, random);
+        }
+        fill_bin(bin, num_events);
+        num_remaining  -= num_events;
+        prob_remaining -= histogram_.content(bin);
+      }
+    }
+
+    observables = *snapshot;
+    delete snapshot;
+    return data;
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,114 @@
+#ifndef BINNEDSAMPLER_h
+#define BINNEDSAMPLER_h
+
+// STL
+#include <string>
+#include <map>
+
+// ROOT
+
+// from RooFit
+
+// from project
+#include "doofit/toy/ToyFactoryStd/BinnedHistogram.h"
+
+// forward declarations
+class RooAbsPdf;
+class RooArgSet;
+class RooDataSet;
+class TRandom;
+
+namespace doofit {
+namespace toy {
+  /** @class BinnedSampler
+   *  @brief Binned generation of high-yield PDFs
+   *
+   *  Instead of generating every event by accept/reject, the bin
+   *  probabilities of a PDF are computed once (in the binnings of the
+   *  observables, i.e. RooRealVar::setBins(...) or a given number of uniform
+   *  bins, and for all states of categories) and the number of events per bin is drawn directly. For a
+   *  fixed number of events, the bin contents are multinomially distributed,
+   *  for extended generation each bin is Poisson distributed. The cost of
+   *  generation then only depends on the number of bins and not on the
+   *  number of events.
+   *
+   *  Bin probabilities are computed via BinnedHistogram::FillFromPdf(), i.e.
+   *  for a single continuous observable they are integrals of the PDF over
+   *  each bin via its cumulative distribution (analytical if the PDF supports
+   *  it and numerical otherwise). In more dimensions, the normalised PDF
+   *  value in the bin centre times the bin volume is used.
+   *
+   *  Generated samples are weighted datasets with one entry per non-empty bin
+   *  at the bin centre and the number of events as weight (weight variable
+   *  ColumnarDataset::weight_name()).
+   *
+   *  Bin probabilities are computed for the parameter values at construction
+   *  time. For other parameter values, a new sampler is needed.
+   */
+  class BinnedSampler {
+   public:
+    /**
+     *  @brief Constructor computing the bin probabilities
+     *
+     *  Check IsValid() before generating.
+     *
+     *  @param pdf the PDF to generate
+     *  @param observables observables to generate (RooAbsRealLValues with
+     *                     finite binning or RooAbsCategoryLValues)
+     *  @param num_bins number of uniform bins for continuous observables by
+     *                  name (instead of their own binnings)
+     */
+    BinnedSampler(RooAbsPdf& pdf, const RooArgSet& observables, const std::map<std::string, int>& num_bins=std::map<std::string, int>());
+
+    /**
+     *  @brief Destructor
+     */
+    ~BinnedSampler();
+
+    BinnedSampler(const BinnedSampler&) = delete;
+    BinnedSampler& operator=(const BinnedSampler&) = delete;
+
+    /**
+     *  @brief Generate a binned sample
+     *
+     *  Observables of the PDF keep their values.
+     *
+     *  @param yield (expected) number of events
+     *  @param extended draw Poisson distributed bin contents with mean
+     *                  @a yield times bin probability (instead of a
+     *                  multinomial distribution of exactly @a yield events)
+     *  @param random random generator to use
+     *  @return the weighted sample (the caller takes ownership)
+     */
+    RooDataSet* Generate(double yield, bool extended, TRandom& random) const;
+
+    /**
+     *  @brief Whether all observables could be binned and probabilities are sane
+     */
+    bool IsValid() const { return valid_; }
+
+    /**
+     *  @brief Number of bins (product of bins in all dimensions)
+     */
+    unsigned long long num_bins() const { return histogram_.num_bins(); }
+
+    /**
+     *  @brief Probability of a bin
+     */
+    double probability(unsigned long long bin) const { return histogram_.content(bin); }
+
+   private:
+    /**
+     *  @brief Bin probabilities in the observables of the PDF
+     */
+    BinnedHistogram histogram_;
+
+    /**
+     *  @brief Whether generation is possible
+     */
+    bool valid_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // BINNEDSAMPLER_h
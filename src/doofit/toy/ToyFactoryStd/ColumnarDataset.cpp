@@ -0,0 +1,219 @@
+#include "doofit/toy/ToyFactoryStd/ColumnarDataset.h"
+
+// STL
+#include <cmath>
+#include <utility>
+
+// ROOT
+#include "TRandom.h"
+#include "TIterator.h"
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooAbsReal.h"
+#include "RooAbsRealLValue.h"
+#include "RooAbsCategory.h"
+#include "RooAbsCategoryLValue.h"
+#include "RooRealVar.h"
+#include "RooGlobalFunc.h"
+#include "RooVectorDataStore.h"
+
+// from project
+
+namespace doofit {
+namespace toy {
+  ColumnarDataset::ColumnarDataset(const RooDataSet& data) :
+  name_(data.GetName()),
+  title_(data.GetTitle()),
+  vars_(new RooArgSet()),
+  num_entries_(data.numEntries()),
+  weighted_(data.isWeighted())
+  {
+    // resolve columns once, get(i) loads values into the same argset
+    const RooArgSet* row = data.get();
+    std::vector<const RooAbsReal*> reals;
+    std::vector<const RooAbsCategory*> cats;
+
+    TIterator* it = row->createIterator();
+    RooAbsArg* arg = NULL;
+    while ((arg = (RooAbsArg*)it->Next())) {
+      const RooAbsReal* real    = dynamic_cast<const RooAbsReal*>(arg);
+      const RooAbsCategory* cat = dynamic_cast<const RooAbsCategory*>(arg);
+      if (real != NULL || cat != NULL) {
+        AddColumn(*arg, std::vector<double>(num_entries_));
+        reals.push_back(real);
+        cats.push_back(cat);
+      }
+    }
+    delete it;
+
+    if (weighted_) {
+      weights_.resize(num_entries_);
+    }
+    for (int i=0; i<num_entries_; ++i) {
+      data.get(i);
+      for (std::size_t c=0; c<columns_.size(); ++c) {
+        columns_[c][i] = cats[c] != NULL ? cats[c]->getIndex() : reals[c]->getVal();
+      }
+      if (weighted_) {
+        weights_[i] = data.weight();
+      }
+    }
+  }
+
+  ColumnarDataset::~ColumnarDataset() {
+    delete vars_;
+  }
+
+  bool ColumnarDataset::AppendShuffled(const ColumnarDataset& other, TRandom& random) {
+    if (other.columns_.size() != columns_.size()) {
+      return false;
+    }
+    std::vector<int> other_columns(columns_.size());
+    for (std::size_t c=0; c<columns_.size(); ++c) {
+      other_columns[c] = other.ColumnIndex(names_[c]);
+      if (other_columns[c] < 0) {
+        return false;
+      }
+    }
+
+    // Fisher-Yates shuffle of entry indices
+    int num_shuffle_elements = num_entries_ + other.num_entries_;
+    std::vector<int> new_order(num_shuffle_elements);
+    if (num_shuffle_elements > 0) {
+      new_order[0] = 0;
+      int j;
+      for (int i=1; i<num_shuffle_elements; ++i) {
+        j = random.Integer(i+1);
+        new_order[i] = new_order[j];
+        new_order[j] = i;
+      }
+    }
+
+    for (std::size_t c=0; c<columns_.size(); ++c) {
+      const std::vector<double>& master = columns_[c];
+      const std::vector<double>& slave  = other.columns_[other_columns[c]];
+      std::vector<double> column(num_shuffle_elements);
+      for (int i=0; i<num_shuffle_elements; ++i) {
+        int num_draw = new_order[i];
+        column[i] = num_draw < num_entries_ ? master[num_draw] : slave[num_draw-num_entries_];
+      }
+      columns_[c].swap(column);
+    }
+
+    if (weighted_ || other.weighted_) {
+      std::vector<double> weights(num_shuffle_elements);
+      for (int i=0; i<num_shuffle_elements; ++i) {
+        int num_draw = new_order[i];
+        if (num_draw < num_entries_) {
+          weights[i] = weighted_ ? weights_[num_draw] : 1.0;
+        } else {
+          weights[i] = other.weighted_ ? other.weights_[num_draw-num_entries_] : 1.0;
+        }
+      }
+      weights_.swap(weights);
+      weighted_ = true;
+    }
+    num_entries_ = num_shuffle_elements;
+    return true;
+  }
+
+  bool ColumnarDataset::MergeColumns(const ColumnarDataset& other) {
+    // entries of weighted samples are bins, they cannot be paired with events
+    if (other.num_entries_ != num_entries_ || weighted_ || other.weighted_) {
+      return false;
+    }
+    for (std::size_t c=0; c<other.columns_.size(); ++c) {
+      int index = ColumnIndex(other.names_[c]);
+      if (index < 0) {
+        AddColumn(*other.vars_->find(other.names_[c].c_str()), other.columns_[c]);
+      } else {
+        // as in RooDataSet::merge(...) the last column prevails
+        columns_[index] = other.columns_[c];
+      }
+    }
+    return true;
+  }
+
+  void ColumnarDataset::Unbin(TRandom& random) {
+    if (!weighted_) return;
+
+    std::vector<int> entries;
+    for (int i=0; i<num_entries_; ++i) {
+      long long num_events = std::llround(weights_[i]);
+      entries.insert(entries.end(), num_events > 0 ? num_events : 0, i);
+    }
+
+    // Fisher-Yates shuffle, events of one bin must not stay together
+    for (int i=static_cast<int>(entries.size())-1; i>0; --i) {
+      std::swap(entries[i], entries[random.Integer(i+1)]);
+    }
+
+    for (std::size_t c=0; c<columns_.size(); ++c) {
+      std::vector<double> column(entries.size());
+      for (std::size_t i=0; i<entries.size(); ++i) {
+        column[i] = columns_[c][entries[i]];
+      }
+      columns_[c].swap(column);
+    }
+    weights_.clear();
+    weighted_    = false;
+    num_entries_ = entries.size();
+  }
+
+  RooDataSet* ColumnarDataset::ToDataSet() const {
+    RooRealVar weight(weight_name(), weight_name(), 0.0);
+    RooDataSet* data = NULL;
+    if (weighted_) {
+      RooArgSet vars(*vars_);
+      vars.add(weight);
+      data = new RooDataSet(name_.c_str(), title_.c_str(), vars, RooFit::WeightVar(weight));
+    } else {
+      data = new RooDataSet(name_.c_str(), title_.c_str(), *vars_);
+    }
+    RooVectorDataStore* store = dynamic_cast<RooVectorDataStore*>(data->store());
+    if (store != NULL) {
+      store->reserve(num_entries_);
+    }
+
+    std::vector<RooAbsRealLValue*> reals(columns_.size(), NULL);
+    std::vector<RooAbsCategoryLValue*> cats(columns_.size(), NULL);
+    for (std::size_t c=0; c<columns_.size(); ++c) {
+      RooAbsArg* var = vars_->find(names_[c].c_str());
+      if (categories_[c]) {
+        cats[c] = dynamic_cast<RooAbsCategoryLValue*>(var);
+      } else {
+        reals[c] = dynamic_cast<RooAbsRealLValue*>(var);
+      }
+    }
+
+    // the dataset's variables are clones of vars_ in identical order
+    for (int i=0; i<num_entries_; ++i) {
+      for (std::size_t c=0; c<columns_.size(); ++c) {
+        if (reals[c] != NULL) {
+          reals[c]->setVal(columns_[c][i]);
+        } else if (cats[c] != NULL) {
+          cats[c]->setIndex(static_cast<int>(columns_[c][i]));
+        }
+      }
+      data->addFast(*vars_, weighted_ ? weights_[i] : 1.0);
+    }
+    return data;
+  }
+
+  void ColumnarDataset::AddColumn(const RooAbsArg& var, std::vector<double> values) {
+    vars_->addClone(var);
+    names_.push_back(var.GetName());
+    categories_.push_back(dynamic_cast<const RooAbsCategory*>(&var) != NULL);
+    columns_.push_back(std::move(values));
+  }
+
+  int ColumnarDataset::ColumnIndex(const std::string& name) const {
+    for (std::size_t c=0; c<names_.size(); ++c) {
+      if (names_[c] == name) return static_cast<int>(c);
+    }
+    return -1;
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,183 @@
+#ifndef COLUMNARDATASET_h
+#define COLUMNARDATASET_h
+
+// STL
+#include <string>
+#include <vector>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class RooDataSet;
+class RooArgSet;
+class RooAbsArg;
+class TRandom;
+
+namespace doofit {
+namespace toy {
+  /** @class ColumnarDataset
+   *  @brief Column buffers to assemble toy samples from component samples
+   *
+   *  Component samples generated by ToyFactoryStd are copied once into plain
+   *  column buffers (values of RooRealVars, indices of RooCategories).
+   *  Appending (in shuffled order) and merging of columns then only operates
+   *  on these buffers and the final RooDataSet is materialised exactly once
+   *  via ToDataSet() into a preallocated store. This avoids copying every
+   *  event through RooArgSets in each step of the assembly.
+   *
+   *  Weighted samples (e.g. from binned generation, see BinnedSampler) keep
+   *  their weights in a separate weight column. Appending a weighted and an
+   *  unweighted sample results in a weighted sample with unit weights for the
+   *  unweighted entries. To merge columns, weighted samples are expanded into
+   *  events first (see Unbin()).
+   */
+  class ColumnarDataset {
+   public:
+    /**
+     *  @brief Constructor copying all columns of a dataset
+     *
+     *  Columns of other types than RooAbsReal or RooAbsCategory are ignored.
+     *
+     *  @param data the dataset to copy
+     */
+    explicit ColumnarDataset(const RooDataSet& data);
+
+    /**
+     *  @brief Destructor
+     */
+    ~ColumnarDataset();
+
+    ColumnarDataset(const ColumnarDataset&) = delete;
+    ColumnarDataset& operator=(const ColumnarDataset&) = delete;
+
+    /**
+     *  @brief Append another sample in shuffled order
+     *
+     *  The entries of both samples are mixed by a Fisher-Yates shuffle of
+     *  the entry indices (consuming random numbers exactly like
+     *  ToyFactoryStd::AppendDatasets() always did). Only the resulting index
+     *  order is applied to the columns.
+     *
+     *  @param other the sample to append (needs identical columns)
+     *  @param random random generator to use
+     *  @return false if columns are not identical (nothing is changed)
+     */
+    bool AppendShuffled(const ColumnarDataset& other, TRandom& random);
+
+    /**
+     *  @brief Add columns of another sample of equal size
+     *
+     *  Values of columns existing in both samples are taken from @a other
+     *  (like RooDataSet::merge(...)).
+     *
+     *  @param other the sample to take columns from
+     *  @return false if sizes do not match or any sample is weighted (nothing 
+     *          is changed)
+     */
+    bool MergeColumns(const ColumnarDataset& other);
+
+    /**
+     *  @brief Expand a weighted (i.e. binned) sample into unit weight events
+     *
+     *  Each entry is repeated by its (rounded) weight and the events are 
+     *  shuffled, so that they can be paired with independently generated 
+     *  columns via MergeColumns(). Unweighted samples are not changed.
+     *
+     *  @param random random generator to use
+     */
+    void Unbin(TRandom& random);
+
+    /**
+     *  @brief Materialise the sample as RooDataSet
+     *
+     *  @return a new dataset (the caller takes ownership)
+     */
+    RooDataSet* ToDataSet() const;
+
+    /**
+     *  @brief Column variables (without weight)
+     */
+    const RooArgSet& vars() const { return *vars_; }
+
+    /**
+     *  @brief Whether the sample has a weight column
+     */
+    bool weighted() const { return weighted_; }
+
+    /**
+     *  @brief Name of the weight variable of weighted toy samples
+     */
+    static const char* weight_name() { return "weight_binned"; }
+
+    /**
+     *  @brief Number of entries
+     */
+    int num_entries() const { return num_entries_; }
+
+   private:
+    /**
+     *  @brief Add a column
+     *
+     *  @param var the column variable (will be cloned)
+     *  @param values the column values
+     */
+    void AddColumn(const RooAbsArg& var, std::vector<double> values);
+
+    /**
+     *  @brief Index of column by name (or -1)
+     */
+    int ColumnIndex(const std::string& name) const;
+
+    /**
+     *  @brief Name of the sample
+     */
+    std::string name_;
+
+    /**
+     *  @brief Title of the sample
+     */
+    std::string title_;
+
+    /**
+     *  @brief Column variables (owned)
+     */
+    RooArgSet* vars_;
+
+    /**
+     *  @brief Column names (in order of columns_)
+     */
+    std::vector<std::string> names_;
+
+    /**
+     *  @brief Whether a column is a category (stores indices)
+     */
+    std::vector<bool> categories_;
+
+    /**
+     *  @brief Column values
+     */
+    std::vector<std::vector<double>> columns_;
+
+    /**
+     *  @brief Whether the sample is weighted
+     */
+    bool weighted_;
+
+    /**
+     *  @brief Weights (empty if not weighted)
+     */
+    std::vector<double> weights_;
+
+    /**
+     *  @brief Number of entries
+     */
+    int num_entries_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // COLUMNARDATASET_h
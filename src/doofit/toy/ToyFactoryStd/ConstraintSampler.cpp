@@ -0,0 +1,195 @@
+#include "doofit/toy/ToyFactoryStd/ConstraintSampler.h"
+
+// STL
+#include <memory>
+
+// ROOT
+#include "TIterator.h"
+#include "TRandom.h"
+#include "TMatrixDSym.h"
+#include "TVectorD.h"
+#include "TDecompChol.h"
+
+// from RooFit
+#include "RooAbsPdf.h"
+#include "RooAbsReal.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooMultiVarGaussian.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  ConstraintSampler::ConstraintSampler(const RooArgSet& constraining_pdfs, const RooArgSet& parameters) {
+    TIterator* it = constraining_pdfs.createIterator();
+    RooAbsArg* arg = NULL;
+    while ((arg = (RooAbsArg*)it->Next())) {
+      RooAbsPdf* pdf = dynamic_cast<RooAbsPdf*>(arg);
+      if (pdf == NULL) continue;
+
+      bool supported = false;
+      if (dynamic_cast<RooGaussian*>(pdf) != NULL) {
+        supported = AddGaussian(*pdf, parameters);
+      } else if (dynamic_cast<RooMultiVarGaussian*>(pdf) != NULL) {
+        supported = AddMultiVarGaussian(*pdf, parameters);
+      }
+
+      if (supported && UpdateCholesky(constraints_.back())) {
+        supported_pdfs_.add(*pdf);
+        for (auto parameter : constraints_.back().parameters) {
+          parameters_.add(*parameter, true);
+        }
+      } else {
+        if (supported) constraints_.pop_back();
+        unsupported_pdfs_.add(*pdf);
+      }
+    }
+    delete it;
+  }
+
+  ConstraintSampler::~ConstraintSampler() {}
+
+  bool ConstraintSampler::Draw(TRandom& random) {
+    const int max_tries = 10000;
+    bool success = true;
+    for (auto& constraint : constraints_) {
+      if (!UpdateCholesky(constraint)) {
+        success = false;
+        continue;
+      }
+
+      int n = constraint.parameters.size();
+      TVectorD mean(n);
+      for (int i=0; i<n; ++i) {
+        mean[i] = constraint.means[i]->getVal();
+      }
+
+      bool in_range = false;
+      TVectorD z(n);
+      for (int num_tries=0; num_tries<max_tries && !in_range; ++num_tries) {
+        for (int i=0; i<n; ++i) {
+          z[i] = random.Gaus();
+        }
+        TVectorD values = constraint.cholesky*z;
+        values += mean;
+
+        in_range = true;
+        for (int i=0; i<n && in_range; ++i) {
+          in_range = constraint.parameters[i]->inRange(values[i], NULL);
+        }
+        if (in_range) {
+          for (int i=0; i<n; ++i) {
+            constraint.parameters[i]->setVal(values[i]);
+          }
+        }
+      }
+
+      if (!in_range) {
+        serr << "ConstraintSampler::Draw(...): Cannot draw constrained parameters of " << constraint.name << " inside their ranges." << endmsg;
+        success = false;
+      }
+    }
+    return success;
+  }
+
+  bool ConstraintSampler::AddGaussian(RooAbsPdf& pdf, const RooArgSet& parameters) {
+    // servers of RooGaussian are x, mean and sigma
+    RooAbsArg* x     = pdf.findServer(0);
+    RooAbsArg* mean  = pdf.findServer(1);
+    RooAbsReal* sigma = dynamic_cast<RooAbsReal*>(pdf.findServer(2));
+    if (x == NULL || mean == NULL || sigma == NULL || parameters.find(sigma->GetName()) != NULL) {
+      return false;
+    }
+
+    // x and mean are interchangeable, exactly one must be constrained
+    RooAbsArg* constrained = parameters.find(x->GetName());
+    RooAbsArg* other       = mean;
+    if (parameters.find(mean->GetName()) != NULL) {
+      if (constrained != NULL) return false;
+      constrained = parameters.find(mean->GetName());
+      other       = x;
+    }
+
+    Constraint constraint;
+    constraint.name               = pdf.GetName();
+    constraint.sigma              = sigma;
+    constraint.multi_var_gaussian = NULL;
+    constraint.parameters.push_back(dynamic_cast<RooRealVar*>(constrained));
+    constraint.means.push_back(dynamic_cast<RooAbsReal*>(other));
+    if (constraint.parameters[0] == NULL || constraint.means[0] == NULL) {
+      return false;
+    }
+    constraints_.push_back(constraint);
+    return true;
+  }
+
+  bool ConstraintSampler::AddMultiVarGaussian(RooAbsPdf& pdf, const RooArgSet& parameters) {
+    RooMultiVarGaussian& multi_var_gaussian = dynamic_cast<RooMultiVarGaussian&>(pdf);
+    int n = multi_var_gaussian.covarianceMatrix().GetNrows();
+
+    // servers are registered in order: first all x, then all mu (the
+    // constrained parameters must be exactly the x)
+    std::unique_ptr<RooArgSet> observables(pdf.getObservables(parameters));
+    int num_servers = 0;
+    TIterator* it = pdf.serverIterator();
+    while (it->Next()) ++num_servers;
+    delete it;
+    if (num_servers != 2*n || observables->getSize() != n) {
+      return false;
+    }
+
+    Constraint constraint;
+    constraint.name               = pdf.GetName();
+    constraint.sigma              = NULL;
+    constraint.multi_var_gaussian = &multi_var_gaussian;
+    for (int i=0; i<n; ++i) {
+      RooRealVar* parameter = dynamic_cast<RooRealVar*>(parameters.find(pdf.findServer(i)->GetName()));
+      RooAbsReal* mean      = dynamic_cast<RooAbsReal*>(pdf.findServer(n+i));
+      if (parameter == NULL || mean == NULL || parameters.find(mean->GetName()) != NULL) {
+        return false;
+      }
+      constraint.parameters.push_back(parameter);
+      constraint.means.push_back(mean);
+    }
+    constraints_.push_back(constraint);
+    return true;
+  }
+
+  std::vector<double> ConstraintSampler::Covariance(const Constraint& constraint) {
+    if (constraint.multi_var_gaussian != NULL) {
+      const TMatrixDSym& covariance = constraint.multi_var_gaussian->covarianceMatrix();
+      return std::vector<double>(covariance.GetMatrixArray(), covariance.GetMatrixArray()+covariance.GetNoElements());
+    } else {
+      double sigma = constraint.sigma->getVal();
+      return std::vector<double>(1, sigma*sigma);
+    }
+  }
+
+  bool ConstraintSampler::UpdateCholesky(Constraint& constraint) {
+    std::vector<double> covariance = Covariance(constraint);
+    if (covariance == constraint.covariance) {
+      return constraint.cholesky.GetNrows() > 0;
+    }
+    constraint.covariance = covariance;
+
+    int n = constraint.parameters.size();
+    TMatrixDSym matrix(n, covariance.data());
+    TDecompChol decomposition(matrix);
+    if (!decomposition.Decompose()) {
+      serr << "ConstraintSampler: Covariance matrix of " << constraint.name << " is not positive definite." << endmsg;
+      constraint.cholesky.ResizeTo(0, 0);
+      return false;
+    }
+    // TDecompChol yields upper triangular U with covariance = U^T U
+    constraint.cholesky.ResizeTo(n, n);
+    constraint.cholesky.Transpose(decomposition.GetU());
+    return true;
+  }
+} // namespace toy
+} // namespace doofit
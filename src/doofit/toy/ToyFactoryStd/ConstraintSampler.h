@@ -0,0 +1,177 @@
+#ifndef CONSTRAINTSAMPLER_h
+#define CONSTRAINTSAMPLER_h
+
+// STL
+#include <string>
+#include <vector>
+
+// ROOT
+#include "TMatrixD.h"
+
+// from RooFit
+#include "RooArgSet.h"
+
+// from project
+
+// forward declarations
+class RooAbsPdf;
+class RooAbsReal;
+class RooRealVar;
+class RooMultiVarGaussian;
+class TRandom;
+
+namespace doofit {
+namespace toy {
+  /** @class ConstraintSampler
+   *  @brief Direct sampling of constrained parameters from Gaussian constraints
+   *
+   *  Constraining PDFs of type RooGaussian (the constrained parameter being
+   *  either x or mean, the width not being constrained) and
+   *  RooMultiVarGaussian are recognised. For each of these, the Cholesky
+   *  factor L of the covariance matrix is computed once and constrained
+   *  parameters are drawn as mean + L*z with a vector z of standard normal
+   *  numbers. Means are read at every draw, the Cholesky factor is only
+   *  computed again if the covariance (resp. width) changed.
+   *
+   *  Like RooFit's generators for these PDFs, values outside the range of a
+   *  parameter are rejected and the whole vector of a PDF is drawn again.
+   *
+   *  All other constraining PDFs are not handled and need to be generated
+   *  otherwise (see unsupported_pdfs()).
+   */
+  class ConstraintSampler {
+   public:
+    /**
+     *  @brief Constructor analysing the constraining PDFs
+     *
+     *  @param constraining_pdfs all constraining PDFs
+     *  @param parameters parameters of the PDF to generate (constrained
+     *                    parameters are found in here by name and set on
+     *                    drawing)
+     */
+    ConstraintSampler(const RooArgSet& constraining_pdfs, const RooArgSet& parameters);
+
+    /**
+     *  @brief Destructor
+     */
+    ~ConstraintSampler();
+
+    ConstraintSampler(const ConstraintSampler&) = delete;
+    ConstraintSampler& operator=(const ConstraintSampler&) = delete;
+
+    /**
+     *  @brief Draw all constrained parameters of supported constraining PDFs
+     *
+     *  @param random random generator to use
+     *  @return false if no values inside the parameter ranges could be drawn
+     *          for some constraint (parameters of this constraint keep their
+     *          values)
+     */
+    bool Draw(TRandom& random);
+
+    /**
+     *  @brief Constrained parameters of all supported constraining PDFs
+     */
+    const RooArgSet& parameters() const { return parameters_; }
+
+    /**
+     *  @brief Supported constraining PDFs
+     */
+    const RooArgSet& supported_pdfs() const { return supported_pdfs_; }
+
+    /**
+     *  @brief Constraining PDFs which are not supported
+     */
+    const RooArgSet& unsupported_pdfs() const { return unsupported_pdfs_; }
+
+   private:
+    /**
+     *  @brief One Gaussian constraint
+     */
+    struct Constraint {
+      /**
+       *  @brief Name of the constraining PDF
+       */
+      std::string name;
+
+      /**
+       *  @brief Constrained parameters
+       */
+      std::vector<RooRealVar*> parameters;
+
+      /**
+       *  @brief Means of the constrained parameters
+       */
+      std::vector<RooAbsReal*> means;
+
+      /**
+       *  @brief Width of a RooGaussian (or NULL)
+       */
+      RooAbsReal* sigma;
+
+      /**
+       *  @brief The RooMultiVarGaussian (or NULL)
+       */
+      RooMultiVarGaussian* multi_var_gaussian;
+
+      /**
+       *  @brief Covariance matrix the Cholesky factor was computed for
+       */
+      std::vector<double> covariance;
+
+      /**
+       *  @brief Lower triangular Cholesky factor of the covariance matrix
+       */
+      TMatrixD cholesky;
+    };
+
+    /**
+     *  @brief Analyse a RooGaussian constraint
+     *
+     *  @return whether the PDF is supported
+     */
+    bool AddGaussian(RooAbsPdf& pdf, const RooArgSet& parameters);
+
+    /**
+     *  @brief Analyse a RooMultiVarGaussian constraint
+     *
+     *  @return whether the PDF is supported
+     */
+    bool AddMultiVarGaussian(RooAbsPdf& pdf, const RooArgSet& parameters);
+
+    /**
+     *  @brief Current covariance matrix of a constraint (row-major)
+     */
+    static std::vector<double> Covariance(const Constraint& constraint);
+
+    /**
+     *  @brief Compute the Cholesky factor if the covariance changed
+     *
+     *  @return false if the covariance is not positive definite
+     */
+    static bool UpdateCholesky(Constraint& constraint);
+
+    /**
+     *  @brief Supported constraints
+     */
+    std::vector<Constraint> constraints_;
+
+    /**
+     *  @brief Constrained parameters (not owned)
+     */
+    RooArgSet parameters_;
+
+    /**
+     *  @brief Supported constraining PDFs (not owned)
+     */
+    RooArgSet supported_pdfs_;
+
+    /**
+     *  @brief Unsupported constraining PDFs (not owned)
+     */
+    RooArgSet unsupported_pdfs_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // CONSTRAINTSAMPLER_h
@@ -0,0 +1,35 @@
+#include "doofit/toy/ToyFactoryStd/DiscreteSampler.h"
+
+// STL
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  DiscreteSampler::DiscreteSampler(const std::vector<std::pair<double,double> >& probabilities) :
+  monotonic_(true)
+  {
+    for (std::vector<std::pair<double,double> >::const_iterator it = probabilities.begin(); it != probabilities.end(); ++it) {
+      if (!cum_probs_.empty() && (*it).second < cum_probs_.back()) {
+        // negative probabilities: only a linear walk gives the legacy result
+        monotonic_ = false;
+      }
+      values_.push_back((*it).first);
+      cum_probs_.push_back((*it).second);
+    }
+
+    int num_values = cum_probs_.size();
+    guide_.resize(num_values);
+    int j = 0;
+    for (int k=0; k<num_values; ++k) {
+      double threshold = static_cast<double>(k)/num_values;
+      while (j < num_values && !(threshold < cum_probs_[j])) ++j;
+      guide_[k] = j;
+    }
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,102 @@
+#ifndef DISCRETESAMPLER_h
+#define DISCRETESAMPLER_h
+
+// STL
+#include <vector>
+#include <utility>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  /** @class DiscreteSampler
+   *  @brief Constant time sampler for discrete probability distributions
+   *
+   *  Built once from the cumulative probabilities of a
+   *  config::DiscreteProbabilityDistribution. Each draw maps one uniform
+   *  random number to the first value whose cumulative probability is larger
+   *  than the random number, i.e. exactly to the same value as a linear walk
+   *  through the cumulative probabilities. Instead of walking, a guide table
+   *  (indexed search) with one entry per value is used to jump directly to
+   *  the relevant value, making the expected cost of a draw independent of
+   *  the number of values.
+   *
+   *  If the cumulative probabilities do not reach 1, random numbers above the
+   *  last cumulative probability are not mapped to any value (Sample()
+   *  returns -1).
+   */
+  class DiscreteSampler {
+   public:
+    /**
+     *  @brief Constructor
+     *
+     *  @param probabilities pairs of value and cumulative probability (as in
+     *                       config::DiscreteProbabilityDistribution)
+     */
+    explicit DiscreteSampler(const std::vector<std::pair<double,double> >& probabilities);
+
+    /**
+     *  @brief Map a uniform random number to a value index
+     *
+     *  @param r uniform random number in [0,1)
+     *  @return index of drawn value or -1 if no value is drawn
+     */
+    int Sample(double r) const {
+      int num_values = cum_probs_.size();
+      if (num_values == 0) return -1;
+      if (!monotonic_) {
+        for (int j=0; j<num_values; ++j) {
+          if (r < cum_probs_[j]) return j;
+        }
+        return -1;
+      }
+
+      int k = static_cast<int>(r*num_values);
+      if (k < 0) k = 0;
+      if (k >= num_values) k = num_values-1;
+      int j = guide_[k];
+      // guard against rounding in r*num_values
+      while (j > 0 && r < cum_probs_[j-1]) --j;
+      while (j < num_values && !(r < cum_probs_[j])) ++j;
+      return j < num_values ? j : -1;
+    }
+
+    /**
+     *  @brief Number of values
+     */
+    int num_values() const { return values_.size(); }
+
+    /**
+     *  @brief Value for index
+     */
+    double value(int index) const { return values_[index]; }
+
+   private:
+    /**
+     *  @brief Cumulative probabilities
+     */
+    std::vector<double> cum_probs_;
+
+    /**
+     *  @brief Values
+     */
+    std::vector<double> values_;
+
+    /**
+     *  @brief Guide table: first index with cumulative probability above k/n
+     */
+    std::vector<int> guide_;
+
+    /**
+     *  @brief Whether cumulative probabilities are non-decreasing
+     */
+    bool monotonic_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // DISCRETESAMPLER_h
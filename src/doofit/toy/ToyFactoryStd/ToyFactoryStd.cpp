@@ -3,21 +3,24 @@
 // STL
 #include <cstring>
 #include <vector>
-#include <csignal>
-
-// POSIX/UNIX
-#include <unistd.h>
+#include <iostream>
+#include <algorithm>
+#include <memory>
 
 // boost
-#include "boost/tuple/tuple.hpp"
 #include "boost/filesystem.hpp"
 #include "boost/math/special_functions/round.hpp"
+#include "boost/lexical_cast.hpp"
 
 // ROOT
 #include "TClass.h"
 #include "TStopwatch.h"
 #include "TFile.h"
 #include "TMath.h"
+#include "RVersion.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+#include "TRandomGen.h"
+#endif
 
 // from RooFit
 #include "RooDataSet.h"
@@ -36,10 +39,19 @@
 #include "RooSimultaneous.h"
 #include "RooSuperCategory.h"
 #include "RooLinkedListIter.h"
+#include "RooAbsGenContext.h"
+#include "RooAbsCategory.h"
+#include "RooVectorDataStore.h"
 
 // from Project
 #include "doofit/config/CommonConfig.h"
 #include "doofit/toy/ToyFactoryStd/ToyFactoryStdConfig.h"
+#include "doofit/toy/ToyFactoryStd/ColumnarDataset.h"
+#include "doofit/toy/ToyFactoryStd/DiscreteSampler.h"
+#include "doofit/toy/ToyFactoryStd/BinnedSampler.h"
+#include "doofit/toy/ToyFactoryStd/BinnedHistogram.h"
+#include "doofit/toy/ToyFactoryStd/ConstraintSampler.h"
+#include "doofit/tools/workers/ForkedWorkers.h"
 #include "doocore/io/MsgStream.h"
 
 using namespace ROOT;
@@ -49,12 +61,13 @@ using namespace doocore::io;
 namespace doofit {
 namespace toy {
 
-  bool ToyFactoryStd::signal_caught_ = false;
-  jmp_buf ToyFactoryStd::jump_buffer_;
-
   ToyFactoryStd::ToyFactoryStd(const config::CommonConfig& cfg_com, const ToyFactoryStdConfig& cfg_tfac) :
   config_common_(cfg_com),
-  config_toyfactory_(cfg_tfac)
+  config_toyfactory_(cfg_tfac),
+  stream_seed_(0),
+  toy_index_(0),
+  generation_worker_(false),
+  generation_session_(false)
   {
     using namespace doocore::io;
     if (cfg_tfac.random_seed()>=0) {
@@ -62,20 +75,58 @@ namespace toy {
     // } else {
     //   swarn << "ToyFactoryStd::ToyFactoryStd(): Random seed set to illegal value " << cfg_tfac.random_seed() << ". Will not touch random generator." << endmsg;
     }
-    signal(SIGABRT, SignalHandler);
-    signal_caught_ = false;
+    if (cfg_tfac.random_streams()) {
+      if (cfg_tfac.random_seed() > 0) {
+        stream_seed_ = cfg_tfac.random_seed();
+      } else {
+        // irreproducible anyway, but streams of this toy factory stay independent
+        stream_seed_ = RooRandom::randomGenerator()->Integer(4294967295u);
+      }
+    }
   }
   
   ToyFactoryStd::~ToyFactoryStd(){
-    
+    ClearGenerationContexts();
+    ClearBinnedGenerations();
   }
   
   RooDataSet* ToyFactoryStd::Generate() {
+    ReadParametersFromFile();
+    return GenerateToy();
+  }
+
+  std::vector<RooDataSet*> ToyFactoryStd::GenerateBatch(unsigned int num_toys) {
+    std::vector<RooDataSet*> datasets;
+    datasets.reserve(num_toys);
+
+    ReadParametersFromFile();
+
+    generation_session_ = true;
+    try {
+      for (unsigned int i=0; i<num_toys; ++i) {
+        datasets.push_back(GenerateToy());
+      }
+    } catch (...) {
+      generation_session_ = false;
+      ClearGenerationContexts();
+      for (auto data : datasets) {
+        delete data;
+      }
+      throw;
+    }
+    generation_session_ = false;
+    ClearGenerationContexts();
+
+    return datasets;
+  }
+
+  RooDataSet* ToyFactoryStd::GenerateToy() {
     sinfo.Ruler();
     TStopwatch sw;
     sw.Start();
     
-    ReadParametersFromFile();
+    stream_path_.clear();
+    SeedRandomStream("constraints");
     DrawConstrainedParameters();
         
     // try to generate with PDF (if set)
@@ -93,9 +144,15 @@ namespace toy {
     const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities = config_toyfactory_.discrete_probabilities();
     
     if (discrete_probabilities.size() > 0) {
+      SeedRandomStream("discrete");
+
       // determine yield and already generated argset for discrete dataset
       double discrete_yield = 0;
       const RooArgSet* argset_already_generated = NULL;
+      if (data != NULL && data->isWeighted()) {
+        serr << "Error in ToyFactoryStd::Generate(): Discrete variables cannot be added to a binned sample." << endmsg;
+        throw WeightedDatasetsNotMergeableException();
+      }
       if (data != NULL) {
         // continous PDF was generated, take args and yield from there
         discrete_yield = data->numEntries();
@@ -145,6 +202,7 @@ namespace toy {
     }
     
     sinfo << "Generation of this sample took " << sw << endmsg;
+    ++toy_index_;
     
     if (config_toyfactory_.dataset_filename_name().first().length() > 0) {
       sinfo << "Writing dataset as " << config_toyfactory_.dataset_filename_name().second() << " into file " << config_toyfactory_.dataset_filename_name().first() << endmsg;
@@ -168,6 +226,82 @@ namespace toy {
     return data;
   }
   
+  RooDataSet* ToyFactoryStd::GenerateAsimov() {
+    sinfo.Ruler();
+    TStopwatch sw;
+    sw.Start();
+    
+    ReadParametersFromFile();
+    
+    const RooArgSet& argset_generation_observables = *(config_toyfactory_.argset_generation_observables());
+    const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities = config_toyfactory_.discrete_probabilities();
+    
+    RooAbsPdf* pdf = NULL;
+    try {
+      pdf = config_toyfactory_.generation_pdf();
+    } catch (const PdfNotSetException& e) {
+      if (discrete_probabilities.size() == 0) {
+        serr << "Not generating Asimov dataset as neither PDF is set nor discrete variables are requested." << endmsg;
+        throw NotGeneratingDataException();
+      }
+    }
+    
+    // histogram in all observables of the PDF and all discrete variables
+    RooArgSet observables;
+    if (pdf != NULL) {
+      RooArgSet* obs_argset = pdf->getObservables(argset_generation_observables);
+      observables.add(*obs_argset);
+      delete obs_argset;
+    }
+    for (std::vector<config::DiscreteProbabilityDistribution>::const_iterator it = discrete_probabilities.begin(); it != discrete_probabilities.end(); ++it) {
+      RooAbsArg* disc_var = argset_generation_observables.find((*it).var_name().c_str());
+      if (disc_var == NULL) {
+        serr << "ERROR: Discrete probability for " << (*it).var_name() 
+        << " is requested for generation but is not in the generation argument set. Cannot generate." << endmsg;
+        throw NotGeneratingDiscreteData();
+      }
+      observables.add(*disc_var, true);
+    }
+    
+    BinnedHistogram histogram(observables, ObservableBins(), DiscreteValues());
+    if (!histogram.IsValid()) {
+      serr << "Cannot bin observables " << observables << " for Asimov dataset." << endmsg;
+      throw NotGeneratingDataException();
+    }
+    
+    if (pdf != NULL) {
+      sinfo << "Computing Asimov dataset for PDF " << pdf->GetName() << " in " << histogram.num_bins() << " bins." << endmsg;
+      sinfo.set_indent(sinfo.indent()+2);
+      AsimovForPdf(*pdf, config_toyfactory_.expected_yield(), histogram);
+      sinfo.set_indent(sinfo.indent()-2);
+    } else {
+      // only discrete variables, their probabilities are applied below
+      for (unsigned long long bin=0; bin<histogram.num_bins(); ++bin) {
+        histogram.set_content(bin, config_toyfactory_.expected_yield()/histogram.num_bins());
+      }
+    }
+    
+    if (discrete_probabilities.size() > 0) {
+      AsimovDiscreteProbabilities(discrete_probabilities, histogram);
+    }
+    
+    RooDataSet* data = histogram.ToDataSet("data_asimov");
+    sinfo << "Asimov dataset contains " << data->sumEntries() << " expected events in " << data->numEntries() << " bins." << endmsg;
+    sinfo << "Computation of the Asimov dataset took " << sw << endmsg;
+    
+    if (config_toyfactory_.dataset_filename_name().first().length() > 0) {
+      sinfo << "Writing dataset as " << config_toyfactory_.dataset_filename_name().second() << " into file " << config_toyfactory_.dataset_filename_name().first() << endmsg;
+      TFile dataset_file(config_toyfactory_.dataset_filename_name().first().c_str(),"recreate");
+      
+      data->Write(config_toyfactory_.dataset_filename_name().second().c_str());
+      dataset_file.Close();
+    }
+    
+    sinfo.Ruler();
+    
+    return data;
+  }
+  
   bool ToyFactoryStd::PdfIsDecomposable(const RooAbsPdf& pdf) const {
     if (PdfIsSimultaneous(pdf) 
         || PdfIsAdded(pdf)
@@ -218,23 +352,49 @@ namespace toy {
       RooAbsArg* arg = NULL;
       RooArgSet* parameters = config_toyfactory_.generation_pdf()->getParameters(config_toyfactory_.argset_generation_observables());
 
+      // parameters of all constraining PDFs (i.e. means and widths) are read 
+      // at once
+      if (config_toyfactory_.parameter_read_file().size() > 0) {
+        if (!boost::filesystem::exists(config_toyfactory_.parameter_read_file())) {
+          serr << "Cannot read parameters from file " << config_toyfactory_.parameter_read_file() << endmsg;
+          throw NotGeneratingDataException();
+        }
+        RooArgSet constr_pdf_parameters;
+        while ((arg = (RooAbsArg*)arg_it->Next())) {
+          RooArgSet* constr_params     = arg->getObservables(parameters);
+          RooArgSet* argset_parameters = arg->getParameters(constr_params);
+          constr_pdf_parameters.add(*argset_parameters, true);
+          delete argset_parameters;
+          delete constr_params;
+        }
+        arg_it->Reset();
+        constr_pdf_parameters.readFromFile(config_toyfactory_.parameter_read_file().c_str());
+      }
+
+      // Gaussian constraints are drawn directly, the Cholesky factors of 
+      // their covariances are cached over toys
+      if (!constraint_sampler_) {
+        constraint_sampler_.reset(new ConstraintSampler(*argset_constraining_pdfs, *parameters));
+        if (constraint_sampler_->supported_pdfs().getSize() > 0) {
+          sinfo << "Drawing " << constraint_sampler_->parameters().getSize() << " parameters of Gaussian constraints " << constraint_sampler_->supported_pdfs() << " directly." << endmsg;
+        }
+      }
+      bool sampled = constraint_sampler_->Draw(*RooRandom::randomGenerator());
+      if (sampled) {
+        set_constrained_parameters_.addClone(constraint_sampler_->parameters());
+      } else {
+        swarn << "Drawing Gaussian constraints directly failed. Falling back to generic generation." << endmsg;
+      }
+
       while ((arg = (RooAbsArg*)arg_it->Next())) {
         RooAbsPdf* constr_pdf    = dynamic_cast<RooAbsPdf*>(arg);
+        if (sampled && constraint_sampler_->supported_pdfs().find(constr_pdf->GetName()) != NULL) continue;
         RooArgSet* constr_params = constr_pdf->getObservables(parameters);
         
         // constr_pdf->getParameters(parameters)->Print();
 
         sinfo << "Drawing for " << *constr_params << " with PDF " << constr_pdf->GetName() << endmsg;
         
-        if (config_toyfactory_.parameter_read_file().size() > 0) {
-          if (!boost::filesystem::exists(config_toyfactory_.parameter_read_file())) {
-            serr << "Cannot read parameters from file " << config_toyfactory_.parameter_read_file() << endmsg;
-            throw NotGeneratingDataException();
-          }
-          RooArgSet* argset_parameters = constr_pdf->getParameters(constr_params);
-          argset_parameters->readFromFile(config_toyfactory_.parameter_read_file().c_str());
-          delete argset_parameters;
-        }
         RooDataSet * constr_data = constr_pdf->generate(*constr_params, 1);
     
         TIterator* par_it = constr_data->get(0)->createIterator();
@@ -258,25 +418,28 @@ namespace toy {
   }
   
   void ToyFactoryStd::MergeDatasets(RooDataSet* master_dataset, RooDataSet* slave_dataset, const std::vector<RooDataSet*>* ignore_sets, bool delete_slave) const {
-    // sanity check
-    const RooArgSet& master_argset = *master_dataset->get();
-    const RooArgSet& slave_argset  = *slave_dataset->get();
+    CheckDatasetsMergeable(*master_dataset->get(), master_dataset->numEntries(), *slave_dataset->get(), slave_dataset->numEntries(), ignore_sets);
+    master_dataset->merge(slave_dataset);
+    if (delete_slave) delete slave_dataset;
+  }
+
+  void ToyFactoryStd::CheckDatasetsMergeable(const RooArgSet& master_argset, int master_entries, const RooArgSet& slave_argset, int slave_entries, const std::vector<RooDataSet*>* ignore_sets) const {
     
-    // master_dataset->Print();
-    // slave_dataset->Print();
+    // master_argset.Print();
+    // slave_argset.Print();
     // if (ignore_sets != nullptr) {
     //   for (auto ignore_set : *ignore_sets) {
     //     ignore_set->Print();
     //   }
     // }
 
-    if (master_dataset->numEntries() != slave_dataset->numEntries()) {
+    if (master_entries != slave_entries) {
       serr << "Attempting two merge two datasets without equal size. Unable to cope with that. Giving up." << endmsg;
-      serr << "The dataset sizes are: " << master_dataset->numEntries() << " vs. " << slave_dataset->numEntries() << endmsg;
+      serr << "The dataset sizes are: " << master_entries << " vs. " << slave_entries << endmsg;
       throw DatasetsNotDisjointException();
     }
     
-    if (master_dataset->get()->overlaps(*slave_dataset->get())) {
+    if (master_argset.overlaps(slave_argset)) {
       // there is an overlap in both datasets, if the overlap is in columns 
       // which are also in ignore_argset this is no problem; need to check for 
       // that.
@@ -319,77 +482,67 @@ namespace toy {
         throw DatasetsNotDisjointException();
       }
     }
-    
-    master_dataset->merge(slave_dataset);
-    if (delete_slave) delete slave_dataset;
   }
 
   RooDataSet* ToyFactoryStd::MixMergeDatasets(RooDataSet* master_dataset, RooDataSet* slave_dataset) const {
     int n_slaves(slave_dataset->numEntries());
+    int n_master(master_dataset->numEntries());
 
-    // randomly distribute *all* slave entries over the master dataset range
-    int n_master = master_dataset->numEntries();
-    // std::fesetround(FE_TONEAREST);
-    std::set<int> positions_slave;
-    int i = 0;
-    while (i < slave_dataset->numEntries()) {
-      int rnd_pos = static_cast<int>(RooRandom::randomGenerator()->Rndm()*n_master);
-
-      if (positions_slave.count(rnd_pos) == 0) {
-        positions_slave.insert(rnd_pos);
-        ++i;
-      }
+    if (n_slaves > n_master) {
+      serr << "Cannot mix " << n_slaves << " entries into a dataset with only " << n_master << " entries." << endmsg;
+      throw DatasetsNotAppendableException();
     }
 
-    // for (auto el : positions_slave) {
-    //   sdebug << " el = " << el << endmsg;
-    // }
-    // sdebug << "mix in " << positions_slave.size() << " elements." << endmsg;
-
-    // double mix_fraction = static_cast<double>(n_slaves) / static_cast<double>(master_dataset->numEntries());
-    
-    // sdebug << "mix fraction = " << slave_dataset->numEntries() << "/" << master_dataset->numEntries() << " = " << static_cast<double>(slave_dataset->numEntries()) / static_cast<double>(master_dataset->numEntries()) << endmsg;
+    // randomly distribute *all* slave entries over the master dataset range
+    std::vector<bool> positions_slave = DrawMixPositions(n_master, n_slaves, *RooRandom::randomGenerator());
 
     const RooArgSet& vars = *master_dataset->get();
     RooDataSet* dataset_new = new RooDataSet(master_dataset->GetName(), master_dataset->GetTitle(), vars);
+    RooVectorDataStore* store_new = dynamic_cast<RooVectorDataStore*>(dataset_new->store());
+    if (store_new != nullptr) {
+      store_new->reserve(n_master);
+    }
 
+    // add() assigns by name, slave columns might be ordered differently
     int n_slave = 0;
-    for (int i=0; i<master_dataset->numEntries(); ++i) {
-      if (positions_slave.count(i) != 0) {
+    for (int i=0; i<n_master; ++i) {
+      if (positions_slave[i]) {
         dataset_new->add(*slave_dataset->get(n_slave)); 
         ++n_slave;
       } else {
         dataset_new->add(*master_dataset->get(i)); 
       }
-
-      //double rnd = RooRandom::randomGenerator()->Rndm();
-
-      // sdebug << "i = " << i << endmsg;
-      // sdebug << "n_slave = " << n_slave << endmsg;
-      // sdebug << "rnd = " << rnd << endmsg;
-
-      // if (rnd < mix_fraction && n_slave<n_slaves) {
-      //   dataset_new->add(*slave_dataset->get(n_slave)); 
-      //   ++n_slave;
-      // } else if (rnd < mix_fraction && n_slave>=n_slaves) {
-      //   swarn << "No more slaves although requested!" << endmsg;
-      //   dataset_new->add(*master_dataset->get(i)); 
-      // } else {
-      //   dataset_new->add(*master_dataset->get(i)); 
-      // }
     }
-    if (n_slave < n_slaves-1) {
-      swarn << "Still " << n_slaves-n_slave-1 << " slaves available!" << endmsg;
+    if (n_slave < n_slaves) {
+      swarn << "Still " << n_slaves-n_slave << " slaves available!" << endmsg;
     }
 
     return dataset_new;
   }
+
+  std::vector<bool> ToyFactoryStd::DrawMixPositions(int num_master, int num_slave, TRandom& random) {
+    std::vector<bool> positions(std::max(num_master, 0), false);
+
+    int num_left = std::min(num_slave, num_master);
+    for (int i=0; i<num_master && num_left > 0; ++i) {
+      if (random.Rndm()*(num_master-i) < num_left) {
+        positions[i] = true;
+        --num_left;
+      }
+    }
+    return positions;
+  }
   
   RooDataSet* ToyFactoryStd::AppendDatasets(RooDataSet* master_dataset, RooDataSet* slave_dataset) const {
-    // sanity check
-    const RooArgSet& master_argset = *master_dataset->get();
-    const RooArgSet& slave_argset  = *slave_dataset->get();
-    
+    CheckDatasetsAppendable(*master_dataset->get(), *slave_dataset->get());
+
+    // if we reached this, both datasets are compatible
+    ColumnarDataset assembly(*master_dataset);
+    assembly.AppendShuffled(ColumnarDataset(*slave_dataset), *RooRandom::randomGenerator());
+    return assembly.ToDataSet();
+  }
+
+  void ToyFactoryStd::CheckDatasetsAppendable(const RooArgSet& master_argset, const RooArgSet& slave_argset) const {
     if (master_argset.getSize() != slave_argset.getSize()) {
       serr << "Attempting two append two datasets with mixed column number. Unable to cope with that. Giving up." << endmsg;
       serr << "Cannot append " << slave_argset << " to " << master_argset << endmsg;
@@ -403,44 +556,60 @@ namespace toy {
       if (!master_argset.contains(*column)) {
         serr << "Attempting two append two datasets with non-identical columns. Unable to cope with that. Giving up." << endmsg;
         serr << "Cannot append " << slave_argset << " to " << master_argset << endmsg;
+        delete iter;
         throw DatasetsNotAppendableException();
       }
     }
     delete iter;
+  }
 
-    // if we reached this, both datasets are compatible
-
-    // Perform Fisher-Yates shuffle
-    TRandom* rand = RooRandom::randomGenerator();
-
-    int num_shuffle_elements = master_dataset->numEntries() + slave_dataset->numEntries();
-    int num_master = master_dataset->numEntries();
-    std::vector<int> new_order(num_shuffle_elements);
-
-    // only possible pitfall: both datasets empty
-    if (num_shuffle_elements > 0) {
-      new_order[0] = 0;
-      int j;
-      for (int i=1; i<num_shuffle_elements; ++i) {
-        j = rand->Integer(i+1);
-        new_order[i] = new_order[j];
-        new_order[j] = i;
-      }  
+  void ToyFactoryStd::AppendToAssembly(RooDataSet*& data, std::unique_ptr<ColumnarDataset>& assembly, RooDataSet* data_new) const {
+    if (data == NULL && !assembly) {
+      // a single component does not need any assembly
+      data = data_new;
+      return;
+    }
+    if (!assembly) {
+      assembly.reset(new ColumnarDataset(*data));
+      delete data;
+      data = NULL;
     }
 
-    const RooArgSet& vars = *master_dataset->get();
-    RooDataSet* dataset_new = new RooDataSet(master_dataset->GetName(), master_dataset->GetTitle(), vars);
-    for (int i=0; i<num_shuffle_elements; ++i) {
-      int num_draw = new_order[i];
+    CheckDatasetsAppendable(assembly->vars(), *data_new->get());
+    assembly->AppendShuffled(ColumnarDataset(*data_new), *RooRandom::randomGenerator());
+    delete data_new;
+  }
 
-      if (num_draw < num_master) {
-        dataset_new->add(*master_dataset->get(num_draw)); 
-      } else {
-        dataset_new->add(*slave_dataset->get(num_draw-num_master)); 
-      }
+  void ToyFactoryStd::MergeIntoAssembly(RooDataSet*& data, std::unique_ptr<ColumnarDataset>& assembly, RooDataSet* data_new, const std::vector<RooDataSet*>* ignore_sets, bool delete_new) const {
+    if (data == NULL && !assembly) {
+      data = delete_new ? data_new : new RooDataSet(*data_new);
+      return;
+    }
+    if (!assembly) {
+      assembly.reset(new ColumnarDataset(*data));
+      delete data;
+      data = NULL;
     }
 
-    return dataset_new;
+    // bins cannot be paired with events, binned factors are expanded into 
+    // (shuffled) events of unit weight
+    ColumnarDataset columns_new(*data_new);
+    if (assembly->weighted() || columns_new.weighted()) {
+      sinfo << "Expanding binned factor of product into events." << endmsg;
+      assembly->Unbin(*RooRandom::randomGenerator());
+      columns_new.Unbin(*RooRandom::randomGenerator());
+    }
+    CheckDatasetsMergeable(assembly->vars(), assembly->num_entries(), *data_new->get(), columns_new.num_entries(), ignore_sets);
+    assembly->MergeColumns(columns_new);
+    if (delete_new) delete data_new;
+  }
+
+  RooDataSet* ToyFactoryStd::FinishAssembly(RooDataSet* data, std::unique_ptr<ColumnarDataset>& assembly) const {
+    if (assembly) {
+      data = assembly->ToDataSet();
+      assembly.reset();
+    }
+    return data;
   }
   
   RooDataSet* ToyFactoryStd::MergeDatasetVector(const std::vector<RooDataSet*>& datasets) const {
@@ -448,14 +617,12 @@ namespace toy {
       serr << "Cannot merge datasets in empty vector." << endmsg;
       throw;
     } 
-    RooDataSet* new_dataset = new RooDataSet(*datasets[0]);
-    
-    if (datasets.size() > 1) {
-      for (std::vector<RooDataSet*>::const_iterator it=datasets.begin()+1; it!=datasets.end(); ++it) {
-        MergeDatasets(new_dataset, *it, NULL, false);
-      }
+    RooDataSet* new_dataset = NULL;
+    std::unique_ptr<ColumnarDataset> assembly;
+    for (auto dataset : datasets) {
+      MergeIntoAssembly(new_dataset, assembly, dataset, NULL, false);
     }
-    return new_dataset;
+    return FinishAssembly(new_dataset, assembly);
   }
   
   std::vector<config::CommaSeparatedPair<std::string>> ToyFactoryStd::GetPdfProtoSections(const std::string& pdf_name) const {
@@ -472,25 +639,253 @@ namespace toy {
   
   
 
-  void ToyFactoryStd::SignalHandler( int signum ) {
-    using namespace doocore::io;
-    if (signum == SIGABRT) {
-      swarn << "Caught SIGABRT signal. Problematic generation occured. Will drop the whole sample." << endmsg;
-      signal_caught_ = true;
-      //jmp_buf jump_buffer_;
-      longjmp(jump_buffer_, 1);
-    } else {
-      // cleanup and close up stuff here  
-      // terminate program  
-      exit(signum);
+  RooDataSet* ToyFactoryStd::GenerateWithCachedContext(RooAbsPdf& pdf, const RooArgSet& argset_observables, int yield, bool extended) const {
+    std::string observables = ObservableNames(argset_observables);
+
+    std::map<const RooAbsPdf*, GenerationContext>::iterator it = generation_contexts_.find(&pdf);
+    bool skip_init = false;
+    if (it != generation_contexts_.end()) {
+      GenerationContext& cached = it->second;
+      if (cached.observables == observables && cached.values == ParameterValues(*cached.parameters)) {
+        skip_init = true;
+      } else {
+        // parameters changed, prepare context again
+        delete cached.context;
+        delete cached.parameters;
+        generation_contexts_.erase(it);
+        it = generation_contexts_.end();
+      }
+    }
+
+    if (it == generation_contexts_.end()) {
+      GenerationContext cached;
+      cached.context     = pdf.genContext(argset_observables);
+      cached.observables = observables;
+      cached.parameters  = pdf.getParameters(argset_observables);
+      cached.values      = ParameterValues(*cached.parameters);
+      it = generation_contexts_.insert(std::make_pair(&pdf, cached)).first;
+    }
+
+    GenerationContext& cached = it->second;
+    if (cached.context == NULL || !cached.context->isValid()) {
+      serr << "ToyFactoryStd::GenerateWithCachedContext(...): Cannot create generator context for PDF " << pdf.GetName() << endmsg;
+      throw NotGeneratingDataException();
     }
+
+    // skipping the initialisation saves e.g. the accept/reject maximum search
+    return cached.context->generate(yield, skip_init, extended);
+  }
+
+  std::vector<double> ToyFactoryStd::ParameterValues(const RooArgSet& parameters) {
+    std::vector<double> values;
+    TIterator* par_iter = parameters.createIterator();
+    RooAbsArg* par = NULL;
+    while ((par = (RooAbsArg*)par_iter->Next())) {
+      RooAbsReal* par_real     = dynamic_cast<RooAbsReal*>(par);
+      RooAbsCategory* par_cat = dynamic_cast<RooAbsCategory*>(par);
+      if (par_real != NULL) {
+        values.push_back(par_real->getVal());
+      } else if (par_cat != NULL) {
+        values.push_back(par_cat->getIndex());
+      }
+    }
+    delete par_iter;
+    return values;
+  }
+
+  std::string ToyFactoryStd::ObservableNames(const RooArgSet& observables) {
+    std::string names;
+    TIterator* obs_iter = observables.createIterator();
+    RooAbsArg* obs = NULL;
+    while ((obs = (RooAbsArg*)obs_iter->Next())) {
+      names += std::string(obs->GetName()) + ",";
+    }
+    delete obs_iter;
+    return names;
+  }
+
+  void ToyFactoryStd::ClearGenerationContexts() {
+    for (auto cached : generation_contexts_) {
+      delete cached.second.context;
+      delete cached.second.parameters;
+    }
+    generation_contexts_.clear();
   }
 
+  RooDataSet* ToyFactoryStd::GenerateBinned(RooAbsPdf& pdf, const RooArgSet& argset_generation_observables, double expected_yield, bool extended) const {
+    RooArgSet* obs_argset = pdf.getObservables(argset_generation_observables);
+    std::string observables = ObservableNames(*obs_argset);
+
+    std::map<const RooAbsPdf*, BinnedGeneration>::iterator it = binned_generations_.find(&pdf);
+    if (it != binned_generations_.end()) {
+      BinnedGeneration& cached = it->second;
+      if (cached.observables != observables || cached.values != ParameterValues(*cached.parameters)) {
+        // parameters changed, compute bin probabilities again
+        delete cached.sampler;
+        delete cached.parameters;
+        binned_generations_.erase(it);
+        it = binned_generations_.end();
+      }
+    }
+
+    if (it == binned_generations_.end()) {
+      BinnedGeneration cached;
+      cached.sampler     = new BinnedSampler(pdf, *obs_argset, ObservableBins());
+      cached.observables = observables;
+      cached.parameters  = pdf.getParameters(*obs_argset);
+      cached.values      = ParameterValues(*cached.parameters);
+      it = binned_generations_.insert(std::make_pair(&pdf, cached)).first;
+      sinfo << "Computed bin probabilities of PDF " << pdf.GetName() << " in " << cached.sampler->num_bins() << " bins." << endmsg;
+    }
+    delete obs_argset;
+
+    BinnedSampler& sampler = *it->second.sampler;
+    if (!sampler.IsValid()) {
+      serr << "ToyFactoryStd::GenerateBinned(...): Cannot generate PDF " << pdf.GetName() << " binned." << endmsg;
+      throw NotGeneratingDataException();
+    }
 
+    double yield = expected_yield;
+    if (yield <= 0.0 && pdf.canBeExtended()) {
+      yield = pdf.expectedEvents(argset_generation_observables);
+    }
+
+    SeedRandomStream("generate");
+    return sampler.Generate(yield, extended, *RooRandom::randomGenerator());
+  }
+
+  void ToyFactoryStd::ClearBinnedGenerations() {
+    for (auto cached : binned_generations_) {
+      delete cached.second.sampler;
+      delete cached.second.parameters;
+    }
+    binned_generations_.clear();
+  }
+
+  std::map<std::string, int> ToyFactoryStd::ObservableBins() const {
+    std::map<std::string, int> num_bins;
+    const std::vector<config::CommaSeparatedPair<std::string>>& observable_bins = config_toyfactory_.observable_bins();
+    for (std::vector<config::CommaSeparatedPair<std::string>>::const_iterator it = observable_bins.begin(); it != observable_bins.end(); ++it) {
+      try {
+        num_bins[(*it).first()] = boost::lexical_cast<int>((*it).second());
+      } catch (const boost::bad_lexical_cast& e) {
+        serr << "Cannot interpret number of bins " << (*it).second() << " for observable " << (*it).first() << "." << endmsg;
+        throw NotGeneratingDataException();
+      }
+    }
+    return num_bins;
+  }
+
+  std::map<std::string, std::vector<double>> ToyFactoryStd::DiscreteValues() const {
+    std::map<std::string, std::vector<double>> values;
+    const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities = config_toyfactory_.discrete_probabilities();
+    for (std::vector<config::DiscreteProbabilityDistribution>::const_iterator it = discrete_probabilities.begin(); it != discrete_probabilities.end(); ++it) {
+      std::vector<double>& var_values = values[(*it).var_name()];
+      var_values.clear();
+      for (auto& probability : (*it).probabilities()) {
+        var_values.push_back(probability.first);
+      }
+    }
+    return values;
+  }
+
+  void ToyFactoryStd::PrepareToy(unsigned long long toy_index, std::uint64_t seed) {
+    toy_index_ = toy_index;
+    if (config_toyfactory_.random_streams()) return;
+
+    SeedRandomGenerator(ToySeed(toy_index_, seed));
+  }
+
+  std::uint64_t ToyFactoryStd::ToySeed(unsigned long long toy_index, std::uint64_t seed) const {
+    return StreamSeed(config_toyfactory_.random_streams() ? stream_seed_ : seed, toy_index, "toy");
+  }
+
+  void ToyFactoryStd::SeedRandomStream(const std::string& step) const {
+    if (!config_toyfactory_.random_streams()) return;
+
+    std::string component;
+    for (auto name : stream_path_) {
+      component += name + "/";
+    }
+    component += step;
+
+    SeedRandomGenerator(StreamSeed(stream_seed_, toy_index_, component));
+  }
+
+  void ToyFactoryStd::SeedRandomGenerator(std::uint64_t seed) {
+    // TRandom3 treats 0 as request for a random seed, avoid it for all generators
+    if (seed == 0) seed = 1;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    TRandomMixMax* generator = dynamic_cast<TRandomMixMax*>(RooRandom::randomGenerator());
+    if (generator == NULL) {
+      // RooRandom takes ownership
+      generator = new TRandomMixMax();
+      RooRandom::setRandomGenerator(generator);
+    }
+    generator->SetSeed(static_cast<ULong64_t>(seed));
+#else
+    UInt_t seed_32 = static_cast<UInt_t>(seed ^ (seed >> 32));
+    if (seed_32 == 0) seed_32 = 1;
+    RooRandom::randomGenerator()->SetSeed(seed_32);
+#endif
+  }
+
+  std::uint64_t ToyFactoryStd::StreamSeed(std::uint64_t seed, std::uint64_t toy_index, const std::string& component) {
+    auto splitmix64 = [](std::uint64_t x) {
+      x += 0x9e3779b97f4a7c15ULL;
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    };
+
+    // 64 bit FNV-1a of component identifier
+    std::uint64_t hash_component = 14695981039346656037ULL;
+    for (auto c : component) {
+      hash_component ^= static_cast<unsigned char>(c);
+      hash_component *= 1099511628211ULL;
+    }
+
+    return splitmix64(splitmix64(splitmix64(seed) ^ toy_index) ^ hash_component);
+  }
+
+  std::vector<RooDataSet*> ToyFactoryStd::RunGenerationTasks(const std::vector<GenerationTask>& tasks) const {
+    std::vector<RooDataSet*> datasets(tasks.size(), nullptr);
+
+    unsigned int num_workers = std::min<std::size_t>(std::max(config_toyfactory_.num_cpu_generation(), 1), tasks.size());
+    if (generation_worker_) num_workers = 1;
+
+    if (num_workers > 1) {
+      // each worker process generates an interleaved subset of components on 
+      // its own copy of the PDF
+      sinfo << "Generating " << tasks.size() << " components in " << num_workers << " worker processes." << endmsg;
+      using namespace doofit::tools::workers;
+      RunInWorkers(tasks.size(), num_workers, 
+                   [this, &tasks](std::size_t i) {
+                     generation_worker_ = true;
+                     std::unique_ptr<RooDataSet> data(tasks[i]());
+                     return data ? SerialiseObject(*data) : std::vector<char>();
+                   },
+                   [&datasets](std::size_t i, std::vector<char>& bytes) {
+                     if (datasets[i] == nullptr) datasets[i] = DeserialiseObject<RooDataSet>(bytes);
+                   });
+    }
+
+    // serial generation (also for anything workers did not deliver)
+    for (unsigned int i=0; i<tasks.size(); ++i) {
+      if (datasets[i] == nullptr) {
+        if (num_workers > 1) {
+          swarn << "No dataset for component " << i << " from worker process. Generating serially." << endmsg;
+        }
+        datasets[i] = tasks[i]();
+      }
+    }
+    return datasets;
+  }
 
   RooDataSet* ToyFactoryStd::GenerateForPdf(RooAbsPdf& pdf, const RooArgSet& argset_generation_observables, double expected_yield, bool extended, std::vector<RooDataSet*> proto_data) const {
     RooDataSet* data = NULL;
     bool have_to_delete_proto_data = false;
+    stream_path_.push_back(pdf.GetName());
     
     const std::vector<config::CommaSeparatedPair<std::string>>& matched_proto_sections = GetPdfProtoSections(pdf.GetName());
     if (matched_proto_sections.size() > 0) {
@@ -523,6 +918,7 @@ namespace toy {
       RooDataSet* proto_data_this_pdf = NULL;
       
       for (std::vector<config::CommaSeparatedPair<std::string>>::const_iterator it=matched_proto_sections.begin(); it != matched_proto_sections.end(); ++it) {
+        SeedRandomStream("proto:" + (*it).second());
         RooDataSet* temp_data = GenerateProtoSample(pdf, *it, argset_generation_observables, config_toyfactory_.easypdf(), config_toyfactory_.workspace(), proto_size);
         
         // merge proto sets if necessary
@@ -539,7 +935,16 @@ namespace toy {
       have_to_delete_proto_data = true;
     }
     
-    if (PdfIsDecomposable(pdf)) {
+    bool binned = PdfIsBinned(pdf);
+    if (binned && proto_data.size() > 0) {
+      swarn << "PDF " << pdf.GetName() << " is to be generated binned, but proto data is needed. Generating unbinned." << endmsg;
+      binned = false;
+    }
+    
+    if (binned) {
+      sinfo << "Generating binned for PDF " << pdf.GetName() << " (" << pdf.IsA()->GetName() << "). Expected yield: " << expected_yield << " events." << endmsg;
+      data = GenerateBinned(pdf, argset_generation_observables, expected_yield, extended);
+    } else if (PdfIsDecomposable(pdf)) {
       // pdf needs to be decomposed and generated piece-wise 
       if (PdfIsExtended(pdf)) {
         // probe yield and sub PDF in PDF's servers
@@ -623,23 +1028,15 @@ namespace toy {
         data = dynamic_cast<RooDataSet*>(proto_set->reduce(EventRange(0, yield_to_generate)));
       } else {
         if (yield_to_generate > 0.0) {
-
-          // set jump point in case RooFit sends SIGABRT (only way to catch this...)
-          int val = setjmp(jump_buffer_);
-          //sdebug << "val = " << val << ", signal_caught_ = " << signal_caught_ << endmsg;
-
-          if (val == 0.0 && !signal_caught_) {
+          SeedRandomStream("generate");
+          if (generation_session_ && proto_set == NULL) {
+            data = GenerateWithCachedContext(pdf, *obs_argset, yield_to_generate, extended);
+          } else {
 #if ROOT_VERSION_CODE >= ROOT_VERSION(5,32,0)
             data = pdf.generate(*obs_argset, yield_to_generate, extend_arg, proto_arg, AutoBinned(false));
 #else
             data = pdf.generate(*obs_argset, yield_to_generate, extend_arg, proto_arg);
 #endif
-          } else {
-            // if SIGABRT is caught, throw a proper exception
-            serr << "ToyFactoryStd::GenerateForPdf(...): RooFit threw SIGABRT signal. Cannot continue." << endmsg;
-            signal(SIGABRT, SIG_DFL);
-            sinfo.set_indent(0);
-            throw RooFitSendingSIGABRTException();
           }
         } else {
           // in case expected yield is zero, RooFit will still generate 1 event. Fix that with an empty dataset.
@@ -670,12 +1067,17 @@ namespace toy {
         delete proto_set;
       }
     }
-    sinfo << "Generated " << data->numEntries() << " events for PDF " << pdf.GetName() <<  " in dimensions " << *data->get() << endmsg;
+    if (data->isWeighted()) {
+      sinfo << "Generated " << data->sumEntries() << " events in " << data->numEntries() << " bins for PDF " << pdf.GetName() <<  " in dimensions " << *data->get() << endmsg;
+    } else {
+      sinfo << "Generated " << data->numEntries() << " events for PDF " << pdf.GetName() <<  " in dimensions " << *data->get() << endmsg;
+    }
     
     if (have_to_delete_proto_data) {
       delete proto_data.back();
       proto_data.pop_back(); 
     }    
+    stream_path_.pop_back();
     return data;
   }
   
@@ -724,6 +1126,14 @@ namespace toy {
     }
     
     double yield_lost_due_rounding = 0.0;
+
+    // with random streams, all yields are drawn first and the sub PDFs are 
+    // generated afterwards as independent tasks
+    bool random_streams = config_toyfactory_.random_streams();
+    std::vector<GenerationTask> tasks;
+    std::vector<RooDataSet*> sub_proto_datasets;
+    std::unique_ptr<ColumnarDataset> assembly;
+    SeedRandomStream("yields");
     
     while ((sub_pdf = (RooAbsPdf*)it->Next())) {
       if (sub_pdf->IsA()->InheritsFrom("RooAbsPdf")) {
@@ -804,25 +1214,38 @@ namespace toy {
 
         // sdebug << "Sub yield for next PDF " << sub_pdf->GetName() << " is " << sub_yield << endmsg;
 
-        if (data) {
-          RooDataSet* data_temp = GenerateForPdf(*sub_pdf, argset_generation_observables, sub_yield, false, sub_proto_data);
-          RooDataSet* data_mixed = AppendDatasets(data, data_temp);
-          delete data;
-          delete data_temp;
-          data = data_mixed;
+        if (random_streams) {
+          tasks.push_back([this, sub_pdf, &argset_generation_observables, sub_yield, sub_proto_data]() {
+            return GenerateForPdf(*sub_pdf, argset_generation_observables, sub_yield, false, sub_proto_data);
+          });
+          if (sub_proto_dataset != NULL) {
+            sub_proto_datasets.push_back(sub_proto_dataset);
+          }
         } else {
-          data = (GenerateForPdf(*sub_pdf, argset_generation_observables, sub_yield, false, sub_proto_data));
-        }
-        
-        if (sub_proto_dataset != NULL) {
-          delete sub_proto_dataset;
+          AppendToAssembly(data, assembly, GenerateForPdf(*sub_pdf, argset_generation_observables, sub_yield, false, sub_proto_data));
+          
+          if (sub_proto_dataset != NULL) {
+            delete sub_proto_dataset;
+          }
         }
       }
     }
     delete it;
+
+    if (random_streams) {
+      std::vector<RooDataSet*> datasets = RunGenerationTasks(tasks);
+      SeedRandomStream("append");
+      for (auto data_temp : datasets) {
+        AppendToAssembly(data, assembly, data_temp);
+      }
+      for (auto sub_proto_dataset : sub_proto_datasets) {
+        delete sub_proto_dataset;
+      }
+    }
     if (proto_dataset != NULL) {
       delete proto_dataset;
     }
+    data = FinishAssembly(data, assembly);
     
     sinfo.set_indent(sinfo.indent()-2);
     return data;
@@ -840,23 +1263,18 @@ namespace toy {
     RooDataSet* data = NULL;
     
     if (extended) {
+      SeedRandomStream("yield");
       expected_yield = RooRandom::randomGenerator()->Poisson(expected_yield);
     }
     
+    // columns of all sub PDFs are collected and the dataset is built once
+    std::unique_ptr<ColumnarDataset> assembly;
     while ((sub_pdf = (RooAbsPdf*)it->Next())) {
-      if (data) {
-        RooDataSet* data_temp = GenerateForPdf(*sub_pdf, argset_generation_observables, expected_yield, false, proto_data);
-        
-        if (proto_data.size() > 0) {
-          MergeDatasets(data, data_temp, &proto_data);
-        } else {
-          MergeDatasets(data, data_temp);
-        }
-      } else {
-        data = GenerateForPdf(*sub_pdf, argset_generation_observables, expected_yield, false, proto_data);
-      }
+      RooDataSet* data_temp = GenerateForPdf(*sub_pdf, argset_generation_observables, expected_yield, false, proto_data);
+      MergeIntoAssembly(data, assembly, data_temp, proto_data.size() > 0 ? &proto_data : NULL);
     }
     delete it;
+    data = FinishAssembly(data, assembly);
     
     sinfo.set_indent(sinfo.indent()-2);
     return data;
@@ -877,15 +1295,15 @@ namespace toy {
     
     RooDataSet* data = NULL;
     
-    RooCatType* sim_cat_type = NULL;
-    TIterator* sim_cat_type_iter = sim_cat.typeIterator();
-    while((sim_cat_type=(RooCatType*)sim_cat_type_iter->Next())) {
-      std::string sim_cat_name = sim_cat_type->GetName();
+    auto generate_category = [&](const std::string& sim_cat_name) -> RooDataSet* {
       sim_cat.setLabel(sim_cat_name.c_str());
       RooAbsPdf& sub_pdf = *(sim_pdf.getPdf(sim_cat_name.c_str()));
       
       sinfo << "Generating for simultaneous sub PDF " << sub_pdf.GetName() << " for category " << sim_cat.getLabel() << endmsg;
+      // categories might share the same sub PDF, but need independent streams
+      stream_path_.push_back(sim_cat_name);
       RooDataSet* data_temp = GenerateForPdf(sub_pdf, argset_generation_observables, expected_yield, extended, proto_data);
+      stream_path_.pop_back();
       data_temp->addColumn(sim_cat);
       
       // add categories if super category
@@ -899,35 +1317,263 @@ namespace toy {
         }
         delete it;
       }
-      
-      if (data) {
-        RooDataSet* data_mixed = AppendDatasets(data, data_temp);
-        delete data;
-        delete data_temp;
-        data = data_mixed;
+      return data_temp;
+    };
+
+    bool random_streams = config_toyfactory_.random_streams();
+    std::vector<GenerationTask> tasks;
+    std::unique_ptr<ColumnarDataset> assembly;
+    
+    RooCatType* sim_cat_type = NULL;
+    TIterator* sim_cat_type_iter = sim_cat.typeIterator();
+    while((sim_cat_type=(RooCatType*)sim_cat_type_iter->Next())) {
+      std::string sim_cat_name = sim_cat_type->GetName();
+
+      if (random_streams) {
+        tasks.push_back(std::bind(generate_category, sim_cat_name));
       } else {
-        data = data_temp;
+        AppendToAssembly(data, assembly, generate_category(sim_cat_name));
       }
     }
     delete sim_cat_type_iter;
+
+    if (random_streams) {
+      std::vector<RooDataSet*> datasets = RunGenerationTasks(tasks);
+      SeedRandomStream("append");
+      for (auto data_temp : datasets) {
+        AppendToAssembly(data, assembly, data_temp);
+      }
+    }
+    data = FinishAssembly(data, assembly);
     sinfo.set_indent(sinfo.indent()-2);
     return data;
   }
   
+  void ToyFactoryStd::AsimovForPdf(RooAbsPdf& pdf, double expected_yield, BinnedHistogram& histogram) const {
+    const RooArgSet& argset_generation_observables = *(config_toyfactory_.argset_generation_observables());
+    
+    if (!PdfIsBinned(pdf) && PdfIsExtended(pdf)) {
+      // probe yield and sub PDF in PDF's servers
+      RooRealVar* yield_ptr = dynamic_cast<RooRealVar*>(pdf.findServer(1));
+      if (yield_ptr == nullptr) {
+        yield_ptr = dynamic_cast<RooRealVar*>(pdf.findServer(0));
+      }
+      RooAbsPdf* sub_pdf_ptr = dynamic_cast<RooAbsPdf*>(pdf.findServer(0));
+      if (sub_pdf_ptr == nullptr) {
+        sub_pdf_ptr = dynamic_cast<RooAbsPdf*>(pdf.findServer(1));
+      }
+      if (yield_ptr == nullptr || sub_pdf_ptr == nullptr) {
+        serr << "ToyFactoryStd::AsimovForPdf(...): Cannot find yield and sub PDF of RooExtendPdf " << pdf.GetName() << endmsg;
+        throw NotGeneratingDataException();
+      }
+      
+      sinfo << "RooExtendPdf " << pdf.GetName() << "(" << sub_pdf_ptr->GetName() << "," << yield_ptr->GetName() << "=" << yield_ptr->getVal() << ") will be decomposed." << endmsg;
+      sinfo.set_indent(sinfo.indent()+2);
+      AsimovForPdf(*sub_pdf_ptr, expected_yield>0 ? expected_yield : yield_ptr->getVal(), histogram);
+      sinfo.set_indent(sinfo.indent()-2);
+    } else if (!PdfIsBinned(pdf) && PdfIsAdded(pdf)) {
+      RooAddPdf& add_pdf = dynamic_cast<RooAddPdf&>(pdf);
+      const RooArgList& coefs = add_pdf.coefList();
+      // whether PDF is extended or relying on coefficients
+      bool add_pdf_extended = (coefs.getSize() == 0);
+      if (expected_yield==0 && add_pdf_extended) {
+        expected_yield = pdf.expectedEvents(argset_generation_observables);
+      }
+      sinfo << "RooAddPdf " << pdf.GetName() << " will be decomposed. Expecting " << expected_yield << " events." << endmsg;
+      sinfo.set_indent(sinfo.indent()+2);
+      
+      // coefficients as in GenerateForAddedPdf(...), but without Poisson 
+      // distributed or rounded yields
+      int coef_i = 0;
+      double sum_coef = 0.0;
+      TIterator* it = add_pdf.pdfList().createIterator();
+      RooAbsPdf* sub_pdf = NULL;
+      while ((sub_pdf = (RooAbsPdf*)it->Next())) {
+        double coef;
+        if (add_pdf_extended) {
+          coef = sub_pdf->expectedEvents(argset_generation_observables)/pdf.expectedEvents(argset_generation_observables);
+        } else if (pdf.mustBeExtended() || coef_i < coefs.getSize()) {
+          coef = dynamic_cast<RooAbsReal&>(coefs[coef_i++]).getVal();
+          sum_coef += coef;
+        } else {
+          // last coefficient is (in non-recursive way) always 1-(sum coeffs)
+          coef = 1.0 - sum_coef;
+        }
+        
+        double sub_yield = (!add_pdf_extended && pdf.mustBeExtended()) ? coef : coef*expected_yield;
+        AsimovForPdf(*sub_pdf, sub_yield, histogram);
+      }
+      delete it;
+      sinfo.set_indent(sinfo.indent()-2);
+    } else if (!PdfIsBinned(pdf) && PdfIsSimultaneous(pdf)) {
+      sinfo << "RooSimultaneous " << pdf.GetName() << " will be decomposed." << endmsg;
+      sinfo.set_indent(sinfo.indent()+2);
+      
+      RooSimultaneous& sim_pdf = dynamic_cast<RooSimultaneous&>(pdf);
+      RooAbsCategoryLValue& sim_cat = *dynamic_cast<RooAbsCategoryLValue*>(sim_pdf.findServer(sim_pdf.indexCat().GetName()));
+      
+      // categories the index category depends on (itself or inputs of a 
+      // super category)
+      RooArgSet sim_cats(sim_cat);
+      RooSuperCategory* sim_super_cat = dynamic_cast<RooSuperCategory*>(&sim_cat);
+      if (sim_super_cat != NULL) {
+        sim_cats.add(sim_super_cat->inputCatList());
+      }
+      
+      RooCatType* sim_cat_type = NULL;
+      TIterator* sim_cat_type_iter = sim_cat.typeIterator();
+      while ((sim_cat_type=(RooCatType*)sim_cat_type_iter->Next())) {
+        sim_cat.setLabel(sim_cat_type->GetName());
+        RooAbsPdf& sub_pdf = *(sim_pdf.getPdf(sim_cat_type->GetName()));
+        sinfo << "Computing expectation for simultaneous sub PDF " << sub_pdf.GetName() << " for category " << sim_cat.getLabel() << endmsg;
+        
+        // expectation of sub PDF restricted to the current category state
+        std::map<std::string, std::vector<double>> values = DiscreteValues();
+        RooArgSet* sub_observables = sub_pdf.getObservables(histogram.observables());
+        TIterator* cat_it = sim_cats.createIterator();
+        RooAbsArg* arg = NULL;
+        while ((arg = (RooAbsArg*)cat_it->Next())) {
+          RooAbsArg* observable = histogram.observables().find(arg->GetName());
+          if (observable != NULL) {
+            sub_observables->add(*observable, true);
+            values[arg->GetName()] = std::vector<double>(1, static_cast<double>(dynamic_cast<RooAbsCategory*>(arg)->getIndex()));
+          }
+        }
+        delete cat_it;
+        
+        BinnedHistogram sub_histogram(*sub_observables, ObservableBins(), values);
+        delete sub_observables;
+        
+        sinfo.set_indent(sinfo.indent()+2);
+        AsimovForPdf(sub_pdf, expected_yield, sub_histogram);
+        sinfo.set_indent(sinfo.indent()-2);
+        histogram.Add(sub_histogram);
+      }
+      delete sim_cat_type_iter;
+      sinfo.set_indent(sinfo.indent()-2);
+    } else {
+      RooArgSet* obs_argset = pdf.getObservables(histogram.observables());
+      
+      // products of PDFs in disjoint observables are the product of their 
+      // normalised expectations
+      std::vector<std::pair<RooAbsPdf*, RooArgSet*>> factors;
+      bool factorising = !PdfIsBinned(pdf) && PdfIsProduct(pdf);
+      if (factorising) {
+        RooArgSet observables_seen;
+        TIterator* it = dynamic_cast<RooProdPdf&>(pdf).pdfList().createIterator();
+        RooAbsPdf* sub_pdf = NULL;
+        while ((sub_pdf = (RooAbsPdf*)it->Next())) {
+          RooArgSet* sub_observables = sub_pdf->getObservables(histogram.observables());
+          if (observables_seen.overlaps(*sub_observables)) {
+            factorising = false;
+          }
+          observables_seen.add(*sub_observables, true);
+          factors.push_back(std::make_pair(sub_pdf, sub_observables));
+        }
+        delete it;
+      }
+      
+      double yield = expected_yield;
+      if (yield <= 0.0 && pdf.canBeExtended()) {
+        yield = pdf.expectedEvents(argset_generation_observables);
+      }
+      
+      BinnedHistogram pdf_histogram(*obs_argset, ObservableBins(), DiscreteValues());
+      bool valid = pdf_histogram.IsValid();
+      if (factorising) {
+        sinfo << "RooProdPdf " << pdf.GetName() << " will be decomposed. Expecting " << yield << " events." << endmsg;
+        sinfo.set_indent(sinfo.indent()+2);
+        for (unsigned long long bin=0; bin<pdf_histogram.num_bins(); ++bin) {
+          pdf_histogram.set_content(bin, 1.0);
+        }
+        for (auto& factor : factors) {
+          // factors without observables only contribute a constant
+          if (factor.second->getSize() == 0) continue;
+          BinnedHistogram factor_histogram(*factor.second, ObservableBins(), DiscreteValues());
+          AsimovForPdf(*factor.first, 1.0, factor_histogram);
+          double sum = factor_histogram.Sum();
+          valid &= sum > 0.0;
+          if (valid) {
+            factor_histogram.Scale(1.0/sum);
+            pdf_histogram.Multiply(factor_histogram);
+          }
+        }
+        sinfo.set_indent(sinfo.indent()-2);
+        if (valid) {
+          pdf_histogram.Scale(yield/pdf_histogram.Sum());
+        }
+      } else {
+        sinfo << "Computing expectation for PDF " << pdf.GetName() << " (" << pdf.IsA()->GetName() << "). Expected yield: " << yield << " events." << endmsg;
+        valid = valid && pdf_histogram.FillFromPdf(pdf, yield);
+      }
+      for (auto& factor : factors) {
+        delete factor.second;
+      }
+      delete obs_argset;
+      
+      if (!valid) {
+        serr << "ToyFactoryStd::AsimovForPdf(...): Cannot compute expectation of PDF " << pdf.GetName() << " in bins." << endmsg;
+        throw NotGeneratingDataException();
+      }
+      histogram.Add(pdf_histogram);
+    }
+  }
+  
+  void ToyFactoryStd::AsimovDiscreteProbabilities(const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities, BinnedHistogram& histogram) const {
+    RooArgSet discrete_vars;
+    for (std::vector<config::DiscreteProbabilityDistribution>::const_iterator it = discrete_probabilities.begin(); it != discrete_probabilities.end(); ++it) {
+      discrete_vars.add(*histogram.observables().find((*it).var_name().c_str()), true);
+    }
+    sinfo << "Applying discrete probabilities for " << discrete_vars << endmsg;
+    
+    // discretely distributed variables replace whatever the PDF expects for 
+    // them: sum over them and multiply with their probabilities
+    RooArgSet observables_other(histogram.observables());
+    observables_other.remove(discrete_vars, true, true);
+    BinnedHistogram marginal(observables_other, ObservableBins(), DiscreteValues());
+    marginal.Add(histogram);
+    histogram.Scale(0.0);
+    histogram.Add(marginal, 1.0, false);
+    
+    for (std::vector<config::DiscreteProbabilityDistribution>::const_iterator it = discrete_probabilities.begin(); it != discrete_probabilities.end(); ++it) {
+      // probabilities of the values as drawn by DiscreteSampler, i.e. the 
+      // first value with a cumulative probability above a uniform number
+      std::map<std::string, std::vector<double>> var_values;
+      for (auto& probability : (*it).probabilities()) {
+        var_values[(*it).var_name()].push_back(probability.first);
+      }
+      BinnedHistogram probabilities(RooArgSet(*discrete_vars.find((*it).var_name().c_str())), ObservableBins(), var_values);
+      
+      double cum_prob_max = 0.0;
+      for (unsigned int i=0; i<(*it).probabilities().size(); ++i) {
+        double cum_prob = (*it).probabilities()[i].second;
+        probabilities.set_content(i, std::max(cum_prob-cum_prob_max, 0.0));
+        cum_prob_max = std::max(cum_prob, cum_prob_max);
+      }
+      if (TMath::Abs(cum_prob_max-1.0) > 1e-9 && cum_prob_max > 0.0) {
+        swarn << "WARNING: Cumulative probability for " << (*it).var_name() << " ends at " << cum_prob_max << ". Probabilities are normalised to 1 for the Asimov dataset." << endmsg;
+        probabilities.Scale(1.0/cum_prob_max);
+      }
+      histogram.Multiply(probabilities);
+    }
+  }
+  
   RooDataSet* ToyFactoryStd::GenerateDiscreteSample(const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities, const RooArgSet& argset_generation_observables, const RooArgSet& argset_already_generated, int yield) const {
-    // Vector containing necessary information for discrete variable generation.
-    // Tuple contents:
-    //  1. The variable as RooAbsArg* itself
-    //  2. the C style array containing cumulative probabilities (efficiency is 
-    //     relevant here)
-    //  3. the corresponding values of the variable as C style array
-    //  4. the number how many times the variable was generated as C style array
-    //  5. number of entries in C style arrays
-    std::vector<boost::tuple<RooAbsArg*,double*,double*,int*,int> > disc_vars;
+    // Everything needed for generation of one discrete variable. Casts are 
+    // done once here and not for every event.
+    struct DiscreteColumn {
+      RooAbsArg* var;
+      RooRealVar* realvar;
+      RooCategory* catvar;
+      DiscreteSampler sampler;
+      std::vector<int> num_generated;
+      std::vector<int> indices;
+    };
+    std::vector<DiscreteColumn> disc_vars;
     
     // prepare everything:
     //  - check variables for validity
-    //  - generate arrays with values and cumulative probabilities
+    //  - build samplers for the probability distributions
     //  - add to relevant arg sets
     RooArgSet disc_argset;
     RooArgSet disc_cat_argset;
@@ -947,27 +1593,6 @@ namespace toy {
           << "). Will overwrite the already generated values or replace based on cumulative probability." << endmsg;
           //throw NotGeneratingDiscreteData();
         } //else {
-        const std::vector<std::pair<double,double> >& prob_map = (*it).probabilities();
-        // create some simple arrays for faster generation (looping over arrays 
-        // faster than looping over complex vectors and stuff).
-        // I tried creating a special case for constant variables 
-        // (num_values == 1), but it's not worth (the overhead through looping 
-        // is irrelevant).
-        int num_values = prob_map.size();
-        double* cum_probs     = new double[num_values];
-        double* values        = new double[num_values];
-        int*    num_generated = new int[num_values];
-        double  total_prob    = 0.0;
-                  
-        int j = 0;
-        for (std::vector<std::pair<double,double> >::const_iterator it_prob = prob_map.begin(); it_prob != prob_map.end(); ++it_prob) {
-          cum_probs[j]     = (*it_prob).second;
-          values[j]        = (*it_prob).first;
-          num_generated[j] = 0;
-          total_prob      += (*it_prob).second;
-          ++j;
-        }
-
         RooRealVar* disc_realvar = dynamic_cast<RooRealVar*>(disc_var);
         RooCategory* disc_catvar = dynamic_cast<RooCategory*>(disc_var);
         
@@ -976,7 +1601,8 @@ namespace toy {
           throw;
         }
         
-        disc_vars.push_back(boost::tuple<RooAbsArg*,double*,double*,int*,int>(disc_var,cum_probs,values,num_generated,num_values));
+        DiscreteSampler sampler((*it).probabilities());
+        disc_vars.push_back(DiscreteColumn{disc_var, disc_realvar, disc_catvar, sampler, std::vector<int>(sampler.num_values(), 0), std::vector<int>()});
         disc_argset.add(*disc_var);
         if (disc_catvar) disc_cat_argset.add(*disc_catvar);
         //}
@@ -985,63 +1611,59 @@ namespace toy {
     
     // prepare dataset
     RooDataSet* data_discrete = new RooDataSet("data_discrete", "data_discrete", disc_argset);
-    double r;
-    int j;
+    RooVectorDataStore* store = dynamic_cast<RooVectorDataStore*>(data_discrete->store());
+    if (store != NULL) {
+      store->reserve(yield);
+    }
     
     sinfo << "Generating discrete dataset for ";
-    for (std::vector<boost::tuple<RooAbsArg*,double*,double*,int*,int> >::const_iterator it = disc_vars.begin(); it != disc_vars.end(); ++it) {
+    for (std::vector<DiscreteColumn>::const_iterator it = disc_vars.begin(); it != disc_vars.end(); ++it) {
       if (it != disc_vars.begin()) sinfo << ", ";
-      sinfo << (*it).get<0>()->GetName();
+      sinfo << (*it).var->GetName();
     }
     sinfo << endmsg;
     
-    // the actual loop generating the dataset
-    for (int i=0; i<yield; ++i) {
-
-      bool add_to_argset = false;
-
-      // loop over variables (thanks to previous preparations, the only call 
-      // consuming relevant CPU time is the call to RooDataSet::addFast(...))
-      for (std::vector<boost::tuple<RooAbsArg*,double*,double*,int*,int> >::const_iterator it = disc_vars.begin(); it != disc_vars.end(); ++it) {   
-        // get all stuff from the tuple
-        RooAbsArg* disc_var   = (*it).get<0>();
-        double* cum_probs     = (*it).get<1>();
-        double* values        = (*it).get<2>();
-        int*    num_generated = (*it).get<3>();
-        int     num_values    = (*it).get<4>();
-        RooRealVar* disc_realvar = dynamic_cast<RooRealVar*>(disc_var);
-        RooCategory* disc_catvar = dynamic_cast<RooCategory*>(disc_var);
-        
-        r = RooRandom::uniform();
-        // stupid walkthrough through cumulative probabilities.
-        // it's definitely not the smartest way, but again it does not matter.
-        // a smart binary search does not gain anything even in perfect test 
-        // cases.
-        for (j=0; j<num_values; ++j) {  
-          if (r < cum_probs[j]) {
-            if (disc_realvar) disc_realvar->setVal(values[j]);
-            if (disc_catvar) disc_catvar->setIndex(values[j]);
-            num_generated[j]++;
+    // the actual loop generating the dataset in blocks: first, value indices 
+    // for a block of events are drawn (random numbers are used in the same 
+    // order as always: per event, per variable), then the block is added to 
+    // the dataset
+    const int block_size = 4096;
+    for (auto& column : disc_vars) {
+      column.indices.resize(std::min(block_size, std::max(yield, 0)));
+    }
+    for (int block_begin=0; block_begin<yield; block_begin+=block_size) {
+      int num_block = std::min(block_size, yield-block_begin);
+      
+      for (int i=0; i<num_block; ++i) {
+        for (auto& column : disc_vars) {
+          column.indices[i] = column.sampler.Sample(RooRandom::uniform());
+        }
+      }
+      
+      for (int i=0; i<num_block; ++i) {
+        bool add_to_argset = false;
+        for (auto& column : disc_vars) {
+          int j = column.indices[i];
+          // if no value is drawn, the variable keeps its previous value
+          if (j >= 0) {
+            if (column.realvar) column.realvar->setVal(column.sampler.value(j));
+            if (column.catvar) column.catvar->setIndex(static_cast<int>(column.sampler.value(j)));
+            column.num_generated[j]++;
             add_to_argset = true;
-            break;
           }
         }
+        if (add_to_argset) data_discrete->addFast(disc_argset);
       }
-      if (add_to_argset) data_discrete->addFast(disc_argset);
     }
     
-    // table print and cleanup
-    for (std::vector<boost::tuple<RooAbsArg*,double*,double*,int*,int> >::const_iterator it = disc_vars.begin(); it != disc_vars.end(); ++it) {       
-      sinfo << "Generation table for " << (*it).get<0>()->GetName() << ": ";
-      for (int i=0; i<(*it).get<4>(); ++i) {
+    // table print
+    for (std::vector<DiscreteColumn>::const_iterator it = disc_vars.begin(); it != disc_vars.end(); ++it) {       
+      sinfo << "Generation table for " << (*it).var->GetName() << ": ";
+      for (int i=0; i<(*it).sampler.num_values(); ++i) {
         if (i > 0) sinfo << ", ";
-        sinfo << "N(" << (*it).get<2>()[i] << ") = " << (*it).get<3>()[i];
+        sinfo << "N(" << (*it).sampler.value(i) << ") = " << (*it).num_generated[i];
       }
       sinfo << endmsg;
-      
-      delete[] (*it).get<1>();
-      delete[] (*it).get<2>();
-      delete[] (*it).get<3>();
     }
     
     return data_discrete;
@@ -1061,6 +1683,9 @@ namespace toy {
     cfg_tfac_proto.set_expected_yield(yield);
     cfg_tfac_proto.set_dataset_size_fixed(true);
     cfg_tfac_proto.set_random_seed(-1);
+    // proto data is generated within the random stream of the requesting PDF
+    cfg_tfac_proto.set_random_streams(false);
+    cfg_tfac_proto.set_num_cpu_generation(1);
 
     ToyFactoryStd tfac_proto(config_common_, cfg_tfac_proto);
     
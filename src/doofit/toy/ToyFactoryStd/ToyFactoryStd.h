@@ -3,7 +3,13 @@
 
 // STL
 #include <cstring>
-#include <csetjmp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <map>
+#include <memory>
+#include <algorithm>
 
 // ROOT
 #include "TClass.h"
@@ -18,8 +24,11 @@
 // forward declarations
 class RooDataSet;
 class RooArgSet;
+class RooAbsGenContext;
+class TRandom;
 class TFile;
 namespace doofit { namespace builder { class EasyPdf; }}
+namespace doofit { namespace toy { class ColumnarDataset; class BinnedSampler; class BinnedHistogram; class ConstraintSampler; }}
 namespace doofit {
 namespace config {
   class CommonConfig; 
@@ -66,6 +75,44 @@ namespace toy {
    *  @see Toy::ToyFactoryStdConfig::set_proto_sections(const std::vector<config::CommaSeparatedPair>&)
    *  @see Toy::ToyFactoryStdConfig::AddProtoSections(const config::CommaSeparatedPair&)
    *
+   *  @section binned-generation Binned generation
+   *
+   *  Components with very high yields can be generated binned (see 
+   *  Toy::ToyFactoryStdConfig::set_binned_pdfs(const std::vector<std::string>&)). 
+   *  The selected (sub) PDF is not decomposed any further, but bin 
+   *  probabilities in the binnings of its observables are computed once per 
+   *  set of parameter values and the number of events per bin is drawn 
+   *  directly (see Toy::BinnedSampler). The result is a weighted dataset with 
+   *  one entry per bin. Binned components can be components of added and 
+   *  simultaneous PDFs (unbinned components then get unit weights) or the 
+   *  whole generation PDF, but not PDFs with proto datasets. Binned factors of
+   *  product PDFs are expanded into events at the bin centres before their 
+   *  columns are merged (see ColumnarDataset::Unbin()), i.e. the product is 
+   *  unbinned.
+   *
+   *  Continuous observables are binned in their own binnings or in a number 
+   *  of uniform bins set via 
+   *  Toy::ToyFactoryStdConfig::set_observable_bins(const std::vector<config::CommaSeparatedPair<std::string>>&).
+   *
+   *  @section asimov Asimov datasets
+   *
+   *  ToyFactoryStd::GenerateAsimov() creates the expectation of the 
+   *  generation PDF instead of a random sample: a weighted dataset with one 
+   *  entry per bin (in the same binnings as for binned generation) and the 
+   *  expected number of events in this bin as weight. The PDF is decomposed 
+   *  like for generation (extended, added, product and simultaneous PDFs), 
+   *  but yields are neither Poisson distributed nor rounded. Discrete 
+   *  probability distributions are applied as factors to the expectation. 
+   *  Constrained parameters are not drawn, i.e. the nominal parameter values 
+   *  are used.
+   *
+   *  @section crashes Crashing generation
+   *
+   *  If RooFit aborts during generation, the process aborts. Use 
+   *  Toy::ToyWorkerPool (or Toy::ToyCampaign) to generate toys in forked 
+   *  worker processes where a crashing toy is recorded as failed and the 
+   *  remaining toys are still generated.
+   *
    *  @todo Proto sets need to be split for sub PDFs.
    *  @todo Test proto generation without externally set yield.
    *
@@ -109,7 +156,91 @@ namespace toy {
      */
     RooDataSet* Generate();
 
+    /**
+     *  @brief Generate a batch of toy samples
+     *
+     *  Equivalent to calling Generate() @a num_toys times, but the parameter 
+     *  file is read only once and generator contexts of leaf PDFs (including 
+     *  normalisation and accept/reject maximum search) are prepared once and 
+     *  reused for all toys of this batch. A context is only prepared again 
+     *  if a parameter of its PDF changed (e.g. after drawing constrained 
+     *  parameters). Leaf PDFs generated with proto data are not cached.
+     *
+     *  @param num_toys number of toy samples to generate
+     *  @return vector of generated samples. The invoker takes ownership (see 
+     *          Generate()).
+     */
+    std::vector<RooDataSet*> GenerateBatch(unsigned int num_toys);
+
+    /**
+     *  @brief Generate an Asimov dataset
+     *
+     *  Instead of a random sample, the expected number of events in each bin 
+     *  of the generation observables is computed for the nominal parameter 
+     *  values (see @ref asimov). The parameter file is read before, 
+     *  constrained parameters are not drawn. If configured, the dataset is 
+     *  written to a file like for Generate().
+     *
+     *  @return weighted dataset with one entry per bin with positive 
+     *          expectation (weight variable ColumnarDataset::weight_name()). 
+     *          The invoker takes ownership.
+     */
+    RooDataSet* GenerateAsimov();
+
     const RooArgSet& set_constrained_parameters() const { return set_constrained_parameters_; }
+
+    /**
+     *  @brief Index of the next toy to generate by this toy factory
+     *
+     *  Used to derive independent random streams per toy (see 
+     *  ToyFactoryStdConfig::set_random_streams(bool)).
+     *
+     *  @return number of toys generated so far
+     */
+    unsigned long long toy_index() const { return toy_index_; }
+
+    /**
+     *  @brief Prepare generation of a specific toy
+     *
+     *  Sets the index of the next toy to generate. With random streams (see 
+     *  ToyFactoryStdConfig::set_random_streams(bool)) the toy is then fully 
+     *  determined by this index. Otherwise, RooRandom::randomGenerator() is 
+     *  seeded based on @a seed and the index, so that toys generated in 
+     *  different processes are independent and reproducible.
+     *
+     *  @param toy_index index of the next toy
+     *  @param seed base seed used without random streams
+     */
+    void PrepareToy(unsigned long long toy_index, std::uint64_t seed);
+
+    /**
+     *  @brief Seed identifying a specific toy
+     *
+     *  Derived from the toy index and either @a seed or (with random streams)
+     *  the stream seed of this factory, consistent with PrepareToy(). Stored 
+     *  with the fit results, it identifies each toy uniquely.
+     *
+     *  @param toy_index index of the toy
+     *  @param seed base seed used without random streams
+     *  @return seed of the toy
+     */
+    std::uint64_t ToySeed(unsigned long long toy_index, std::uint64_t seed) const;
+
+    /**
+     *  @brief Draw random positions to mix slave entries into a master dataset
+     *
+     *  Selection sampling (Knuth's Algorithm S): each position i is selected 
+     *  with probability (slaves left)/(positions left), which places all 
+     *  @a num_slave entries uniformly at random over the @a num_master 
+     *  positions (each subset of positions is equally likely) in O(n) time 
+     *  without rejection. Used by MixMergeDatasets().
+     *
+     *  @param num_master number of positions (i.e. master entries)
+     *  @param num_slave number of positions to select (at most num_master)
+     *  @param random random generator to use
+     *  @return flags for all positions (true if position is taken by a slave)
+     */
+    static std::vector<bool> DrawMixPositions(int num_master, int num_slave, TRandom& random);
     
   protected:
     
@@ -181,6 +312,17 @@ namespace toy {
         return false;
       }
     }
+    
+    /**
+     *  @brief Checks if a RooAbsPdf is to be generated binned
+     *
+     *  @param pdf pdf to check for binned generation
+     *  @return whether pdf is in the binned PDFs of the config
+     */
+    bool PdfIsBinned(const RooAbsPdf& pdf) const {
+      const std::vector<std::string>& binned_pdfs = config_toyfactory_.binned_pdfs();
+      return std::find(binned_pdfs.begin(), binned_pdfs.end(), pdf.GetName()) != binned_pdfs.end();
+    }
     ///@}
     
     /** @name Parameter value functions
@@ -199,7 +341,10 @@ namespace toy {
      *  @brief Draw constrained parameters from constraining PDFs
      *
      *  Parameters described via constraining PDFs will be drawn accordingly to
-     *  assure that a constrained fit situation is handled correctly.
+     *  assure that a constrained fit situation is handled correctly. 
+     *  Gaussian and multivariate Gaussian constraints are drawn directly via 
+     *  a cached ConstraintSampler, all other constraining PDFs via RooFit's 
+     *  generators.
      */
     void DrawConstrainedParameters();
     ///@}
@@ -238,7 +383,8 @@ namespace toy {
      *  size compared to the master dataset.
      *
      *  In case the slave is smaller only a fraction of its events is mixed into
-     *  the master set.
+     *  the master set. All slave entries are placed at uniformly random 
+     *  positions (see DrawMixPositions()) in linear time.
      *
      *  @warning Both individual datasets will not be changed or deleted!
      *
@@ -285,6 +431,68 @@ namespace toy {
      *  @return a new dataset merged from all elements of the vector 
      */
     RooDataSet* MergeDatasetVector(const std::vector<RooDataSet*>& datasets) const;
+
+    /**
+     *  @brief Sanity check for MergeDatasets()
+     *
+     *  Throws a DatasetsNotDisjointException if datasets of the given columns
+     *  and sizes cannot be merged.
+     *
+     *  @param master_argset columns of the first dataset
+     *  @param master_entries number of entries of the first dataset
+     *  @param slave_argset columns of the second dataset
+     *  @param slave_entries number of entries of the second dataset
+     *  @param ignore_sets datasets with columns to ignore in overlap check
+     */
+    void CheckDatasetsMergeable(const RooArgSet& master_argset, int master_entries, const RooArgSet& slave_argset, int slave_entries, const std::vector<RooDataSet*>* ignore_sets) const;
+
+    /**
+     *  @brief Sanity check for AppendDatasets()
+     *
+     *  Throws a DatasetsNotAppendableException if datasets of the given 
+     *  columns cannot be appended.
+     *
+     *  @param master_argset columns of the first dataset
+     *  @param slave_argset columns of the second dataset
+     */
+    void CheckDatasetsAppendable(const RooArgSet& master_argset, const RooArgSet& slave_argset) const;
+
+    /**
+     *  @brief Append a component dataset to a toy sample under assembly
+     *
+     *  Equivalent to successive calls of AppendDatasets() (including the 
+     *  random numbers used for shuffling), but entries are only copied into 
+     *  the column buffers of @a assembly. A single component is passed 
+     *  through without any copy. Use FinishAssembly() to get the result.
+     *
+     *  @param data dataset assembled so far (NULL at start, owned)
+     *  @param assembly column buffers (created on second component)
+     *  @param data_new dataset to append (will be deleted)
+     */
+    void AppendToAssembly(RooDataSet*& data, std::unique_ptr<ColumnarDataset>& assembly, RooDataSet* data_new) const;
+
+    /**
+     *  @brief Merge a component dataset into a toy sample under assembly
+     *
+     *  Equivalent to successive calls of MergeDatasets(), but columns are 
+     *  only collected in @a assembly. Use FinishAssembly() to get the result.
+     *
+     *  @param data dataset assembled so far (NULL at start, owned)
+     *  @param assembly column buffers (created on second component)
+     *  @param data_new dataset to merge
+     *  @param ignore_sets datasets with columns to ignore in overlap check
+     *  @param delete_new whether data_new is to be deleted (default: yes)
+     */
+    void MergeIntoAssembly(RooDataSet*& data, std::unique_ptr<ColumnarDataset>& assembly, RooDataSet* data_new, const std::vector<RooDataSet*>* ignore_sets=NULL, bool delete_new=true) const;
+
+    /**
+     *  @brief Materialise a toy sample under assembly
+     *
+     *  @param data dataset assembled so far
+     *  @param assembly column buffers (will be reset)
+     *  @return the assembled dataset
+     */
+    RooDataSet* FinishAssembly(RooDataSet* data, std::unique_ptr<ColumnarDataset>& assembly) const;
     ///@}
     
     /** @name Proto dataset functions
@@ -433,14 +641,226 @@ namespace toy {
     RooDataSet* GenerateProtoSample(const RooAbsPdf& pdf, const config::CommaSeparatedPair<std::string>& proto_section, const RooArgSet& argset_generation_observables, doofit::builder::EasyPdf* easypdf, RooWorkspace* workspace, int yield) const;
     ///@}
     
-    /** @name Helper functions
-     *  Functions to do other helper tasks
+    /** @name Generator session functions
+     *  Functions to reuse generator contexts within GenerateBatch()
+     */
+    ///@{
+    /**
+     *  @brief Cached generator context of a leaf PDF
+     */
+    struct GenerationContext {
+      /**
+       *  @brief The generator context
+       */
+      RooAbsGenContext* context;
+
+      /**
+       *  @brief Names of observables the context generates
+       */
+      std::string observables;
+
+      /**
+       *  @brief Parameters of the PDF
+       */
+      RooArgSet* parameters;
+
+      /**
+       *  @brief Parameter values the context was prepared for
+       */
+      std::vector<double> values;
+    };
+
+    /**
+     *  @brief Generate a toy sample (without reading the parameter file)
+     *
+     *  @return the generated sample (see Generate())
+     */
+    RooDataSet* GenerateToy();
+
+    /**
+     *  @brief Generate for a leaf PDF with a cached generator context
+     *
+     *  @param pdf PDF to generate sample for
+     *  @param argset_observables observables to generate
+     *  @param yield number of events to generate
+     *  @param extended draw number of events from a Poisson distribution
+     *  @return the generated sample
+     */
+    RooDataSet* GenerateWithCachedContext(RooAbsPdf& pdf, const RooArgSet& argset_observables, int yield, bool extended) const;
+
+    /**
+     *  @brief Get current values of a set of parameters
+     *
+     *  @param parameters the parameters
+     *  @return the values (indices for categories)
+     */
+    static std::vector<double> ParameterValues(const RooArgSet& parameters);
+
+    /**
+     *  @brief Get names of a set of observables (to identify cached contexts)
+     *
+     *  @param observables the observables
+     *  @return comma separated names
+     */
+    static std::string ObservableNames(const RooArgSet& observables);
+
+    /**
+     *  @brief Delete all cached generator contexts
+     */
+    void ClearGenerationContexts();
+    ///@}
+
+    /** @name Binned generation functions
+     *  Functions for binned generation of high-yield components
      */
     ///@{
     /**
-     *  @brief Signal handler for RooFit raising SIGABRT
-     */    
-    static void SignalHandler(int signum);
+     *  @brief Cached bin probabilities of a binned PDF
+     */
+    struct BinnedGeneration {
+      /**
+       *  @brief The sampler holding bin probabilities
+       */
+      BinnedSampler* sampler;
+
+      /**
+       *  @brief Names of observables the sampler generates
+       */
+      std::string observables;
+
+      /**
+       *  @brief Parameters of the PDF
+       */
+      RooArgSet* parameters;
+
+      /**
+       *  @brief Parameter values the bin probabilities were computed for
+       */
+      std::vector<double> values;
+    };
+
+    /**
+     *  @brief Generate a PDF binned into a weighted dataset
+     *
+     *  Bin probabilities are only computed again if parameter values changed.
+     *
+     *  @param pdf PDF to generate sample for
+     *  @param argset_generation_observables observables to generate
+     *  @param expected_yield (expected) number of events (0 for the PDF's own expectation)
+     *  @param extended draw bin contents from Poisson distributions
+     *  @return the generated weighted sample
+     */
+    RooDataSet* GenerateBinned(RooAbsPdf& pdf, const RooArgSet& argset_generation_observables, double expected_yield, bool extended) const;
+
+    /**
+     *  @brief Delete all cached bin probabilities
+     */
+    void ClearBinnedGenerations();
+
+    /**
+     *  @brief Numbers of bins of observables from the config
+     *
+     *  @return number of bins by observable name
+     */
+    std::map<std::string, int> ObservableBins() const;
+
+    /**
+     *  @brief Values of variables with discrete probability distributions
+     *
+     *  @return values (resp. category indices) by variable name
+     */
+    std::map<std::string, std::vector<double>> DiscreteValues() const;
+    ///@}
+
+    /** @name Asimov dataset functions
+     *  Functions to compute expected numbers of events per bin
+     */
+    ///@{
+    /**
+     *  @brief Add the expectation of a PDF to a histogram
+     *
+     *  The PDF is decomposed recursively like in GenerateForPdf(...). Leaf 
+     *  PDFs (and PDFs to generate binned) are integrated over the bins in 
+     *  their observables and spread uniformly over other dimensions of 
+     *  @a histogram.
+     *
+     *  @param pdf PDF to compute the expectation for
+     *  @param expected_yield expected number of events (0 for the PDF's own expectation)
+     *  @param histogram histogram in the generation observables to add to
+     */
+    void AsimovForPdf(RooAbsPdf& pdf, double expected_yield, BinnedHistogram& histogram) const;
+
+    /**
+     *  @brief Apply discrete probability distributions to an expectation
+     *
+     *  The expectation is summed over the discretely distributed variables 
+     *  and multiplied with their probabilities.
+     *
+     *  @param discrete_probabilities the distributions
+     *  @param histogram the expectation in the generation observables
+     */
+    void AsimovDiscreteProbabilities(const std::vector<config::DiscreteProbabilityDistribution>& discrete_probabilities, BinnedHistogram& histogram) const;
+    ///@}
+
+    /** @name Random stream and parallel generation functions
+     *  Functions for reproducible generation of independent components
+     */
+    ///@{
+    /**
+     *  @brief Task generating one independent component
+     */
+    typedef std::function<RooDataSet*()> GenerationTask;
+
+    /**
+     *  @brief Seed the random generator for a generation step
+     *
+     *  If random streams are enabled, RooRandom::randomGenerator() is seeded 
+     *  based on random seed, toy index and the current position in the PDF 
+     *  decomposition plus the given step name. Otherwise nothing happens.
+     *
+     *  @param step name of the generation step in the current component
+     */
+    void SeedRandomStream(const std::string& step) const;
+
+    /**
+     *  @brief Derive a seed for a random stream
+     *
+     *  Counter-based derivation via SplitMix64 hashing, i.e. the seed only 
+     *  depends on the arguments and not on any generation before.
+     *
+     *  @param seed base seed
+     *  @param toy_index index of the toy
+     *  @param component identifier of the component and generation step
+     *  @return seed for this stream
+     */
+    static std::uint64_t StreamSeed(std::uint64_t seed, std::uint64_t toy_index, const std::string& component);
+
+    /**
+     *  @brief Seed RooRandom::randomGenerator() with a full 64 bit seed
+     *
+     *  TRandom3 only takes 32 bit seeds, so derived seeds of different toys 
+     *  or streams could collide. Therefore, a TRandomMixMax (seeded with all 
+     *  64 bits) is installed as RooRandom::randomGenerator() on first use. 
+     *  With ROOT versions before 6.08 (no TRandomMixMax), the seed is folded 
+     *  to 32 bit for TRandom3.
+     *
+     *  @param seed the seed
+     */
+    static void SeedRandomGenerator(std::uint64_t seed);
+
+    /**
+     *  @brief Run independent generation tasks
+     *
+     *  If configured, tasks are distributed over forked worker processes which
+     *  send back the generated datasets via pipes (see 
+     *  doofit::tools::workers::RunInWorkers()). Any dataset not delivered by
+     *  a worker is generated serially afterwards. As each task seeds its own 
+     *  random stream, the result does not depend on the number of workers.
+     *
+     *  @param tasks the tasks to run
+     *  @return generated datasets in the order of the tasks
+     */
+    std::vector<RooDataSet*> RunGenerationTasks(const std::vector<GenerationTask>& tasks) const;
     ///@}
 
     /**
@@ -457,8 +877,45 @@ namespace toy {
      */
     RooArgSet set_constrained_parameters_;
 
-    static bool signal_caught_;
-    static jmp_buf jump_buffer_;
+    /**
+     *  @brief Sampler for Gaussian constraints (created on first use)
+     */
+    std::unique_ptr<ConstraintSampler> constraint_sampler_;
+
+    /**
+     *  @brief Base seed for random streams
+     */
+    std::uint64_t stream_seed_;
+
+    /**
+     *  @brief Number of toys generated so far
+     */
+    unsigned long long toy_index_;
+
+    /**
+     *  @brief Current position in PDF decomposition (for random streams)
+     */
+    mutable std::vector<std::string> stream_path_;
+
+    /**
+     *  @brief Whether this process is a generation worker (no nested workers)
+     */
+    mutable bool generation_worker_;
+
+    /**
+     *  @brief Whether generator contexts are cached (i.e. inside GenerateBatch())
+     */
+    bool generation_session_;
+
+    /**
+     *  @brief Cached generator contexts by leaf PDF
+     */
+    mutable std::map<const RooAbsPdf*, GenerationContext> generation_contexts_;
+
+    /**
+     *  @brief Cached bin probabilities by binned PDF
+     */
+    mutable std::map<const RooAbsPdf*, BinnedGeneration> binned_generations_;
   };
   
   /** \struct NotGeneratingDataException
@@ -468,13 +925,6 @@ namespace toy {
     virtual const char* what() const throw() { return "Not generating any data"; }
   };
 
-  /** \struct NotGeneratingDataException
-   *  \brief Exception for not generating any data
-   */
-  struct RooFitSendingSIGABRTException: public virtual boost::exception, public virtual std::exception { 
-    virtual const char* what() const throw() { return "RooFit sent SIGABRT"; }
-  };
-  
   /** \struct NotGeneratingDiscreteData
    *  \brief Exception for not generating discrete data
    */
@@ -495,6 +945,13 @@ namespace toy {
   struct DatasetsNotAppendableException: public virtual boost::exception, public virtual std::exception { 
     virtual const char* what() const throw() { return "Trying to merge non-appendable datasets"; }
   };
+  
+  /** \struct WeightedDatasetsNotMergeableException
+   *  \brief Exception for trying to merge columns of weighted (binned) datasets
+   */
+  struct WeightedDatasetsNotMergeableException: public virtual boost::exception, public virtual std::exception { 
+    virtual const char* what() const throw() { return "Trying to merge weighted datasets"; }
+  };
 } // namespace toy
 } // namespace doofit
 
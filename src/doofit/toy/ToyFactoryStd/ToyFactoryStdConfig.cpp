@@ -44,6 +44,8 @@ namespace toy {
   argset_generation_observables_workspace_(""),
   random_seed_(0),
   argset_constraining_pdfs_(NULL),
+  random_streams_(false),
+  num_cpu_generation_(1),
   ws_file_(NULL)
   {
     swarn << "Usage of ToyFactoryStdConfig::ToyFactoryStdConfig() is not recommended!" <<endmsg;
@@ -60,6 +62,8 @@ namespace toy {
   argset_generation_observables_workspace_(""),
   random_seed_(0),
   argset_constraining_pdfs_(NULL),
+  random_streams_(false),
+  num_cpu_generation_(1),
   ws_file_(NULL)
   {
   }
@@ -215,6 +219,8 @@ namespace toy {
     }
     
     scfg << "Fixed size dataset:        " << dataset_size_fixed_ << endmsg;
+    scfg << "Random streams:            " << random_streams() << endmsg;
+    scfg << "Worker processes:          " << num_cpu_generation_ << endmsg;
     
     for (vector<config::DiscreteProbabilityDistribution>::const_iterator it = discrete_probabilities_.begin(); it != discrete_probabilities_.end(); ++it) {
       scfg << "Discrete probability:      " << *it << endmsg;
@@ -222,6 +228,12 @@ namespace toy {
     for (vector<config::CommaSeparatedPair<std::string>>::const_iterator it = proto_sections_.begin(); it != proto_sections_.end(); ++it) {
       scfg << "Proto dataset section:     " << *it << endmsg;
     }
+    for (vector<string>::const_iterator it = binned_pdfs_.begin(); it != binned_pdfs_.end(); ++it) {
+      scfg << "Binned generation PDF:     " << *it << endmsg;
+    }
+    for (vector<config::CommaSeparatedPair<std::string>>::const_iterator it = observable_bins_.begin(); it != observable_bins_.end(); ++it) {
+      scfg << "Observable bins:           " << *it << endmsg;
+    }
     
     scfg << "Constraining PDFs:         ";
     if (argset_constraining_pdfs()) {
@@ -295,7 +307,11 @@ namespace toy {
      "Name of constraining PDFs argset to use on linked workspace")
     (GetOptionString("discrete_probabilities").c_str(), po::value<vector<config::DiscreteProbabilityDistribution> >(&discrete_probabilities_)->composing(), "Discrete probability distribution for variables (can be multiply defined). The string representation is var_name,value1,prob1,value2,prob2,...,valueN,probN")
     (GetOptionString("proto_section").c_str(), po::value<vector<config::CommaSeparatedPair<std::string>> >(&proto_sections_)->composing(), "Proto dataset generation section. Specify sub PDF name and config section to use for proto data for this PDF. String representation is pdf_name,section")
+    (GetOptionString("binned_pdf").c_str(), po::value<vector<string> >(&binned_pdfs_)->composing(), "Name of a (sub) PDF to generate binned into a weighted dataset (in the binning of its observables) instead of event by event (can be multiply defined)")
+    (GetOptionString("observable_bins").c_str(), po::value<vector<config::CommaSeparatedPair<std::string>> >(&observable_bins_)->composing(), "Number of uniform bins of a continuous observable for binned generation and Asimov datasets (instead of its own binning, can be multiply defined). String representation is var_name,num_bins")
     (GetOptionString("dataset_size_fixed").c_str(), po::value<bool>(&dataset_size_fixed_)->default_value(false),"Set to true to generate a fixed size dataset (instead of poisson distributed size which is default)")
+    (GetOptionString("random_streams").c_str(), po::value<bool>(&random_streams_)->default_value(false),"Set to true to seed the random generator separately for each toy and PDF component (generated samples will not depend on num_cpu_generation)")
+    (GetOptionString("num_cpu_generation").c_str(), po::value<int>(&num_cpu_generation_)->default_value(1),"Number of worker processes to generate independent components of added and simultaneous PDFs in parallel (implies random_streams)")
     (GetOptionString("workspace_filename_name").c_str(), po::value<config::CommaSeparatedPair<std::string>>(&workspace_filename_name_),"Filename to load workspace from (if not set directly) and name of workspace in file (set as filename,workspace_name)")
     (GetOptionString("dataset_filename_name").c_str(), po::value<config::CommaSeparatedPair<std::string>>(&dataset_filename_name_),"Filename to save generated dataset to and name of dataset in file (set as filename,dataset_name)")
     (GetOptionString("parameter_read_file").c_str(), po::value<string>(&parameter_read_file_),"Filename to read parameters from before generation")
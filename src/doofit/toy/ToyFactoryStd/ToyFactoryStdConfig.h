@@ -120,6 +120,23 @@ namespace toy {
      *  @see ToyFactoryStdConfig::AddProtoSections(const config::CommaSeparatedPair&)
      */
     const std::vector<config::CommaSeparatedPair<std::string>>& proto_sections() const {return proto_sections_;}
+    /**
+     *  @brief Getter for names of PDFs to generate binned
+     *
+     *  @see @ref binned-generation
+     *  @see ToyFactoryStdConfig::set_binned_pdfs(const std::vector<std::string>&)
+     *  @see ToyFactoryStdConfig::AddBinnedPdf(const std::string&)
+     */
+    const std::vector<std::string>& binned_pdfs() const {return binned_pdfs_;}
+    /**
+     *  @brief Getter for numbers of bins of observables
+     *
+     *  @see @ref binned-generation
+     *  @see @ref asimov
+     *  @see ToyFactoryStdConfig::set_observable_bins(const std::vector<config::CommaSeparatedPair<std::string>>&)
+     *  @see ToyFactoryStdConfig::AddObservableBins(const config::CommaSeparatedPair<std::string>&)
+     */
+    const std::vector<config::CommaSeparatedPair<std::string>>& observable_bins() const {return observable_bins_;}
     /**
      *  \brief Getter for RooArgSet* with all constraining PDFs to draw from
      */
@@ -131,6 +148,20 @@ namespace toy {
      *  @return current value of dataset_size_fixed_
      */
     bool dataset_size_fixed() const {return dataset_size_fixed_;}
+    /**
+     *  @brief Getter for independent random streams per toy and component
+     *
+     *  @see ToyFactoryStdConfig::set_random_streams(bool)
+     *  @return current value of random_streams_
+     */
+    bool random_streams() const {return random_streams_ || num_cpu_generation_ > 1;}
+    /**
+     *  @brief Getter for number of worker processes for generation
+     *
+     *  @see ToyFactoryStdConfig::set_num_cpu_generation(int)
+     *  @return current value of num_cpu_generation_
+     */
+    int num_cpu_generation() const {return num_cpu_generation_;}
     /**
      *  @brief Getter for for file to load workspace from (and name of workspace in file)
      *
@@ -305,6 +336,37 @@ namespace toy {
      *  @param proto_sections vector of config::CommaSeparatedPair to use
      */
     void set_proto_sections(const std::vector<config::CommaSeparatedPair<std::string>>& proto_sections) {proto_sections_ = proto_sections;}
+    /**
+     *  @brief Setter for names of PDFs to generate binned
+     *
+     *  Directly set the names of (sub) PDFs to generate binned instead of 
+     *  event by event. Each of these PDFs is generated as a whole (i.e. not 
+     *  decomposed any further) into a weighted dataset with one entry per bin 
+     *  of its observables. This is meant for components with very high 
+     *  yields.
+     *
+     *  @see @ref binned-generation
+     *  @see ToyFactoryStdConfig::AddBinnedPdf(const std::string&)
+     *
+     *  @param binned_pdfs names of PDFs to generate binned
+     */
+    void set_binned_pdfs(const std::vector<std::string>& binned_pdfs) {binned_pdfs_ = binned_pdfs;}
+    /**
+     *  @brief Setter for numbers of bins of observables
+     *
+     *  Directly set the number of uniform bins to use for continuous 
+     *  observables in binned generation and Asimov datasets. Each pair 
+     *  consists of the observable name and the number of bins. Observables 
+     *  without an entry are binned in their own binning (i.e. 
+     *  RooRealVar::setBins(...)).
+     *
+     *  @see @ref binned-generation
+     *  @see @ref asimov
+     *  @see ToyFactoryStdConfig::AddObservableBins(const config::CommaSeparatedPair<std::string>&)
+     *
+     *  @param observable_bins pairs of observable name and number of bins
+     */
+    void set_observable_bins(const std::vector<config::CommaSeparatedPair<std::string>>& observable_bins) {observable_bins_ = observable_bins;}
     /**
      *  \brief Setter for RooArgSet* with all constraining PDFs to draw from
      */
@@ -322,6 +384,32 @@ namespace toy {
      *                            or not (false)
      */
     void set_dataset_size_fixed(bool dataset_size_fixed) {dataset_size_fixed_ = dataset_size_fixed;} 
+    /**
+     *  @brief Setter for independent random streams per toy and component
+     *
+     *  If set, the random generator is seeded separately for each generation 
+     *  step based on the random seed, the index of the toy generated by this 
+     *  toy factory and the component of the PDF decomposition (e.g. a sub PDF 
+     *  of a RooAddPdf or a category of a RooSimultaneous). Generated samples 
+     *  are then identical regardless of the number of worker processes (see 
+     *  set_num_cpu_generation(int)). However, they differ from samples 
+     *  generated without random streams for the same seed.
+     *
+     *  @param random_streams use independent random streams (true) or not
+     */
+    void set_random_streams(bool random_streams) {random_streams_ = random_streams;}
+    /**
+     *  @brief Setter for number of worker processes for generation
+     *
+     *  Independent components of RooAddPdfs and RooSimultaneous PDFs will be 
+     *  generated in parallel in the given number of forked worker processes.
+     *  As RooFit is not thread-safe, processes are used instead of threads. 
+     *  A value larger than 1 implies independent random streams (see 
+     *  set_random_streams(bool)).
+     *
+     *  @param num_cpu_generation number of worker processes
+     */
+    void set_num_cpu_generation(int num_cpu_generation) {num_cpu_generation_ = num_cpu_generation;}
     /**
      *  @brief Setter for file to load workspace from (and name of workspace in file)
      *
@@ -388,6 +476,24 @@ namespace toy {
      *  @param proto_section config::CommaSeparatedPair to add
      */
     void AddProtoSections(const config::CommaSeparatedPair<std::string>& proto_section) {proto_sections_.push_back(proto_section);}
+    /**
+     *  @brief Add a PDF to generate binned
+     *
+     *  @see @ref binned-generation
+     *  @see ToyFactoryStdConfig::set_binned_pdfs(const std::vector<std::string>&)
+     *
+     *  @param pdf_name name of the (sub) PDF to generate binned
+     */
+    void AddBinnedPdf(const std::string& pdf_name) {binned_pdfs_.push_back(pdf_name);}
+    /**
+     *  @brief Add a number of bins for an observable
+     *
+     *  @see @ref asimov
+     *  @see ToyFactoryStdConfig::set_observable_bins(const std::vector<config::CommaSeparatedPair<std::string>>&)
+     *
+     *  @param observable_bins pair of observable name and number of bins
+     */
+    void AddObservableBins(const config::CommaSeparatedPair<std::string>& observable_bins) {observable_bins_.push_back(observable_bins);}
     ///@}
     
   protected:
@@ -508,6 +614,18 @@ namespace toy {
      *  @see ToyFactoryStdConfig::AddProtoSections(const config::CommaSeparatedPair&)
      */
     std::vector<config::CommaSeparatedPair<std::string>> proto_sections_;
+    /**
+     *  @brief Names of PDFs to generate binned
+     *
+     *  @see ToyFactoryStdConfig::set_binned_pdfs(const std::vector<std::string>&)
+     */
+    std::vector<std::string> binned_pdfs_;
+    /**
+     *  @brief Numbers of bins of observables (observable name, number of bins)
+     *
+     *  @see ToyFactoryStdConfig::set_observable_bins(const std::vector<config::CommaSeparatedPair<std::string>>&)
+     */
+    std::vector<config::CommaSeparatedPair<std::string>> observable_bins_;
     /**
      *  @brief RooArgSet with all constraining PDFs to generate constrained parameters from
      *
@@ -524,6 +642,18 @@ namespace toy {
      *  a fixed and well defined size.
      */
     bool dataset_size_fixed_;
+    /**
+     *  @brief Option for independent random streams per toy and component
+     *
+     *  @see ToyFactoryStdConfig::set_random_streams(bool)
+     */
+    bool random_streams_;
+    /**
+     *  @brief Number of worker processes for generation of independent components
+     *
+     *  @see ToyFactoryStdConfig::set_num_cpu_generation(int)
+     */
+    int num_cpu_generation_;
     /**
      *  @brief File name to get workspace from (and name of workspace on file)
      */
@@ -0,0 +1,347 @@
+#include "doofit/toy/ToyFactoryStd/ToyWorkerPool.h"
+
+// STL
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <csignal>
+
+// POSIX/UNIX
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ROOT
+#include "TStopwatch.h"
+
+// from RooFit
+#include "RooDataSet.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "doofit/toy/ToyFactoryStd/ToyFactoryStd.h"
+#include "doofit/tools/workers/ForkedWorkers.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  ToyWorkerPool::ToyWorkerPool(ToyFactoryStd& factory, unsigned int num_workers, unsigned int block_size, unsigned int queue_depth) :
+  factory_(factory),
+  num_workers_(num_workers > 0 ? num_workers : 1),
+  block_size_(block_size > 0 ? block_size : 1),
+  queue_depth_(queue_depth > 0 ? queue_depth : 1),
+  seed_(0),
+  manager_pid_(-1),
+  manager_fd_(-1),
+  finished_(true),
+  stop_(false)
+  {}
+
+  ToyWorkerPool::~ToyWorkerPool() {
+    Stop();
+  }
+
+  bool ToyWorkerPool::Start(unsigned long long num_toys, std::uint64_t seed) {
+    Stop();
+    seed_ = seed;
+
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      swarn << "Cannot create pipe for toy worker pool." << endmsg;
+      return false;
+    }
+
+    // no other thread of the calling process may be in ROOT/RooFit now
+    pid_t pid = doofit::tools::workers::Fork();
+    if (pid < 0) {
+      swarn << "Cannot fork manager process for toy worker pool." << endmsg;
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      return false;
+    } else if (pid == 0) {
+      close(pipe_fds[0]);
+      // manager and workers form a process group to be stopped together
+      setpgid(0, 0);
+      Manage(pipe_fds[1], num_toys, seed);
+    }
+
+    setpgid(pid, pid);
+    close(pipe_fds[1]);
+    manager_pid_ = pid;
+    manager_fd_  = pipe_fds[0];
+    finished_    = false;
+    stop_        = false;
+    reader_      = boost::thread(&ToyWorkerPool::Read, this);
+    return true;
+  }
+
+  bool ToyWorkerPool::Next(unsigned long long& index, RooDataSet*& data, double& generation_time) {
+    Message message;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (buffer_.empty() && !finished_) {
+        cond_filled_.wait(lock);
+      }
+      if (buffer_.empty()) {
+        return false;
+      }
+      message = std::move(buffer_.front());
+      buffer_.pop_front();
+      cond_space_.notify_one();
+    }
+
+    index           = message.index;
+    data            = NULL;
+    generation_time = 0.0;
+
+    if (message.length < 0) {
+      FailedToy failed_toy;
+      failed_toy.index  = message.index;
+      failed_toy.seed   = factory_.ToySeed(message.index, seed_);
+      failed_toy.status = static_cast<int>(message.value);
+      failed_toys_.push_back(failed_toy);
+
+      serr << "Toy " << failed_toy.index << " (seed " << failed_toy.seed << ") failed: ";
+      if (failed_toy.status < 0) {
+        serr << "no worker process could be started." << endmsg;
+      } else if (WIFSIGNALED(failed_toy.status)) {
+        serr << "worker process was killed by signal " << WTERMSIG(failed_toy.status) << "." << endmsg;
+      } else {
+        serr << "worker process exited with code " << WEXITSTATUS(failed_toy.status) << "." << endmsg;
+      }
+    } else {
+      data = doofit::tools::workers::DeserialiseObject<RooDataSet>(message.bytes);
+      generation_time = message.value/1e6;
+    }
+    return true;
+  }
+
+  void ToyWorkerPool::Stop() {
+    if (manager_pid_ < 0) return;
+
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      stop_ = true;
+      cond_space_.notify_all();
+    }
+    // terminate manager and all workers, this also closes the pipe
+    kill(-manager_pid_, SIGKILL);
+    if (reader_.joinable()) reader_.join();
+    close(manager_fd_);
+    int status = 0;
+    waitpid(manager_pid_, &status, 0);
+
+    manager_pid_ = -1;
+    manager_fd_  = -1;
+    buffer_.clear();
+    finished_ = true;
+  }
+
+  unsigned int ToyWorkerPool::num_queued() {
+    boost::mutex::scoped_lock lock(mutex_);
+    return buffer_.size();
+  }
+
+  void ToyWorkerPool::Manage(int fd, unsigned long long num_toys, std::uint64_t seed) {
+    struct Worker {
+      pid_t pid;
+      int fd;
+      unsigned long long next;
+      unsigned long long end;
+    };
+    std::vector<Worker> workers;
+
+    std::deque<std::pair<unsigned long long, unsigned long long>> pending;
+    for (unsigned long long begin=0; begin<num_toys; begin+=block_size_) {
+      pending.push_back(std::make_pair(begin, std::min<unsigned long long>(begin+block_size_, num_toys)));
+    }
+
+    // toys received out of order wait here until all previous toys are sent
+    std::map<unsigned long long, Message> completed;
+    unsigned long long next_send = 0;
+    unsigned long long capacity  = static_cast<unsigned long long>(num_workers_)*queue_depth_;
+
+    while (next_send < num_toys) {
+      // keep workers busy, but do not run too far ahead of the consumer
+      while (workers.size() < num_workers_ && !pending.empty() && pending.front().first < next_send+capacity) {
+        std::pair<unsigned long long, unsigned long long> block = pending.front();
+        pending.pop_front();
+
+        int pipe_fds[2];
+        pid_t pid = -1;
+        if (pipe(pipe_fds) == 0) {
+          pid = doofit::tools::workers::Fork();
+          if (pid < 0) {
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+          }
+        }
+
+        if (pid == 0) {
+          close(fd);
+          close(pipe_fds[0]);
+          for (auto& worker : workers) {
+            close(worker.fd);
+          }
+          Work(pipe_fds[1], block.first, block.second, seed);
+        } else if (pid > 0) {
+          close(pipe_fds[1]);
+          Worker worker = {pid, pipe_fds[0], block.first, block.second};
+          workers.push_back(worker);
+        } else if (workers.empty()) {
+          // without any worker, the first toy of this block cannot be generated
+          Message failure;
+          failure.index  = block.first;
+          failure.value  = -1;
+          failure.length = -1;
+          completed[block.first] = failure;
+          if (block.first+1 < block.second) {
+            pending.push_front(std::make_pair(block.first+1, block.second));
+          }
+          break;
+        } else {
+          pending.push_front(block);
+          break;
+        }
+      }
+
+      if (!workers.empty()) {
+        std::vector<pollfd> poll_fds(workers.size());
+        for (unsigned int i=0; i<workers.size(); ++i) {
+          poll_fds[i].fd      = workers[i].fd;
+          poll_fds[i].events  = POLLIN;
+          poll_fds[i].revents = 0;
+        }
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+          continue;
+        }
+
+        std::vector<Worker> workers_active;
+        for (unsigned int i=0; i<workers.size(); ++i) {
+          Worker& worker = workers[i];
+          if (poll_fds[i].revents == 0) {
+            workers_active.push_back(worker);
+            continue;
+          }
+
+          Message message;
+          if (ReadMessage(worker.fd, message) && message.index >= 0 && static_cast<unsigned long long>(message.index) == worker.next) {
+            worker.next = message.index+1;
+            completed[message.index] = std::move(message);
+            workers_active.push_back(worker);
+          } else {
+            // worker finished or died
+            close(worker.fd);
+            int status = 0;
+            waitpid(worker.pid, &status, 0);
+            if (worker.next < worker.end) {
+              Message failure;
+              failure.index  = worker.next;
+              failure.value  = status;
+              failure.length = -1;
+              completed[worker.next] = failure;
+              if (worker.next+1 < worker.end) {
+                pending.push_front(std::make_pair(worker.next+1, worker.end));
+              }
+            }
+          }
+        }
+        workers.swap(workers_active);
+      }
+
+      // pass on toys in order
+      std::map<unsigned long long, Message>::iterator it;
+      while ((it = completed.find(next_send)) != completed.end()) {
+        const Message& message = it->second;
+        if (!WriteMessage(fd, message.index, message.value, message.length, message.bytes.data())) {
+          _exit(1);
+        }
+        completed.erase(it);
+        ++next_send;
+      }
+    }
+
+    close(fd);
+    _exit(0);
+  }
+
+  void ToyWorkerPool::Work(int fd, unsigned long long begin, unsigned long long end, std::uint64_t seed) {
+    for (unsigned long long i=begin; i<end; ++i) {
+      RooDataSet* data = NULL;
+      TStopwatch sw;
+      sw.Start(true);
+      try {
+        factory_.PrepareToy(i, seed);
+        data = factory_.Generate();
+      } catch (const std::exception& e) {
+        serr << "Generation of toy " << i << " failed: " << e.what() << endmsg;
+        _exit(1);
+      } catch (...) {
+        serr << "Generation of toy " << i << " failed." << endmsg;
+        _exit(1);
+      }
+      sw.Stop();
+      if (data == NULL) {
+        _exit(2);
+      }
+
+      std::vector<char> bytes = doofit::tools::workers::SerialiseObject(*data);
+      delete data;
+      if (!WriteMessage(fd, i, static_cast<std::int64_t>(sw.RealTime()*1e6), bytes.size(), bytes.data())) {
+        _exit(3);
+      }
+    }
+    close(fd);
+    // leave without any cleanup of the parent's state
+    _exit(0);
+  }
+
+  void ToyWorkerPool::Read() {
+    while (true) {
+      Message message;
+      bool success = ReadMessage(manager_fd_, message);
+
+      boost::mutex::scoped_lock lock(mutex_);
+      if (!success) break;
+      while (buffer_.size() >= static_cast<std::size_t>(num_workers_)*queue_depth_ && !stop_) {
+        cond_space_.wait(lock);
+      }
+      if (stop_) break;
+      buffer_.push_back(std::move(message));
+      cond_filled_.notify_one();
+    }
+    boost::mutex::scoped_lock lock(mutex_);
+    finished_ = true;
+    cond_filled_.notify_all();
+  }
+
+  bool ToyWorkerPool::WriteMessage(int fd, std::int64_t index, std::int64_t value, std::int64_t length, const char* bytes) {
+    using namespace doofit::tools::workers;
+    std::int64_t header[3] = {index, value, length};
+    return WriteAll(fd, reinterpret_cast<const char*>(header), sizeof(header)) &&
+           WriteAll(fd, bytes, static_cast<std::size_t>(std::max<std::int64_t>(length, 0)));
+  }
+
+  bool ToyWorkerPool::ReadMessage(int fd, Message& message) {
+    using namespace doofit::tools::workers;
+    std::int64_t header[3];
+    if (!ReadAll(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+      return false;
+    }
+    message.index  = header[0];
+    message.value  = header[1];
+    message.length = header[2];
+    if (message.length <= 0) {
+      message.bytes.clear();
+      return message.length < 0;
+    }
+    message.bytes.resize(message.length);
+    return ReadAll(fd, message.bytes.data(), message.bytes.size());
+  }
+} // namespace toy
+} // namespace doofit
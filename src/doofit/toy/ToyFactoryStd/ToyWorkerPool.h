@@ -0,0 +1,183 @@
+#ifndef TOYWORKERPOOL_h
+#define TOYWORKERPOOL_h
+
+// STL
+#include <cstdint>
+#include <vector>
+#include <deque>
+
+// BOOST
+#include <boost/thread.hpp>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class RooDataSet;
+
+namespace doofit {
+namespace toy {
+  class ToyFactoryStd;
+
+  /** @class ToyWorkerPool
+   *  @brief Pool of forked processes generating toys in isolation
+   *
+   *  Each block of toys is generated in its own child process. If RooFit
+   *  aborts, crashes or throws while generating a toy, only this child dies:
+   *  the toy is recorded as failed (with its index and seed, see
+   *  failed_toys()) and the remaining toys of the block are generated by a
+   *  new child.
+   *
+   *  On Start(), a manager process is forked from the calling process. The
+   *  manager does not do anything but forking workers and passing their
+   *  toys on. Therefore, all workers inherit the prepared state of the
+   *  calling process at the time of Start() (PDF, workspace, generator
+   *  settings) copy-on-write without any rebuild cost, even if the calling
+   *  process changes its state afterwards (e.g. by fitting). The manager
+   *  keeps @a num_workers workers busy and sends toys back in order of their
+   *  index via a pipe. A reader thread in the calling process buffers at
+   *  most @a queue_depth toys per worker. The manager is forked via
+   *  doofit::tools::workers::Fork(), i.e. while no background thread of the
+   *  calling process (e.g. the fit result saver of ToyStudyStd) is in ROOT.
+   *
+   *  Each toy is prepared via ToyFactoryStd::PrepareToy(), i.e. toys do not
+   *  depend on number of workers or block size and failed toys can be
+   *  reproduced with their index and seed.
+   */
+  class ToyWorkerPool {
+   public:
+    /**
+     *  @brief A toy that could not be generated
+     */
+    struct FailedToy {
+      /**
+       *  @brief Index of the toy
+       */
+      unsigned long long index;
+      /**
+       *  @brief Seed of the toy (see ToyFactoryStd::ToySeed())
+       */
+      std::uint64_t seed;
+      /**
+       *  @brief Wait status of the worker process (see waitpid(2))
+       */
+      int status;
+    };
+
+    /**
+     *  @brief Constructor for ToyWorkerPool
+     *
+     *  @param factory toy factory to generate toys with
+     *  @param num_workers number of worker processes running in parallel
+     *  @param block_size number of toys generated by one worker process
+     *  @param queue_depth number of toys per worker buffered ahead of the consumer
+     */
+    ToyWorkerPool(ToyFactoryStd& factory, unsigned int num_workers, unsigned int block_size=1, unsigned int queue_depth=2);
+
+    /**
+     *  @brief Destructor, stops all processes
+     */
+    ~ToyWorkerPool();
+
+    /**
+     *  @brief Start generation of toys 0 to @a num_toys-1
+     *
+     *  @param num_toys number of toys
+     *  @param seed seed passed to ToyFactoryStd::PrepareToy()
+     *  @return false if no manager process could be started
+     */
+    bool Start(unsigned long long num_toys, std::uint64_t seed);
+
+    /**
+     *  @brief Get the next toy (in order of index, blocking)
+     *
+     *  @param index index of the toy
+     *  @param data the toy (caller takes ownership) or NULL if the toy failed
+     *  @param generation_time wall time in seconds the worker needed for this toy
+     *  @return false if there are no more toys
+     */
+    bool Next(unsigned long long& index, RooDataSet*& data, double& generation_time);
+
+    /**
+     *  @brief Stop all processes (toys not consumed yet are dropped)
+     */
+    void Stop();
+
+    /**
+     *  @brief Number of toys buffered in the calling process
+     */
+    unsigned int num_queued();
+
+    /**
+     *  @brief Toys that failed so far
+     */
+    const std::vector<FailedToy>& failed_toys() const { return failed_toys_; }
+
+   private:
+    /**
+     *  @brief Toy (or failure of a toy) sent through a pipe
+     *
+     *  On the pipe, each message is a header of three 64 bit integers (index,
+     *  value, length) followed by length bytes of the serialised dataset. For
+     *  a failed toy, length is -1 and value is the wait status of the worker.
+     *  Otherwise value is the generation time in microseconds.
+     */
+    struct Message {
+      Message() : index(0), value(0), length(0) {}
+      std::int64_t index;
+      std::int64_t value;
+      std::int64_t length;
+      std::vector<char> bytes;
+    };
+
+    /**
+     *  @brief Main function of the manager process (does not return)
+     */
+    void Manage(int fd, unsigned long long num_toys, std::uint64_t seed);
+
+    /**
+     *  @brief Main function of a worker process (does not return)
+     */
+    void Work(int fd, unsigned long long begin, unsigned long long end, std::uint64_t seed);
+
+    /**
+     *  @brief Thread function moving messages from the manager into the buffer
+     */
+    void Read();
+
+    /**
+     *  @brief Write a message into a pipe
+     */
+    static bool WriteMessage(int fd, std::int64_t index, std::int64_t value, std::int64_t length, const char* bytes);
+
+    /**
+     *  @brief Read a message from a pipe
+     */
+    static bool ReadMessage(int fd, Message& message);
+
+    ToyFactoryStd& factory_;
+    unsigned int num_workers_;
+    unsigned int block_size_;
+    unsigned int queue_depth_;
+
+    std::uint64_t seed_;
+    int manager_pid_;
+    int manager_fd_;
+
+    std::deque<Message> buffer_;
+    boost::thread reader_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_filled_;
+    boost::condition_variable cond_space_;
+    bool finished_;
+    bool stop_;
+
+    std::vector<FailedToy> failed_toys_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // TOYWORKERPOOL_h
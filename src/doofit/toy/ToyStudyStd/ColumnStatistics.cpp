@@ -0,0 +1,203 @@
+#include "doofit/toy/ToyStudyStd/ColumnStatistics.h"
+
+// STL
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// ROOT
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooAbsReal.h"
+
+// from project
+
+namespace doofit {
+namespace toy {
+  namespace {
+    const std::vector<double> kDefaultProbabilities{0.15865, 0.5, 0.84135};
+  }
+
+  double ColumnSummary::Quantile(double p) const {
+    for (std::size_t i=0; i<probabilities.size(); ++i) {
+      if (std::abs(probabilities[i]-p) < 1e-12) return quantiles[i];
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  ColumnStatistics::ColumnStatistics() :
+  num_rows_(0)
+  {}
+
+  void ColumnStatistics::Extract(const RooDataSet& dataset, const std::vector<std::string>& columns) {
+    columns_.clear();
+    summaries_.clear();
+    window_summaries_.clear();
+    selection_.clear();
+    num_rows_ = dataset.numEntries();
+
+    // the row argset of the dataset is updated in place by get(i)
+    const RooArgSet* row = dataset.get();
+    std::vector<std::pair<const RooAbsReal*, std::vector<double>*>> extractions;
+    for (auto column : columns) {
+      const RooAbsReal* var = dynamic_cast<const RooAbsReal*>(row->find(column.c_str()));
+      if (var != nullptr && columns_.count(column) == 0) {
+        std::vector<double>& buffer = columns_[column];
+        buffer.reserve(num_rows_);
+        extractions.push_back(std::make_pair(var, &buffer));
+      }
+    }
+
+    for (std::size_t i=0; i<num_rows_; ++i) {
+      dataset.get(i);
+      for (auto extraction : extractions) {
+        extraction.second->push_back(extraction.first->getVal());
+      }
+    }
+  }
+
+  const std::vector<double>* ColumnStatistics::Column(const std::string& column) const {
+    std::map<std::string, std::vector<double>>::const_iterator it = columns_.find(column);
+    if (it == columns_.end()) return nullptr;
+    return &(it->second);
+  }
+
+  void ColumnStatistics::SetSelection(const std::vector<bool>& selection) {
+    selection_ = selection;
+    window_summaries_.clear();
+  }
+
+  const ColumnSummary& ColumnStatistics::Summary(const std::string& column) {
+    std::map<std::string, ColumnSummary>::const_iterator it = summaries_.find(column);
+    if (it != summaries_.end()) return it->second;
+
+    std::vector<double> values;
+    const std::vector<double>* values_column = Column(column);
+    if (values_column != nullptr) values = *values_column;
+
+    return summaries_[column] = Summarize(values, kDefaultProbabilities);
+  }
+
+  const ColumnSummary& ColumnStatistics::SelectionSummary(const std::string& column, double low, double high) {
+    std::map<std::string, WindowSummary>::const_iterator it = window_summaries_.find(column);
+    if (it != window_summaries_.end() && it->second.low == low && it->second.high == high) {
+      return it->second.summary;
+    }
+
+    std::vector<double> values(SelectedValues(column, low, high));
+    WindowSummary& window_summary = window_summaries_[column];
+    window_summary.low     = low;
+    window_summary.high    = high;
+    window_summary.summary = Summarize(values, kDefaultProbabilities);
+    return window_summary.summary;
+  }
+
+  std::vector<double> ColumnStatistics::SelectedValues(const std::string& column, double low, double high) const {
+    std::vector<double> values;
+    const std::vector<double>* values_column = Column(column);
+    if (values_column == nullptr) return values;
+
+    bool use_selection = selection_.size() == values_column->size();
+    values.reserve(values_column->size());
+    for (std::size_t i=0; i<values_column->size(); ++i) {
+      double value = (*values_column)[i];
+      if ((!use_selection || selection_[i]) && value > low && value < high) {
+        values.push_back(value);
+      }
+    }
+    return values;
+  }
+
+  std::pair<double,double> ColumnStatistics::MedianLimits(const std::string& column) {
+    std::vector<double> values;
+    const std::vector<double>* values_column = Column(column);
+    if (values_column != nullptr) values = *values_column;
+    if (values.empty()) return MinMax(column);
+
+    // order statistics at the same indices as in the sorted array
+    const std::size_t n = values.size();
+    std::vector<double>::iterator it_lo  = values.begin() + static_cast<std::size_t>(n*0.15865);
+    std::vector<double>::iterator it_med = values.begin() + n/2;
+    std::vector<double>::iterator it_hi  = values.begin() + std::min(static_cast<std::size_t>(n*0.84135), n-1);
+    std::nth_element(values.begin(), it_med, values.end());
+    double med = *it_med;
+    // lower and upper parts are only partitioned, select inside each of them
+    std::nth_element(values.begin(), it_lo, it_med);
+    double lo  = *it_lo;
+    std::nth_element(it_med, it_hi, values.end());
+    double hi  = *it_hi;
+
+    std::pair<double,double> window(lo - 3.0*(med-lo), hi + 3.0*(hi-med));
+    if (!(window.second > window.first)) {
+      window = MinMax(column);
+    }
+    return window;
+  }
+
+  std::pair<double,double> ColumnStatistics::MinMax(const std::string& column) {
+    const ColumnSummary& summary = Summary(column);
+    std::pair<double,double> minmax(summary.min, summary.max);
+    if (!(minmax.second > minmax.first)) {
+      minmax.first  -= 1.0;
+      minmax.second += 1.0;
+    }
+    return minmax;
+  }
+
+  ColumnSummary ColumnStatistics::Summarize(std::vector<double>& values, const std::vector<double>& probabilities) {
+    ColumnSummary summary;
+    summary.num_entries   = values.size();
+    summary.mean          = std::numeric_limits<double>::quiet_NaN();
+    summary.min           = std::numeric_limits<double>::quiet_NaN();
+    summary.max           = std::numeric_limits<double>::quiet_NaN();
+    summary.probabilities = probabilities;
+    summary.quantiles.assign(probabilities.size(), std::numeric_limits<double>::quiet_NaN());
+
+    const std::size_t n = values.size();
+    if (n == 0) return summary;
+
+    double sum = 0.0;
+    summary.min = values[0];
+    summary.max = values[0];
+    for (auto value : values) {
+      sum += value;
+      if (value < summary.min) summary.min = value;
+      if (value > summary.max) summary.max = value;
+    }
+    summary.mean = sum/static_cast<double>(n);
+
+    // select quantiles in ascending order, each selection only needs to
+    // consider the part of the buffer above the previous one
+    std::vector<std::size_t> order(probabilities.size());
+    for (std::size_t i=0; i<order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&probabilities](std::size_t a, std::size_t b) {
+      return probabilities[a] < probabilities[b];
+    });
+
+    std::vector<double>::iterator begin = values.begin();
+    for (auto index : order) {
+      double p = std::min(std::max(probabilities[index], 0.0), 1.0);
+      double position = p*static_cast<double>(n-1);
+      std::size_t k = static_cast<std::size_t>(position);
+      double fraction = position - static_cast<double>(k);
+
+      std::vector<double>::iterator nth = values.begin() + k;
+      if (nth >= begin) {
+        std::nth_element(begin, nth, values.end());
+        begin = nth;
+      }
+      double quantile = *nth;
+      if (fraction > 0.0 && k+1 < n) {
+        // next order statistic is the minimum of the upper part
+        double next = *std::min_element(nth+1, values.end());
+        quantile += fraction*(next-quantile);
+      }
+      summary.quantiles[index] = quantile;
+    }
+
+    return summary;
+  }
+} // namespace toy
+} // namespace doofit
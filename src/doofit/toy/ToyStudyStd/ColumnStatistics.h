@@ -0,0 +1,175 @@
+#ifndef COLUMNSTATISTICS_h
+#define COLUMNSTATISTICS_h
+
+// STL
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class RooDataSet;
+
+namespace doofit {
+namespace toy {
+  /** @struct ColumnSummary
+   *  @brief Summary statistics of one column (see ColumnStatistics)
+   */
+  struct ColumnSummary {
+    std::size_t num_entries;
+    double mean;
+    double min;
+    double max;
+    std::vector<double> probabilities;
+    std::vector<double> quantiles;
+
+    /**
+     *  @brief Get a quantile computed for this summary
+     *
+     *  @param p probability as requested for the summary
+     *  @return quantile (or NaN if not computed)
+     */
+    double Quantile(double p) const;
+
+    double median() const { return Quantile(0.5); }
+    double quantile_low() const { return Quantile(0.15865); }
+    double quantile_high() const { return Quantile(0.84135); }
+  };
+
+  /** @class ColumnStatistics
+   *  @brief Quantiles, median, mean and limits of dataset columns
+   *
+   *  All requested columns of a RooDataSet are extracted in a single pass over
+   *  the dataset into contiguous buffers. Summaries (mean, minimum, maximum
+   *  and a set of quantiles) are computed in one pass over a column using
+   *  successive std::nth_element selections, i.e. in linear time without
+   *  sorting, and are cached per column.
+   *
+   *  Quantiles are interpolated linearly between order statistics at
+   *  position p*(n-1).
+   *
+   *  Additionally, a row selection can be set. Summaries of selected rows
+   *  inside a window (as used for fits and plots) are cached separately.
+   */
+  class ColumnStatistics {
+   public:
+    ColumnStatistics();
+
+    /**
+     *  @brief Extract columns from a dataset (in one pass)
+     *
+     *  Previously extracted columns and all cached summaries are dropped.
+     *  Columns not contained in the dataset are ignored.
+     *
+     *  @param dataset dataset to extract from
+     *  @param columns names of columns to extract
+     */
+    void Extract(const RooDataSet& dataset, const std::vector<std::string>& columns);
+
+    /**
+     *  @brief Get an extracted column
+     *
+     *  @param column name of column
+     *  @return pointer to column values (or nullptr if not extracted)
+     */
+    const std::vector<double>* Column(const std::string& column) const;
+
+    /**
+     *  @brief Number of rows of extracted columns
+     */
+    std::size_t num_rows() const { return num_rows_; }
+
+    /**
+     *  @brief Set selection of rows for SelectionSummary() and SelectedValues()
+     *
+     *  @param selection one entry per row (rows with false are not selected)
+     */
+    void SetSelection(const std::vector<bool>& selection);
+
+    /**
+     *  @brief Summary of all rows of a column (cached)
+     *
+     *  Quantiles are computed for probabilities 0.15865, 0.5 and 0.84135.
+     *
+     *  @param column name of column
+     *  @return summary (num_entries is 0 if column is not extracted)
+     */
+    const ColumnSummary& Summary(const std::string& column);
+
+    /**
+     *  @brief Summary of selected rows of a column inside a window (cached)
+     *
+     *  @param column name of column
+     *  @param low lower window limit (exclusive)
+     *  @param high upper window limit (exclusive)
+     *  @return summary (num_entries is 0 if no value is selected)
+     */
+    const ColumnSummary& SelectionSummary(const std::string& column, double low, double high);
+
+    /**
+     *  @brief Values of selected rows of a column inside a window
+     *
+     *  @param column name of column
+     *  @param low lower window limit (exclusive)
+     *  @param high upper window limit (exclusive)
+     *  @return selected values in original order
+     */
+    std::vector<double> SelectedValues(const std::string& column, double low, double high) const;
+
+    /**
+     *  @brief Median based window of a column for fitting and plotting
+     *
+     *  Same window as doocore::lutils::MedianLimitsForTuple() on the dataset
+     *  the column was extracted from, without copying and sorting it again:
+     *  the central 68.27% interval (order statistics at n*0.15865 and 
+     *  n*0.84135 of all rows) is extended by three times the distance of its
+     *  limits to the median (order statistic at n/2) on each side.
+     *
+     *  @param column name of column
+     *  @return pair of lower and upper limit
+     */
+    std::pair<double,double> MedianLimits(const std::string& column);
+
+    /**
+     *  @brief Minimum and maximum of a column
+     *
+     *  @param column name of column
+     *  @return pair of minimum and maximum
+     */
+    std::pair<double,double> MinMax(const std::string& column);
+
+    /**
+     *  @brief Compute summary statistics of values
+     *
+     *  @param values values to summarise (will be reordered)
+     *  @param probabilities probabilities of quantiles to compute
+     *  @return summary
+     */
+    static ColumnSummary Summarize(std::vector<double>& values, const std::vector<double>& probabilities);
+
+   private:
+    /**
+     *  @brief Cached summary for selected rows in a window
+     */
+    struct WindowSummary {
+      double low;
+      double high;
+      ColumnSummary summary;
+    };
+
+    std::size_t num_rows_;
+    std::map<std::string, std::vector<double>> columns_;
+    std::vector<bool> selection_;
+    std::map<std::string, ColumnSummary> summaries_;
+    std::map<std::string, WindowSummary> window_summaries_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // COLUMNSTATISTICS_h
@@ -0,0 +1,165 @@
+#include "doofit/toy/ToyStudyStd/EasyFitResultPrefetcher.h"
+
+// STL
+
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TThread.h"
+#include "TROOT.h"
+#include "RVersion.h"
+
+// from RooFit
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "doofit/fitter/easyfit/EasyFitResult.h"
+#include "doofit/tools/workers/ForkedWorkers.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  using doofit::fitter::easyfit::EasyFitResult;
+
+  EasyFitResultPrefetcher::EasyFitResultPrefetcher(const std::vector<doofit::config::CommaSeparatedPair<std::string>>& files_trees, unsigned int buffer_size, long long cache_size) :
+  files_trees_(files_trees),
+  buffer_size_(buffer_size > 0 ? buffer_size : 1),
+  cache_size_(cache_size),
+  buffer_(),
+  current_(nullptr, nullptr),
+  started_(false),
+  finished_(false),
+  stop_(false)
+  {}
+
+  EasyFitResultPrefetcher::~EasyFitResultPrefetcher() {
+    Stop();
+
+    DeletePair(current_);
+    for (auto& results : buffer_) {
+      DeletePair(results);
+    }
+  }
+
+  void EasyFitResultPrefetcher::Start() {
+    if (started_) return;
+    started_ = true;
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+    ROOT::EnableThreadSafety();
+#endif
+    worker_ = boost::thread(&EasyFitResultPrefetcher::Worker, this);
+  }
+
+  bool EasyFitResultPrefetcher::Next(const EasyFitResult*& fit_result0, const EasyFitResult*& fit_result1) {
+    if (!started_) Start();
+
+    boost::mutex::scoped_lock lock(mutex_);
+    DeletePair(current_);
+
+    while (buffer_.empty() && !finished_) {
+      cond_filled_.wait(lock);
+    }
+
+    if (buffer_.empty()) {
+      fit_result0 = nullptr;
+      fit_result1 = nullptr;
+      return false;
+    }
+
+    current_ = buffer_.front();
+    buffer_.pop_front();
+    cond_space_.notify_one();
+
+    fit_result0 = current_.first;
+    fit_result1 = current_.second;
+    return true;
+  }
+
+  void EasyFitResultPrefetcher::Stop() {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      stop_ = true;
+    }
+    cond_space_.notify_all();
+    if (worker_.joinable()) worker_.join();
+  }
+
+  void EasyFitResultPrefetcher::Worker() {
+    TThread this_tthread;
+
+    for (auto file_tree : files_trees_) {
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (stop_) break;
+      }
+
+      // no fork() while this thread is in ROOT (released while waiting for 
+      // space in the buffer, which the forking thread consumes)
+      doofit::tools::workers::ThreadSection section(doofit::tools::workers::ForkMutex());
+      TFile file(file_tree.first().c_str(), "read");
+      if (file.IsZombie() || !file.IsOpen()) {
+        serr << "Cannot open file " << file_tree.first() << " which may be not existing or corrupted. Ignoring this file." << endmsg;
+        continue;
+      }
+      TTree* tree = dynamic_cast<TTree*>(file.Get(file_tree.second().c_str()));
+      if (tree == nullptr) {
+        serr << "Cannot find tree " << file_tree.second() << " in " << file_tree.first() << ". Ignoring this file." << endmsg;
+        continue;
+      }
+
+      // all branches are needed, so skip the learning phase of the cache
+      tree->SetCacheSize(cache_size_);
+      tree->AddBranchToCache("*", true);
+      tree->StopCacheLearningPhase();
+
+      bool stopped = false;
+      {
+        // decoding buffers bound to the tree, copies go into the buffer
+        EasyFitResult decoded0(*tree, "fr0_");
+        EasyFitResult decoded1(*tree, "fr1_");
+
+        for (long long i=0; i<tree->GetEntries() && !stopped; ++i) {
+          tree->GetEntry(i);
+          ResultPair results(new EasyFitResult(decoded0), new EasyFitResult(decoded1));
+
+          section.unlock();
+          {
+            boost::mutex::scoped_lock lock(mutex_);
+            while (buffer_.size() >= buffer_size_ && !stop_) {
+              cond_space_.wait(lock);
+            }
+            if (stop_) {
+              DeletePair(results);
+              stopped = true;
+            } else {
+              buffer_.push_back(results);
+              cond_filled_.notify_one();
+            }
+          }
+          section.lock();
+        }
+        tree->ResetBranchAddresses();
+      }
+
+      delete tree;
+      file.Close();
+      if (stopped) break;
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    finished_ = true;
+    cond_filled_.notify_all();
+  }
+
+  void EasyFitResultPrefetcher::DeletePair(ResultPair& results) {
+    delete results.first;
+    delete results.second;
+    results.first  = nullptr;
+    results.second = nullptr;
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,107 @@
+#ifndef EASYFITRESULTPREFETCHER_h
+#define EASYFITRESULTPREFETCHER_h
+
+// STL
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+
+// BOOST
+#include <boost/thread.hpp>
+
+// ROOT
+
+// from RooFit
+
+// from project
+#include "doofit/config/CommaSeparatedPair.h"
+
+namespace doofit {
+  namespace fitter { namespace easyfit {
+    class EasyFitResult;
+  }
+}
+namespace toy {
+  /** @class EasyFitResultPrefetcher
+   *  @brief Iterator over EasyFitResult pairs decoded ahead in a background thread
+   *
+   *  A background thread opens all given files one after another, reads the
+   *  trees through a TTreeCache and decodes each entry into a new pair of
+   *  EasyFitResults (prefixes "fr0_" and "fr1_"). Decoded pairs are kept in a
+   *  bounded buffer of @a buffer_size pairs, so that consumers calling Next()
+   *  usually do not have to wait for I/O and decompression.
+   *
+   *  Files or trees that cannot be opened are reported and skipped.
+   */
+  class EasyFitResultPrefetcher {
+   public:
+    /**
+     *  @brief Constructor for EasyFitResultPrefetcher
+     *
+     *  @param files_trees file names and tree names to read
+     *  @param buffer_size maximum number of decoded pairs kept in memory
+     *  @param cache_size size of TTreeCache in bytes
+     */
+    EasyFitResultPrefetcher(const std::vector<doofit::config::CommaSeparatedPair<std::string>>& files_trees, unsigned int buffer_size=64, long long cache_size=30000000);
+
+    /**
+     *  @brief Destructor, stops the background thread
+     */
+    ~EasyFitResultPrefetcher();
+
+    /**
+     *  @brief Start decoding in the background
+     */
+    void Start();
+
+    /**
+     *  @brief Get next EasyFitResult pair
+     *
+     *  Blocks only if no decoded pair is available yet. The returned pointers
+     *  stay valid until the next call of Next() or destruction of this
+     *  prefetcher.
+     *
+     *  @param fit_result0 first fit result ("fr0_")
+     *  @param fit_result1 second fit result ("fr1_")
+     *  @return false if all pairs are consumed (pointers are set to nullptr)
+     */
+    bool Next(const doofit::fitter::easyfit::EasyFitResult*& fit_result0, const doofit::fitter::easyfit::EasyFitResult*& fit_result1);
+
+    /**
+     *  @brief Stop decoding and wait for the background thread
+     */
+    void Stop();
+
+   private:
+    typedef std::pair<doofit::fitter::easyfit::EasyFitResult*, doofit::fitter::easyfit::EasyFitResult*> ResultPair;
+
+    /**
+     *  @brief Thread function decoding all files
+     */
+    void Worker();
+
+    /**
+     *  @brief Delete a pair of EasyFitResults
+     */
+    static void DeletePair(ResultPair& results);
+
+    std::vector<doofit::config::CommaSeparatedPair<std::string>> files_trees_;
+    unsigned int buffer_size_;
+    long long cache_size_;
+
+    std::deque<ResultPair> buffer_;
+    ResultPair current_;
+
+    boost::thread worker_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_filled_;
+    boost::condition_variable cond_space_;
+    bool started_;
+    bool finished_;
+    bool stop_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // EASYFITRESULTPREFETCHER_h
@@ -0,0 +1,441 @@
+#include "doofit/toy/ToyStudyStd/FitResultColumns.h"
+
+// STL
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+// ROOT
+#include "TTree.h"
+#include "TBranch.h"
+#include "TDirectory.h"
+#include "TMatrixDSym.h"
+#include "TObject.h"
+
+// from RooFit
+#include "RooFitResult.h"
+#include "RooArgList.h"
+#include "RooRealVar.h"
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from Project
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  namespace {
+    /**
+     *  @brief RooFitResult with access to protected setters
+     *
+     *  RooFitResult only allows RooMinimizer and friends to fill it. This thin
+     *  helper class makes the setters accessible to rebuild a fit result from
+     *  columns. It does not add any data members and can be handled (and
+     *  deleted) as an ordinary RooFitResult.
+     *
+     *  As fit results from columns have a diagonal covariance matrix, 
+     *  refilling one in place only needs to update the diagonal.
+     */
+    class ColumnarRooFitResult : public RooFitResult {
+     public:
+      ColumnarRooFitResult(const char* name, const char* title) : RooFitResult(name, title) {}
+
+      using RooFitResult::setConstParList;
+      using RooFitResult::setInitParList;
+      using RooFitResult::setFinalParList;
+      using RooFitResult::setCovarianceMatrix;
+      using RooFitResult::setMinNLL;
+      using RooFitResult::setEDM;
+      using RooFitResult::setStatus;
+      using RooFitResult::setCovQual;
+      using RooFitResult::setStatusHistory;
+
+      void SetVariance(int i, double variance) {
+        if (_VM != nullptr) (*_VM)(i,i) = variance;
+      }
+    };
+  }
+
+  FitResultColumns::FitResultColumns(const std::string& prefix) :
+  prefix_(prefix),
+  status_num_(0),
+  cov_qual_(-1),
+  min_nll_(0.0),
+  edm_(0.0)
+  {
+    for (int i=0; i<kMaxNumStatus; ++i) status_[i] = 0;
+  }
+
+  bool FitResultColumns::RegisterForWriting(TTree& tree, const RooFitResult& fit_result) {
+    const RooArgList& pars_final(fit_result.floatParsFinal());
+
+    parameters_.clear();
+    parameters_.reserve(pars_final.getSize());
+    for (int i=0; i<pars_final.getSize(); ++i) {
+      const RooRealVar* par = dynamic_cast<const RooRealVar*>(pars_final.at(i));
+      if (par == nullptr) continue;
+
+      ParameterColumns columns;
+      columns.name       = par->GetName();
+      columns.title      = par->GetTitle();
+      columns.unit       = par->getUnit();
+      columns.min        = par->hasMin() ? par->getMin() : -std::numeric_limits<double>::infinity();
+      columns.max        = par->hasMax() ? par->getMax() : +std::numeric_limits<double>::infinity();
+      columns.value      = 0.0;
+      columns.error      = -1.0;
+      columns.error_low  = 1.0;
+      columns.error_high = -1.0;
+      columns.init       = 0.0;
+      parameters_.push_back(columns);
+    }
+
+    status_labels_.clear();
+    for (unsigned int i=0; i<fit_result.numStatusHistory() && i<static_cast<unsigned int>(kMaxNumStatus); ++i) {
+      status_labels_.push_back(fit_result.statusLabelHistory(i));
+    }
+
+    // from here on parameters_ must not be resized as addresses are handed
+    // over to the tree
+    bool success = true;
+    success &= RegisterBranch(tree, &status_num_, prefix_+"status_num", prefix_+"status_num/I");
+    success &= RegisterBranch(tree, status_, prefix_+"status", prefix_+"status["+prefix_+"status_num]/I");
+    success &= RegisterBranch(tree, &cov_qual_, prefix_+"cov_qual", prefix_+"cov_qual/I");
+    success &= RegisterBranch(tree, &min_nll_, prefix_+"min_nll", prefix_+"min_nll/D");
+    success &= RegisterBranch(tree, &edm_, prefix_+"edm", prefix_+"edm/D");
+
+    for (auto& columns : parameters_) {
+      std::string name(prefix_+columns.name);
+      success &= RegisterBranch(tree, &columns.value,      name+"_value",      name+"_value/D");
+      success &= RegisterBranch(tree, &columns.error,      name+"_error",      name+"_error/D");
+      success &= RegisterBranch(tree, &columns.error_low,  name+"_error_low",  name+"_error_low/D");
+      success &= RegisterBranch(tree, &columns.error_high, name+"_error_high", name+"_error_high/D");
+      success &= RegisterBranch(tree, &columns.init,       name+"_init",       name+"_init/D");
+    }
+
+    return success;
+  }
+
+  bool FitResultColumns::SetFitResult(const RooFitResult& fit_result) {
+    const RooArgList& pars_final(fit_result.floatParsFinal());
+    const RooArgList& pars_init(fit_result.floatParsInit());
+
+    if (static_cast<unsigned int>(pars_final.getSize()) != parameters_.size()) {
+      serr << "FitResultColumns::SetFitResult(): Fit result has " << pars_final.getSize()
+           << " floating parameters, but " << parameters_.size() << " columns are registered." << endmsg;
+      return false;
+    }
+
+    for (unsigned int i=0; i<parameters_.size(); ++i) {
+      ParameterColumns& columns(parameters_[i]);
+      const RooRealVar* par = dynamic_cast<const RooRealVar*>(pars_final.at(i));
+      if (par == nullptr || columns.name != par->GetName()) {
+        par = dynamic_cast<const RooRealVar*>(pars_final.find(columns.name.c_str()));
+        if (par == nullptr) {
+          serr << "FitResultColumns::SetFitResult(): Fit result does not contain parameter " << columns.name << endmsg;
+          return false;
+        }
+      }
+
+      // init parameters are stored in the same order as final parameters
+      const RooRealVar* par_init = dynamic_cast<const RooRealVar*>(pars_init.at(i));
+      if (par_init == nullptr || columns.name != par_init->GetName()) {
+        par_init = dynamic_cast<const RooRealVar*>(pars_init.find(columns.name.c_str()));
+      }
+
+      columns.value      = par->getVal();
+      columns.error      = par->getError();
+      columns.error_low  = par->getAsymErrorLo();
+      columns.error_high = par->getAsymErrorHi();
+      columns.init       = par_init != nullptr ? par_init->getVal() : 0.0;
+    }
+
+    status_num_ = std::min(static_cast<int>(fit_result.numStatusHistory()), kMaxNumStatus);
+    for (int i=0; i<status_num_; ++i) {
+      status_[i] = fit_result.statusCodeHistory(i);
+    }
+    cov_qual_ = fit_result.covQual();
+    min_nll_  = fit_result.minNll();
+    edm_      = fit_result.edm();
+
+    return true;
+  }
+
+  void FitResultColumns::WriteMetadata(TDirectory& dir, const std::string& treename) const {
+    std::string name_meta(MetadataTreeName(treename));
+
+    std::string type, prefix, name, title, unit;
+    std::string* type_ptr   = &type;
+    std::string* prefix_ptr = &prefix;
+    std::string* name_ptr   = &name;
+    std::string* title_ptr  = &title;
+    std::string* unit_ptr   = &unit;
+    double min(0.0), max(0.0);
+
+    TTree* tree_meta = dynamic_cast<TTree*>(dir.Get(name_meta.c_str()));
+    if (tree_meta == nullptr) {
+      dir.cd();
+      tree_meta = new TTree(name_meta.c_str(), "Metadata for columnar toy study fit results");
+      tree_meta->Branch("type", &type_ptr);
+      tree_meta->Branch("prefix", &prefix_ptr);
+      tree_meta->Branch("name", &name_ptr);
+      tree_meta->Branch("title", &title_ptr);
+      tree_meta->Branch("unit", &unit_ptr);
+      tree_meta->Branch("min", &min, "min/D");
+      tree_meta->Branch("max", &max, "max/D");
+    } else {
+      tree_meta->SetBranchAddress("type", &type_ptr);
+      tree_meta->SetBranchAddress("prefix", &prefix_ptr);
+      tree_meta->SetBranchAddress("name", &name_ptr);
+      tree_meta->SetBranchAddress("title", &title_ptr);
+      tree_meta->SetBranchAddress("unit", &unit_ptr);
+      tree_meta->SetBranchAddress("min", &min);
+      tree_meta->SetBranchAddress("max", &max);
+
+      // metadata for this prefix is already stored
+      for (long long i=0; i<tree_meta->GetEntries(); ++i) {
+        tree_meta->GetEntry(i);
+        if (prefix == prefix_) {
+          tree_meta->ResetBranchAddresses();
+          return;
+        }
+      }
+    }
+
+    prefix = prefix_;
+    for (auto& columns : parameters_) {
+      type  = "parameter";
+      name  = columns.name;
+      title = columns.title;
+      unit  = columns.unit;
+      min   = columns.min;
+      max   = columns.max;
+      tree_meta->Fill();
+    }
+    for (auto& label : status_labels_) {
+      type  = "status";
+      name  = label;
+      title = label;
+      unit  = "";
+      min   = 0.0;
+      max   = 0.0;
+      tree_meta->Fill();
+    }
+
+    tree_meta->Write("", TObject::kOverwrite);
+    tree_meta->ResetBranchAddresses();
+  }
+
+  bool FitResultColumns::RegisterForReading(TTree& tree, TDirectory& dir, const std::string& treename,
+                                            const std::vector<std::string>& parameters) {
+    TTree* tree_meta = dynamic_cast<TTree*>(dir.Get(MetadataTreeName(treename).c_str()));
+    if (tree_meta == nullptr) {
+      serr << "FitResultColumns::RegisterForReading(): Cannot find metadata tree " << MetadataTreeName(treename) << endmsg;
+      return false;
+    }
+
+    std::string* type_ptr   = nullptr;
+    std::string* prefix_ptr = nullptr;
+    std::string* name_ptr   = nullptr;
+    std::string* title_ptr  = nullptr;
+    std::string* unit_ptr   = nullptr;
+    double min(0.0), max(0.0);
+    tree_meta->SetBranchAddress("type", &type_ptr);
+    tree_meta->SetBranchAddress("prefix", &prefix_ptr);
+    tree_meta->SetBranchAddress("name", &name_ptr);
+    tree_meta->SetBranchAddress("title", &title_ptr);
+    tree_meta->SetBranchAddress("unit", &unit_ptr);
+    tree_meta->SetBranchAddress("min", &min);
+    tree_meta->SetBranchAddress("max", &max);
+
+    parameters_.clear();
+    status_labels_.clear();
+    for (long long i=0; i<tree_meta->GetEntries(); ++i) {
+      tree_meta->GetEntry(i);
+      if (*prefix_ptr != prefix_) continue;
+
+      if (*type_ptr == "parameter") {
+        if (!parameters.empty() && std::find(parameters.begin(), parameters.end(), *name_ptr) == parameters.end()) continue;
+
+        ParameterColumns columns;
+        columns.name       = *name_ptr;
+        columns.title      = *title_ptr;
+        columns.unit       = *unit_ptr;
+        columns.min        = min;
+        columns.max        = max;
+        columns.value      = 0.0;
+        columns.error      = -1.0;
+        columns.error_low  = 1.0;
+        columns.error_high = -1.0;
+        columns.init       = 0.0;
+        parameters_.push_back(columns);
+      } else if (*type_ptr == "status") {
+        status_labels_.push_back(*name_ptr);
+      }
+    }
+    delete tree_meta;
+
+    for (auto& name : parameters) {
+      auto it = std::find_if(parameters_.begin(), parameters_.end(), 
+                             [&name](const ParameterColumns& columns) { return columns.name == name; });
+      if (it == parameters_.end()) {
+        swarn << "FitResultColumns::RegisterForReading(): Requested parameter " << name << " not found for column prefix " << prefix_ << "." << endmsg;
+      }
+    }
+
+    if (parameters_.size() == 0) {
+      serr << "FitResultColumns::RegisterForReading(): No parameters for column prefix " << prefix_ << " in metadata." << endmsg;
+      return false;
+    }
+
+    bool success = true;
+    success &= AttachBranch(tree, &status_num_, prefix_+"status_num");
+    success &= AttachBranch(tree, status_, prefix_+"status");
+    success &= AttachBranch(tree, &cov_qual_, prefix_+"cov_qual");
+    success &= AttachBranch(tree, &min_nll_, prefix_+"min_nll");
+    success &= AttachBranch(tree, &edm_, prefix_+"edm");
+
+    for (auto& columns : parameters_) {
+      std::string name(prefix_+columns.name);
+      success &= AttachBranch(tree, &columns.value,      name+"_value");
+      success &= AttachBranch(tree, &columns.error,      name+"_error");
+      success &= AttachBranch(tree, &columns.error_low,  name+"_error_low");
+      success &= AttachBranch(tree, &columns.error_high, name+"_error_high");
+      success &= AttachBranch(tree, &columns.init,       name+"_init");
+    }
+
+    return success;
+  }
+
+  RooFitResult* FitResultColumns::CreateFitResult(RooFitResult* recycled) const {
+    std::vector<std::pair<std::string,int>> status_history;
+    for (int i=0; i<status_num_; ++i) {
+      std::string label(static_cast<unsigned int>(i) < status_labels_.size() ? status_labels_[i] : "");
+      status_history.push_back(std::make_pair(label, status_[i]));
+    }
+
+    ColumnarRooFitResult* fit_result = dynamic_cast<ColumnarRooFitResult*>(recycled);
+    if (fit_result != nullptr && MatchesParameters(*fit_result)) {
+      // refill in place, parameters are in the same order
+      const RooArgList& pars_final(fit_result->floatParsFinal());
+      const RooArgList& pars_init(fit_result->floatParsInit());
+      for (unsigned int i=0; i<parameters_.size(); ++i) {
+        const ParameterColumns& columns(parameters_[i]);
+
+        RooRealVar* par = static_cast<RooRealVar*>(pars_final.at(i));
+        SetMetadata(*par, columns);
+        par->setVal(columns.value);
+        par->setError(columns.error);
+        par->setAsymError(columns.error_low, columns.error_high);
+
+        RooRealVar* par_init = static_cast<RooRealVar*>(pars_init.at(i));
+        SetMetadata(*par_init, columns);
+        par_init->setVal(columns.init);
+
+        fit_result->SetVariance(i, columns.error > 0.0 ? columns.error*columns.error : 0.0);
+      }
+    } else {
+      delete recycled;
+      fit_result = new ColumnarRooFitResult("fit_result", "Fit result from columns");
+
+      RooArgList pars_final, pars_init;
+      TMatrixDSym covariance(parameters_.size());
+      for (unsigned int i=0; i<parameters_.size(); ++i) {
+        const ParameterColumns& columns(parameters_[i]);
+
+        RooRealVar par(columns.name.c_str(), columns.title.c_str(), columns.value, columns.unit.c_str());
+        SetMetadata(par, columns);
+        par.setError(columns.error);
+        par.setAsymError(columns.error_low, columns.error_high);
+        pars_final.addClone(par);
+
+        RooRealVar par_init(columns.name.c_str(), columns.title.c_str(), columns.init, columns.unit.c_str());
+        SetMetadata(par_init, columns);
+        pars_init.addClone(par_init);
+
+        covariance(i,i) = columns.error > 0.0 ? columns.error*columns.error : 0.0;
+      }
+
+      fit_result->setConstParList(RooArgList());
+      fit_result->setInitParList(pars_init);
+      fit_result->setFinalParList(pars_final);
+      fit_result->setCovarianceMatrix(covariance);
+    }
+
+    fit_result->setMinNLL(min_nll_);
+    fit_result->setEDM(edm_);
+    fit_result->setCovQual(cov_qual_);
+    fit_result->setStatus(status_num_ > 0 ? status_[status_num_-1] : 0);
+    fit_result->setStatusHistory(status_history);
+
+    return fit_result;
+  }
+
+  bool FitResultColumns::Recyclable(const RooFitResult& fit_result) {
+    return dynamic_cast<const ColumnarRooFitResult*>(&fit_result) != nullptr;
+  }
+
+  bool FitResultColumns::MatchesParameters(const RooFitResult& fit_result) const {
+    const RooArgList& pars_final(fit_result.floatParsFinal());
+    const RooArgList& pars_init(fit_result.floatParsInit());
+    if (static_cast<unsigned int>(pars_final.getSize()) != parameters_.size() ||
+        static_cast<unsigned int>(pars_init.getSize()) != parameters_.size()) {
+      return false;
+    }
+    for (unsigned int i=0; i<parameters_.size(); ++i) {
+      if (parameters_[i].name != pars_final.at(i)->GetName() ||
+          parameters_[i].name != pars_init.at(i)->GetName()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void FitResultColumns::SetMetadata(RooRealVar& par, const ParameterColumns& columns) {
+    par.SetTitle(columns.title.c_str());
+    par.setUnit(columns.unit.c_str());
+    if (columns.min > -std::numeric_limits<double>::infinity()) {
+      par.setMin(columns.min);
+    } else {
+      par.removeMin();
+    }
+    if (columns.max < +std::numeric_limits<double>::infinity()) {
+      par.setMax(columns.max);
+    } else {
+      par.removeMax();
+    }
+  }
+
+  bool FitResultColumns::TreeHasColumns(TTree& tree, const std::string& prefix) {
+    return tree.GetBranch((prefix+"min_nll").c_str()) != nullptr &&
+           tree.GetBranch((prefix+"status_num").c_str()) != nullptr;
+  }
+
+  bool FitResultColumns::RegisterBranch(TTree& tree, void* ptr, const std::string& name, const std::string& leaflist) {
+    if (tree.GetEntries() == 0 && tree.GetBranch(name.c_str()) == nullptr) {
+      tree.Branch(name.c_str(), ptr, leaflist.c_str());
+      return true;
+    } else if (tree.GetBranch(name.c_str()) != nullptr) {
+      tree.SetBranchAddress(name.c_str(), ptr);
+      return true;
+    } else {
+      serr << "FitResultColumns::RegisterBranch(): Tree exists but branch " << name << " is unknown." << endmsg;
+      return false;
+    }
+  }
+
+  bool FitResultColumns::AttachBranch(TTree& tree, void* ptr, const std::string& name) {
+    TBranch* branch = tree.GetBranch(name.c_str());
+    if (branch == nullptr) {
+      serr << "FitResultColumns::AttachBranch(): Cannot find branch " << name << " in tree." << endmsg;
+      return false;
+    }
+    tree.SetBranchStatus(name.c_str(), 1);
+    tree.SetBranchAddress(name.c_str(), ptr);
+    tree.AddBranchToCache(branch, true);
+    return true;
+  }
+} // namespace toy
+} // namespace doofit
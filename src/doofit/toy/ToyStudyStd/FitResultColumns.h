@@ -0,0 +1,250 @@
+#ifndef FITRESULTCOLUMNS_h
+#define FITRESULTCOLUMNS_h
+
+// STL
+#include <string>
+#include <vector>
+#include <utility>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class RooFitResult;
+class RooRealVar;
+class TTree;
+class TDirectory;
+
+namespace doofit {
+namespace toy {
+  /** @class FitResultColumns
+   *  @brief Flat columnar TTree representation of a RooFitResult
+   *
+   *  Streaming full RooFitResult objects into a TTree is expensive to read
+   *  back as every single result needs to be deserialized completely (incl.
+   *  covariance matrices, constant parameters and all RooRealVar objects).
+   *  FitResultColumns instead stores one flat numeric column per quantity and
+   *  floating parameter, i.e. for a column prefix "fit_results_":
+   *
+   *   - fit_results_<par>_value, fit_results_<par>_error,
+   *     fit_results_<par>_error_low, fit_results_<par>_error_high,
+   *     fit_results_<par>_init
+   *   - fit_results_status_num, fit_results_status (array),
+   *     fit_results_cov_qual, fit_results_min_nll, fit_results_edm
+   *
+   *  Parameter metadata (titles, units, limits) and status labels do not
+   *  change from toy to toy and are therefore stored only once per file in a
+   *  separate metadata tree (see FitResultColumns::MetadataTreeName()).
+   *
+   *  Reading back only activates the columns of the requested parameters so
+   *  that TTree::GetEntry() only decompresses what the evaluation actually
+   *  needs. Fit results created from columns can be handed back to
+   *  CreateFitResult() to be refilled in place instead of allocating a new
+   *  RooFitResult for every toy.
+   */
+  class FitResultColumns {
+   public:
+    /**
+     *  @brief Constructor for FitResultColumns
+     *
+     *  @param prefix prefix for all column names (e.g. "fit_results_")
+     */
+    FitResultColumns(const std::string& prefix);
+
+    /** @name Writing
+     *  Functions for writing fit results into columns
+     */
+    ///@{
+    /**
+     *  @brief Register columns in a TTree for writing
+     *
+     *  If the tree is empty, new branches will be created based on the
+     *  parameters in @a fit_result. Otherwise, the existing branches are
+     *  attached.
+     *
+     *  @param tree TTree to register branches in
+     *  @param fit_result fit result defining the parameter layout
+     *  @return true if all columns could be registered, false if not
+     */
+    bool RegisterForWriting(TTree& tree, const RooFitResult& fit_result);
+
+    /**
+     *  @brief Copy fit result into column buffers
+     *
+     *  After this call, TTree::Fill() will write the fit result.
+     *
+     *  @param fit_result fit result to copy (must match registered layout)
+     *  @return true if the fit result matches the registered layout
+     */
+    bool SetFitResult(const RooFitResult& fit_result);
+
+    /**
+     *  @brief Write parameter metadata into a directory
+     *
+     *  Metadata of all registered parameters (titles, units, limits) and
+     *  status labels are written once into a metadata TTree.
+     *
+     *  @param dir directory (i.e. TFile) to write metadata tree to
+     *  @param treename name of the results tree
+     */
+    void WriteMetadata(TDirectory& dir, const std::string& treename) const;
+    ///@}
+
+    /** @name Reading
+     *  Functions for reading fit results from columns
+     */
+    ///@{
+    /**
+     *  @brief Register columns in an existing TTree for reading
+     *
+     *  Parameter layout and metadata is read from the metadata tree in @a dir.
+     *  Only the columns of the requested parameters and the status columns 
+     *  will be activated in @a tree. Fit results created afterwards only 
+     *  contain the requested parameters.
+     *
+     *  @param tree TTree to read fit results from
+     *  @param dir directory (i.e. TFile) containing the metadata tree
+     *  @param treename name of the results tree
+     *  @param parameters names of parameters to read (empty for all)
+     *  @return true if columns could be registered, false if not
+     */
+    bool RegisterForReading(TTree& tree, TDirectory& dir, const std::string& treename,
+                            const std::vector<std::string>& parameters=std::vector<std::string>());
+
+    /**
+     *  @brief Create a RooFitResult from current column buffers
+     *
+     *  Create a RooFitResult containing floating parameters (init and final),
+     *  status history, covariance quality, minimal NLL and EDM. The
+     *  covariance matrix is diagonal based on the parameter errors.
+     *
+     *  If @a recycled is a fit result previously created by this function 
+     *  (see Recyclable()) with the same parameters, it is refilled in place 
+     *  and returned. Otherwise it is deleted and a new fit result is created.
+     *
+     *  @param recycled fit result to reuse (ownership is transferred, can be nullptr)
+     *  @return RooFitResult (ownership is transferred to caller)
+     */
+    RooFitResult* CreateFitResult(RooFitResult* recycled=nullptr) const;
+    ///@}
+
+    /**
+     *  @brief Check if a tree contains columnar fit results for a prefix
+     *
+     *  @param tree TTree to check
+     *  @param prefix column prefix to check for
+     *  @return true if tree contains columnar fit results
+     */
+    static bool TreeHasColumns(TTree& tree, const std::string& prefix);
+
+    /**
+     *  @brief Check if a fit result was created by CreateFitResult()
+     *
+     *  @param fit_result fit result to check
+     *  @return true if fit_result can be passed to CreateFitResult() for reuse
+     */
+    static bool Recyclable(const RooFitResult& fit_result);
+
+    /**
+     *  @brief Name of the metadata tree for a given results tree
+     *
+     *  @param treename name of the results tree
+     *  @return name of the metadata tree
+     */
+    static std::string MetadataTreeName(const std::string& treename) { return treename + "_columns"; }
+
+    /**
+     *  @brief Getter for number of registered parameters
+     */
+    unsigned int num_parameters() const { return parameters_.size(); }
+
+   private:
+    /**
+     *  @brief Maximum number of status codes to store per fit result
+     */
+    static const int kMaxNumStatus = 10;
+
+    /**
+     *  @brief Metadata and column buffers for one floating parameter
+     */
+    struct ParameterColumns {
+      std::string name;
+      std::string title;
+      std::string unit;
+      double min;
+      double max;
+
+      double value;
+      double error;
+      double error_low;
+      double error_high;
+      double init;
+    };
+
+    /**
+     *  @brief Register one branch (create if empty tree, attach otherwise)
+     */
+    bool RegisterBranch(TTree& tree, void* ptr, const std::string& name, const std::string& leaflist);
+
+    /**
+     *  @brief Check if a fit result contains exactly the registered parameters
+     */
+    bool MatchesParameters(const RooFitResult& fit_result) const;
+
+    /**
+     *  @brief Set title, unit and limits of a parameter from its metadata
+     */
+    static void SetMetadata(RooRealVar& par, const ParameterColumns& columns);
+
+    /**
+     *  @brief Attach one branch for reading and activate it
+     */
+    bool AttachBranch(TTree& tree, void* ptr, const std::string& name);
+
+    /**
+     *  @brief Column prefix
+     */
+    std::string prefix_;
+
+    /**
+     *  @brief Floating parameters (order matches RooFitResult::floatParsFinal())
+     */
+    std::vector<ParameterColumns> parameters_;
+
+    /**
+     *  @brief Status labels (i.e. algorithm names)
+     */
+    std::vector<std::string> status_labels_;
+
+    /**
+     *  @brief Number of stored status codes
+     */
+    int status_num_;
+
+    /**
+     *  @brief Status codes
+     */
+    int status_[kMaxNumStatus];
+
+    /**
+     *  @brief Covariance matrix quality
+     */
+    int cov_qual_;
+
+    /**
+     *  @brief Minimal NLL
+     */
+    double min_nll_;
+
+    /**
+     *  @brief Estimated distance to minimum
+     */
+    double edm_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // FITRESULTCOLUMNS_h
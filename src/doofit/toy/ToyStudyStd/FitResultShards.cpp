@@ -0,0 +1,207 @@
+#include "doofit/toy/ToyStudyStd/FitResultShards.h"
+
+// STL
+#include <algorithm>
+
+// boost
+#include "boost/filesystem.hpp"
+
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TObject.h"
+
+// from RooFit
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+#include "doocore/system/FileLock.h"
+
+// from project
+#include "doofit/toy/ToyStudyStd/FitResultColumns.h"
+#include "doofit/toy/ToyStudyStd/ResultSetManifest.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  namespace fs = boost::filesystem;
+
+  std::string FitResultShards::UniqueShardFileName(const std::string& filename) {
+    return fs::unique_path(filename + ".shard-%%%%-%%%%-%%%%-%%%%.root").string();
+  }
+
+  bool FitResultShards::Publish(const std::string& shardname) {
+    boost::system::error_code ec;
+    fs::rename(TemporaryFileName(shardname), shardname, ec);
+    if (ec) {
+      serr << "Cannot rename " << TemporaryFileName(shardname) << " to " << shardname << ": " << ec.message() << endmsg;
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<std::string> FitResultShards::FindShards(const std::string& filename) {
+    std::vector<std::string> shards;
+
+    fs::path path_result(fs::absolute(filename));
+    fs::path path_dir(path_result.parent_path());
+    std::string prefix(path_result.filename().string() + ".shard-");
+    std::string postfix(".root");
+
+    if (!fs::is_directory(path_dir)) {
+      return shards;
+    }
+
+    for (fs::directory_iterator it(path_dir), it_end; it != it_end; ++it) {
+      std::string name(it->path().filename().string());
+      if (fs::is_regular_file(it->status()) &&
+          name.size() > prefix.size() + postfix.size() &&
+          name.compare(0, prefix.size(), prefix) == 0 &&
+          name.compare(name.size()-postfix.size(), postfix.size(), postfix) == 0) {
+        shards.push_back(it->path().string());
+      }
+    }
+    std::sort(shards.begin(), shards.end());
+
+    return shards;
+  }
+
+  long long FitResultShards::Merge(const std::string& filename, const std::string& treename, const std::string& branch_name_result,
+                                   bool update_manifest, bool remove_shards) {
+    doocore::system::FileLock flock(filename);
+    if (!flock.Lock()) {
+      serr << "Cannot merge shards into " << filename << " as the file is locked by another process." << endmsg;
+      return -1;
+    }
+
+    // snapshot under the lock, shards published afterwards are not touched
+    std::vector<std::string> shards(FindShards(filename));
+    long long num_entries = 0;
+    if (shards.size() == 0) {
+      swarn << "No shards found for " << filename << ". Nothing to merge." << endmsg;
+    } else {
+      num_entries = MergeShards(filename, treename, branch_name_result, shards, update_manifest, remove_shards);
+    }
+
+    flock.Unlock();
+    return num_entries;
+  }
+
+  long long FitResultShards::MergeShards(const std::string& filename, const std::string& treename, const std::string& branch_name_result,
+                                         const std::vector<std::string>& shards, bool update_manifest, bool remove_shards) {
+    std::vector<std::string> inputs;
+    if (fs::exists(filename)) {
+      inputs.push_back(filename);
+    }
+    inputs.insert(inputs.end(), shards.begin(), shards.end());
+
+    sinfo << "Merging " << shards.size() << " shards into " << filename << endmsg;
+
+    // write into temporary file first and replace result file afterwards
+    std::string filename_tmp(fs::unique_path(filename + ".merge-%%%%-%%%%.tmp").string());
+    TFile file_out(filename_tmp.c_str(), "recreate");
+    if (file_out.IsZombie() || !file_out.IsOpen()) {
+      serr << "Cannot open temporary file " << filename_tmp << " for merging." << endmsg;
+      return -1;
+    }
+
+    const std::string name_meta(FitResultColumns::MetadataTreeName(treename));
+    TTree* tree_out = nullptr;
+    TTree* tree_meta_out = nullptr;
+    bool success = true;
+
+    for (std::vector<std::string>::const_iterator it = inputs.begin(); it != inputs.end() && success; ++it) {
+      TFile file_in(it->c_str(), "read");
+      if (file_in.IsZombie() || !file_in.IsOpen()) {
+        serr << "Cannot open " << *it << " for merging. Ignoring this file." << endmsg;
+        continue;
+      }
+
+      TTree* tree_in = dynamic_cast<TTree*>(file_in.Get(treename.c_str()));
+      if (tree_in == nullptr) {
+        serr << "Cannot find tree " << treename << " in " << *it << ". Ignoring this file." << endmsg;
+        file_in.Close();
+        continue;
+      }
+
+      file_out.cd();
+      // fast cloning copies compressed baskets without deserializing fit results
+      if (tree_out == nullptr) {
+        tree_out = tree_in->CloneTree(-1, "fast");
+        if (tree_out == nullptr) {
+          serr << "Cannot clone tree " << treename << " from " << *it << "." << endmsg;
+          success = false;
+        }
+      } else if (tree_out->CopyEntries(tree_in, -1, "fast") < 0) {
+        serr << "Cannot merge tree from " << *it << ". Is the tree layout compatible?" << endmsg;
+        success = false;
+      }
+
+      TTree* tree_meta_in = dynamic_cast<TTree*>(file_in.Get(name_meta.c_str()));
+      if (success && tree_meta_out == nullptr && tree_meta_in != nullptr) {
+        file_out.cd();
+        tree_meta_out = tree_meta_in->CloneTree(-1, "fast");
+      }
+
+      file_in.Close();
+    }
+
+    long long num_entries = -1;
+    ResultManifestEntry manifest_entry;
+    if (success && tree_out != nullptr) {
+      file_out.cd();
+      // index for fast access to specific toys
+      if (tree_out->GetBranch("run_id") != nullptr && tree_out->GetBranch("seed") != nullptr) {
+        tree_out->BuildIndex("run_id", "seed");
+      }
+      tree_out->Write("", TObject::kOverwrite);
+      if (tree_meta_out != nullptr) {
+        tree_meta_out->Write("", TObject::kOverwrite);
+      }
+      num_entries = tree_out->GetEntries();
+      manifest_entry = ResultSetManifest::Describe(filename, *tree_out, branch_name_result);
+    }
+    file_out.Close();
+
+    if (num_entries < 0) {
+      serr << "Merging shards into " << filename << " failed. Leaving shards untouched." << endmsg;
+      fs::remove(filename_tmp);
+      return -1;
+    }
+
+    boost::system::error_code ec;
+    fs::rename(filename_tmp, filename, ec);
+    if (ec) {
+      serr << "Cannot replace " << filename << " by merged file " << filename_tmp << ": " << ec.message() << endmsg;
+      return -1;
+    }
+
+    if (remove_shards) {
+      for (std::vector<std::string>::const_iterator it = shards.begin(); it != shards.end(); ++it) {
+        fs::remove(*it);
+      }
+    }
+
+    // replace shard records by the merged file (still holding the file lock)
+    if (update_manifest) {
+      ResultSetManifest manifest(filename);
+      manifest.Load();
+      if (remove_shards) {
+        for (std::vector<std::string>::const_iterator it = shards.begin(); it != shards.end(); ++it) {
+          manifest.Remove(*it);
+        }
+      }
+      manifest.Remove(filename);
+      manifest_entry.file_size = ResultSetManifest::FileSize(filename);
+      manifest.Set(manifest_entry);
+      if (!manifest.Write()) {
+        swarn << "Cannot update result manifest " << ResultSetManifest::ManifestFileName(filename) << endmsg;
+      }
+    }
+
+    sinfo << "Merged " << num_entries << " fit results into " << filename << endmsg;
+    return num_entries;
+  }
+} // namespace toy
+} // namespace doofit
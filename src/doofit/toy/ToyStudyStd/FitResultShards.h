@@ -0,0 +1,115 @@
+#ifndef FITRESULTSHARDS_h
+#define FITRESULTSHARDS_h
+
+// STL
+#include <string>
+#include <vector>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  /** @class FitResultShards
+   *  @brief Sharded storage of toy study fit results without file locking
+   *
+   *  Instead of appending fit results to one shared file (which requires all
+   *  toy jobs to compete for a file lock), each job writes its fit results
+   *  into own shard files next to the requested result file. Shard files are
+   *  written under a temporary name and atomically renamed when complete, so
+   *  that a shard is either visible completely or not at all.
+   *
+   *  For a result file "/path/results.root", shards are named
+   *  "/path/results.root.shard-<unique>.root". FitResultShards::Merge()
+   *  concatenates all shards into the result file. Fit result baskets are
+   *  copied directly (fast cloning) without deserializing any RooFitResult.
+   *  The merged tree is indexed by run_id and seed. An existing
+   *  ResultSetManifest of the result file is updated accordingly.
+   */
+  class FitResultShards {
+   public:
+    /**
+     *  @brief Get a new unique shard file name for a result file
+     *
+     *  @param filename name of the result file
+     *  @return unique shard file name in the same directory as filename
+     */
+    static std::string UniqueShardFileName(const std::string& filename);
+
+    /**
+     *  @brief Get temporary file name for a shard file
+     *
+     *  Shards are written under this name and renamed to the final shard name
+     *  after the file is closed.
+     *
+     *  @param shardname name of the shard file
+     *  @return temporary file name
+     */
+    static std::string TemporaryFileName(const std::string& shardname) { return shardname + ".tmp"; }
+
+    /**
+     *  @brief Atomically publish a completely written shard
+     *
+     *  @param shardname name of the shard file (written as TemporaryFileName(shardname))
+     *  @return true if successful
+     */
+    static bool Publish(const std::string& shardname);
+
+    /**
+     *  @brief Find all complete shard files for a result file
+     *
+     *  Temporary files of shards still being written are ignored.
+     *
+     *  @param filename name of the result file
+     *  @return sorted list of shard file names
+     */
+    static std::vector<std::string> FindShards(const std::string& filename);
+
+    /**
+     *  @brief Merge all shards of a result file into the result file
+     *
+     *  All shards (and the result file itself, if existing) are concatenated
+     *  into a new file which then atomically replaces the result file. Column
+     *  metadata trees of columnar fit results are taken over from the first
+     *  input containing them. If requested, the result set manifest (see 
+     *  ResultSetManifest) is created or updated to list the merged file 
+     *  instead of the merged shards.
+     *
+     *  The whole merge holds the file lock of the result file (the same lock
+     *  ToyStudyStd takes when appending to it), so concurrent merges in other
+     *  processes are serialised. Only shards found after the lock has been
+     *  acquired are merged and removed; shards published during the merge
+     *  are left for the next merge.
+     *
+     *  @param filename name of the result file
+     *  @param treename name of the fit result tree
+     *  @param branch_name_result name of the (first) fit result branch
+     *  @param update_manifest create or update the result set manifest
+     *  @param remove_shards remove merged shards afterwards
+     *  @return number of fit results in merged file (or -1 on error, also if the result file is locked)
+     */
+    static long long Merge(const std::string& filename, const std::string& treename, const std::string& branch_name_result,
+                           bool update_manifest=true, bool remove_shards=true);
+
+   private:
+    /**
+     *  @brief Merge a snapshot of shards into the result file (file lock held by caller)
+     *
+     *  @param filename name of the result file
+     *  @param treename name of the fit result tree
+     *  @param branch_name_result name of the (first) fit result branch
+     *  @param shards shards to merge
+     *  @param update_manifest create or update the result set manifest
+     *  @param remove_shards remove merged shards afterwards
+     *  @return number of fit results in merged file (or -1 on error)
+     */
+    static long long MergeShards(const std::string& filename, const std::string& treename, const std::string& branch_name_result,
+                                 const std::vector<std::string>& shards, bool update_manifest, bool remove_shards);
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // FITRESULTSHARDS_h
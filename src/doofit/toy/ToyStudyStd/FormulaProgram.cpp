@@ -0,0 +1,392 @@
+#include "doofit/toy/ToyStudyStd/FormulaProgram.h"
+
+// STL
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  namespace {
+    const std::size_t kMaxStack = 64;
+
+    double Abs(double x) { return std::fabs(x); }
+    double Sqrt(double x) { return std::sqrt(x); }
+    double Exp(double x) { return std::exp(x); }
+    double Log(double x) { return std::log(x); }
+    double Log10(double x) { return std::log10(x); }
+    double Sin(double x) { return std::sin(x); }
+    double Cos(double x) { return std::cos(x); }
+    double Tan(double x) { return std::tan(x); }
+    double ASin(double x) { return std::asin(x); }
+    double ACos(double x) { return std::acos(x); }
+    double ATan(double x) { return std::atan(x); }
+    double SinH(double x) { return std::sinh(x); }
+    double CosH(double x) { return std::cosh(x); }
+    double TanH(double x) { return std::tanh(x); }
+    double Power(double x, double y) { return std::pow(x, y); }
+    double ATan2(double y, double x) { return std::atan2(y, x); }
+    double Min(double x, double y) { return std::min(x, y); }
+    double Max(double x, double y) { return std::max(x, y); }
+    double FMod(double x, double y) { return std::fmod(x, y); }
+
+    const std::map<std::string, double (*)(double)>& Functions1() {
+      static const std::map<std::string, double (*)(double)> functions{
+        {"sqrt", Sqrt}, {"exp", Exp}, {"log", Log}, {"log10", Log10},
+        {"sin", Sin}, {"cos", Cos}, {"tan", Tan},
+        {"asin", ASin}, {"acos", ACos}, {"atan", ATan},
+        {"sinh", SinH}, {"cosh", CosH}, {"tanh", TanH},
+        {"abs", Abs}, {"fabs", Abs}};
+      return functions;
+    }
+
+    const std::map<std::string, double (*)(double, double)>& Functions2() {
+      static const std::map<std::string, double (*)(double, double)> functions{
+        {"pow", Power}, {"power", Power}, {"atan2", ATan2},
+        {"min", Min}, {"max", Max}, {"fmod", FMod}};
+      return functions;
+    }
+
+    // TMath::Sqrt -> sqrt, TMath::Power -> power etc.
+    std::string NormaliseFunctionName(std::string name) {
+      if (name.compare(0, 7, "TMath::") == 0) name = name.substr(7);
+      if (name.compare(0, 5, "std::") == 0) name = name.substr(5);
+      std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+      return name;
+    }
+  }
+
+  FormulaProgram::FormulaProgram() :
+  max_stack_(0),
+  compiled_(false),
+  position_(0)
+  {}
+
+  bool FormulaProgram::Compile(const std::string& expression, const std::vector<std::string>& variables) {
+    variables_  = variables;
+    program_.clear();
+    max_stack_  = 0;
+    compiled_   = false;
+    error_      = "";
+    expression_ = expression;
+    position_   = 0;
+
+    if (!ParseOr()) return false;
+    SkipWhitespace();
+    if (position_ != expression_.size()) {
+      return Fail("unexpected character");
+    }
+
+    // determine required stack depth
+    std::size_t depth = 0;
+    for (auto instruction : program_) {
+      switch (instruction.op) {
+        case kConstant:
+        case kVariable:
+          ++depth;
+          break;
+        case kNegate:
+        case kNot:
+        case kFunction1:
+          break;
+        default:
+          --depth;
+          break;
+      }
+      max_stack_ = std::max(max_stack_, depth);
+    }
+    if (depth != 1) {
+      return Fail("invalid expression");
+    }
+    if (max_stack_ > kMaxStack) {
+      return Fail("expression too deeply nested");
+    }
+
+    compiled_ = true;
+    return true;
+  }
+
+  double FormulaProgram::Evaluate(const double* values) const {
+    double stack[kMaxStack];
+    std::size_t top = 0;
+
+    for (auto& instruction : program_) {
+      switch (instruction.op) {
+        case kConstant:
+          stack[top++] = instruction.constant;
+          break;
+        case kVariable:
+          stack[top++] = values[instruction.index];
+          break;
+        case kNegate:
+        case kNot:
+        case kFunction1:
+          stack[top-1] = Apply(instruction.op, stack[top-1], 0.0, instruction);
+          break;
+        default:
+          --top;
+          stack[top-1] = Apply(instruction.op, stack[top-1], stack[top], instruction);
+          break;
+      }
+    }
+    return top > 0 ? stack[0] : std::nan("");
+  }
+
+  double FormulaProgram::Apply(OpCode op, double a, double b, const Instruction& instruction) {
+    switch (op) {
+      case kAdd:          return a + b;
+      case kSubtract:     return a - b;
+      case kMultiply:     return a * b;
+      case kDivide:       return a / b;
+      case kPower:        return std::pow(a, b);
+      case kNegate:       return -a;
+      case kNot:          return a == 0.0 ? 1.0 : 0.0;
+      case kLess:         return a < b ? 1.0 : 0.0;
+      case kLessEqual:    return a <= b ? 1.0 : 0.0;
+      case kGreater:      return a > b ? 1.0 : 0.0;
+      case kGreaterEqual: return a >= b ? 1.0 : 0.0;
+      case kEqual:        return a == b ? 1.0 : 0.0;
+      case kNotEqual:     return a != b ? 1.0 : 0.0;
+      case kAnd:          return (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+      case kOr:           return (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+      case kFunction1:    return instruction.function1(a);
+      case kFunction2:    return instruction.function2(a, b);
+      default:            return std::nan("");
+    }
+  }
+
+  bool FormulaProgram::ParseOr() {
+    if (!ParseAnd()) return false;
+    while (Consume("||")) {
+      if (!ParseAnd()) return false;
+      Emit(kOr);
+    }
+    return true;
+  }
+
+  bool FormulaProgram::ParseAnd() {
+    if (!ParseComparison()) return false;
+    while (Consume("&&")) {
+      if (!ParseComparison()) return false;
+      Emit(kAnd);
+    }
+    return true;
+  }
+
+  bool FormulaProgram::ParseComparison() {
+    if (!ParseAdditive()) return false;
+    while (true) {
+      OpCode op;
+      if (Consume("<="))      op = kLessEqual;
+      else if (Consume(">=")) op = kGreaterEqual;
+      else if (Consume("==")) op = kEqual;
+      else if (Consume("!=")) op = kNotEqual;
+      else if (Consume("<"))  op = kLess;
+      else if (Consume(">"))  op = kGreater;
+      else return true;
+
+      if (!ParseAdditive()) return false;
+      Emit(op);
+    }
+  }
+
+  bool FormulaProgram::ParseAdditive() {
+    if (!ParseMultiplicative()) return false;
+    while (true) {
+      OpCode op;
+      if (Consume("+"))      op = kAdd;
+      else if (Consume("-")) op = kSubtract;
+      else return true;
+
+      if (!ParseMultiplicative()) return false;
+      Emit(op);
+    }
+  }
+
+  bool FormulaProgram::ParseMultiplicative() {
+    if (!ParseUnary()) return false;
+    while (true) {
+      OpCode op;
+      SkipWhitespace();
+      // do not mistake "**" (power) for multiplication
+      if (expression_.compare(position_, 2, "**") != 0 && Consume("*")) op = kMultiply;
+      else if (Consume("/")) op = kDivide;
+      else return true;
+
+      if (!ParseUnary()) return false;
+      Emit(op);
+    }
+  }
+
+  bool FormulaProgram::ParseUnary() {
+    if (Consume("-")) {
+      if (!ParseUnary()) return false;
+      Emit(kNegate);
+      return true;
+    }
+    if (Consume("+")) {
+      return ParseUnary();
+    }
+    SkipWhitespace();
+    if (expression_.compare(position_, 2, "!=") != 0 && Consume("!")) {
+      if (!ParseUnary()) return false;
+      Emit(kNot);
+      return true;
+    }
+    return ParsePower();
+  }
+
+  bool FormulaProgram::ParsePower() {
+    if (!ParsePrimary()) return false;
+    if (Consume("^") || Consume("**")) {
+      // right associative, exponent may carry a sign
+      if (!ParseUnary()) return false;
+      Emit(kPower);
+    }
+    return true;
+  }
+
+  bool FormulaProgram::ParsePrimary() {
+    SkipWhitespace();
+    if (position_ >= expression_.size()) {
+      return Fail("unexpected end of expression");
+    }
+
+    char c = expression_[position_];
+
+    if (c == '(') {
+      ++position_;
+      if (!ParseOr()) return false;
+      if (!Consume(")")) return Fail("missing )");
+      return true;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+      const char* begin = expression_.c_str() + position_;
+      char* end = nullptr;
+      double value = std::strtod(begin, &end);
+      if (end == begin) return Fail("invalid number");
+      position_ += end - begin;
+      Emit(kConstant, 0, value);
+      return true;
+    }
+
+    if (c == '@') {
+      ++position_;
+      std::size_t start = position_;
+      while (position_ < expression_.size() && std::isdigit(static_cast<unsigned char>(expression_[position_]))) ++position_;
+      if (start == position_) return Fail("invalid variable reference");
+      int index = std::atoi(expression_.substr(start, position_-start).c_str());
+      if (index < 0 || static_cast<std::size_t>(index) >= variables_.size()) return Fail("variable index out of range");
+      Emit(kVariable, index);
+      return true;
+    }
+
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      std::size_t start = position_;
+      while (position_ < expression_.size() &&
+             (std::isalnum(static_cast<unsigned char>(expression_[position_])) || expression_[position_] == '_' ||
+              expression_.compare(position_, 2, "::") == 0)) {
+        position_ += expression_.compare(position_, 2, "::") == 0 ? 2 : 1;
+      }
+      return ParseIdentifier(expression_.substr(start, position_-start));
+    }
+
+    return Fail("unexpected character");
+  }
+
+  bool FormulaProgram::ParseIdentifier(const std::string& identifier) {
+    // variable by name
+    std::vector<std::string>::const_iterator it_var = std::find(variables_.begin(), variables_.end(), identifier);
+    if (it_var != variables_.end()) {
+      Emit(kVariable, static_cast<int>(it_var - variables_.begin()));
+      return true;
+    }
+
+    // x[n]
+    if (identifier == "x" && Consume("[")) {
+      SkipWhitespace();
+      std::size_t start = position_;
+      while (position_ < expression_.size() && std::isdigit(static_cast<unsigned char>(expression_[position_]))) ++position_;
+      int index = std::atoi(expression_.substr(start, position_-start).c_str());
+      if (start == position_ || !Consume("]")) return Fail("invalid variable reference");
+      if (index < 0 || static_cast<std::size_t>(index) >= variables_.size()) return Fail("variable index out of range");
+      Emit(kVariable, index);
+      return true;
+    }
+
+    std::string name(NormaliseFunctionName(identifier));
+
+    if (name == "pi") {
+      // TMath::Pi() or plain pi
+      SkipWhitespace();
+      if (expression_.compare(position_, 1, "(") == 0) {
+        if (!Consume("(") || !Consume(")")) return Fail("invalid use of pi");
+      }
+      Emit(kConstant, 0, M_PI);
+      return true;
+    }
+
+    if (!Consume("(")) {
+      return Fail("unknown variable " + identifier);
+    }
+
+    std::map<std::string, double (*)(double)>::const_iterator it_function1 = Functions1().find(name);
+    std::map<std::string, double (*)(double, double)>::const_iterator it_function2 = Functions2().find(name);
+    if (it_function1 != Functions1().end()) {
+      if (!ParseOr()) return false;
+      if (!Consume(")")) return Fail("missing ) after argument of " + identifier);
+      Emit(kFunction1, 0, 0.0, it_function1->second);
+      return true;
+    } else if (it_function2 != Functions2().end()) {
+      if (!ParseOr()) return false;
+      if (!Consume(",")) return Fail("missing second argument of " + identifier);
+      if (!ParseOr()) return false;
+      if (!Consume(")")) return Fail("missing ) after arguments of " + identifier);
+      Emit(kFunction2, 0, 0.0, nullptr, it_function2->second);
+      return true;
+    }
+
+    return Fail("unknown function " + identifier);
+  }
+
+  void FormulaProgram::SkipWhitespace() {
+    while (position_ < expression_.size() && std::isspace(static_cast<unsigned char>(expression_[position_]))) ++position_;
+  }
+
+  bool FormulaProgram::Consume(const std::string& token) {
+    SkipWhitespace();
+    if (expression_.compare(position_, token.size(), token) == 0) {
+      position_ += token.size();
+      return true;
+    }
+    return false;
+  }
+
+  bool FormulaProgram::Fail(const std::string& message) {
+    if (error_.size() == 0) {
+      error_ = message + " at position " + std::to_string(position_) + " in \"" + expression_ + "\"";
+    }
+    program_.clear();
+    return false;
+  }
+
+  void FormulaProgram::Emit(OpCode op, int index, double constant, Function1 function1, Function2 function2) {
+    Instruction instruction;
+    instruction.op        = op;
+    instruction.index     = index;
+    instruction.constant  = constant;
+    instruction.function1 = function1;
+    instruction.function2 = function2;
+    program_.push_back(instruction);
+  }
+} // namespace toy
+} // namespace doofit
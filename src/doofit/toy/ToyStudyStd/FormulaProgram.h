@@ -0,0 +1,126 @@
+#ifndef FORMULAPROGRAM_h
+#define FORMULAPROGRAM_h
+
+// STL
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  /** @class FormulaProgram
+   *  @brief Formula expression compiled into a compact stack program
+   *
+   *  Parses a formula expression (as used by RooFormulaVar/TFormula) once and
+   *  compiles it into a postfix program operating on variable indices. The
+   *  program is then evaluated for each set of values without any string
+   *  parsing or RooFit overhead.
+   *
+   *  Supported are numbers, variables (by name, as @a n or as x[@a n]), the
+   *  operators + - * / ^ ** (power), comparisons and logical && || ! (giving
+   *  1 or 0), parentheses, the constant pi and the functions sqrt, exp, log,
+   *  log10, sin, cos, tan, asin, acos, atan, sinh, cosh, tanh, abs/fabs,
+   *  pow, atan2, min, max and fmod. TMath:: variants (e.g. TMath::Sqrt,
+   *  TMath::Power, TMath::Pi()) are accepted as well.
+   */
+  class FormulaProgram {
+   public:
+    FormulaProgram();
+
+    /**
+     *  @brief Compile an expression
+     *
+     *  @param expression the formula expression
+     *  @param variables names of variables (index in this vector is the variable index)
+     *  @return true if successful (otherwise see error())
+     */
+    bool Compile(const std::string& expression, const std::vector<std::string>& variables);
+
+    /**
+     *  @brief Evaluate for one set of values
+     *
+     *  @param values one value per variable
+     *  @return value of the formula
+     */
+    double Evaluate(const double* values) const;
+
+    bool compiled() const { return compiled_; }
+    const std::string& error() const { return error_; }
+    const std::vector<std::string>& variables() const { return variables_; }
+
+   private:
+    enum OpCode {
+      kConstant,
+      kVariable,
+      kAdd,
+      kSubtract,
+      kMultiply,
+      kDivide,
+      kPower,
+      kNegate,
+      kNot,
+      kLess,
+      kLessEqual,
+      kGreater,
+      kGreaterEqual,
+      kEqual,
+      kNotEqual,
+      kAnd,
+      kOr,
+      kFunction1,
+      kFunction2
+    };
+
+    typedef double (*Function1)(double);
+    typedef double (*Function2)(double, double);
+
+    struct Instruction {
+      OpCode op;
+      int index;
+      double constant;
+      Function1 function1;
+      Function2 function2;
+    };
+
+    /** @name Recursive descent parser
+     *  Each function parses one precedence level and emits instructions.
+     */
+    ///@{
+    bool ParseOr();
+    bool ParseAnd();
+    bool ParseComparison();
+    bool ParseAdditive();
+    bool ParseMultiplicative();
+    bool ParseUnary();
+    bool ParsePower();
+    bool ParsePrimary();
+    bool ParseIdentifier(const std::string& identifier);
+    ///@}
+
+    void SkipWhitespace();
+    bool Consume(const std::string& token);
+    bool Fail(const std::string& message);
+    void Emit(OpCode op, int index=0, double constant=0.0, Function1 function1=nullptr, Function2 function2=nullptr);
+
+    static double Apply(OpCode op, double a, double b, const Instruction& instruction);
+
+    std::vector<std::string> variables_;
+    std::vector<Instruction> program_;
+    std::size_t max_stack_;
+    bool compiled_;
+    std::string error_;
+
+    // parser state
+    std::string expression_;
+    std::size_t position_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // FORMULAPROGRAM_h
@@ -0,0 +1,264 @@
+#include "doofit/toy/ToyStudyStd/OnlineAccumulators.h"
+
+// STL
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// ROOT
+#include "TH1D.h"
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  OnlineMoments::OnlineMoments() :
+  count_(0),
+  mean_(0.0),
+  m2_(0.0),
+  min_(std::numeric_limits<double>::max()),
+  max_(-std::numeric_limits<double>::max())
+  {}
+
+  void OnlineMoments::Add(double x) {
+    ++count_;
+    double delta = x - mean_;
+    mean_ += delta/static_cast<double>(count_);
+    m2_   += delta*(x - mean_);
+
+    if (x < min_) min_ = x;
+    if (x > max_) max_ = x;
+  }
+
+  double OnlineMoments::stddev() const {
+    return std::sqrt(variance());
+  }
+
+  double OnlineMoments::error_mean() const {
+    return count_ > 0 ? stddev()/std::sqrt(static_cast<double>(count_)) : 0.0;
+  }
+
+  P2Quantile::P2Quantile(double p) :
+  p_(p),
+  count_(0)
+  {
+    for (int i=0; i<5; ++i) {
+      heights_[i] = 0.0;
+      positions_[i] = i+1;
+    }
+    positions_desired_[0] = 1.0;
+    positions_desired_[1] = 1.0 + 2.0*p_;
+    positions_desired_[2] = 1.0 + 4.0*p_;
+    positions_desired_[3] = 3.0 + 2.0*p_;
+    positions_desired_[4] = 5.0;
+    increments_[0] = 0.0;
+    increments_[1] = p_/2.0;
+    increments_[2] = p_;
+    increments_[3] = (1.0+p_)/2.0;
+    increments_[4] = 1.0;
+  }
+
+  void P2Quantile::Add(double x) {
+    if (count_ < 5) {
+      heights_[count_++] = x;
+      if (count_ == 5) {
+        std::sort(heights_, heights_+5);
+      }
+      return;
+    }
+    ++count_;
+
+    // find cell k with heights_[k] <= x < heights_[k+1] and adjust extremes
+    int k = 0;
+    if (x < heights_[0]) {
+      heights_[0] = x;
+      k = 0;
+    } else if (x >= heights_[4]) {
+      heights_[4] = x;
+      k = 3;
+    } else {
+      k = 0;
+      while (k < 3 && x >= heights_[k+1]) ++k;
+    }
+
+    for (int i=k+1; i<5; ++i) {
+      positions_[i] += 1.0;
+    }
+    for (int i=0; i<5; ++i) {
+      positions_desired_[i] += increments_[i];
+    }
+
+    // adjust heights of inner markers if necessary
+    for (int i=1; i<4; ++i) {
+      double d = positions_desired_[i] - positions_[i];
+      if ((d >=  1.0 && positions_[i+1] - positions_[i] >  1.0) ||
+          (d <= -1.0 && positions_[i-1] - positions_[i] < -1.0)) {
+        int sign = d > 0.0 ? 1 : -1;
+        double height = Parabolic(i, sign);
+        if (heights_[i-1] < height && height < heights_[i+1]) {
+          heights_[i] = height;
+        } else {
+          heights_[i] = Linear(i, sign);
+        }
+        positions_[i] += sign;
+      }
+    }
+  }
+
+  double P2Quantile::Value() const {
+    if (count_ == 0) {
+      return 0.0;
+    } else if (count_ < 5) {
+      std::vector<double> values(heights_, heights_+count_);
+      std::sort(values.begin(), values.end());
+      double position = p_*(values.size()-1);
+      std::size_t index = static_cast<std::size_t>(position);
+      if (index+1 >= values.size()) return values.back();
+      return values[index] + (position-index)*(values[index+1]-values[index]);
+    } else {
+      return heights_[2];
+    }
+  }
+
+  double P2Quantile::Parabolic(int i, double d) const {
+    return heights_[i] + d/(positions_[i+1] - positions_[i-1]) * 
+           ((positions_[i] - positions_[i-1] + d)*(heights_[i+1] - heights_[i])/(positions_[i+1] - positions_[i]) + 
+            (positions_[i+1] - positions_[i] - d)*(heights_[i] - heights_[i-1])/(positions_[i] - positions_[i-1]));
+  }
+
+  double P2Quantile::Linear(int i, int d) const {
+    return heights_[i] + d*(heights_[i+d] - heights_[i])/(positions_[i+d] - positions_[i]);
+  }
+
+  OnlineHistogram::OnlineHistogram(unsigned int num_bins, unsigned int num_warmup) :
+  num_bins_(std::max(num_bins, 1u)),
+  num_warmup_(num_warmup),
+  frozen_(false),
+  min_(0.0),
+  max_(0.0),
+  buffer_(),
+  bins_(),
+  underflow_(0),
+  overflow_(0)
+  {}
+
+  void OnlineHistogram::Add(double x) {
+    if (frozen_) {
+      Fill(x);
+    } else {
+      buffer_.push_back(x);
+      if (buffer_.size() >= num_warmup_) {
+        Freeze();
+      }
+    }
+  }
+
+  void OnlineHistogram::Freeze() {
+    if (frozen_) return;
+
+    if (buffer_.size() > 0) {
+      std::vector<double> sorted(buffer_);
+      std::sort(sorted.begin(), sorted.end());
+      double lo = sorted[static_cast<std::size_t>(0.001*(sorted.size()-1))];
+      double hi = sorted[static_cast<std::size_t>(0.999*(sorted.size()-1))];
+      double width = hi - lo;
+      if (width <= 0.0) {
+        width = std::max(std::abs(lo)*0.1, 1e-9);
+      }
+      // leave room for values beyond the warm-up range
+      min_ = lo - width;
+      max_ = hi + width;
+    } else {
+      min_ = -1.0;
+      max_ = +1.0;
+    }
+
+    bins_.assign(num_bins_, 0);
+    frozen_ = true;
+    for (auto x : buffer_) {
+      Fill(x);
+    }
+    std::vector<double>().swap(buffer_);
+  }
+
+  void OnlineHistogram::Fill(double x) {
+    if (x < min_) {
+      ++underflow_;
+    } else if (x >= max_) {
+      ++overflow_;
+    } else {
+      std::size_t bin = static_cast<std::size_t>((x - min_)/(max_ - min_)*num_bins_);
+      if (bin >= num_bins_) bin = num_bins_-1;
+      ++bins_[bin];
+    }
+  }
+
+  TH1D* OnlineHistogram::CreateHistogram(const std::string& name, const std::string& title, double min, double max, unsigned int num_bins_max) {
+    Freeze();
+
+    double width_bin = (max_ - min_)/num_bins_;
+    int bin_lo = std::max(0, static_cast<int>(std::floor((min - min_)/width_bin)));
+    int bin_hi = std::min(static_cast<int>(num_bins_), static_cast<int>(std::ceil((max - min_)/width_bin)));
+    if (bin_hi <= bin_lo) {
+      bin_lo = 0;
+      bin_hi = num_bins_;
+    }
+
+    // merge fine bins to not exceed num_bins_max
+    int num_merge = (bin_hi - bin_lo + num_bins_max - 1)/std::max(num_bins_max, 1u);
+    if (num_merge < 1) num_merge = 1;
+    int num_bins_new = (bin_hi - bin_lo + num_merge - 1)/num_merge;
+    bin_hi = std::min(static_cast<int>(num_bins_), bin_lo + num_bins_new*num_merge);
+    num_bins_new = (bin_hi - bin_lo + num_merge - 1)/num_merge;
+
+    TH1D* hist = new TH1D(name.c_str(), title.c_str(), num_bins_new, min_ + bin_lo*width_bin, min_ + (bin_lo + num_bins_new*num_merge)*width_bin);
+    hist->SetDirectory(nullptr);
+    for (int i=bin_lo; i<bin_hi; ++i) {
+      int bin_new = (i-bin_lo)/num_merge + 1;
+      hist->SetBinContent(bin_new, hist->GetBinContent(bin_new) + bins_[i]);
+    }
+    for (int i=1; i<=num_bins_new; ++i) {
+      hist->SetBinError(i, std::sqrt(hist->GetBinContent(i)));
+    }
+    return hist;
+  }
+
+  OnlineParameterAccumulator::OnlineParameterAccumulator(const std::string& name, const std::string& title) :
+  name_(name),
+  title_(title),
+  moments_(),
+  median_(0.5),
+  quantile_low_(0.15865),
+  quantile_high_(0.84135),
+  histogram_()
+  {}
+
+  void OnlineParameterAccumulator::Add(double x) {
+    moments_.Add(x);
+    median_.Add(x);
+    quantile_low_.Add(x);
+    quantile_high_.Add(x);
+    histogram_.Add(x);
+  }
+
+  std::pair<double,double> OnlineParameterAccumulator::QuantileWindow() const {
+    double lo = quantile_low();
+    double hi = quantile_high();
+    double med = median();
+
+    // roughly +-4 sigma for a Gaussian distribution
+    std::pair<double,double> window(lo - 3.0*(med-lo), hi + 3.0*(hi-med));
+    if (window.second <= window.first) {
+      window.first  = moments_.min();
+      window.second = moments_.max();
+    }
+    if (window.second <= window.first) {
+      window.first  -= 1.0;
+      window.second += 1.0;
+    }
+    return window;
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,201 @@
+#ifndef ONLINEACCUMULATORS_h
+#define ONLINEACCUMULATORS_h
+
+// STL
+#include <string>
+#include <vector>
+#include <utility>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class TH1D;
+
+namespace doofit {
+namespace toy {
+  /** @class OnlineMoments
+   *  @brief Numerically stable running mean and variance (Welford's algorithm)
+   *
+   *  Keeps count, mean, sum of squared deviations, minimum and maximum of all
+   *  added values in constant memory.
+   */
+  class OnlineMoments {
+   public:
+    OnlineMoments();
+
+    /**
+     *  @brief Add a value
+     */
+    void Add(double x);
+
+    unsigned long long count() const { return count_; }
+    double mean() const { return mean_; }
+    double variance() const { return count_ > 1 ? m2_/static_cast<double>(count_-1) : 0.0; }
+    double stddev() const;
+    double error_mean() const;
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+   private:
+    unsigned long long count_;
+    double mean_;
+    double m2_;
+    double min_;
+    double max_;
+  };
+
+  /** @class P2Quantile
+   *  @brief Running estimate of a single quantile (P-square algorithm)
+   *
+   *  Estimates the @a p quantile without storing values, following R. Jain and
+   *  I. Chlamtac, Communications of the ACM 28 (1985) 1076. Five markers are
+   *  kept and adjusted via piecewise-parabolic interpolation. For less than
+   *  five values the exact quantile is returned.
+   */
+  class P2Quantile {
+   public:
+    /**
+     *  @brief Constructor for P2Quantile
+     *
+     *  @param p quantile to estimate (0 < p < 1)
+     */
+    P2Quantile(double p=0.5);
+
+    /**
+     *  @brief Add a value
+     */
+    void Add(double x);
+
+    /**
+     *  @brief Current estimate of the quantile
+     */
+    double Value() const;
+
+    double p() const { return p_; }
+
+   private:
+    double Parabolic(int i, double d) const;
+    double Linear(int i, int d) const;
+
+    double p_;
+    unsigned long long count_;
+    double heights_[5];
+    double positions_[5];
+    double positions_desired_[5];
+    double increments_[5];
+  };
+
+  /** @class OnlineHistogram
+   *  @brief Fixed-bin histogram with automatic range
+   *
+   *  The first @a num_warmup values are buffered to determine a sensible
+   *  range. Afterwards the range is fixed and values are only counted into
+   *  bins (or under-/overflow), i.e. memory does not grow with the number of
+   *  values.
+   */
+  class OnlineHistogram {
+   public:
+    /**
+     *  @brief Constructor for OnlineHistogram
+     *
+     *  @param num_bins number of bins
+     *  @param num_warmup number of values to buffer for range determination
+     */
+    OnlineHistogram(unsigned int num_bins=500, unsigned int num_warmup=1000);
+
+    /**
+     *  @brief Add a value
+     */
+    void Add(double x);
+
+    /**
+     *  @brief Fix range and move buffered values into bins
+     *
+     *  Called automatically after @a num_warmup values.
+     */
+    void Freeze();
+
+    /**
+     *  @brief Create a ROOT histogram (ownership is transferred to caller)
+     *
+     *  @param name name of histogram
+     *  @param title title of histogram
+     *  @param min lower edge of requested window (will be aligned to bins)
+     *  @param max upper edge of requested window (will be aligned to bins)
+     *  @param num_bins_max maximum number of bins in created histogram
+     */
+    TH1D* CreateHistogram(const std::string& name, const std::string& title, double min, double max, unsigned int num_bins_max=100);
+
+    double range_min() const { return min_; }
+    double range_max() const { return max_; }
+    unsigned long long underflow() const { return underflow_; }
+    unsigned long long overflow() const { return overflow_; }
+
+   private:
+    void Fill(double x);
+
+    unsigned int num_bins_;
+    unsigned int num_warmup_;
+    bool frozen_;
+    double min_;
+    double max_;
+    std::vector<double> buffer_;
+    std::vector<unsigned long long> bins_;
+    unsigned long long underflow_;
+    unsigned long long overflow_;
+  };
+
+  /** @class OnlineParameterAccumulator
+   *  @brief Bounded-memory summary of one evaluated toy study variable
+   *
+   *  Combines OnlineMoments, P2Quantile estimates of median and the
+   *  quantiles for a symmetric 68.27% interval and an OnlineHistogram for
+   *  one evaluated variable (parameter, pull, residual, ...).
+   */
+  class OnlineParameterAccumulator {
+   public:
+    OnlineParameterAccumulator(const std::string& name="", const std::string& title="");
+
+    /**
+     *  @brief Add a value
+     */
+    void Add(double x);
+
+    const std::string& name() const { return name_; }
+    const std::string& title() const { return title_; }
+    const OnlineMoments& moments() const { return moments_; }
+    double median() const { return median_.Value(); }
+    double quantile_low() const { return quantile_low_.Value(); }
+    double quantile_high() const { return quantile_high_.Value(); }
+    OnlineHistogram& histogram() { return histogram_; }
+
+    /**
+     *  @brief Quantile based window for fitting and plotting
+     *
+     *  The window extends the central 68.27% interval by three times the
+     *  distance between its limits and the median on each side (i.e. roughly
+     *  +-4 sigma for a Gaussian distribution). As quantiles are estimated,
+     *  this only approximates ColumnStatistics::MedianLimits() used in the 
+     *  non-streaming evaluation, which needs all values.
+     *
+     *  @return pair of lower and upper limit
+     */
+    std::pair<double,double> QuantileWindow() const;
+
+   private:
+    std::string name_;
+    std::string title_;
+    OnlineMoments moments_;
+    P2Quantile median_;
+    P2Quantile quantile_low_;
+    P2Quantile quantile_high_;
+    OnlineHistogram histogram_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // ONLINEACCUMULATORS_h
@@ -0,0 +1,223 @@
+#include "doofit/toy/ToyStudyStd/ResultSetManifest.h"
+
+// STL
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// boost
+#include "boost/filesystem.hpp"
+
+// ROOT
+#include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+
+// from RooFit
+
+// from DooCore
+#include "doocore/io/MsgStream.h"
+
+// from project
+#include "doofit/toy/ToyStudyStd/FitResultColumns.h"
+
+using namespace doocore::io;
+
+namespace doofit {
+namespace toy {
+  namespace fs = boost::filesystem;
+
+  const std::string ResultSetManifest::kFormatRooFitResult  = "RooFitResult";
+  const std::string ResultSetManifest::kFormatColumnar      = "Columnar";
+  const std::string ResultSetManifest::kFormatEasyFitResult = "EasyFitResult";
+  const std::string ResultSetManifest::kFormatUnknown       = "Unknown";
+
+  ResultSetManifest::ResultSetManifest(const std::string& filename) :
+  manifest_filename_(ManifestFileName(filename))
+  {}
+
+  std::string ResultSetManifest::ResultSetFileName(const std::string& filename) {
+    // shards are named "<result file>.shard-<unique>.root" (see FitResultShards)
+    std::string::size_type pos = filename.rfind(".shard-");
+    if (pos != std::string::npos && pos > 0) {
+      return filename.substr(0, pos);
+    }
+    return filename;
+  }
+
+  bool ResultSetManifest::Load() {
+    entries_.clear();
+    index_.clear();
+
+    std::ifstream stream(manifest_filename_.c_str());
+    if (!stream.is_open()) {
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(stream, line)) {
+      if (line.size() == 0 || line[0] == '#') continue;
+
+      std::istringstream line_stream(line);
+      ResultManifestEntry entry;
+      std::string entries, file_size;
+      if (std::getline(line_stream, entry.file, '\t') &&
+          std::getline(line_stream, entry.tree, '\t') &&
+          std::getline(line_stream, entries, '\t') &&
+          std::getline(line_stream, entry.format, '\t') &&
+          std::getline(line_stream, entry.schema_hash, '\t') &&
+          std::getline(line_stream, file_size)) {
+        try {
+          entry.entries   = std::stoll(entries);
+          entry.file_size = std::stoll(file_size);
+          Set(entry);
+        } catch (const std::exception&) {
+          // ignore incomplete record (e.g. of a writer interrupted while appending)
+        }
+      }
+    }
+    return true;
+  }
+
+  bool ResultSetManifest::Append(const ResultManifestEntry& entry) {
+    Set(entry);
+
+    std::ostringstream record;
+    record << entry.file << '\t' << entry.tree << '\t' << entry.entries << '\t' << entry.format << '\t'
+           << entry.schema_hash << '\t' << entry.file_size << '\n';
+    const std::string record_string(record.str());
+
+    // single unbuffered append, so that concurrent writers do not interleave
+    FILE* file = std::fopen(manifest_filename_.c_str(), "a");
+    if (file == nullptr) {
+      return false;
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    bool success = std::fwrite(record_string.c_str(), 1, record_string.size(), file) == record_string.size();
+    success = (std::fclose(file) == 0) && success;
+    return success;
+  }
+
+  bool ResultSetManifest::Write() const {
+    std::string filename_tmp(fs::unique_path(manifest_filename_ + ".%%%%-%%%%.tmp").string());
+    {
+      std::ofstream stream(filename_tmp.c_str());
+      if (!stream.is_open()) {
+        serr << "Cannot write result manifest " << filename_tmp << endmsg;
+        return false;
+      }
+      stream << "# file\ttree\tentries\tformat\tschema_hash\tfile_size\n";
+      for (auto entry : entries_) {
+        stream << entry.file << '\t' << entry.tree << '\t' << entry.entries << '\t' << entry.format << '\t'
+               << entry.schema_hash << '\t' << entry.file_size << '\n';
+      }
+      if (!stream.good()) {
+        serr << "Cannot write result manifest " << filename_tmp << endmsg;
+        return false;
+      }
+    }
+
+    boost::system::error_code ec;
+    fs::rename(filename_tmp, manifest_filename_, ec);
+    if (ec) {
+      serr << "Cannot rename " << filename_tmp << " to " << manifest_filename_ << ": " << ec.message() << endmsg;
+      fs::remove(filename_tmp, ec);
+      return false;
+    }
+    return true;
+  }
+
+  void ResultSetManifest::Set(const ResultManifestEntry& entry) {
+    std::pair<std::string,std::string> key(entry.file, entry.tree);
+    std::map<std::pair<std::string,std::string>, std::size_t>::const_iterator it = index_.find(key);
+    if (it != index_.end()) {
+      entries_[it->second] = entry;
+    } else {
+      index_[key] = entries_.size();
+      entries_.push_back(entry);
+    }
+  }
+
+  void ResultSetManifest::Remove(const std::string& filename) {
+    const std::string name(fs::path(filename).filename().string());
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [&name](const ResultManifestEntry& entry) {
+      return entry.file == name;
+    }), entries_.end());
+
+    index_.clear();
+    for (std::size_t i=0; i<entries_.size(); ++i) {
+      index_[std::make_pair(entries_[i].file, entries_[i].tree)] = i;
+    }
+  }
+
+  const ResultManifestEntry* ResultSetManifest::Find(const std::string& filename, const std::string& treename) const {
+    std::map<std::pair<std::string,std::string>, std::size_t>::const_iterator it = index_.find(std::make_pair(fs::path(filename).filename().string(), treename));
+    if (it == index_.end()) {
+      return nullptr;
+    }
+
+    const ResultManifestEntry& entry = entries_[it->second];
+    if (entry.file_size >= 0 && entry.file_size == FileSize(filename)) {
+      return &entry;
+    } else {
+      return nullptr;
+    }
+  }
+
+  ResultManifestEntry ResultSetManifest::Describe(const std::string& filename, TTree& tree, const std::string& branch_name_result) {
+    ResultManifestEntry entry;
+    entry.file        = fs::path(filename).filename().string();
+    entry.tree        = tree.GetName();
+    entry.entries     = tree.GetEntries();
+    entry.schema_hash = SchemaHash(tree);
+    entry.file_size   = -1;
+
+    if (tree.GetBranch(branch_name_result.c_str()) != nullptr) {
+      entry.format = kFormatRooFitResult;
+    } else if (FitResultColumns::TreeHasColumns(tree, branch_name_result + "_")) {
+      entry.format = kFormatColumnar;
+    } else if (tree.GetBranch("fr0_fcn") != nullptr) {
+      entry.format = kFormatEasyFitResult;
+    } else {
+      entry.format = kFormatUnknown;
+    }
+    return entry;
+  }
+
+  std::string ResultSetManifest::SchemaHash(TTree& tree) {
+    std::vector<std::string> descriptions;
+    TObjArray* branches = tree.GetListOfBranches();
+    if (branches != nullptr) {
+      for (int i=0; i<branches->GetEntriesFast(); ++i) {
+        TBranch* branch = dynamic_cast<TBranch*>(branches->At(i));
+        if (branch != nullptr) {
+          descriptions.push_back(std::string(branch->GetName()) + ":" + branch->GetTitle() + ":" + branch->GetClassName());
+        }
+      }
+    }
+    std::sort(descriptions.begin(), descriptions.end());
+
+    // 64 bit FNV-1a (stable across platforms and program runs)
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (auto description : descriptions) {
+      for (auto c : description + ";") {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+      }
+    }
+
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(buffer);
+  }
+
+  long long ResultSetManifest::FileSize(const std::string& filename) {
+    boost::system::error_code ec;
+    boost::uintmax_t size = fs::file_size(filename, ec);
+    if (ec) return -1;
+    return static_cast<long long>(size);
+  }
+} // namespace toy
+} // namespace doofit
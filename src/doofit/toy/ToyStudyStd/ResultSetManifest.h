@@ -0,0 +1,158 @@
+#ifndef RESULTSETMANIFEST_h
+#define RESULTSETMANIFEST_h
+
+// STL
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+// forward declarations
+class TTree;
+
+namespace doofit {
+namespace toy {
+  /** @struct ResultManifestEntry
+   *  @brief Description of one fit result tree in a ResultSetManifest
+   */
+  struct ResultManifestEntry {
+    /// name of the file (without directory, relative to the manifest)
+    std::string file;
+    /// name of the tree
+    std::string tree;
+    /// number of entries in the tree
+    long long entries;
+    /// storage format (ResultSetManifest::kFormatRooFitResult etc.)
+    std::string format;
+    /// hash of branch names and types of the tree
+    std::string schema_hash;
+    /// size of the file in bytes when this entry was written
+    long long file_size;
+  };
+
+  /** @class ResultSetManifest
+   *  @brief Sidecar manifest describing all files of a toy study result set
+   *
+   *  A result set consists of a result file and (in sharded mode) its shard
+   *  files (see FitResultShards). The manifest "<result file>.manifest" lists
+   *  file, tree, number of entries, storage format, schema hash and file size
+   *  for each of them, so that readers can plan their work without opening
+   *  any ROOT file.
+   *
+   *  The manifest is a plain text file with one tab-separated record per
+   *  line. New records are appended; for the same file and tree the last
+   *  record wins. Records are only trusted if the file size still matches,
+   *  i.e. files changed without updating the manifest are treated as unknown.
+   */
+  class ResultSetManifest {
+   public:
+    static const std::string kFormatRooFitResult;
+    static const std::string kFormatColumnar;
+    static const std::string kFormatEasyFitResult;
+    static const std::string kFormatUnknown;
+
+    /**
+     *  @brief Constructor for ResultSetManifest
+     *
+     *  @param filename name of the result file or of one of its shards
+     */
+    explicit ResultSetManifest(const std::string& filename);
+
+    /**
+     *  @brief Name of the manifest file for a result file
+     */
+    static std::string ManifestFileName(const std::string& filename) { return ResultSetFileName(filename) + ".manifest"; }
+
+    /**
+     *  @brief Name of the result file a (shard) file belongs to
+     *
+     *  @param filename name of a result or shard file
+     *  @return name of the result file
+     */
+    static std::string ResultSetFileName(const std::string& filename);
+
+    /**
+     *  @brief Load the manifest from disk
+     *
+     *  @return true if a manifest was found
+     */
+    bool Load();
+
+    /**
+     *  @brief Append a record to the manifest on disk (and in memory)
+     *
+     *  Each record is written as one line in a single append operation.
+     *
+     *  @param entry the record to append
+     *  @return true if successful
+     */
+    bool Append(const ResultManifestEntry& entry);
+
+    /**
+     *  @brief Rewrite the manifest with the current records
+     *
+     *  The manifest is written to a temporary file and renamed, superseded
+     *  records are dropped.
+     *
+     *  @return true if successful
+     */
+    bool Write() const;
+
+    /**
+     *  @brief Add or replace a record in memory
+     */
+    void Set(const ResultManifestEntry& entry);
+
+    /**
+     *  @brief Remove all records of a file in memory
+     */
+    void Remove(const std::string& filename);
+
+    /**
+     *  @brief Find a valid record for a file and tree
+     *
+     *  @param filename name of the file
+     *  @param treename name of the tree
+     *  @return pointer to record or nullptr if unknown or outdated
+     */
+    const ResultManifestEntry* Find(const std::string& filename, const std::string& treename) const;
+
+    /**
+     *  @brief Describe a fit result tree
+     *
+     *  The file size is not set, as the file is usually still open.
+     *
+     *  @param filename name of the file containing the tree
+     *  @param tree the tree to describe
+     *  @param branch_name_result name of the (first) fit result branch
+     *  @return record for the tree
+     */
+    static ResultManifestEntry Describe(const std::string& filename, TTree& tree, const std::string& branch_name_result);
+
+    /**
+     *  @brief Hash of names and types of all branches in a tree
+     */
+    static std::string SchemaHash(TTree& tree);
+
+    /**
+     *  @brief Size of a file in bytes (or -1 if not existing)
+     */
+    static long long FileSize(const std::string& filename);
+
+    const std::vector<ResultManifestEntry>& entries() const { return entries_; }
+
+   private:
+    std::string manifest_filename_;
+    std::vector<ResultManifestEntry> entries_;
+    std::map<std::pair<std::string,std::string>, std::size_t> index_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // RESULTSETMANIFEST_h
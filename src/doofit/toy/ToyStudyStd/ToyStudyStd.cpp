@@ -6,12 +6,19 @@
 #include <queue>
 #include <list>
 #include <csignal>
+#include <algorithm>
+#include <memory>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <cstring>
 
 // boost
 #include "boost/interprocess/sync/file_lock.hpp"
 #include "boost/filesystem.hpp"
 #include "boost/random/random_device.hpp"
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
 
@@ -19,16 +26,20 @@
 #include "TTree.h"
 #include "TFile.h"
 #include "TBranch.h"
+#include "TLeaf.h"
 #include "TMath.h"
 #include "TStopwatch.h"
 #include "TROOT.h"
 #include "TString.h"
 #include "TThread.h"
+#include "RVersion.h"
 #include "TCanvas.h"
 #include "TStopwatch.h"
 #include "TGraph.h"
 #include "TAxis.h"
 #include "TPaveText.h"
+#include "TH1D.h"
+#include "TF1.h"
 
 // from RooFit
 #include "RooFitResult.h"
@@ -36,6 +47,7 @@
 #include "RooDataSet.h"
 #include "RooRealVar.h"
 #include "RooGaussian.h"
+#include "RooFormulaVar.h"
 #include "RooPlot.h"
 
 // from DooCore
@@ -50,6 +62,11 @@
 #include "doofit/config/CommaSeparatedPair.h"
 #include "doofit/config/CommaSeparatedList.h"
 #include "doofit/toy/ToyStudyStd/ToyStudyStdConfig.h"
+#include "doofit/toy/ToyStudyStd/FitResultColumns.h"
+#include "doofit/toy/ToyStudyStd/FitResultShards.h"
+#include "doofit/toy/ToyStudyStd/TruncatedGaussianEstimator.h"
+#include "doofit/toy/ToyStudyStd/EasyFitResultPrefetcher.h"
+#include "doofit/tools/workers/ForkedWorkers.h"
 #include "doofit/plotting/Plot/PlotConfig.h"
 #include <doofit/fitter/easyfit/EasyFitResult.h>
 
@@ -61,6 +78,28 @@ namespace doofit {
 namespace toy {
   namespace fs = boost::filesystem;
   bool ToyStudyStd::abort_save_ = false;
+
+  namespace {
+    /**
+     *  @brief Whether the seed branch of a tree is an Int_t leaf (trees written before 64 bit seeds)
+     */
+    bool SeedBranchIsInt(TTree& tree) {
+      TLeaf* leaf = tree.GetLeaf("seed");
+      return leaf != NULL && std::string(leaf->GetTypeName()) == "Int_t";
+    }
+
+    /**
+     *  @brief Set the seed branch address according to the leaf type
+     */
+    void SetSeedBranchAddress(TTree& tree, Long64_t* seed, Int_t* seed_int) {
+      if (SeedBranchIsInt(tree)) {
+        swarn << "Tree " << tree.GetName() << " stores seeds as Int_t. Seeds are truncated to 32 bit." << endmsg;
+        tree.SetBranchAddress("seed", seed_int);
+      } else {
+        tree.SetBranchAddress("seed", seed);
+      }
+    }
+  }
   
   ToyStudyStd::ToyStudyStd(const config::CommonConfig& cfg_com, const ToyStudyStdConfig& cfg_tstudy, const doofit::plotting::PlotConfig& cfg_plot) :
   config_common_(cfg_com),
@@ -70,12 +109,16 @@ namespace toy {
   fit_results_bookkeep_(),
   evaluated_values_(NULL),
   accepting_fit_results_(true),
+  num_fit_results_pending_(0),
   reading_fit_results_(false),
   fit_results_read_queue_(),
-  file_tree_easyfit_(std::make_pair(nullptr, nullptr)),
+  fitresult_reader_next_file_(0),
+  fitresult_reader_active_(0),
+  fitresult_reader_background_(false),
+  results_stored_(0),
+  results_neglected_(0),
+  easyfit_prefetcher_(),
   num_easyfit_results_(0),
-  easyfit_result_0_(nullptr),
-  easyfit_result_1_(nullptr),
   debug_(false)
   {
     LockSaveFitResultMutex();
@@ -86,19 +129,17 @@ namespace toy {
   ToyStudyStd::~ToyStudyStd() {
     FinishFitResultSaving();
     reading_fit_results_ = false;
+    fitresult_reader_space_.notify_all();
     if (fitresult_reader_worker_.joinable()) fitresult_reader_worker_.join();
+    fitresult_reader_pool_.join_all();
     
     if (evaluated_values_ != NULL) delete evaluated_values_;
     for (std::vector<FitResultContainer>::const_iterator it_results = fit_results_bookkeep_.begin(); it_results != fit_results_bookkeep_.end(); ++it_results) {
       delete std::get<0>(*it_results);
       if (std::get<1>(*it_results) != NULL) delete std::get<1>(*it_results);
     }
-
-    if (easyfit_result_0_ != nullptr) {
-      delete easyfit_result_0_;
-    }
-    if (easyfit_result_1_ != nullptr) {
-      delete easyfit_result_1_;
+    for (auto fit_result : recycled_fit_results_) {
+      delete fit_result;
     }
   }
   
@@ -106,7 +147,7 @@ namespace toy {
                                    const RooFitResult* fit_result2,
                                    TStopwatch* stopwatch1,
                                    TStopwatch* stopwatch2,
-                                   int seed,
+                                   long long seed,
                                    int run_id) {
     if (!accepting_fit_results_) {
       serr << "No longer accepting fit results." << endmsg;
@@ -139,6 +180,7 @@ namespace toy {
         time_real2 = stopwatch2->RealTime();
       }
       
+      ++num_fit_results_pending_;
       fit_results_save_queue_.push(std::make_tuple(fit_result1_copy,
                                                    fit_result2_copy,
                                                    time_cpu1,
@@ -155,14 +197,75 @@ namespace toy {
       LockSaveFitResultMutex();
     }
   }
+
+  void ToyStudyStd::WaitForPendingFitResults(unsigned int max_pending) {
+    boost::mutex::scoped_lock lock(num_fit_results_pending_mutex_);
+    while (accepting_fit_results_ && num_fit_results_pending_ > max_pending) {
+      num_fit_results_pending_cond_.wait(lock);
+    }
+  }
   
+  long long ToyStudyStd::MergeFitResultShards() {
+    // make sure own shards are written completely
+    FinishFitResultSaving();
+
+    const std::string& filename = config_toystudy_.store_result_filename_treename().first();
+    const std::string& treename = config_toystudy_.store_result_filename_treename().second();
+    if (filename.size() == 0 || treename.size() == 0) {
+      serr << "No file and tree to merge fit result shards into are specified." << endmsg;
+      throw ExceptionCannotStoreFitResult();
+    }
+
+    return FitResultShards::Merge(filename, treename, config_toystudy_.fit_result1_branch_name(), config_toystudy_.result_manifest());
+  }
+
   void ToyStudyStd::ReadFitResults() {
     // stop saving if there are still deferred fit results to be saved.
     FinishFitResultSaving();
     
+    const std::vector<doofit::config::CommaSeparatedPair<std::string>>& results_files = config_toystudy_.read_results_filename_treename();
+    
+    sinfo.Ruler();
+    
+    if (results_files.size() == 0) {
+      serr << "No files to read fit results from are specified. Cannot read in." << endmsg;
+      throw ExceptionCannotReadFitResult();
+    }
+    
+    if (fit_results_.size() > 0) {
+      serr << "Reading in fit results while results are already stored. Empty stored fit results first." << endmsg;
+      throw ExceptionCannotReadFitResult();
+    }
+
+    // a previous parallel read might still be running
+    reading_fit_results_ = false;
+    fitresult_reader_space_.notify_all();
+    fitresult_reader_pool_.join_all();
+
+    results_stored_    = 0;
+    results_neglected_ = 0;
+    fitresult_reader_next_file_ = 0;
     reading_fit_results_ = true;
 
-    ReadFitResultWorker();
+    unsigned int num_threads = std::min<std::size_t>(std::max(config_toystudy_.num_threads_read(), 1), results_files.size());
+    PlanReadFitResults(num_threads > 1);
+
+    // in streaming evaluation a single reader also runs in the background, so
+    // that the bounded read queue keeps memory usage limited while evaluating
+    fitresult_reader_background_ = num_threads > 1 || config_toystudy_.evaluate_streaming();
+    if (fitresult_reader_background_) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+      ROOT::EnableThreadSafety();
+#endif
+      sinfo << "Reading fit results from " << results_files.size() << " files using " << num_threads << " reader thread(s)." << endmsg;
+
+      fitresult_reader_active_ = num_threads;
+      for (unsigned int i=0; i<num_threads; ++i) {
+        fitresult_reader_pool_.create_thread(boost::bind(&ToyStudyStd::ReadFitResultPoolWorker, this));
+      }
+    } else {
+      ReadFitResultWorker();
+    }
 
     // if (!fitresult_reader_worker_.joinable()) {
     //   fitresult_reader_worker_ = boost::thread(&ToyStudyStd::ReadFitResultWorker, this);
@@ -181,10 +284,13 @@ namespace toy {
     //   return fit_results;
     // } else {
       bool got_one = false;
-      // while (!got_one && (reading_fit_results_ || fit_results_read_queue_.size() > 0)) {
-      while (!got_one && (fit_results_read_queue_.size() > 0)) {
+      while (!got_one && (reading_fit_results_ || fit_results_read_queue_.size() > 0)) {
         got_one = fit_results_read_queue_.wait_and_pop(fit_results);
       }
+      if (got_one) {
+        // wake up parallel readers waiting for space in the queue
+        fitresult_reader_space_.notify_all();
+      }
 
       // std::cout << std::get<0>(fit_results) << std::endl;
       // std::cout << std::get<1>(fit_results) << std::endl;
@@ -201,6 +307,12 @@ namespace toy {
 
     if (num_easyfit_results_ == 0 && results_files_easyfit_.size() > 0) {
       for (auto file_tree : results_files_easyfit_) {
+        ResultManifestEntry manifest_entry;
+        if (FindResultManifestEntry(file_tree, manifest_entry)) {
+          num_easyfit_results_ += manifest_entry.entries;
+          continue;
+        }
+
         TFile file(file_tree.first().c_str(), "read");
         TTree* tree = dynamic_cast<TTree*>(file.Get(file_tree.second().c_str()));
         if (tree != nullptr) {
@@ -216,66 +328,30 @@ namespace toy {
     using namespace doofit::fitter::easyfit;
     using namespace doocore::io;
 
-    TFile*& file(file_tree_easyfit_.first);
-    TTree*& tree(file_tree_easyfit_.second);
+    // on demand start decoding of all EasyFitResult files in the background
+    if (!easyfit_prefetcher_ && results_files_easyfit_.size() > 0) {
+      NumberOfAvailableEasyFitResults();
 
-    if (file == nullptr && tree == nullptr && results_files_easyfit_.size() == 0) {
-      if (easyfit_result_0_ != nullptr) {
-        delete easyfit_result_0_;
-        easyfit_result_0_ = nullptr;
-      }
-      if (easyfit_result_1_ != nullptr) {
-        delete easyfit_result_1_;
-        easyfit_result_1_ = nullptr;
-      }
-      return std::make_tuple(easyfit_result_0_, easyfit_result_1_);
-    }
-
-    // on demand open new file
-    if (file == nullptr && tree == nullptr) {
-      while (file == nullptr && tree == nullptr) {
-        doofit::config::CommaSeparatedPair<std::string> file_tree = results_files_easyfit_.front();
-        results_files_easyfit_.pop_front();
+      std::vector<doofit::config::CommaSeparatedPair<std::string>> files_trees(results_files_easyfit_.begin(), results_files_easyfit_.end());
+      results_files_easyfit_.clear();
 
-        // sdebug << "Opening " << file_tree.first().c_str() << endmsg;
-        file = new TFile(file_tree.first().c_str(), "read");
-        tree = dynamic_cast<TTree*>(file->Get(file_tree.second().c_str()));
-      }
-
-      // sdebug << "Opened new file" << endmsg;
-      // sdebug << file_tree_easyfit_.first << endmsg;
-      // sdebug << file_tree_easyfit_.second << endmsg;
-
-      position_tree_easyfit_ = 0;
-      if (easyfit_result_0_ != nullptr) {
-        delete easyfit_result_0_;
-      }
-      if (easyfit_result_1_ != nullptr) {
-        delete easyfit_result_1_;
-      }
-
-      easyfit_result_0_ = new EasyFitResult(*tree, "fr0_");
-      easyfit_result_1_ = new EasyFitResult(*tree, "fr1_");
+      easyfit_prefetcher_.reset(new EasyFitResultPrefetcher(files_trees, config_toystudy_.easyfit_prefetch_size()));
+      easyfit_prefetcher_->Start();
     }
 
-    tree->GetEntry(position_tree_easyfit_);
-    --num_easyfit_results_;
-    ++position_tree_easyfit_;
-    
-    if (position_tree_easyfit_ == tree->GetEntries()) {
-      delete tree;
-      file->Close();
-      delete file;
-
-      tree = nullptr;
-      file = nullptr;
-
-      // sdebug << "Closing and releasing file" << endmsg;
-      // sdebug << file_tree_easyfit_.first << endmsg;
-      // sdebug << file_tree_easyfit_.second << endmsg;
+    const EasyFitResult* easyfit_result_0 = nullptr;
+    const EasyFitResult* easyfit_result_1 = nullptr;
+    if (easyfit_prefetcher_) {
+      if (easyfit_prefetcher_->Next(easyfit_result_0, easyfit_result_1)) {
+        if (num_easyfit_results_ > 0) --num_easyfit_results_;
+      } else {
+        // skipped files might have been counted
+        num_easyfit_results_ = 0;
+        easyfit_prefetcher_.reset();
+      }
     }
 
-    return std::make_tuple<const doofit::fitter::easyfit::EasyFitResult*,const doofit::fitter::easyfit::EasyFitResult*>(easyfit_result_0_, easyfit_result_1_);
+    return std::make_tuple(easyfit_result_0, easyfit_result_1);
   }
 
   
@@ -284,18 +360,40 @@ namespace toy {
   }
 
   void ToyStudyStd::PurgeReleasedFitResults() {
+    // deletion of RooFit objects must not interfere with parallel readers
+    boost::mutex::scoped_lock lock_roofit(fitresult_roofit_mutex_);
     while (fit_results_release_queue_.size() > 0) {
       const RooFitResult* dummy = nullptr;
       FitResultContainer fit_results(dummy,dummy,0.0,0.0,0.0,0.0,0,0);
       if (fit_results_release_queue_.wait_and_pop(fit_results)) {
         //sdebug << "Deleting fit results." << endmsg;
-        if (std::get<0>(fit_results) != nullptr) delete std::get<0>(fit_results);
-        if (std::get<1>(fit_results) != nullptr) delete std::get<1>(fit_results);
+        if (std::get<0>(fit_results) != nullptr) DisposeFitResult(std::get<0>(fit_results));
+        if (std::get<1>(fit_results) != nullptr) DisposeFitResult(std::get<1>(fit_results));
       }
     }
   }
+
+  void ToyStudyStd::DisposeFitResult(const RooFitResult* fit_result) {
+    if (FitResultColumns::Recyclable(*fit_result)) {
+      recycled_fit_results_.push_back(const_cast<RooFitResult*>(fit_result));
+    } else {
+      delete fit_result;
+    }
+  }
+
+  RooFitResult* ToyStudyStd::PopRecycledFitResult() {
+    if (recycled_fit_results_.empty()) return nullptr;
+    RooFitResult* fit_result = recycled_fit_results_.back();
+    recycled_fit_results_.pop_back();
+    return fit_result;
+  }
   
   void ToyStudyStd::EvaluateFitResults() {
+    if (config_toystudy_.evaluate_streaming()) {
+      EvaluateFitResultsStreaming();
+      return;
+    }
+
     const RooFitResult* dummy = nullptr;
     FitResultContainer fit_results(dummy, dummy, 0.0, 0.0, 0.0, 0.0, 0, 0);
     do {
@@ -305,9 +403,9 @@ namespace toy {
         fit_results_.push_back(fit_results);
         fit_results_bookkeep_.push_back(fit_results);
 
-        int seed = std::get<6>(fit_results);
+        long long seed = std::get<6>(fit_results);
         //if (seed != 0) {
-        fit_results_by_seed_.insert(std::pair<int,FitResultContainer>(seed, fit_results));
+        fit_results_by_seed_.insert(std::pair<long long,FitResultContainer>(seed, fit_results));
         //}
       }
     } while (std::get<0>(fit_results) != NULL);
@@ -382,6 +480,11 @@ namespace toy {
   }
   
   void ToyStudyStd::PlotEvaluatedParameters() {
+    if (evaluated_values_ == nullptr && evaluated_accumulators_.size() > 0) {
+      PlotEvaluatedParametersStreaming();
+      return;
+    }
+
     if (evaluated_values_ == nullptr || evaluated_values_->numEntries() <= 0) {
       serr << "Cannot plot as no fit results are evaluated." << endmsg;
       throw ExceptionCannotEvaluateFitResults();
@@ -390,23 +493,38 @@ namespace toy {
     sinfo.Ruler();
     sinfo << "Plotting parameter distributions." << endmsg;
     
-    gROOT->SetStyle("Plain");
-    doocore::lutils::setStyle("LHCbOptimized");
-    TCanvas canvas("canvas_toystudy", "canvas", 800, 600);
-    doocore::lutils::printPlotOpenStack(&canvas, "AllPlots", config_toystudy_.plot_directory());
-    
     const RooArgSet* parameters = evaluated_values_->get();
     int num_parameters          = parameters->getSize();
     TIterator* parameter_iter   = parameters->createIterator();
     RooRealVar* parameter       = NULL;
+
+    std::vector<RooRealVar*> parameter_list;
+    while ((parameter = (RooRealVar*)parameter_iter->Next())) {
+      parameter_list.push_back(parameter);
+    }
+    delete parameter_iter;
+
+    // fits and statistics of all parameters (possibly in parallel), plotting 
+    // is done afterwards in a fixed order
+    ColumnStatistics statistics;
+    PrepareColumnStatistics(parameter_list, statistics);
+
+    std::vector<ParameterDistribution> distributions;
+    EvaluateParameterDistributions(parameter_list, statistics, distributions);
+    
+    gROOT->SetStyle("Plain");
+    doocore::lutils::setStyle("LHCbOptimized");
+    TCanvas canvas("canvas_toystudy", "canvas", 800, 600);
+    doocore::lutils::printPlotOpenStack(&canvas, "AllPlots", config_toystudy_.plot_directory());
     
     using namespace doocore::io;
-    Progress p("Evaluating parameter distributions", num_parameters);
+    Progress p("Plotting parameter distributions", num_parameters);
     
     std::map<std::string, std::tuple<double, double, double, double>> parameter_cls;
 
-    while ((parameter = (RooRealVar*)parameter_iter->Next())) {
-      // std::chrono::high_resolution_clock::time_point time_start(std::chrono::high_resolution_clock::now());
+    for (unsigned int index_parameter=0; index_parameter<parameter_list.size(); ++index_parameter) {
+      parameter = parameter_list[index_parameter];
+      const ParameterDistribution& distribution = distributions[index_parameter];
 
       std::string param_name = parameter->GetName();
 
@@ -420,22 +538,12 @@ namespace toy {
         for (auto postfix_error : postfixes_error) {
           std::string name_error = param_name + postfix_error;
           const RooRealVar* error = dynamic_cast<const RooRealVar*>(parameters->find(name_error.c_str()));
-          if (error != nullptr) {
+          const std::vector<double>* values = statistics.Column(param_name);
+          const std::vector<double>* errors = statistics.Column(name_error);
+          if (error != nullptr && values != nullptr && errors != nullptr && values->size() > 0) {
             //sinfo << "Parameter " << param_name << " can be correlated against an error." << endmsg;
 
-            std::vector<double> values;
-            std::vector<double> errors;
-            values.reserve(evaluated_values_->numEntries());
-            errors.reserve(evaluated_values_->numEntries());
-
-            for (int i=0; i<evaluated_values_->numEntries(); ++i) {
-              const RooArgSet* params = evaluated_values_->get(i);
-              //sdebug << param_name << " - " << params->getRealValue(param_name.c_str()) << " +/- " << params->getRealValue(name_error.c_str()) << endmsg;
-              values.push_back(params->getRealValue(param_name.c_str()));
-              errors.push_back(params->getRealValue(name_error.c_str()));
-            }
-
-            TGraph graph_value_error(evaluated_values_->numEntries(), &values[0], &errors[0]);
+            TGraph graph_value_error(values->size(), &(*values)[0], &(*errors)[0]);
             TCanvas canvas("c", "c", 800, 600);
             graph_value_error.Draw("AP");
 
@@ -448,137 +556,24 @@ namespace toy {
         }
       }
 
-      // std::chrono::high_resolution_clock::time_point time_correlation(std::chrono::high_resolution_clock::now());      
-      // double duration_correlation(std::chrono::duration_cast<std::chrono::microseconds>(time_correlation - time_start).count());
-      // sdebug << "duration_correlation = " << duration_correlation*1e-3 << endmsg;
-
-      std::vector<std::string> ignore_for_cls{"_err",
-                                              "_lerr",
-                                              "_herr",
-                                              "_init",
-                                              "_res",
-                                              "_refresidual",
-                                              "_pull",
-                                              "minos_problems",
-                                              "parameters_at_limit"
-                                              };
-
-      std::pair<double,double> minmax = doocore::lutils::MedianLimitsForTuple(*evaluated_values_, param_name);
+      std::pair<double,double> minmax(distribution.limit_low, distribution.limit_high);
 
-      if (config_toystudy_.plot_on_full_range()) {
-        minmax = doocore::lutils::MinMaxLimitsForDataSet(*evaluated_values_, param_name);
+      if (distribution.has_cls) {
+        parameter_cls.insert(std::pair<std::string, std::tuple<double, double, double, double> >(param_name, std::make_tuple(distribution.cl_mean, distribution.cl_median, distribution.cl_low, distribution.cl_high)));
       }
-      
-      // std::chrono::high_resolution_clock::time_point time_sort(std::chrono::high_resolution_clock::now());      
-      // double duration_sort(std::chrono::duration_cast<std::chrono::microseconds>(time_sort - time_correlation).count());
-      // sdebug << "duration_sort = " << duration_sort*1e-3 << endmsg;
-
-      // if (param_name == "par_bssig_time_S_err") {
-      //   minmax.second = 2.3;
-      // }
 
-      // sinfo << "Plotting parameter " << param_name << " in range [" << minmax.first << "," << minmax.second << "]" << endmsg;
-            
-      RooRealVar* mean             = nullptr;
-      RooRealVar* sigma            = nullptr;
-      RooGaussian* gauss           = nullptr;
-      // RooPlot* param_frame         = nullptr;
-      RooDataSet* fit_plot_dataset = nullptr;
-      RooArgSet parameters_copy(*parameter);
-      int fit_status = 0;
-
-      TString cut = "";
-      if (config_toystudy_.fit_plot_on_quantile_window()) {
-        cut = param_name + ">" + boost::lexical_cast<std::string>(minmax.first) + "&&" + param_name + "<" + boost::lexical_cast<std::string>(minmax.second);
-      }
-      //sdebug << cut << endmsg;
-
-      // if (param_name == "par_bssig_time_S_pull") {
-      //   //cut = param_name + ">" + boost::lexical_cast<std::string>(minmax.first) + "&&" + param_name + "<0.75"; 
-      //   parameters_copy.add(*parameters->find("par_bssig_time_S_herr"));
-      //   cut = cut + "&&" + "par_bssig_time_S_herr<0.4";
-      // }
-      // parameters_copy.Print();
-      // sdebug << cut << endmsg;
-
-      if (config_toystudy_.neglect_parameters_at_limit()) {
-        if (cut.Length() > 0) cut = cut + "&&";
-        cut = cut + "parameters_at_limit < 0.5";
-        parameters_copy.add(*parameters->find("parameters_at_limit"));
-      }
-      if (config_toystudy_.neglect_minos_problems()) {
-        if (cut.Length() > 0) cut = cut + "&&";
-        cut = cut + "minos_problems < 0.5";
-        parameters_copy.add(*parameters->find("minos_problems"));
-      }
-      if (cut.Length() > 0) {
-        fit_plot_dataset = new RooDataSet("fit_plot_dataset", "Plotting and fitting dataset for ToyStudyStd", evaluated_values_, parameters_copy, cut);
-      } else {
-        fit_plot_dataset = evaluated_values_;
-      }
-
-      //CL calculation 
-      bool isparameteritself = true;
-      for(auto i : ignore_for_cls){
-        if (param_name.find(i) != std::string::npos)
-          isparameteritself = false;
-      }
-      if(isparameteritself){
-        std::vector<double> sorted_data(fit_plot_dataset->numEntries());
-        double mean = doocore::statistics::general::get_mean_from_dataset(fit_plot_dataset, param_name);
-        double median = doocore::statistics::general::get_median_from_dataset(fit_plot_dataset, param_name);
-        double CL_boundary_lo = doocore::statistics::general::get_quantile_from_dataset(fit_plot_dataset, param_name, 0.15865, sorted_data);
-        double CL_boundary_hi = doocore::statistics::general::get_quantile_from_dataset(sorted_data, 0.84135);
-
-        parameter_cls.insert(std::pair<std::string, std::tuple<double, double, double, double> >(param_name, std::make_tuple(mean, median, CL_boundary_lo,CL_boundary_hi)));
-      }
-
-      // std::chrono::high_resolution_clock::time_point time_prefit(std::chrono::high_resolution_clock::now());      
-      // double duration_prefit(std::chrono::duration_cast<std::chrono::microseconds>(time_prefit - time_sort).count());
-      // sdebug << "duration_prefit = " << duration_prefit*1e-3 << endmsg;
-
-      // for all pulls fit a gaussian
-      RooFitResult* fit_result = nullptr;
-      if (param_name.length() > 4 &&
-          (param_name.substr(param_name.length()-5).compare("_pull") == 0 ||
-           param_name.substr(param_name.length()-4).compare("_res") == 0 ||
-           param_name.substr(param_name.length()-4).compare("_err") == 0 ||
-           param_name.substr(param_name.length()-5).compare("_init") == 0 ||
-           (param_name.length() > 12 && param_name.substr(param_name.length()-12).compare("_refresidual") == 0))) {
-           // || param_name.substr(0,4).compare("time") == 0)) {
-        mean  = new RooRealVar("m", "mean of pull", (minmax.first+minmax.second)/2.0,minmax.first,minmax.second);
-        sigma = new RooRealVar("s", "sigma of pull", (minmax.second-minmax.first)/10.0,0,minmax.second-minmax.first);
-        gauss = new RooGaussian("pdf_pull", "Gaussian PDF of pull", *parameter, *mean, *sigma);
-        
+      if (distribution.has_fit) {
         sinfo.increment_indent(2);
-        //sinfo << "Fitting Gaussian distribution for parameter " << param_name << endmsg;
-        int num_lost_entries     = evaluated_values_->numEntries() - fit_plot_dataset->numEntries();
-        double frac_lost_entries = (evaluated_values_->numEntries() - fit_plot_dataset->numEntries())/static_cast<double>(evaluated_values_->numEntries())*100;
-        if (fit_plot_dataset != evaluated_values_ && frac_lost_entries>1.0) {
+        int num_lost_entries     = evaluated_values_->numEntries() - distribution.num_entries_fit;
+        double frac_lost_entries = num_lost_entries/static_cast<double>(evaluated_values_->numEntries())*100;
+        if (frac_lost_entries>1.0) {
           sinfo << "Losing " << num_lost_entries << " (" << frac_lost_entries << "%) toys for this fit due to cuts applied for " << param_name << "." << endmsg;
         }
-
-        // supress RooFit spam
-        RooMsgService::instance().setStreamStatus(0, false);
-        RooMsgService::instance().setStreamStatus(1, false);
-
-        int num_cores = std::max(fit_plot_dataset->numEntries() < 200 ? fit_plot_dataset->numEntries()/1000+1 : 1, 8);
-        //sdebug << fit_plot_dataset->numEntries() << " thus " << num_cores << " cores." << endmsg;
-        num_cores = 1;
-        fit_result = gauss->fitTo(*fit_plot_dataset, NumCPU(num_cores), Verbose(false), PrintLevel(-1), PrintEvalErrors(-1), Warnings(false), Save(true),  Minimizer("Minuit2","minimize"), Optimize(0));
-        fit_status = fit_result->statusCodeHistory(0);
-
-        // un-supress RooFit spam
-        RooMsgService::instance().setStreamStatus(0, true);
-        RooMsgService::instance().setStreamStatus(1, true);
-
-        //fit_result->Print("v");
         sinfo.increment_indent(-2);
       }
 
-      // std::chrono::high_resolution_clock::time_point time_postfit(std::chrono::high_resolution_clock::now());      
-      // double duration_postfit(std::chrono::duration_cast<std::chrono::microseconds>(time_postfit - time_prefit).count());
-      // sdebug << "duration_postfit = " << duration_postfit*1e-3 << endmsg;
+      RooArgSet parameters_copy(*parameter);
+      RooDataSet* fit_plot_dataset = CreateFitPlotDataset(*parameter, minmax, parameters_copy);
       
       int num_bins = fit_plot_dataset->numEntries() < 1000 ? fit_plot_dataset->numEntries()/10 : 100;
       if (num_bins < 10) num_bins = 10;
@@ -586,82 +581,51 @@ namespace toy {
       
       RooPlot* frame = parameter->frame(Range(minmax.first,minmax.second));
 
-      if (config_toystudy_.plot_symmetric_around_mean() && gauss != nullptr /* && param_name.substr(0,4).compare("time") != 0 */) {
+      if (config_toystudy_.plot_symmetric_around_mean() && distribution.has_fit && distribution.fit_status == 0 /* && param_name.substr(0,4).compare("time") != 0 */) {
         // Define plot range symmetrical around mean of Gaussian fit
-        double range_limit = std::max(mean->getVal() - minmax.first, minmax.second - mean->getVal());
-        minmax.first = mean->getVal() - range_limit;
-        minmax.second = mean->getVal() + range_limit;
-        frame = parameter->frame(Range(mean->getVal() - range_limit, mean->getVal() + range_limit));
+        double range_limit = std::max(distribution.fit_mean - minmax.first, minmax.second - distribution.fit_mean);
+        minmax.first = distribution.fit_mean - range_limit;
+        minmax.second = distribution.fit_mean + range_limit;
+        delete frame;
+        frame = parameter->frame(Range(distribution.fit_mean - range_limit, distribution.fit_mean + range_limit));
       }
 
       fit_plot_dataset->plotOn(frame);
       if (fit_plot_dataset != evaluated_values_) delete fit_plot_dataset;
-      
-      // get fit pars
-      RooRealVar* var_mean = nullptr;
-      RooRealVar* var_sigma = nullptr;
 
       // only plot the fit gauss for init distributions for constrained parameters
       // in the next line we check if the width of the gaussian is wide enough,
       // if not, then set bool to false.
       bool plot_gauss_pdf_for_init_distributions = true;
-      if (gauss != NULL && fit_status == 0){
-        const RooArgList& list_fit_params(fit_result->floatParsFinal());
-        var_mean  = dynamic_cast<RooRealVar*>(list_fit_params.find("m"));
-        var_sigma = dynamic_cast<RooRealVar*>(list_fit_params.find("s"));
-        if (var_sigma->getVal()<1e-6) plot_gauss_pdf_for_init_distributions = false;
+      if (distribution.has_fit && distribution.fit_status == 0){
+        if (distribution.fit_sigma<1e-6) plot_gauss_pdf_for_init_distributions = false;
       }
 
       TPaveText* pt = nullptr;
-      if (gauss != NULL && fit_status == 0) {
+      if (distribution.has_fit && distribution.fit_status == 0) {
         // sdebug << config_plot_.GetPdfLineColor(1) << endmsg;
 
-        if (plot_gauss_pdf_for_init_distributions) gauss->plotOn(frame, LineColor(config_plot_.GetPdfLineColor(1)));
-        //param_frame = gauss->paramOn(frame, Layout(0.6, 0.9, 0.9));
-
-        using namespace doocore::statistics::general;
-        ValueWithError<double> val_mean(var_mean->getVal(), var_mean->getError());
-        ValueWithError<double> val_sigma(var_sigma->getVal(), var_sigma->getError());
-
-        pt = new TPaveText(0.57, 0.77, 0.92, 0.92, "NB NDC");
-        pt->SetFillColor(kWhite);
-        //pt->SetOption("NB");
-        pt->SetTextAlign(12);
-        pt->SetBorderSize(1);
-        pt->SetMargin(0.05);
-        pt->SetTextFont(133);
-        pt->SetTextSize(30);
-
-        std::string str_mean("m = ");
-        str_mean += val_mean.FormatStringTLatex();
-        std::string str_sigma("s = ");
-        str_sigma += val_sigma.FormatStringTLatex();
-
-        if (param_name.length() > 4 &&
-          (param_name.substr(param_name.length()-5).compare("_pull") == 0)) {
-          double pull_mean(val_mean.value/val_mean.error);
-          double pull_sigma((val_sigma.value-1.0)/val_sigma.error);
+        if (plot_gauss_pdf_for_init_distributions) {
+          RooRealVar mean("m", "mean of pull", distribution.fit_mean);
+          RooRealVar sigma("s", "sigma of pull", distribution.fit_sigma);
+          RooGaussian gauss("pdf_pull", "Gaussian PDF of pull", *parameter, mean, sigma);
 
-          std::stringstream sstr_pull_mean;
-          sstr_pull_mean << std::setprecision(2) << std::fixed << pull_mean;
-          std::stringstream sstr_pull_sigma;
-          sstr_pull_sigma << std::setprecision(2) << std::fixed << pull_sigma;
-
-          str_mean  += " (" + sstr_pull_mean.str()  + "#kern[0.3]{#sigma})";
-          str_sigma += " (" + sstr_pull_sigma.str() + "#kern[0.3]{#sigma})";
-
-          boost::replace_all(str_mean,  "-", "#minus");
-          boost::replace_all(str_sigma, "-", "#minus");
-
-          pt->SetX1(0.46);
+          // Gaussian was estimated on the fit window only, scale accordingly
+          double content_window = 1.0;
+          if (distribution.fit_truncated) {
+            content_window = TMath::Freq((distribution.limit_high-distribution.fit_mean)/distribution.fit_sigma) - 
+                             TMath::Freq((distribution.limit_low-distribution.fit_mean)/distribution.fit_sigma);
+          }
+          if (content_window > 0.0) {
+            gauss.plotOn(frame, LineColor(config_plot_.GetPdfLineColor(1)), Normalization(1.0/content_window, RooAbsReal::Relative));
+          }
         }
 
-        pt->AddText(str_mean.c_str());
-        pt->AddText(str_sigma.c_str());
+        pt = CreateGaussianFitText(param_name, distribution.fit_mean, distribution.fit_mean_error, distribution.fit_sigma, distribution.fit_sigma_error);
 
         frame->SetMaximum(frame->GetMaximum()*1.3);
 
-      } else if (fit_status != 0) {
+      } else if (distribution.has_fit) {
         swarn << "ToyStudyStd::PlotEvaluatedParameters(): Gaussian fit for " << parameter->GetName() << " failed. Will not plot." << endmsg;
       }
       frame->Draw();
@@ -688,26 +652,12 @@ namespace toy {
       doocore::lutils::printPlot(&canvas, plot_name, config_toystudy_.plot_directory(), true);
       doocore::lutils::printPlot(&canvas, "AllPlots", config_toystudy_.plot_directory(), true);
       
-      if (fit_result != nullptr) {
-        delete fit_result;
-      }
       if (pt != nullptr) {
         delete pt;
       }
 
       delete frame;
       
-      if (gauss != NULL) {
-        //delete param_frame;
-        delete gauss;
-        delete sigma;
-        delete mean;
-      }
-
-      // std::chrono::high_resolution_clock::time_point time_plotvars(std::chrono::high_resolution_clock::now());      
-      // double duration_plotvars(std::chrono::duration_cast<std::chrono::microseconds>(time_plotvars - time_correlation).count());
-      // sdebug << "duration_plotvars = " << duration_plotvars*1e-3 << endmsg;
-      
       ++p;
     }
     p.Finish();
@@ -715,6 +665,267 @@ namespace toy {
     doocore::lutils::printPlotCloseStack(&canvas, "AllPlots", config_toystudy_.plot_directory());
     sinfo.Ruler();
 
+    PrintQuantileEstimates(parameter_cls);
+  }
+
+  RooDataSet* ToyStudyStd::CreateFitPlotDataset(const RooRealVar& parameter, const std::pair<double,double>& minmax, RooArgSet& parameters_copy) const {
+    const RooArgSet* parameters = evaluated_values_->get();
+    std::string param_name = parameter.GetName();
+
+    TString cut = "";
+    if (config_toystudy_.fit_plot_on_quantile_window()) {
+      cut = param_name + ">" + boost::lexical_cast<std::string>(minmax.first) + "&&" + param_name + "<" + boost::lexical_cast<std::string>(minmax.second);
+    }
+    //sdebug << cut << endmsg;
+
+    if (config_toystudy_.neglect_parameters_at_limit()) {
+      if (cut.Length() > 0) cut = cut + "&&";
+      cut = cut + "parameters_at_limit < 0.5";
+      parameters_copy.add(*parameters->find("parameters_at_limit"));
+    }
+    if (config_toystudy_.neglect_minos_problems()) {
+      if (cut.Length() > 0) cut = cut + "&&";
+      cut = cut + "minos_problems < 0.5";
+      parameters_copy.add(*parameters->find("minos_problems"));
+    }
+    if (cut.Length() > 0) {
+      return new RooDataSet("fit_plot_dataset", "Plotting and fitting dataset for ToyStudyStd", evaluated_values_, parameters_copy, cut);
+    } else {
+      return evaluated_values_;
+    }
+  }
+
+  void ToyStudyStd::PrepareColumnStatistics(const std::vector<RooRealVar*>& parameters, ColumnStatistics& statistics) const {
+    std::vector<std::string> columns;
+    for (auto parameter : parameters) {
+      columns.push_back(parameter->GetName());
+    }
+    columns.push_back("parameters_at_limit");
+    columns.push_back("minos_problems");
+    statistics.Extract(*evaluated_values_, columns);
+
+    std::vector<bool> selection(statistics.num_rows(), true);
+    const std::vector<double>* parameters_at_limit = statistics.Column("parameters_at_limit");
+    const std::vector<double>* minos_problems      = statistics.Column("minos_problems");
+    for (std::size_t i=0; i<statistics.num_rows(); ++i) {
+      if (config_toystudy_.neglect_parameters_at_limit() && parameters_at_limit != nullptr && (*parameters_at_limit)[i] >= 0.5) {
+        selection[i] = false;
+      }
+      if (config_toystudy_.neglect_minos_problems() && minos_problems != nullptr && (*minos_problems)[i] >= 0.5) {
+        selection[i] = false;
+      }
+    }
+    statistics.SetSelection(selection);
+  }
+
+  void ToyStudyStd::EvaluateParameterDistribution(RooRealVar& parameter, ColumnStatistics& statistics, ParameterDistribution& distribution) {
+    std::string param_name = parameter.GetName();
+
+    distribution.valid           = false;
+    distribution.has_cls         = false;
+    distribution.has_fit         = false;
+    distribution.fit_status      = 0;
+    distribution.fit_truncated   = false;
+    distribution.num_entries_fit = 0;
+
+    std::vector<std::string> ignore_for_cls{"_err",
+                                            "_lerr",
+                                            "_herr",
+                                            "_init",
+                                            "_res",
+                                            "_refresidual",
+                                            "_pull",
+                                            "minos_problems",
+                                            "parameters_at_limit"
+                                            };
+
+    std::pair<double,double> minmax;
+    if (config_toystudy_.plot_on_full_range()) {
+      minmax = statistics.MinMax(param_name);
+    } else {
+      minmax = statistics.MedianLimits(param_name);
+    }
+    distribution.limit_low  = minmax.first;
+    distribution.limit_high = minmax.second;
+
+    // same cuts as in CreateFitPlotDataset()
+    double window_low  = -std::numeric_limits<double>::infinity();
+    double window_high = +std::numeric_limits<double>::infinity();
+    if (config_toystudy_.fit_plot_on_quantile_window()) {
+      window_low  = minmax.first;
+      window_high = minmax.second;
+    }
+    const ColumnSummary& summary_fit = statistics.SelectionSummary(param_name, window_low, window_high);
+    distribution.num_entries_fit = summary_fit.num_entries;
+
+    //CL calculation 
+    bool isparameteritself = true;
+    for(auto i : ignore_for_cls){
+      if (param_name.find(i) != std::string::npos)
+        isparameteritself = false;
+    }
+    if(isparameteritself && summary_fit.num_entries > 0){
+      distribution.has_cls   = true;
+      distribution.cl_mean   = summary_fit.mean;
+      distribution.cl_median = summary_fit.median();
+      distribution.cl_low    = summary_fit.quantile_low();
+      distribution.cl_high   = summary_fit.quantile_high();
+    }
+
+    // for all pulls fit a gaussian
+    if (param_name.length() > 4 &&
+        (param_name.substr(param_name.length()-5).compare("_pull") == 0 ||
+         param_name.substr(param_name.length()-4).compare("_res") == 0 ||
+         param_name.substr(param_name.length()-4).compare("_err") == 0 ||
+         param_name.substr(param_name.length()-5).compare("_init") == 0 ||
+         (param_name.length() > 12 && param_name.substr(param_name.length()-12).compare("_refresidual") == 0))) {
+         // || param_name.substr(0,4).compare("time") == 0)) {
+
+      // unbinned ML estimate of a Gaussian truncated to the fit window
+      TruncatedGaussianEstimator estimator(window_low, window_high);
+      estimator.Add(statistics.SelectedValues(param_name, window_low, window_high));
+      GaussianEstimate estimate = estimator.Estimate();
+
+      distribution.has_fit         = true;
+      distribution.fit_status      = estimate.valid ? 0 : 1;
+      distribution.fit_truncated   = config_toystudy_.fit_plot_on_quantile_window();
+      distribution.fit_mean        = estimate.mean;
+      distribution.fit_mean_error  = estimate.mean_error;
+      distribution.fit_sigma       = estimate.sigma;
+      distribution.fit_sigma_error = estimate.sigma_error;
+
+      if (config_toystudy_.crosscheck_pull_fits_roofit()) {
+        RooArgSet parameters_copy(parameter);
+        RooDataSet* fit_plot_dataset = CreateFitPlotDataset(parameter, minmax, parameters_copy);
+
+        // same model as unbinned RooFit fit (normalised in the fit window)
+        double parameter_min = parameter.getMin();
+        double parameter_max = parameter.getMax();
+        parameter.setRange(window_low, window_high);
+
+        RooRealVar mean("m", "mean of pull", (minmax.first+minmax.second)/2.0,minmax.first,minmax.second);
+        RooRealVar sigma("s", "sigma of pull", (minmax.second-minmax.first)/10.0,0,minmax.second-minmax.first);
+        RooGaussian gauss("pdf_pull", "Gaussian PDF of pull", parameter, mean, sigma);
+
+        // supress RooFit spam
+        RooMsgService::instance().setStreamStatus(0, false);
+        RooMsgService::instance().setStreamStatus(1, false);
+
+        RooFitResult* fit_result = gauss.fitTo(*fit_plot_dataset, NumCPU(1), Verbose(false), PrintLevel(-1), PrintEvalErrors(-1), Warnings(false), Save(true),  Minimizer("Minuit2","minimize"), Optimize(0));
+
+        // un-supress RooFit spam
+        RooMsgService::instance().setStreamStatus(0, true);
+        RooMsgService::instance().setStreamStatus(1, true);
+
+        parameter.setRange(parameter_min, parameter_max);
+
+        if (fit_result->statusCodeHistory(0) == 0 && estimate.valid) {
+          const RooArgList& list_fit_params(fit_result->floatParsFinal());
+          const RooRealVar* var_mean  = dynamic_cast<const RooRealVar*>(list_fit_params.find("m"));
+          const RooRealVar* var_sigma = dynamic_cast<const RooRealVar*>(list_fit_params.find("s"));
+          if (std::abs(var_mean->getVal() - estimate.mean) > 0.1*estimate.mean_error ||
+              std::abs(var_sigma->getVal() - estimate.sigma) > 0.1*estimate.sigma_error) {
+            swarn << "Gaussian estimate for " << param_name << " (m = " << estimate.mean << " +/- " << estimate.mean_error 
+                  << ", s = " << estimate.sigma << " +/- " << estimate.sigma_error << ") differs from RooFit fit (m = " 
+                  << var_mean->getVal() << " +/- " << var_mean->getError() << ", s = " << var_sigma->getVal() << " +/- " 
+                  << var_sigma->getError() << ")." << endmsg;
+          }
+        } else {
+          swarn << "Gaussian estimate or RooFit cross-check fit for " << param_name << " failed." << endmsg;
+        }
+        delete fit_result;
+        if (fit_plot_dataset != evaluated_values_) delete fit_plot_dataset;
+      }
+    }
+
+    distribution.valid = true;
+  }
+
+  void ToyStudyStd::EvaluateParameterDistributions(const std::vector<RooRealVar*>& parameters, ColumnStatistics& statistics, std::vector<ParameterDistribution>& distributions) {
+    distributions.assign(parameters.size(), ParameterDistribution());
+    for (auto& distribution : distributions) {
+      distribution.valid = false;
+    }
+
+    unsigned int num_workers = std::min<std::size_t>(std::max(config_toystudy_.num_cpu_evaluation(), 1), parameters.size());
+
+    if (num_workers > 1) {
+      // RooFit is not thread-safe. Each worker process evaluates an 
+      // interleaved subset of parameters on its own copy of the evaluated 
+      // values and reports back the plain results.
+      sinfo << "Fitting parameter distributions in " << num_workers << " worker processes." << endmsg;
+      doofit::tools::workers::RunInWorkers(parameters.size(), num_workers,
+        [&](std::size_t i) {
+          ParameterDistribution distribution;
+          EvaluateParameterDistribution(*parameters[i], statistics, distribution);
+          distribution.index = i;
+          return doofit::tools::workers::SerialisePlain(distribution);
+        },
+        [&](std::size_t i, std::vector<char>& bytes) {
+          ParameterDistribution distribution;
+          if (doofit::tools::workers::DeserialisePlain(bytes, distribution)) {
+            distributions[i] = distribution;
+          }
+        });
+    }
+
+    // serial evaluation (also for anything workers did not deliver)
+    for (unsigned int i=0; i<parameters.size(); ++i) {
+      if (!distributions[i].valid) {
+        if (num_workers > 1) {
+          swarn << "No result for " << parameters[i]->GetName() << " from worker process. Evaluating serially." << endmsg;
+        }
+        EvaluateParameterDistribution(*parameters[i], statistics, distributions[i]);
+        distributions[i].index = i;
+      }
+    }
+  }
+
+  TPaveText* ToyStudyStd::CreateGaussianFitText(const std::string& param_name, double mean, double mean_error, double sigma, double sigma_error) const {
+    using namespace doocore::statistics::general;
+    ValueWithError<double> val_mean(mean, mean_error);
+    ValueWithError<double> val_sigma(sigma, sigma_error);
+
+    TPaveText* pt = new TPaveText(0.57, 0.77, 0.92, 0.92, "NB NDC");
+    pt->SetFillColor(kWhite);
+    //pt->SetOption("NB");
+    pt->SetTextAlign(12);
+    pt->SetBorderSize(1);
+    pt->SetMargin(0.05);
+    pt->SetTextFont(133);
+    pt->SetTextSize(30);
+
+    std::string str_mean("m = ");
+    str_mean += val_mean.FormatStringTLatex();
+    std::string str_sigma("s = ");
+    str_sigma += val_sigma.FormatStringTLatex();
+
+    if (param_name.length() > 4 &&
+      (param_name.substr(param_name.length()-5).compare("_pull") == 0)) {
+      double pull_mean(val_mean.value/val_mean.error);
+      double pull_sigma((val_sigma.value-1.0)/val_sigma.error);
+
+      std::stringstream sstr_pull_mean;
+      sstr_pull_mean << std::setprecision(2) << std::fixed << pull_mean;
+      std::stringstream sstr_pull_sigma;
+      sstr_pull_sigma << std::setprecision(2) << std::fixed << pull_sigma;
+
+      str_mean  += " (" + sstr_pull_mean.str()  + "#kern[0.3]{#sigma})";
+      str_sigma += " (" + sstr_pull_sigma.str() + "#kern[0.3]{#sigma})";
+
+      boost::replace_all(str_mean,  "-", "#minus");
+      boost::replace_all(str_sigma, "-", "#minus");
+
+      pt->SetX1(0.46);
+    }
+
+    pt->AddText(str_mean.c_str());
+    pt->AddText(str_sigma.c_str());
+
+    return pt;
+  }
+
+  void ToyStudyStd::PrintQuantileEstimates(const std::map<std::string, std::tuple<double, double, double, double>>& parameter_cls) const {
     sinfo << "Quantile-based estimates for symmetric 68.27% CLs:" << endmsg;
     for(auto i : parameter_cls){
       sinfo << i.first << " : Mean = " << std::get<0>(i.second) << ", Median = " << std::get<1>(i.second) <<  ", Quantiles = (" << std::get<2>(i.second) << ", " << std::get<3>(i.second) << ")" << endmsg;
@@ -730,11 +941,193 @@ namespace toy {
       sinfo.increment_indent(-5);
     }
   }
+
+  void ToyStudyStd::EvaluateFitResultsStreaming() {
+    if (config_toystudy_.evaluate_reference_toys()) {
+      serr << "Reference toy analysis needs all fit results in memory and is not possible with streaming evaluation." << endmsg;
+      throw ExceptionCannotEvaluateFitResults();
+    }
+
+    sinfo.Ruler();
+    sinfo << "Evaluating fit results (streaming)" << endmsg;
+
+    if (evaluated_values_ != NULL) {
+      delete evaluated_values_;
+      evaluated_values_ = NULL;
+    }
+    evaluated_accumulators_.clear();
+
+    int i(0);
+    int num_neglected(0);
+    const RooFitResult* dummy = nullptr;
+    FitResultContainer fit_results(dummy, dummy, 0.0, 0.0, 0.0, 0.0, 0, 0);
+    do {
+      fit_results = GetFitResult();
+
+      if (std::get<0>(fit_results) != NULL) {
+        {
+          // RooFit objects must not be created in parallel to reader threads
+          boost::mutex::scoped_lock lock_roofit(fitresult_roofit_mutex_);
+          const RooArgSet& parameter_set = BuildEvaluationArgSet(fit_results);
+
+          bool neglect = (config_toystudy_.neglect_parameters_at_limit() && parameter_set.getRealValue("parameters_at_limit") > 0.5) ||
+                         (config_toystudy_.neglect_minos_problems() && parameter_set.getRealValue("minos_problems") > 0.5);
+
+          if (parameter_set.getSize() > 0 && !neglect) {
+            TIterator* parameter_iter = parameter_set.createIterator();
+            RooRealVar* parameter     = NULL;
+            while ((parameter = dynamic_cast<RooRealVar*>(parameter_iter->Next()))) {
+              std::string param_name = parameter->GetName();
+              auto it_accumulator = evaluated_accumulators_.find(param_name);
+              if (it_accumulator == evaluated_accumulators_.end()) {
+                it_accumulator = evaluated_accumulators_.insert(std::make_pair(param_name, OnlineParameterAccumulator(param_name, parameter->GetTitle()))).first;
+              }
+              it_accumulator->second.Add(parameter->getVal());
+            }
+            delete parameter_iter;
+            ++i;
+          } else if (neglect) {
+            ++num_neglected;
+          }
+        }
+
+        // evaluated fit results are not needed anymore
+        ReleaseFitResult(fit_results);
+        PurgeReleasedFitResults();
+      }
+    } while (std::get<0>(fit_results) != NULL);
+
+    if (i <= 0) {
+      serr << "Cannot evaluate as no fit results are loaded." << endmsg;
+      throw ExceptionCannotEvaluateFitResults();
+    }
+
+    PrintUnexpectedPullOverview();
+
+    if (num_neglected > 0) {
+      sinfo << "Neglected " << num_neglected << " fit results due to parameters at limit or MINOS problems." << endmsg;
+    }
+    sinfo << "Evaluated " << i << " fit results." << endmsg;
+    sinfo.Ruler();
+  }
+
+  void ToyStudyStd::PlotEvaluatedParametersStreaming() {
+    sinfo.Ruler();
+    sinfo << "Plotting parameter distributions." << endmsg;
+
+    gROOT->SetStyle("Plain");
+    doocore::lutils::setStyle("LHCbOptimized");
+    TCanvas canvas("canvas_toystudy", "canvas", 800, 600);
+    doocore::lutils::printPlotOpenStack(&canvas, "AllPlots", config_toystudy_.plot_directory());
+
+    using namespace doocore::io;
+    Progress p("Evaluating parameter distributions", evaluated_accumulators_.size());
+
+    std::map<std::string, std::tuple<double, double, double, double>> parameter_cls;
+
+    std::vector<std::string> ignore_for_cls{"_err",
+                                            "_lerr",
+                                            "_herr",
+                                            "_init",
+                                            "_res",
+                                            "_refresidual",
+                                            "_pull",
+                                            "minos_problems",
+                                            "parameters_at_limit"
+                                            };
+
+    for (auto& accumulator_pair : evaluated_accumulators_) {
+      const std::string& param_name = accumulator_pair.first;
+      OnlineParameterAccumulator& accumulator = accumulator_pair.second;
+      const OnlineMoments& moments = accumulator.moments();
+
+      std::pair<double,double> minmax = accumulator.QuantileWindow();
+      if (config_toystudy_.plot_on_full_range()) {
+        minmax = std::make_pair(moments.min(), moments.max());
+      }
+
+      bool isparameteritself = true;
+      for (auto i : ignore_for_cls) {
+        if (param_name.find(i) != std::string::npos)
+          isparameteritself = false;
+      }
+      if (isparameteritself) {
+        parameter_cls.insert(std::make_pair(param_name, std::make_tuple(moments.mean(), accumulator.median(), accumulator.quantile_low(), accumulator.quantile_high())));
+      }
+
+      std::string hist_name = param_name + "_hist";
+      TH1D* hist = accumulator.histogram().CreateHistogram(hist_name, accumulator.title(), minmax.first, minmax.second, 100);
+
+      // for all pulls fit a gaussian to the binned distribution
+      TF1* gauss = nullptr;
+      int fit_status = 0;
+      if (param_name.length() > 4 &&
+          (param_name.substr(param_name.length()-5).compare("_pull") == 0 ||
+           param_name.substr(param_name.length()-4).compare("_res") == 0 ||
+           param_name.substr(param_name.length()-4).compare("_err") == 0 ||
+           param_name.substr(param_name.length()-5).compare("_init") == 0 ||
+           (param_name.length() > 12 && param_name.substr(param_name.length()-12).compare("_refresidual") == 0))) {
+        // histogram is filled via SetBinContent, so its number of entries is meaningless
+        double frac_lost_entries = (1.0 - hist->Integral()/static_cast<double>(moments.count()))*100;
+        if (frac_lost_entries > 1.0) {
+          sinfo.increment_indent(2);
+          sinfo << "Losing " << frac_lost_entries << "% toys for this fit as they are outside the plotting window for " << param_name << "." << endmsg;
+          sinfo.increment_indent(-2);
+        }
+
+        gauss = new TF1("pdf_pull", "gaus", minmax.first, minmax.second);
+        gauss->SetParameters(hist->GetMaximum(), moments.mean(), moments.stddev() > 0.0 ? moments.stddev() : (minmax.second-minmax.first)/10.0);
+        gauss->SetLineColor(config_plot_.GetPdfLineColor(1));
+        fit_status = hist->Fit(gauss, "Q0", "", minmax.first, minmax.second);
+      }
+
+      hist->SetMinimum(0.0);
+      hist->GetXaxis()->SetTitle(accumulator.title().c_str());
+      hist->Draw("E");
+
+      TPaveText* pt = nullptr;
+      if (gauss != nullptr && fit_status == 0) {
+        if (gauss->GetParameter(2) >= 1e-6) {
+          gauss->Draw("same");
+        }
+        pt = CreateGaussianFitText(param_name, gauss->GetParameter(1), gauss->GetParError(1), std::abs(gauss->GetParameter(2)), gauss->GetParError(2));
+        hist->SetMaximum(hist->GetMaximum()*1.3);
+        pt->Draw();
+      } else if (fit_status != 0) {
+        swarn << "ToyStudyStd::PlotEvaluatedParameters(): Gaussian fit for " << param_name << " failed. Will not plot." << endmsg;
+      }
+
+      std::stringstream str;
+      using boost::format;
+      str << format("%1$.1g") % hist->GetBinWidth(1);
+      std::string label_y = "Pseudo-experiments / " + str.str();
+      hist->GetYaxis()->SetTitle(label_y.c_str());
+
+      doocore::lutils::printPlot(&canvas, param_name, config_toystudy_.plot_directory(), true);
+      doocore::lutils::printPlot(&canvas, "AllPlots", config_toystudy_.plot_directory(), true);
+
+      if (pt != nullptr) {
+        delete pt;
+      }
+      if (gauss != nullptr) {
+        delete gauss;
+      }
+      delete hist;
+
+      ++p;
+    }
+    p.Finish();
+
+    doocore::lutils::printPlotCloseStack(&canvas, "AllPlots", config_toystudy_.plot_directory());
+    sinfo.Ruler();
+
+    PrintQuantileEstimates(parameter_cls);
+  }
     
   RooArgSet ToyStudyStd::BuildEvaluationArgSet(FitResultContainer fit_results) {
     RooArgSet parameters;
     
-    int seed                        = std::get<6>(fit_results);
+    long long seed                  = std::get<6>(fit_results);
     int run_id                      = std::get<7>(fit_results);
     
     int run_id_reference            = config_toystudy_.reference_toys_id();
@@ -837,28 +1230,20 @@ namespace toy {
         const RooFormulaVar* add_var_err(std::get<1>(add_var_container.second));
         std::string title(std::get<2>(add_var_container.second));
 
-        EvaluateFormula(list_parameters, *add_var);
-        RooRealVar add_var_real(add_var->GetName(), title.c_str(), add_var->getVal());
+        RooRealVar add_var_real(add_var->GetName(), title.c_str(), EvaluateCompiledFormula(list_parameters, *add_var, formula_bindings_[0][add_var]));
 
         if (add_var_err != nullptr) {
-          EvaluateFormula(list_parameters, *add_var_err);
-          add_var_real.setError(add_var_err->getVal());
+          add_var_real.setError(EvaluateCompiledFormula(list_parameters, *add_var_err, formula_bindings_[0][add_var_err]));
         } else {
           add_var_real.setError(1.0);
         }
         list_parameters.addClone(add_var_real);
 
-        EvaluateFormula(list_parameters_init, *add_var);
-        RooRealVar add_var_real_init(add_var->GetName(), add_var->GetName(), add_var->getVal());
+        RooRealVar add_var_real_init(add_var->GetName(), add_var->GetName(), EvaluateCompiledFormula(list_parameters_init, *add_var, formula_bindings_[1][add_var]));
         list_parameters_init.addClone(add_var_real_init);
 
         if (list_parameters_ref.getSize() > 0) {
-          EvaluateFormula(list_parameters_ref, *add_var);
-
-          // sdebug << list_parameters_ref << endmsg;
-          // sdebug << "add_var->getVal() = " << add_var->getVal() << endmsg;
-
-          RooRealVar add_var_real_ref(add_var->GetName(), add_var->GetName(), add_var->getVal());
+          RooRealVar add_var_real_ref(add_var->GetName(), add_var->GetName(), EvaluateCompiledFormula(list_parameters_ref, *add_var, formula_bindings_[2][add_var]));
           list_parameters_ref.addClone(add_var_real_ref);
         }
       }
@@ -1174,6 +1559,93 @@ namespace toy {
     // sdebug << formula.GetName() << " = " << formula.getVal() << endmsg;
   }
 
+  const ToyStudyStd::CompiledFormula& ToyStudyStd::CompileFormula(const RooFormulaVar& formula) {
+    std::map<const RooFormulaVar*, CompiledFormula>::const_iterator it = compiled_formulas_.find(&formula);
+    if (it != compiled_formulas_.end()) {
+      return it->second;
+    }
+
+    CompiledFormula& compiled = compiled_formulas_[&formula];
+    std::vector<std::string> variables;
+    unsigned int i(0);
+    RooAbsArg* arg(formula.getParameter(i));
+    while (arg != nullptr) {
+      std::string name_var(arg->GetName());
+      variables.push_back(name_var);
+      compiled.dependents.push_back(dynamic_cast<const RooAbsReal*>(arg));
+
+      // dependents "X_err" are bound to the error of fit parameter X
+      if (name_var.length() > 4 && name_var.substr(name_var.length() - 4) == "_err") {
+        compiled.sources.push_back(name_var.substr(0, name_var.length() - 4));
+        compiled.use_errors.push_back(true);
+      } else {
+        compiled.sources.push_back(name_var);
+        compiled.use_errors.push_back(false);
+      }
+
+      ++i;
+      arg = formula.getParameter(i);
+    }
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,22,0)
+    std::string expression(formula.expression());
+#else
+    // RooFormulaVar prints its expression as formula="..."
+    std::ostringstream meta_args;
+    formula.printMetaArgs(meta_args);
+    std::string expression(meta_args.str());
+    std::string::size_type pos_begin = expression.find("formula=\"");
+    std::string::size_type pos_end   = expression.rfind('"');
+    if (pos_begin != std::string::npos && pos_end > pos_begin + 9) {
+      expression = expression.substr(pos_begin + 9, pos_end - pos_begin - 9);
+    } else {
+      expression = "";
+    }
+#endif
+
+    if (!compiled.program.Compile(expression, variables)) {
+      swarn << "Cannot compile formula " << formula.GetName() << " (" << compiled.program.error() << "). Falling back to RooFormulaVar evaluation." << endmsg;
+    }
+    return compiled;
+  }
+
+  double ToyStudyStd::EvaluateCompiledFormula(const RooArgList& args, const RooFormulaVar& formula, std::vector<int>& bindings) {
+    const CompiledFormula& compiled = CompileFormula(formula);
+    if (!compiled.program.compiled()) {
+      EvaluateFormula(args, formula);
+      return formula.getVal();
+    }
+
+    const std::size_t num_variables = compiled.sources.size();
+    if (bindings.size() != num_variables) {
+      bindings.assign(num_variables, -1);
+    }
+
+    std::vector<double> values(num_variables);
+    for (std::size_t i=0; i<num_variables; ++i) {
+      const char* name_source = compiled.sources[i].c_str();
+
+      // positions in args are identical for all toys, so usually no lookup by name is needed
+      int index = bindings[i];
+      if (index < 0 || index >= args.getSize() || std::strcmp(args.at(index)->GetName(), name_source) != 0) {
+        RooAbsArg* arg = args.find(name_source);
+        index = arg != nullptr ? args.index(arg) : -1;
+        bindings[i] = index;
+      }
+
+      const RooRealVar* var_result(index >= 0 ? dynamic_cast<const RooRealVar*>(args.at(index)) : nullptr);
+      if (var_result != nullptr) {
+        values[i] = compiled.use_errors[i] ? var_result->getError() : var_result->getVal();
+      } else if (compiled.dependents[i] != nullptr) {
+        values[i] = compiled.dependents[i]->getVal();
+      } else {
+        values[i] = 0.0;
+      }
+    }
+
+    return compiled.program.Evaluate(values.data());
+  }
+
   RooRealVar& ToyStudyStd::CopyRooRealVar(const RooRealVar& other, const std::string& new_name, const std::string& new_title) const {
     RooRealVar* new_var = new RooRealVar(new_name.length()>0 ? new_name.c_str() : other.GetName(),
                                          new_title.length()>0 ? new_title.c_str() : other.GetTitle(),
@@ -1208,172 +1680,379 @@ namespace toy {
     
     const std::vector<doofit::config::CommaSeparatedPair<std::string>>& results_files = config_toystudy_.read_results_filename_treename();
     
+    for (std::vector<doofit::config::CommaSeparatedPair<std::string>>::const_iterator it_files = results_files.begin(); it_files != results_files.end(); ++it_files) {
+      if (!ReadFitResultsFromFile(*it_files)) {
+        //sinfo << "Read in " << results_stored_ << " toys as requested. Finishing." << endmsg;
+        break;
+      }
+    } // for (std::vector<doofit::config::CommaSeparatedPair<std::string>>::const_iterator it_files = results_files.begin(); it_files != results_files.end(); ++it_files) {
+
+    FinishReadFitResults();
+  }
+
+  void ToyStudyStd::ReadFitResultPoolWorker() {
+    TThread this_tthread;
+
+    const std::vector<doofit::config::CommaSeparatedPair<std::string>>& results_files = config_toystudy_.read_results_filename_treename();
+
+    bool continue_reading = true;
+    while (continue_reading) {
+      // pick next file not yet processed by any reader
+      std::size_t index_file = 0;
+      {
+        boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+        index_file = fitresult_reader_next_file_++;
+        if (index_file < fitresult_reader_order_.size()) {
+          index_file = fitresult_reader_order_[index_file];
+        }
+      }
+
+      if (index_file < results_files.size() && reading_fit_results_) {
+        continue_reading = ReadFitResultsFromFile(results_files[index_file]);
+      } else {
+        continue_reading = false;
+      }
+    }
+
+    // the last active reader finishes
+    bool last_reader = false;
+    {
+      boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+      --fitresult_reader_active_;
+      last_reader = (fitresult_reader_active_ == 0);
+    }
+    if (last_reader) {
+      FinishReadFitResults();
+    }
+  }
+
+  void ToyStudyStd::FinishReadFitResults() {
+    fit_results_read_queue_.disable_queue();
+    sinfo << "Read in " << results_stored_ << " fit results. (" << results_neglected_ << " results negelected, that is " << static_cast<double>(results_neglected_)/static_cast<double>(results_stored_+results_neglected_)*100.0 << "%)" << endmsg;
     sinfo.Ruler();
-    
-    if (results_files.size() == 0) {
-      serr << "No files to read fit results from are specified. Cannot read in." << endmsg;
-      throw ExceptionCannotReadFitResult();
+
+    reading_fit_results_ = false;
+    fitresult_reader_space_.notify_all();
+  }
+
+  bool ToyStudyStd::AcceptReadFitResult(const FitResultContainer& fit_results) {
+    {
+      boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+
+      // bounded queue: with background readers, wait for the consumer to catch 
+      // up before decoding even more fit results into memory
+      if (fitresult_reader_background_ && config_toystudy_.read_queue_max_size() > 0) {
+        while (reading_fit_results_ && fit_results_read_queue_.size() >= static_cast<unsigned int>(config_toystudy_.read_queue_max_size())) {
+          fitresult_reader_space_.timed_wait(lock, boost::posix_time::milliseconds(100));
+        }
+      }
+
+      bool accept = reading_fit_results_ && 
+                    (config_toystudy_.num_toys_read() <= 0 || results_stored_ < config_toystudy_.num_toys_read());
+      if (accept) {
+        // reserve the slot under lock to keep num_toys_read exact
+        results_stored_++;
+      } else {
+        lock.unlock();
+        boost::mutex::scoped_lock lock_roofit(fitresult_roofit_mutex_);
+        delete std::get<0>(fit_results);
+        if (std::get<1>(fit_results) != NULL) {
+          delete std::get<1>(fit_results);
+        }
+        return false;
+      }
     }
-    
-    if (fit_results_.size() > 0) {
-      serr << "Reading in fit results while results are already stored. Empty stored fit results first." << endmsg;
-      throw ExceptionCannotReadFitResult();
+
+    fit_results_read_queue_.push(fit_results);
+    return true;
+  }
+
+  bool ToyStudyStd::ToyLimitReached() {
+    boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+    return config_toystudy_.num_toys_read() > 0 && results_stored_ >= config_toystudy_.num_toys_read();
+  }
+
+  void ToyStudyStd::PlanReadFitResults(bool parallel) {
+    const std::vector<doofit::config::CommaSeparatedPair<std::string>>& results_files = config_toystudy_.read_results_filename_treename();
+
+    result_manifests_.clear();
+    fitresult_reader_order_.clear();
+    if (!config_toystudy_.result_manifest()) return;
+
+    for (auto file_tree : results_files) {
+      std::string name_manifest(ResultSetManifest::ManifestFileName(file_tree.first()));
+      if (result_manifests_.count(name_manifest) == 0) {
+        result_manifests_.insert(std::make_pair(name_manifest, ResultSetManifest(file_tree.first()))).first->second.Load();
+      }
     }
+
+    std::vector<std::pair<long long, std::size_t>> files_entries;
+    long long num_entries_known = 0;
+    unsigned int num_files_known = 0;
+    for (std::size_t i=0; i<results_files.size(); ++i) {
+      ResultManifestEntry manifest_entry;
+      long long entries = std::numeric_limits<long long>::max();
+      if (FindResultManifestEntry(results_files[i], manifest_entry)) {
+        entries = manifest_entry.entries;
+        num_entries_known += entries;
+        ++num_files_known;
+      }
+      files_entries.push_back(std::make_pair(entries, i));
+    }
+    if (num_files_known > 0) {
+      sinfo << "Result manifests list " << num_entries_known << " fit results in " << num_files_known << " of " << results_files.size() << " files." << endmsg;
+    }
+
+    if (parallel) {
+      // largest files first for better load balancing of the reader pool
+      std::stable_sort(files_entries.begin(), files_entries.end(), [](const std::pair<long long, std::size_t>& a, const std::pair<long long, std::size_t>& b) {
+        return a.first > b.first;
+      });
+      for (auto file_entries : files_entries) {
+        fitresult_reader_order_.push_back(file_entries.second);
+      }
+    }
+  }
+
+  bool ToyStudyStd::FindResultManifestEntry(const doofit::config::CommaSeparatedPair<std::string>& file_tree, ResultManifestEntry& entry) {
+    if (!config_toystudy_.result_manifest()) return false;
+
+    boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+    std::map<std::string, ResultSetManifest>::const_iterator it = result_manifests_.find(ResultSetManifest::ManifestFileName(file_tree.first()));
+    if (it == result_manifests_.end()) return false;
+
+    const ResultManifestEntry* entry_found = it->second.Find(file_tree.first(), file_tree.second());
+    if (entry_found == nullptr) return false;
+
+    entry = *entry_found;
+    return true;
+  }
+
+  void ToyStudyStd::AddResultManifestEntry(const doofit::config::CommaSeparatedPair<std::string>& file_tree, TTree& tree) {
+    if (!config_toystudy_.result_manifest()) return;
+
+    ResultManifestEntry entry(ResultSetManifest::Describe(file_tree.first(), tree, config_toystudy_.fit_result1_branch_name()));
+    entry.file_size = ResultSetManifest::FileSize(file_tree.first());
+
+    boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+    std::string name_manifest(ResultSetManifest::ManifestFileName(file_tree.first()));
+    std::map<std::string, ResultSetManifest>::iterator it = result_manifests_.find(name_manifest);
+    if (it == result_manifests_.end()) {
+      it = result_manifests_.insert(std::make_pair(name_manifest, ResultSetManifest(file_tree.first()))).first;
+    }
+    // other readers (threads or processes) might have added the record since
+    // the manifest was loaded
+    it->second.Load();
+    if (it->second.Find(file_tree.first(), file_tree.second()) != nullptr) return;
+
+    // result files might be read-only, a missing record is not a problem
+    it->second.Append(entry);
+  }
+
+  bool ToyStudyStd::ReadFitResultsFromFile(const doofit::config::CommaSeparatedPair<std::string>& file_tree) {
+    ResultManifestEntry manifest_entry;
+    bool in_manifest = FindResultManifestEntry(file_tree, manifest_entry);
+    if (in_manifest && manifest_entry.format == ResultSetManifest::kFormatEasyFitResult) {
+      sinfo << "Tree " << file_tree.first() << ":" << file_tree.second() << " is an EasyFitResult container according to manifest. Will process separately." << endmsg;
+      boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+      results_files_easyfit_.push_back(file_tree);
+      lock.unlock();
+      return !ToyLimitReached();
+    }
+    if (in_manifest && manifest_entry.entries == 0) {
+      sinfo << "Tree " << file_tree.first() << ":" << file_tree.second() << " contains no fit results according to manifest. Skipping." << endmsg;
+      return !ToyLimitReached();
+    }
+
+    sinfo << "Loading fit results from " << file_tree.first() 
+    << " from branch " << config_toystudy_.fit_result1_branch_name() << endmsg;
+    // no fork() while this thread is in ROOT (released while waiting for the
+    // consumer of read fit results)
+    doofit::tools::workers::ThreadSection section(doofit::tools::workers::ForkMutex());
+    TFile file(file_tree.first().c_str(), "read");
+    if (file.IsZombie() || !file.IsOpen()) {
+      serr << "Cannot open file " << file_tree.first() << " which may be not existing or corrupted. Ignoring this file." << endmsg;
+      //throw ExceptionCannotReadFitResult();
+      return !ToyLimitReached();
+    }
+
+    TTree* tree = (TTree*)file.Get(file_tree.second().c_str());
+    if (tree == NULL) {
+      serr << "Cannot find tree " << file_tree.second() << " in file. Cannot read in fit results. Ignoring this file." << endmsg;
+      //throw ExceptionCannotReadFitResult();
+      return !ToyLimitReached();
+    }
+
+    if (!in_manifest) {
+      AddResultManifestEntry(file_tree, *tree);
+    }
+
+    TBranch* result_branch = tree->GetBranch(config_toystudy_.fit_result1_branch_name().c_str());
+    TBranch* result2_branch = tree->GetBranch(config_toystudy_.fit_result2_branch_name().c_str());
+
+    const std::string prefix_columns1 = config_toystudy_.fit_result1_branch_name() + "_";
+    const std::string prefix_columns2 = config_toystudy_.fit_result2_branch_name() + "_";
+
+    bool columnar = (result_branch == NULL && FitResultColumns::TreeHasColumns(*tree, prefix_columns1));
     
-    int results_stored = 0;
-    int results_neglected = 0;
-    // std::vector<RooFitResult*> vector_debug;
-    
-    for (std::vector<doofit::config::CommaSeparatedPair<std::string>>::const_iterator it_files = results_files.begin(); it_files != results_files.end(); ++it_files) {
-      sinfo << "Loading fit results from " << (*it_files).first() 
-      << " from branch " << config_toystudy_.fit_result1_branch_name() << endmsg;
-      TFile file((*it_files).first().c_str(), "read");
-      if (file.IsZombie() || !file.IsOpen()) {
-        serr << "Cannot open file " << (*it_files).first() << " which may be not existing or corrupted. Ignoring this file." << endmsg;
-        //throw ExceptionCannotReadFitResult();
+    if (result_branch == NULL && !columnar) {
+      // TODO: Check for EasyFitResult container
+      // results_files_easyfit_
+
+      TBranch* branch_easyfit_probe = tree->GetBranch("fr0_fcn");
+
+      if (branch_easyfit_probe != nullptr) {
+        sinfo << "Tree " << file_tree.first() << ":" << file_tree.second() << " is an EasyFitResult container. Will process separately." << endmsg;
+        boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+        results_files_easyfit_.push_back(file_tree);
       } else {
-        
-        TTree* tree = (TTree*)file.Get((*it_files).second().c_str());
-        if (tree == NULL) {
-          serr << "Cannot find tree " << (*it_files).second() << " in file. Cannot read in fit results. Ignoring this file." << endmsg;
-          //throw ExceptionCannotReadFitResult();
-        } else { // if (tree == NULL) {
-          
-          TBranch* result_branch = tree->GetBranch(config_toystudy_.fit_result1_branch_name().c_str());
-          TBranch* result2_branch = tree->GetBranch(config_toystudy_.fit_result2_branch_name().c_str());
-          
-          if (result_branch == NULL) {
-            // TODO: Check for EasyFitResult container
-            // results_files_easyfit_
+        serr << "Cannot find branch " << config_toystudy_.fit_result1_branch_name() << " in tree. Cannot read in fit results." << endmsg;
+        //throw ExceptionCannotReadFitResult();
+      }
+      return !ToyLimitReached();
+    }
 
-            TBranch* branch_easyfit_probe = tree->GetBranch("fr0_fcn");
+    FitResultColumns columns1(prefix_columns1);
+    FitResultColumns columns2(prefix_columns2);
+    bool has_result2 = false;
 
-            if (branch_easyfit_probe != nullptr) {
-              sinfo << "Tree " << it_files->first() << ":" << it_files->second() << " is an EasyFitResult container. Will process separately." << endmsg;
-              results_files_easyfit_.push_back(*it_files);
-            } else {
-              serr << "Cannot find branch " << config_toystudy_.fit_result1_branch_name() << " in tree. Cannot read in fit results." << endmsg;
-              //throw ExceptionCannotReadFitResult();
-            }
-          } else { // if (result_branch == NULL) {
-            // Fit times
-            TBranch* time_cpu1_branch  = tree->GetBranch("time_cpu1");
-            TBranch* time_real1_branch = tree->GetBranch("time_real1");
-            TBranch* time_cpu2_branch  = tree->GetBranch("time_cpu2");
-            TBranch* time_real2_branch = tree->GetBranch("time_real2");
-            TBranch* seed_branch       = tree->GetBranch("seed");
-            TBranch* run_id_branch     = tree->GetBranch("run_id");
-            
-            RooFitResult* fit_result  = NULL;
-            RooFitResult* fit_result2 = NULL;
-            double time_cpu1 = 0.0, time_real1 = 0.0;
-            double time_cpu2 = 0.0, time_real2 = 0.0;
-            int seed(0);
-            int run_id(0);
-
-            tree->SetCacheEntryRange(0,tree->GetEntries());
-            
-            tree->AddBranchToCache(result_branch, true);
-            result_branch->SetAddress(&fit_result);
-            
-            if (result2_branch != NULL) {
-              tree->AddBranchToCache(result2_branch, true);
-              result2_branch->SetAddress(&fit_result2);
-            }
-            if (time_cpu1_branch != NULL) {
-              tree->AddBranchToCache(time_cpu1_branch, true);
-              time_cpu1_branch->SetAddress(&time_cpu1);
-            }
-            if (time_real1_branch != NULL) {
-              tree->AddBranchToCache(time_real1_branch, true);
-              time_real1_branch->SetAddress(&time_real1);
-            }
-            if (time_cpu2_branch != NULL) {
-              tree->AddBranchToCache(time_cpu2_branch, true);
-              time_cpu2_branch->SetAddress(&time_cpu2);
-            }
-            if (time_real2_branch != NULL) {
-              tree->AddBranchToCache(time_real2_branch, true);
-              time_real2_branch->SetAddress(&time_real2);
-            }
-            if (seed_branch != NULL) {
-              tree->AddBranchToCache(seed_branch, true);
-              seed_branch->SetAddress(&seed);
-            }
-            if (run_id_branch != NULL) {
-              tree->AddBranchToCache(run_id_branch, true);
-              run_id_branch->SetAddress(&run_id);
-            }
-            tree->StopCacheLearningPhase();
-            
-            using namespace doocore::io;
-            std::string title_progress = "Reading fit results from " + (*it_files).first() + ":" + (*it_files).second();
-            Progress p(title_progress, tree->GetEntries());
-            for (int i=0; i<tree->GetEntries(); ++i) {
-              tree->GetEntry(i);
-              
-              // save a copy
-              if (fit_result != NULL && FitResultOkay(*fit_result)) {
-                fit_results_read_queue_.push(std::make_tuple(fit_result,
-                                                             fit_result2,
-                                                             time_cpu1,
-                                                             time_real1,
-                                                             time_cpu2,
-                                                             time_real2,
-                                                             seed,
-                                                             run_id));
-                results_stored++;
-              } else {
-                if (fit_result == NULL) {
-                  serr << "Fit result number " << i << " in file " << *it_files << " is NULL and therefore neglected. This indicates corrupted files and should never happen." << endmsg;
-                  while (true) {}
-                } else {
-                  delete fit_result;
-                  if (fit_result2 != NULL) {
-                    delete fit_result2;
-                  }
-                  fit_result = nullptr;
-                  fit_result2 = nullptr;
-                  
-                  swarn << "Fit result number " << i << " in file " << *it_files << " neglected." << endmsg;
-                }
-                results_neglected++;
-              }
-              fit_result = nullptr;
-              fit_result2 = nullptr;
+    RooFitResult* fit_result  = NULL;
+    RooFitResult* fit_result2 = NULL;
+    double time_cpu1 = 0.0, time_real1 = 0.0;
+    double time_cpu2 = 0.0, time_real2 = 0.0;
+    Long64_t seed(0);
+    Int_t seed_int(0);
+    int run_id(0);
 
-              PurgeReleasedFitResults();
+    tree->SetCacheEntryRange(0,tree->GetEntries());
 
-              if (config_toystudy_.num_toys_read() > 0 && results_stored >= config_toystudy_.num_toys_read()) {
-                break;
-              }
+    if (columnar) {
+      sinfo << "Tree " << file_tree.first() << ":" << file_tree.second() << " contains columnar fit results." << endmsg;
 
-              ++p;
-            }
-            p.Finish();
+      // only activate columns actually needed
+      tree->SetBranchStatus("*", 0);
 
-            delete tree;
-            file.Close();
+      std::vector<std::string> read_parameters;
+      for (int j=0; j<config_toystudy_.read_parameters().size(); ++j) {
+        read_parameters.push_back(config_toystudy_.read_parameters()[j]);
+      }
 
-            if (config_toystudy_.num_toys_read() > 0 && results_stored >= config_toystudy_.num_toys_read()) {
-              //sinfo << "Read in " << results_stored << " toys as requested. Finishing." << endmsg;
-              break;
-            }
-          } // if (result_branch == NULL) {
-        } // if (tree == NULL) {
-      } // if (file.IsZombie() || !file.IsOpen()) {
-    } // for (std::vector<doofit::config::CommaSeparatedPair<std::string>>::const_iterator it_files = results_files.begin(); it_files != results_files.end(); ++it_files) {
-    fit_results_read_queue_.disable_queue();
-    sinfo << "Read in " << results_stored << " fit results. (" << results_neglected << " results negelected, that is " << static_cast<double>(results_neglected)/static_cast<double>(results_stored+results_neglected)*100.0 << "%)" << endmsg;
-    sinfo.Ruler();
+      has_result2 = FitResultColumns::TreeHasColumns(*tree, prefix_columns2);
+      if (!columns1.RegisterForReading(*tree, file, file_tree.second(), read_parameters) ||
+          (has_result2 && !columns2.RegisterForReading(*tree, file, file_tree.second(), read_parameters))) {
+        serr << "Cannot register columnar fit results in tree " << file_tree.second() << ". Ignoring this file." << endmsg;
+        delete tree;
+        file.Close();
+        return !ToyLimitReached();
+      }
+    } else {
+      tree->AddBranchToCache(result_branch, true);
+      result_branch->SetAddress(&fit_result);
+      
+      if (result2_branch != NULL) {
+        tree->AddBranchToCache(result2_branch, true);
+        result2_branch->SetAddress(&fit_result2);
+      }
+    }
 
-    // if (debug_) {
-    //   for (auto& fr : vector_debug) {
-    //     delete fr;
-    //   }
-    // }
+    // Fit times, seed and run id
+    std::vector<std::pair<std::string, void*>> branches_bookkeeping;
+    branches_bookkeeping.push_back(std::make_pair("time_cpu1", &time_cpu1));
+    branches_bookkeeping.push_back(std::make_pair("time_real1", &time_real1));
+    branches_bookkeeping.push_back(std::make_pair("time_cpu2", &time_cpu2));
+    branches_bookkeeping.push_back(std::make_pair("time_real2", &time_real2));
+    bool seed_is_int = SeedBranchIsInt(*tree);
+    branches_bookkeeping.push_back(std::make_pair("seed", seed_is_int ? static_cast<void*>(&seed_int) : static_cast<void*>(&seed)));
+    branches_bookkeeping.push_back(std::make_pair("run_id", &run_id));
+    for (auto branch_bookkeeping : branches_bookkeeping) {
+      TBranch* branch = tree->GetBranch(branch_bookkeeping.first.c_str());
+      if (branch != NULL) {
+        tree->SetBranchStatus(branch_bookkeeping.first.c_str(), 1);
+        tree->AddBranchToCache(branch, true);
+        branch->SetAddress(branch_bookkeeping.second);
+      }
+    }
+    tree->StopCacheLearningPhase();
     
-    reading_fit_results_ = false;
+    bool continue_reading = true;
+
+    using namespace doocore::io;
+    std::string title_progress = "Reading fit results from " + file_tree.first() + ":" + file_tree.second();
+    Progress p(title_progress, tree->GetEntries());
+    for (int i=0; i<tree->GetEntries() && continue_reading; ++i) {
+      bool okay = false;
+      bool is_null = false;
+      {
+        // RooFit object creation and deletion is not thread-safe. Columnar 
+        // fit results are decoded without RooFit and only the final result
+        // creation is serialised. Streamed RooFitResult objects are created 
+        // by the TTree I/O itself, so for these the whole entry is read 
+        // under the lock and reader threads do not decode in parallel.
+        if (columnar) {
+          tree->GetEntry(i);
+        }
+        boost::mutex::scoped_lock lock_roofit(fitresult_roofit_mutex_);
+        if (columnar) {
+          // reuse released fit results instead of allocating new ones
+          fit_result  = columns1.CreateFitResult(PopRecycledFitResult());
+          fit_result2 = has_result2 ? columns2.CreateFitResult(PopRecycledFitResult()) : NULL;
+        } else {
+          tree->GetEntry(i);
+        }
+      
+        is_null = (fit_result == NULL);
+        okay = (!is_null && FitResultOkay(*fit_result));
+        if (!okay && fit_result != NULL) {
+          DisposeFitResult(fit_result);
+          if (fit_result2 != NULL) {
+            DisposeFitResult(fit_result2);
+          }
+          fit_result = nullptr;
+          fit_result2 = nullptr;
+        }
+      }
+
+      if (seed_is_int) seed = seed_int;
+
+      // save a copy
+      if (okay) {
+        section.unlock();
+        continue_reading = AcceptReadFitResult(std::make_tuple(fit_result,
+                                                               fit_result2,
+                                                               time_cpu1,
+                                                               time_real1,
+                                                               time_cpu2,
+                                                               time_real2,
+                                                               seed,
+                                                               run_id));
+        section.lock();
+      } else {
+        if (is_null && !columnar) {
+          serr << "Fit result number " << i << " in file " << file_tree << " is NULL and therefore neglected. This indicates corrupted files and should never happen." << endmsg;
+          while (true) {}
+        } else {
+          swarn << "Fit result number " << i << " in file " << file_tree << " neglected." << endmsg;
+        }
+        boost::mutex::scoped_lock lock(fitresult_reader_mutex_);
+        results_neglected_++;
+      }
+      fit_result = nullptr;
+      fit_result2 = nullptr;
+
+      PurgeReleasedFitResults();
+
+      if (ToyLimitReached()) {
+        continue_reading = false;
+      }
+
+      ++p;
+    }
+    p.Finish();
+
+    delete tree;
+    file.Close();
+
+    return continue_reading;
   }
   
   void ToyStudyStd::SaveFitResultWorker() {
@@ -1392,7 +2071,7 @@ namespace toy {
       
       const std::string& filename = config_toystudy_.store_result_filename_treename().first();
       const std::string& treename = config_toystudy_.store_result_filename_treename().second();
-      unsigned int save_counter = 1;
+      unsigned int save_counter = 0;
       
       // if our own queue is empty, we need to wait for new fit results to come 
       // in anyway.
@@ -1426,11 +2105,17 @@ namespace toy {
         sw_lock.Stop();
         boost::mutex::scoped_lock fitresult_save_worker_local_lock(fitresult_save_worker_mutex_);
         
-        doocore::system::FileLock flock(filename);
+        // sharded mode: every batch goes into an own shard file, no locking 
+        // needed as nobody else is writing this file
+        bool sharded = config_toystudy_.store_result_sharded();
+        std::string shardname(sharded ? FitResultShards::UniqueShardFileName(filename) : "");
+        const std::string& filename_save = sharded ? FitResultShards::TemporaryFileName(shardname) : filename;
+
+        std::unique_ptr<doocore::system::FileLock> flock(sharded ? nullptr : new doocore::system::FileLock(filename));
         boost::random::random_device rnd;
         
         sw_lock.Start(false);
-        if (!flock.Lock()) {
+        if (flock && !flock->Lock()) {
           // get new wait time based on last deadtimes's average
           double new_wait_time = 0.0;
           for (std::list<double>::const_iterator it = deadtimes.begin();
@@ -1454,12 +2139,15 @@ namespace toy {
           while (deadtimes.size() > 5) deadtimes.pop_front();
           
           if (!abort_save_) {
-            sinfo << "Saving fit result to file " << filename << endmsg;
-            bool file_existing = fs::exists(filename);
-            TFile f(fs::absolute(filename).string().c_str(),"update");
+            // no fork() while this thread is in ROOT (see doofit::tools::workers::ForkMutex())
+            doofit::tools::workers::ThreadSection section(doofit::tools::workers::ForkMutex());
+            sinfo << "Saving fit result to file " << (sharded ? shardname : filename) << endmsg;
+            bool file_existing = fs::exists(filename_save);
+            ResultManifestEntry manifest_entry;
+            TFile f(fs::absolute(filename_save).string().c_str(),"update");
             if (f.IsZombie() || !f.IsOpen()) {
               serr << "Cannot open file which may be corrupted." << endmsg;
-              flock.Unlock();
+              if (flock) flock->Unlock();
               throw ExceptionCannotStoreFitResult();
             } else {
               if (!abort_save_) {
@@ -1472,7 +2160,9 @@ namespace toy {
                 double time_real1 = std::get<3>(fit_results);
                 double time_cpu2 = std::get<4>(fit_results);
                 double time_real2 = std::get<5>(fit_results);
-                int seed(std::get<6>(fit_results));
+                Long64_t seed(std::get<6>(fit_results));
+                // trees written before seeds were widened store them as Int_t
+                Int_t seed_int(static_cast<Int_t>(seed));
                 int run_id(std::get<7>(fit_results));
                 
                 TTree* tree_results = NULL;
@@ -1480,29 +2170,66 @@ namespace toy {
                   tree_results = (TTree*)f.Get(treename.c_str());
                 } 
                 
+                // columnar storage of fit results (if requested)
+                bool columnar = config_toystudy_.store_result_columnar();
+                FitResultColumns columns1(config_toystudy_.fit_result1_branch_name() + "_");
+                FitResultColumns columns2(config_toystudy_.fit_result2_branch_name() + "_");
+
+                // copy fit results into column buffers, false if they do not 
+                // match the registered layout and must not be filled
+                auto set_columns = [&]() {
+                  if (!columnar) return true;
+                  if (!columns1.SetFitResult(*fit_result1)) return false;
+                  if (fit_result2 != NULL) return columns2.SetFitResult(*fit_result2);
+                  return columns2.num_parameters() == 0;
+                };
+
                 if (tree_results == NULL) {
                   tree_results = new TTree(treename.c_str(), "Tree for toy study fit results");
-                  tree_results->Branch(config_toystudy_.fit_result1_branch_name().c_str(), "RooFitResult", &fit_result1, 64000, 0);
-                  if (fit_result2 != NULL) {
-                    tree_results->Branch(config_toystudy_.fit_result2_branch_name().c_str(), "RooFitResult", &fit_result2, 64000, 0);
+                  if (columnar) {
+                    columns1.RegisterForWriting(*tree_results, *fit_result1);
+                    if (fit_result2 != NULL) {
+                      columns2.RegisterForWriting(*tree_results, *fit_result2);
+                    }
+                  } else {
+                    tree_results->Branch(config_toystudy_.fit_result1_branch_name().c_str(), "RooFitResult", &fit_result1, 64000, 0);
+                    if (fit_result2 != NULL) {
+                      tree_results->Branch(config_toystudy_.fit_result2_branch_name().c_str(), "RooFitResult", &fit_result2, 64000, 0);
+                    }
                   }
                   tree_results->Branch("time_cpu1",  &time_cpu1,  "time_cpu1/D");
                   tree_results->Branch("time_real1", &time_real1, "time_real1/D");
                   tree_results->Branch("time_cpu2",  &time_cpu2,  "time_cpu2/D");
                   tree_results->Branch("time_real2", &time_real2, "time_real2/D");
-                  tree_results->Branch("seed", &seed, "seed/I");
+                  tree_results->Branch("seed", &seed, "seed/L");
                   tree_results->Branch("run_id", &run_id, "run_id/I");
+                } else if (columnar) {
+                  if (!FitResultColumns::TreeHasColumns(*tree_results, config_toystudy_.fit_result1_branch_name() + "_") ||
+                      !columns1.RegisterForWriting(*tree_results, *fit_result1) ||
+                      (fit_result2 != NULL && !columns2.RegisterForWriting(*tree_results, *fit_result2))) {
+                    serr << "Cannot store fit result! Tree exists but is not compatible with columnar fit results." << endmsg;
+                    f.Close();
+                    if (flock) flock->Unlock();
+                    throw ExceptionCannotStoreFitResult();
+                  }
+                  
+                  tree_results->SetBranchAddress("time_cpu1", &time_cpu1);
+                  tree_results->SetBranchAddress("time_real1", &time_real1);
+                  tree_results->SetBranchAddress("time_cpu2", &time_cpu2);
+                  tree_results->SetBranchAddress("time_real2", &time_real2);
+                  SetSeedBranchAddress(*tree_results, &seed, &seed_int);
+                  tree_results->SetBranchAddress("run_id", &run_id);
                 } else {  
                   if (tree_results->GetBranch(config_toystudy_.fit_result1_branch_name().c_str()) == NULL) {
                     serr << "Cannot store fit result! Tree exists but branch " << config_toystudy_.fit_result1_branch_name() << " is unknown." << endmsg;
                     f.Close();
-                    flock.Unlock();
+                    if (flock) flock->Unlock();
                     throw ExceptionCannotStoreFitResult();
                   }
                   if (fit_result2 != NULL && tree_results->GetBranch(config_toystudy_.fit_result2_branch_name().c_str()) == NULL) {
                     serr << "Cannot store fit result! Tree exists but branch " << config_toystudy_.fit_result2_branch_name() << " is unknown." << endmsg;
                     f.Close();
-                    flock.Unlock();
+                    if (flock) flock->Unlock();
                     throw ExceptionCannotStoreFitResult();
                   }
                   
@@ -1522,19 +2249,25 @@ namespace toy {
                   }
 
                   if (tree_results->GetBranch("seed") != NULL) {
-                    tree_results->SetBranchAddress("seed", &seed);
+                    SetSeedBranchAddress(*tree_results, &seed, &seed_int);
                   }
                   if (tree_results->GetBranch("run_id") != NULL) {
                     tree_results->SetBranchAddress("run_id", &run_id);
                   }
                 }
-                     
-                tree_results->Fill();
+                
+                if (set_columns()) {
+                  tree_results->Fill();
+                  save_counter++;
+                } else {
+                  serr << "Cannot store fit result with seed " << seed << "! Parameters do not match the columnar fit results in tree " << treename << ". Skipping it." << endmsg;
+                }
                 
                 delete fit_result1;
                 if (fit_result2 != NULL) { 
                   delete fit_result2;
                 }
+                FitResultSaved();
                 
                 while (!saver_queue.empty()) {
                   fit_results = saver_queue.front();
@@ -1546,17 +2279,32 @@ namespace toy {
                   time_cpu2   = std::get<4>(fit_results);
                   time_real2  = std::get<5>(fit_results);
                   seed        = std::get<6>(fit_results);
+                  seed_int    = static_cast<Int_t>(seed);
                   run_id      = std::get<7>(fit_results);
                   
-                  tree_results->Fill();
-                  save_counter++;
+                  if (set_columns()) {
+                    tree_results->Fill();
+                    save_counter++;
+                  } else {
+                    serr << "Cannot store fit result with seed " << seed << "! Parameters do not match the columnar fit results in tree " << treename << ". Skipping it." << endmsg;
+                  }
                   delete fit_result1;
+                  FitResultSaved();
                   if (fit_result2 != NULL) {
                     delete fit_result2;
                   }
                 }
                 
                 tree_results->Write("",TObject::kOverwrite);
+                if (columnar) {
+                  columns1.WriteMetadata(f, treename);
+                  if (columns2.num_parameters() > 0) {
+                    columns2.WriteMetadata(f, treename);
+                  }
+                }
+                if (config_toystudy_.result_manifest()) {
+                  manifest_entry = ResultSetManifest::Describe(sharded ? shardname : filename, *tree_results, config_toystudy_.fit_result1_branch_name());
+                }
                 
                 sinfo << "Deferred saving of " << save_counter << " fit results (resp. pairs of fit results) successful." << endmsg;
               } else {
@@ -1565,10 +2313,21 @@ namespace toy {
               
               f.Close();
               
-              flock.Unlock();
+              if (sharded && !abort_save_) {
+                FitResultShards::Publish(shardname);
+              }
+              // update manifest of result set while still holding the lock
+              if (manifest_entry.file.size() > 0 && !abort_save_) {
+                manifest_entry.file_size = ResultSetManifest::FileSize(sharded ? shardname : filename);
+                ResultSetManifest manifest(filename);
+                if (!manifest.Append(manifest_entry)) {
+                  swarn << "Cannot update result manifest " << ResultSetManifest::ManifestFileName(filename) << endmsg;
+                }
+              }
+              if (flock) flock->Unlock();
             }
           } else {
-            flock.Unlock();
+            if (flock) flock->Unlock();
             swarn << "Aborting save as signal to end execution was caught before." << endmsg;
           }
           sw_lock.Stop();
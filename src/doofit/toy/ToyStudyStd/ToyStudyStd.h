@@ -5,6 +5,8 @@
 #include <tuple>
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
 
 // BOOST
 #include <boost/thread.hpp>
@@ -17,6 +19,10 @@
 
 // from project
 #include "doofit/toy/ToyStudyStd/ToyStudyStdConfig.h"
+#include "doofit/toy/ToyStudyStd/OnlineAccumulators.h"
+#include "doofit/toy/ToyStudyStd/ColumnStatistics.h"
+#include "doofit/toy/ToyStudyStd/ResultSetManifest.h"
+#include "doofit/toy/ToyStudyStd/FormulaProgram.h"
 #include "doocore/lutils/lutils.h"
 #include "doocore/io/MsgStream.h"
 #include "doofit/plotting/Plot/PlotConfig.h"
@@ -25,7 +31,11 @@
 class RooFitResult;
 class RooDataSet;
 class RooRealVar;
+class RooArgList;
+class RooAbsReal;
+class RooFormulaVar;
 class TStopwatch;
+class TPaveText;
 
 namespace doofit {
   namespace config {
@@ -36,9 +46,10 @@ namespace doofit {
   }
 }
 namespace toy {
+  class EasyFitResultPrefetcher;
   
   // fit_result1, fit_result2, time_cpu1, time_real1, time_cpu2, time_real2, seed, run_id
-  typedef std::tuple<const RooFitResult*,const RooFitResult*,double,double,double,double,int,int> FitResultContainer;
+  typedef std::tuple<const RooFitResult*,const RooFitResult*,double,double,double,double,long long,int> FitResultContainer;
 
   // fit_result1, fit_result2
   typedef std::tuple<const doofit::fitter::easyfit::EasyFitResult*,const doofit::fitter::easyfit::EasyFitResult*> EasyFitResultContainer;
@@ -149,6 +160,10 @@ namespace toy {
      *  
      *  Branch name(s) are specified via ToyStudyStdConfig.
      *
+     *  If ToyStudyStdConfig::store_result_columnar() is set, fit results are
+     *  not stored as RooFitResult objects, but as flat columns per parameter
+     *  (see FitResultColumns). Branch names are then used as column prefixes.
+     *
      *  @warning Passing pointers to this function, it is assumed that this 
      *        ToyStudyStd instance does take over ownership of the fit 
      *        result(s) (in contrast to previous versions). FitResults passed
@@ -178,7 +193,7 @@ namespace toy {
                         const RooFitResult* fit_result2 = NULL,
                         TStopwatch* stopwatch1 = NULL,
                         TStopwatch* stopwatch2 = NULL,
-                        int seed = 0,
+                        long long seed = 0,
                         int run_id = 0);
     
     /**
@@ -193,8 +208,40 @@ namespace toy {
         fit_results_save_queue_.disable_queue();
         fitresult_save_worker_mutex_.unlock();
         fitresult_save_worker_.join();
+        num_fit_results_pending_cond_.notify_all();
       }
     }
+
+    /**
+     *  @brief Number of fit results accepted by StoreFitResult() but not yet saved
+     *
+     *  Can be used to limit the backlog of the deferred saver (see ToyCampaign).
+     */
+    unsigned int num_fit_results_pending() const { return num_fit_results_pending_; }
+
+    /**
+     *  @brief Block until at most max_pending fit results are waiting to be saved
+     *
+     *  The save worker signals each saved fit result, so no polling is 
+     *  needed. Returns immediately if fit results are no longer accepted.
+     *
+     *  @param max_pending maximum number of pending fit results to wait for
+     */
+    void WaitForPendingFitResults(unsigned int max_pending);
+
+    /**
+     *  @brief Merge fit result shards into the result file
+     *
+     *  If fit results were stored with ToyStudyStdConfig::store_result_sharded()
+     *  set, all shard files of the result file set via 
+     *  ToyStudyStdConfig::set_store_result_filename_treename() are merged into
+     *  the result file and removed afterwards. Fit results are not 
+     *  deserialized during merging.
+     *
+     *  @see FitResultShards::Merge()
+     *  @return number of fit results in merged result file (or -1 on error)
+     */
+    long long MergeFitResultShards();
     ///@}
 
     /** @name Evaluation functions
@@ -211,6 +258,17 @@ namespace toy {
      *
      *  This function will just invoke the reader worker thread which will load
      *  fit results in the background.
+     *
+     *  If ToyStudyStdConfig::num_threads_read() is larger than 1, a pool of 
+     *  reader threads will read multiple files in parallel and this function 
+     *  returns immediately. Fit results are then handed over via 
+     *  GetFitResult() as soon as they are available. The number of read but 
+     *  not yet handed over fit results is limited by 
+     *  ToyStudyStdConfig::read_queue_max_size(). 
+     *
+     *  @warning As RooFit is not thread-safe, do not create or delete RooFit
+     *           objects in parallel to the reader pool other than via 
+     *           GetFitResult(), ReleaseFitResult() and PurgeReleasedFitResults().
      */
     void ReadFitResults();
     /**
@@ -232,13 +290,15 @@ namespace toy {
     /**
      *  @brief Get next EasyFitResult (pair) in queue
      *
-     *  On demand open files and trees containing EasyFitResults and return next
-     *  EasyFitResultContainer in queue. 
+     *  On first call, an EasyFitResultPrefetcher is started which opens all 
+     *  files and trees containing EasyFitResults and decodes them in the 
+     *  background (see ToyStudyStdConfig::set_easyfit_prefetch_size()). 
+     *  Returns the next EasyFitResultContainer in queue.
      *
-     *  Returned EasyFitResult references will be overwritten on next call. If 
-     *  necessary, the caller has to copy the EasyFitResults themself.
+     *  Returned EasyFitResult references will be invalid after the next call.
+     *  If necessary, the caller has to copy the EasyFitResults themself.
      *
-     *  @return tuple of fit results
+     *  @return tuple of fit results (tuple of nullptr if no more results)
      */
     EasyFitResultContainer GetEasyFitResult();
 
@@ -260,6 +320,9 @@ namespace toy {
 
     /**
      *  @brief Purge previously released fit results
+     *
+     *  Fit results read from columnar files are kept for reuse by the 
+     *  readers, all others are deleted.
      */
     void PurgeReleasedFitResults();
 
@@ -268,6 +331,13 @@ namespace toy {
      *
      *  Stored fit results are evaluated and pulls and other relevant values are
      *  being determined.
+     *
+     *  If ToyStudyStdConfig::evaluate_streaming() is set, fit results are not
+     *  kept in memory. Evaluated values are fed into online accumulators (see 
+     *  OnlineParameterAccumulator) and each fit result is deleted directly 
+     *  after evaluation. evaluated_values() is not available in this mode.
+     *  Fit results with parameters at limit or MINOS problems are neglected 
+     *  completely if requested via ToyStudyStdConfig.
      */
     void EvaluateFitResults();
     /**
@@ -275,6 +345,13 @@ namespace toy {
      *
      *  After evaluation pulls and other relevant parameters are being plotted 
      *  to the plot directory specified in ToyStudyStdConfig::plot_directory_
+     *
+     *  After streaming evaluation, distributions are plotted from the 
+     *  accumulated histograms and Gaussian fits are binned fits.
+     *
+     *  Fits and statistics for all parameters can be determined in parallel 
+     *  (see ToyStudyStdConfig::set_num_cpu_evaluation()). Plots are always 
+     *  created in the same order afterwards.
      */
     void PlotEvaluatedParameters();
     ///@}
@@ -337,6 +414,57 @@ namespace toy {
      *  @param formula the formula to apply args to
      */
     void EvaluateFormula(const RooAbsCollection& args, const RooFormulaVar& formula) const;
+
+    /**
+     *  @brief Formula compiled into a FormulaProgram with bound inputs
+     */
+    struct CompiledFormula {
+      /**
+       *  @brief Name of fit parameter per program variable
+       */
+      std::vector<std::string> sources;
+
+      /**
+       *  @brief Take error instead of value of the fit parameter
+       */
+      std::vector<bool> use_errors;
+
+      /**
+       *  @brief Formula dependents (their values are used if no fit parameter is found)
+       */
+      std::vector<const RooAbsReal*> dependents;
+
+      /**
+       *  @brief Compiled formula (fallback to EvaluateFormula() if not compiled)
+       */
+      FormulaProgram program;
+    };
+
+    /**
+     *  @brief Get compiled version of a RooFormulaVar
+     *
+     *  The formula expression is parsed only once and cached. If the expression
+     *  cannot be compiled, a warning is printed and the returned program is not
+     *  compiled.
+     *
+     *  @param formula the formula to compile
+     *  @return the compiled formula
+     */
+    const CompiledFormula& CompileFormula(const RooFormulaVar& formula);
+
+    /**
+     *  @brief Evaluate a formula based on a list of variables
+     *
+     *  Same semantics as EvaluateFormula(), but the compiled program is used
+     *  if available. Positions of the inputs in args are cached in bindings
+     *  and only looked up again if the list layout changes.
+     *
+     *  @param args argument list to take inputs from
+     *  @param formula the formula to evaluate
+     *  @param bindings cached positions of inputs in args
+     *  @return value of the formula
+     */
+    double EvaluateCompiledFormula(const RooArgList& args, const RooFormulaVar& formula, std::vector<int>& bindings);
     
     /**
      *  @brief Copy an existing RooRealVar into a new RooRealVar
@@ -365,6 +493,117 @@ namespace toy {
      *  outside the expected range (-5..+5). 
      */
     void PrintUnexpectedPullOverview() const;
+
+    /**
+     *  @brief Evaluate fit results with bounded memory
+     *
+     *  @see EvaluateFitResults()
+     */
+    void EvaluateFitResultsStreaming();
+
+    /**
+     *  @brief Plot parameters evaluated via EvaluateFitResultsStreaming()
+     */
+    void PlotEvaluatedParametersStreaming();
+
+    /**
+     *  @brief Create text box with results of Gaussian fit to a distribution
+     *
+     *  @param param_name name of the plotted variable
+     *  @param mean fitted mean
+     *  @param mean_error error of fitted mean
+     *  @param sigma fitted width
+     *  @param sigma_error error of fitted width
+     *  @return new TPaveText (ownership is transferred to caller)
+     */
+    TPaveText* CreateGaussianFitText(const std::string& param_name, double mean, double mean_error, double sigma, double sigma_error) const;
+
+    /**
+     *  @brief Print quantile based estimates for symmetric 68.27% CLs
+     *
+     *  @param parameter_cls map of parameter name to mean, median, lower and upper quantile
+     */
+    void PrintQuantileEstimates(const std::map<std::string, std::tuple<double, double, double, double>>& parameter_cls) const;
+
+    /**
+     *  @brief Fit and statistics results for one evaluated parameter
+     *
+     *  Plain data only, as it is transferred between worker processes.
+     */
+    struct ParameterDistribution {
+      int    index;
+      bool   valid;
+      double limit_low;
+      double limit_high;
+      int    num_entries_fit;
+      bool   has_cls;
+      double cl_mean;
+      double cl_median;
+      double cl_low;
+      double cl_high;
+      bool   has_fit;
+      int    fit_status;
+      bool   fit_truncated;
+      double fit_mean;
+      double fit_mean_error;
+      double fit_sigma;
+      double fit_sigma_error;
+    };
+
+    /**
+     *  @brief Create dataset for fitting and plotting of one parameter
+     *
+     *  Cuts on the plotting window and on problematic fits are applied as 
+     *  configured in ToyStudyStdConfig.
+     *
+     *  @param parameter the parameter to fit/plot
+     *  @param minmax plotting window
+     *  @param parameters_copy set of variables for the new dataset (will be extended as needed)
+     *  @return new RooDataSet (caller takes ownership) or evaluated_values_ if no cut is applied
+     */
+    RooDataSet* CreateFitPlotDataset(const RooRealVar& parameter, const std::pair<double,double>& minmax, RooArgSet& parameters_copy) const;
+
+    /**
+     *  @brief Determine plotting window, CL quantiles and Gaussian fit for one parameter
+     *
+     *  The Gaussian is estimated via TruncatedGaussianEstimator (optionally
+     *  cross-checked with a RooFit fit, see 
+     *  ToyStudyStdConfig::set_crosscheck_pull_fits_roofit()). Window, CL 
+     *  quantiles and values for the estimate are taken from the extracted 
+     *  columns in @a statistics.
+     *
+     *  @param parameter the parameter to evaluate
+     *  @param statistics extracted columns of evaluated_values_ (see PrepareColumnStatistics())
+     *  @param distribution the results
+     */
+    void EvaluateParameterDistribution(RooRealVar& parameter, ColumnStatistics& statistics, ParameterDistribution& distribution);
+
+    /**
+     *  @brief Evaluate distributions of all parameters
+     *
+     *  If ToyStudyStdConfig::num_cpu_evaluation() is larger than 1, parameters
+     *  are distributed over forked worker processes (RooFit is not thread-safe,
+     *  see doofit::tools::workers::RunInWorkers()). Parameters without results from 
+     *  workers are evaluated serially.
+     *
+     *  @param parameters the parameters to evaluate
+     *  @param statistics extracted columns of evaluated_values_ (see PrepareColumnStatistics())
+     *  @param distributions the results (same order as parameters)
+     */
+    void EvaluateParameterDistributions(const std::vector<RooRealVar*>& parameters, ColumnStatistics& statistics, std::vector<ParameterDistribution>& distributions);
+
+    /**
+     *  @brief Extract columns of evaluated_values_ for evaluation and plotting
+     *
+     *  All parameters are extracted in one pass over evaluated_values_. The 
+     *  row selection is set according to the cuts on problematic fits as 
+     *  configured in ToyStudyStdConfig (cf. CreateFitPlotDataset()).
+     *
+     *  @param parameters the parameters to extract
+     *  @param statistics the column statistics to fill
+     */
+    void PrepareColumnStatistics(const std::vector<RooRealVar*>& parameters, ColumnStatistics& statistics) const;
+
     
     /**
      *  @brief Handle Unix signals
@@ -388,9 +627,99 @@ namespace toy {
     /**
      *  @brief Worker function for reading of fit results
      *
-     *  This function will take care of reading fit results from a file. 
+     *  This function will take care of reading fit results from all files 
+     *  sequentially. 
      */
     void ReadFitResultWorker();
+
+    /**
+     *  @brief Worker function for parallel reading of fit results
+     *
+     *  Thread function for the reader pool. Each worker picks the next not yet
+     *  processed file until all files are read or ToyStudyStdConfig::num_toys_read()
+     *  is reached. The last finishing worker closes the read queue.
+     */
+    void ReadFitResultPoolWorker();
+
+    /**
+     *  @brief Read all fit results from one file into the read queue
+     *
+     *  @param file_tree file name and tree name to read from
+     *  @return false if reading should stop (i.e. enough fit results read)
+     */
+    bool ReadFitResultsFromFile(const doofit::config::CommaSeparatedPair<std::string>& file_tree);
+
+    /**
+     *  @brief Keep a columnar fit result for reuse or delete it otherwise
+     *
+     *  fitresult_roofit_mutex_ must be held.
+     *
+     *  @param fit_result fit result to dispose of (ownership is transferred)
+     */
+    void DisposeFitResult(const RooFitResult* fit_result);
+
+    /**
+     *  @brief Take a fit result for reuse (see DisposeFitResult())
+     *
+     *  fitresult_roofit_mutex_ must be held.
+     *
+     *  @return fit result (ownership is transferred) or nullptr if none is available
+     */
+    RooFitResult* PopRecycledFitResult();
+
+    /**
+     *  @brief Load manifests of all result sets to read and plan reading
+     *
+     *  Loads the ResultSetManifest of each file to read from. In parallel 
+     *  reading mode, files are ordered by decreasing number of entries (files 
+     *  not in any manifest first) to balance the reader pool.
+     *
+     *  @param parallel plan for parallel reading
+     */
+    void PlanReadFitResults(bool parallel);
+
+    /**
+     *  @brief Find the manifest record of a file to read
+     *
+     *  @param file_tree file name and tree name
+     *  @param entry the record (if found)
+     *  @return true if a valid record is found
+     */
+    bool FindResultManifestEntry(const doofit::config::CommaSeparatedPair<std::string>& file_tree, ResultManifestEntry& entry);
+
+    /**
+     *  @brief Add a manifest record for a probed file
+     *
+     *  The manifest is reloaded first and nothing is appended if it already
+     *  has a valid record for the file (e.g. added by another reader).
+     *
+     *  @param file_tree file name and tree name
+     *  @param tree the opened tree
+     */
+    void AddResultManifestEntry(const doofit::config::CommaSeparatedPair<std::string>& file_tree, TTree& tree);
+
+    /**
+     *  @brief Hand over a read fit result to the read queue
+     *
+     *  In parallel reading mode this function blocks while the read queue 
+     *  holds ToyStudyStdConfig::read_queue_max_size() or more fit results. 
+     *  If the fit result is not needed anymore (i.e. enough fit results read),
+     *  it will be deleted.
+     *
+     *  @param fit_results fit results to hand over
+     *  @return true if the fit result was accepted, false if not
+     */
+    bool AcceptReadFitResult(const FitResultContainer& fit_results);
+
+    /**
+     *  @brief Check if the requested number of fit results is read
+     */
+    bool ToyLimitReached();
+
+    /**
+     *  @brief Close read queue and print summary after reading
+     */
+    void FinishReadFitResults();
     
    private:
     
@@ -405,6 +734,17 @@ namespace toy {
       // disabling this line enables full asynchrous deferred writing of fit results. 
       fitresult_save_worker_mutex_.lock();
     }
+
+    /**
+     *  @brief Count a fit result as saved and wake up WaitForPendingFitResults()
+     */
+    void FitResultSaved() {
+      {
+        boost::mutex::scoped_lock lock(num_fit_results_pending_mutex_);
+        --num_fit_results_pending_;
+      }
+      num_fit_results_pending_cond_.notify_all();
+    }
     
     /**
      *  \brief CommonConfig instance to use
@@ -429,7 +769,7 @@ namespace toy {
     /**
      *  @brief Container for read in and active fit results with key as seed
      */
-    std::multimap<int, FitResultContainer> fit_results_by_seed_;
+    std::multimap<long long, FitResultContainer> fit_results_by_seed_;
 
     /**
      *  \brief Container for all ever read in fit results
@@ -439,6 +779,10 @@ namespace toy {
      *  \brief RooDataSet for all evaluated parameters, their pulls and so on
      */
     RooDataSet* evaluated_values_;
+    /**
+     *  \brief Online accumulators for all evaluated parameters (streaming evaluation)
+     */
+    std::map<std::string, OnlineParameterAccumulator> evaluated_accumulators_;
     /**
      *  \brief Counter for unexpectedly large pulls
      *
@@ -480,6 +824,18 @@ namespace toy {
      *  @brief Thread-safe queue for fit results to save
      */
     doocore::lutils::concurrent_queue<FitResultContainer > fit_results_save_queue_;
+    /**
+     *  @brief Number of fit results accepted for saving but not yet saved
+     */
+    std::atomic<unsigned int> num_fit_results_pending_;
+    /**
+     *  @brief Mutex for num_fit_results_pending_cond_
+     */
+    boost::mutex num_fit_results_pending_mutex_;
+    /**
+     *  @brief Condition signalled by the save worker for each saved fit result
+     */
+    boost::condition_variable num_fit_results_pending_cond_;
     ///@}
     
     /** @name Reader worker members
@@ -494,10 +850,11 @@ namespace toy {
      *  @brief State variable determining if this class is still reading fit results
      *
      *  This variable will be set to true upon construction and false upon 
-     *  destruction to allow the reader thread to finish properly.
+     *  destruction to allow the reader thread to finish properly. It is 
+     *  read by all reader threads without lock and therefore atomic.
      * 
      */
-    bool reading_fit_results_;
+    std::atomic<bool> reading_fit_results_;
     /**
      *  @brief Thread-safe queue for fit results to read in
      */
@@ -506,6 +863,63 @@ namespace toy {
      *  @brief Thread-safe queue for fit results to delete
      */
     doocore::lutils::concurrent_queue<FitResultContainer > fit_results_release_queue_;
+    /**
+     *  @brief Threads for parallel reading of fit results
+     */
+    boost::thread_group fitresult_reader_pool_;
+    /**
+     *  @brief Mutex for reader bookkeeping (next file, counters, EasyFitResult files)
+     */
+    boost::mutex fitresult_reader_mutex_;
+    /**
+     *  @brief Mutex serialising RooFit object creation and deletion
+     *
+     *  RooFit itself is not thread-safe. Streaming RooFitResult objects and 
+     *  deleting them is therefore serialised while file access and columnar
+     *  decoding run in parallel.
+     */
+    boost::mutex fitresult_roofit_mutex_;
+    /**
+     *  @brief Released columnar fit results for reuse by the readers
+     *
+     *  Guarded by fitresult_roofit_mutex_.
+     */
+    std::vector<RooFitResult*> recycled_fit_results_;
+    /**
+     *  @brief Condition to wake up readers waiting for space in the read queue
+     */
+    boost::condition_variable fitresult_reader_space_;
+    /**
+     *  @brief Index of next file to be processed by the reader pool
+     */
+    std::size_t fitresult_reader_next_file_;
+    /**
+     *  @brief Order of files to be processed by the reader pool
+     */
+    std::vector<std::size_t> fitresult_reader_order_;
+    /**
+     *  @brief Loaded manifests of result sets to read (by manifest file name)
+     */
+    std::map<std::string, ResultSetManifest> result_manifests_;
+    /**
+     *  @brief Number of still active reader threads
+     */
+    unsigned int fitresult_reader_active_;
+    /**
+     *  @brief Whether fit results are read in background threads
+     *
+     *  Only then the read queue is bounded by 
+     *  ToyStudyStdConfig::read_queue_max_size().
+     */
+    bool fitresult_reader_background_;
+    /**
+     *  @brief Number of fit results handed over to the read queue
+     */
+    int results_stored_;
+    /**
+     *  @brief Number of neglected fit results
+     */
+    int results_neglected_;
     ///@}
 
     /** @name EasyFitResult input support
@@ -518,29 +932,29 @@ namespace toy {
     std::list<doofit::config::CommaSeparatedPair<std::string>> results_files_easyfit_;
 
     /**
-     *  @brief Currently opened TFile + TTree for EasyFitResult input
-     */
-    std::pair<TFile*,TTree*> file_tree_easyfit_;
-
-    /**
-     *  @brief Position in currently opened TTree for EasyFitResult input
+     *  @brief Background reader for EasyFitResult input
      */
-    long long position_tree_easyfit_;
+    std::unique_ptr<EasyFitResultPrefetcher> easyfit_prefetcher_;
 
     /**
      *  @brief Number of available EasyFitResults
      */
     unsigned long long num_easyfit_results_;
+    ///@}
 
+    /** @name Additional variables
+     *  Compiled formulas for additional variables
+     */
+    ///@{
     /**
-     *  @brief Current EasyFitResult #1
+     *  @brief Compiled formulas by formula
      */
-    doofit::fitter::easyfit::EasyFitResult* easyfit_result_0_;
+    std::map<const RooFormulaVar*, CompiledFormula> compiled_formulas_;
 
     /**
-     *  @brief Current EasyFitResult #2
+     *  @brief Cached input positions per formula for final, initial and reference parameters
      */
-    doofit::fitter::easyfit::EasyFitResult* easyfit_result_1_;
+    std::map<const RooFormulaVar*, std::vector<int>> formula_bindings_[3];
     ///@}
 
     bool debug_;
@@ -28,6 +28,9 @@ namespace toy {
   config::AbsConfig("empty_name"),
   fit_result1_branch_name_("fit_results"),
   fit_result2_branch_name_("fit_results2"),
+  store_result_columnar_(false),
+  store_result_sharded_(false),
+  result_manifest_(true),
   handle_asymmetric_errors_(true),
   fit_plot_on_quantile_window_(true),
   plot_symmetric_around_mean_(false),
@@ -38,19 +41,34 @@ namespace toy {
   plot_parameter_vs_error_correlation_(false),
   evaluate_reference_toys_(false),
   reference_toys_id_(0),
-  num_toys_read_(-1)
+  num_toys_read_(-1),
+  num_threads_read_(1),
+  read_queue_max_size_(1000),
+  easyfit_prefetch_size_(64),
+  evaluate_streaming_(false),
+  num_cpu_evaluation_(1),
+  crosscheck_pull_fits_roofit_(false)
   {
     swarn << "Usage of ToyStudyStdConfig::ToyStudyStdConfig() is not recommended!" <<endmsg;
   }
   
   ToyStudyStdConfig::ToyStudyStdConfig(const std::string& name) :
   config::AbsConfig(name),
+  store_result_columnar_(false),
+  store_result_sharded_(false),
+  result_manifest_(true),
   handle_asymmetric_errors_(true),
   min_acceptable_cov_matrix_quality_(3),
   plot_parameter_vs_error_correlation_(false),
   evaluate_reference_toys_(false),
   reference_toys_id_(0),
-  num_toys_read_(-1)
+  num_toys_read_(-1),
+  num_threads_read_(1),
+  read_queue_max_size_(1000),
+  easyfit_prefetch_size_(64),
+  evaluate_streaming_(false),
+  num_cpu_evaluation_(1),
+  crosscheck_pull_fits_roofit_(false)
   {
   }
   
@@ -62,6 +80,9 @@ namespace toy {
       scfg << "File and tree to save result to:   " << store_result_filename_treename_ << endmsg;
       scfg << "Branch name fit result 1:          " << fit_result1_branch_name_ << endmsg;
       scfg << "Branch name fit result 2:          " << fit_result2_branch_name_ << endmsg;
+      scfg << "Store fit results as columns:      " << store_result_columnar_ << endmsg;
+      scfg << "Store fit results in shards:       " << store_result_sharded_ << endmsg;
+      scfg << "Maintain result set manifest:      " << result_manifest_ << endmsg;
     }
     if (store_converted_result_filename_treename_.first().size() > 0) {
       scfg << "File and tree to save converted result to: " << store_result_filename_treename_ << endmsg;
@@ -84,6 +105,9 @@ namespace toy {
     for (int i = 0; i<minos_parameters_.size(); i++) {
       scfg << "MINOS check for parameters:      " << minos_parameters_[i] << endmsg;
     }
+    for (int i = 0; i<read_parameters_.size(); i++) {
+      scfg << "Read columnar parameter:           " << read_parameters_[i] << endmsg;
+    }
     if (parameter_genvalue_read_file().size()>0) {
       scfg << "Read generation values from:       " << parameter_genvalue_read_file() << endmsg;
     }
@@ -102,6 +126,14 @@ namespace toy {
     } else {
       scfg << "Number of toys to read in:         " << "all" << endmsg;
     }
+    scfg << "Number of reader threads:          " << num_threads_read() << endmsg;
+    scfg << "Streaming evaluation:              " << evaluate_streaming() << endmsg;
+    scfg << "Worker processes for evaluation:   " << num_cpu_evaluation() << endmsg;
+    scfg << "Cross-check pull fits with RooFit: " << crosscheck_pull_fits_roofit() << endmsg;
+    if (num_threads_read() > 1) {
+      scfg << "Maximum fit results in read queue: " << read_queue_max_size() << endmsg;
+    }
+    scfg << "EasyFitResults decoded ahead:      " << easyfit_prefetch_size() << endmsg;
   }
   
   void ToyStudyStdConfig::DefineOptions() {
@@ -112,6 +144,9 @@ namespace toy {
     (GetOptionString("store_converted_result_filename_treename").c_str(), po::value<config::CommaSeparatedPair<std::string>>(&store_converted_result_filename_treename_),"File name and tree name to save converted fit results to (set as filename,treename)")
     (GetOptionString("fit_result1_branch_name").c_str(), po::value<std::string>(&fit_result1_branch_name_)->default_value("fit_results"),"Fit result 1 branch name in tree")
     (GetOptionString("fit_result2_branch_name").c_str(), po::value<std::string>(&fit_result2_branch_name_)->default_value("fit_results2"),"Fit result 2 branch name in tree")
+    (GetOptionString("store_result_columnar").c_str(), po::value<bool>(&store_result_columnar_)->default_value(false),"Store fit results as flat columns per parameter instead of RooFitResult objects (default: false; much faster to read in)")
+    (GetOptionString("store_result_sharded").c_str(), po::value<bool>(&store_result_sharded_)->default_value(false),"Store fit results into own shard files per job instead of locking a shared result file (default: false; merge shards afterwards)")
+    (GetOptionString("result_manifest").c_str(), po::value<bool>(&result_manifest_)->default_value(true),"Maintain and use sidecar manifests of result sets to avoid opening every result file for metadata (default: true)")
     (GetOptionString("read_results_filename_treename").c_str(), po::value<vector<config::CommaSeparatedPair<std::string>> >(&read_results_filename_treename_)->composing(), "File names and tree names to read fit results from (set as filename,treename)")
     (GetOptionString("read_results_filename_treename_pattern").c_str(), po::value<config::CommaSeparatedPair<std::string>>(&read_results_filename_treename_pattern_),"File name pattern and tree name to read fit result from (set as regexfilenamepattern,treename)")
     (GetOptionString("plot_directory").c_str(), po::value<std::string>(&plot_directory_), "Plot directory for evaluation of fit results")
@@ -128,7 +163,14 @@ namespace toy {
     (GetOptionString("evaluate_reference_toys").c_str(), po::value<bool>(&evaluate_reference_toys_)->default_value(false),"Perform reference toy analysis of each two toys with identical random seeds (default: false)")
     (GetOptionString("reference_toys_id").c_str(), po::value<int>(&reference_toys_id_)->default_value(0),"Reference toy analysis run id to regard as study to evaluate.")
     (GetOptionString("num_toys_read").c_str(), po::value<int>(&num_toys_read_)->default_value(-1),"Number of toys to read in (default: -1 meaning all)")
-    (GetOptionString("minos_parameters").c_str(), po::value<config::CommaSeparatedList<std::string>>(&minos_parameters_)->composing(),"List of parameters that MINOS was run on (considered when checking for MINOS problems)");
+    (GetOptionString("num_threads_read").c_str(), po::value<int>(&num_threads_read_)->default_value(1),"Number of threads to read fit result files in parallel (default: 1)")
+    (GetOptionString("read_queue_max_size").c_str(), po::value<int>(&read_queue_max_size_)->default_value(1000),"Maximum number of read fit results kept in memory while reading in parallel or streaming (default: 1000; 0 means unlimited)")
+    (GetOptionString("easyfit_prefetch_size").c_str(), po::value<int>(&easyfit_prefetch_size_)->default_value(64),"Number of EasyFitResult pairs decoded ahead in the background (default: 64)")
+    (GetOptionString("evaluate_streaming").c_str(), po::value<bool>(&evaluate_streaming_)->default_value(false),"Evaluate fit results with bounded memory via online accumulators instead of storing all evaluated values (default: false)")
+    (GetOptionString("num_cpu_evaluation").c_str(), po::value<int>(&num_cpu_evaluation_)->default_value(1),"Number of worker processes to fit parameter distributions in parallel (default: 1)")
+    (GetOptionString("crosscheck_pull_fits_roofit").c_str(), po::value<bool>(&crosscheck_pull_fits_roofit_)->default_value(false),"Cross-check analytic Gaussian estimates of pull distributions with unbinned RooFit fits (default: false)")
+    (GetOptionString("minos_parameters").c_str(), po::value<config::CommaSeparatedList<std::string>>(&minos_parameters_)->composing(),"List of parameters that MINOS was run on (considered when checking for MINOS problems)")
+    (GetOptionString("read_parameters").c_str(), po::value<config::CommaSeparatedList<std::string>>(&read_parameters_)->composing(),"List of parameters to read from columnar fit results (default: all)");
     
     descs_visible_.push_back(generation);
   }
@@ -82,6 +82,27 @@ namespace toy {
      *  @return current value of fit_result2_branch_name_
      */
     const std::string& fit_result2_branch_name() const {return fit_result2_branch_name_;}
+    /**
+     *  @brief Getter for storing fit results as flat columns instead of RooFitResult objects
+     *
+     *  @see ToyStudyStdConfig::set_store_result_columnar(bool)
+     *  @return current value of store_result_columnar_
+     */
+    bool store_result_columnar() const {return store_result_columnar_;}
+    /**
+     *  @brief Getter for storing fit results into lock-free shard files
+     *
+     *  @see ToyStudyStdConfig::set_store_result_sharded(bool)
+     *  @return current value of store_result_sharded_
+     */
+    bool store_result_sharded() const {return store_result_sharded_;}
+    /**
+     *  @brief Getter for maintaining and using result set manifests
+     *
+     *  @see ToyStudyStdConfig::set_result_manifest(bool)
+     *  @return current value of result_manifest_
+     */
+    bool result_manifest() const {return result_manifest_;}
     /**
      *  @brief Getter for file names and tree names to read fit result from
      *
@@ -193,6 +214,48 @@ namespace toy {
      */
     int num_toys_read() const { return num_toys_read_; }
 
+    /**
+     *  @brief Getter for number of threads to read fit results with
+     *
+     *  @return current value of num_threads_read_
+     */
+    int num_threads_read() const { return num_threads_read_; }
+
+    /**
+     *  @brief Getter for maximum number of read fit results kept in memory
+     *
+     *  @return current value of read_queue_max_size_
+     */
+    int read_queue_max_size() const { return read_queue_max_size_; }
+
+    /**
+     *  @brief Getter for number of EasyFitResult pairs decoded ahead
+     *
+     *  @return current value of easyfit_prefetch_size_
+     */
+    int easyfit_prefetch_size() const { return easyfit_prefetch_size_; }
+
+    /**
+     *  @brief Getter for streaming evaluation of fit results
+     *
+     *  @return current value of evaluate_streaming_
+     */
+    bool evaluate_streaming() const { return evaluate_streaming_; }
+
+    /**
+     *  @brief Getter for number of worker processes for fitting parameter distributions
+     *
+     *  @return current value of num_cpu_evaluation_
+     */
+    int num_cpu_evaluation() const { return num_cpu_evaluation_; }
+
+    /**
+     *  @brief Getter for cross-checking Gaussian pull estimates with RooFit fits
+     *
+     *  @return current value of crosscheck_pull_fits_roofit_
+     */
+    bool crosscheck_pull_fits_roofit() const { return crosscheck_pull_fits_roofit_; }
+
     /**
      *  @brief Getter for additional variables
      *
@@ -243,6 +306,51 @@ namespace toy {
      *  @param fit_result2_branch_name new value for fit_result2_branch_name_
      */
     void set_fit_result2_branch_name(const std::string& fit_result2_branch_name) {fit_result2_branch_name_ = fit_result2_branch_name;}
+    /**
+     *  @brief Setter for storing fit results as flat columns instead of RooFitResult objects
+     *
+     *  If set, ToyStudyStd::StoreFitResult() will not stream whole 
+     *  RooFitResult objects into the result tree, but write one flat column 
+     *  per parameter and quantity (value, error, asymmetric errors, init 
+     *  value) plus status, covariance quality, minimal NLL, fit times, seed and
+     *  run id. Column names are prefixed by the fit result branch names (e.g.
+     *  "fit_results_par_x_value"). Parameter metadata is stored only once per 
+     *  file. ToyStudyStd::ReadFitResults() detects columnar trees 
+     *  automatically and reads only the needed columns which is considerably
+     *  faster than deserializing RooFitResults.
+     *
+     *  @see FitResultColumns
+     *  @param store_result_columnar new value for store_result_columnar_
+     */
+    void set_store_result_columnar(bool store_result_columnar) {store_result_columnar_ = store_result_columnar;}
+    /**
+     *  @brief Setter for storing fit results into lock-free shard files
+     *
+     *  If set, ToyStudyStd::StoreFitResult() will not lock and update the 
+     *  result file, but write each batch of fit results into an own shard file 
+     *  next to the result file. Shards are written under a temporary name and
+     *  renamed atomically when complete. Use ToyStudyStd::MergeFitResultShards()
+     *  or the MergeFitResultShards executable to merge shards into the result 
+     *  file afterwards.
+     *
+     *  @see FitResultShards
+     *  @param store_result_sharded new value for store_result_sharded_
+     */
+    void set_store_result_sharded(bool store_result_sharded) {store_result_sharded_ = store_result_sharded;}
+    /**
+     *  @brief Setter for maintaining and using result set manifests
+     *
+     *  If set, a sidecar manifest "<result file>.manifest" is updated whenever
+     *  fit results are saved (or shards are merged), listing file, tree, 
+     *  number of entries, format and schema hash of all files of the result 
+     *  set. On reading, files are classified and counted via the manifest 
+     *  without opening them. Files without valid manifest record are probed 
+     *  as before and a record is added if possible.
+     *
+     *  @see ResultSetManifest
+     *  @param result_manifest new value for result_manifest_
+     */
+    void set_result_manifest(bool result_manifest) {result_manifest_ = result_manifest;}
     /**
      *  @brief Setter for file name pattern and tree name to read fit result from
      *
@@ -319,6 +427,9 @@ namespace toy {
     /**
      *  @brief Setter for neglecting all toy fits where at least one parameter is at/near limit
      *
+     *  For columnar fit results, only the parameters read (see 
+     *  read_parameters()) are checked.
+     *
      *  @param neglect_parameters_at_limit new value for neglect_parameters_at_limit_
      */
     void set_neglect_parameters_at_limit(bool& neglect_parameters_at_limit) {neglect_parameters_at_limit_ = neglect_parameters_at_limit;}
@@ -401,6 +512,79 @@ namespace toy {
      */
     void set_num_toys_read(int num_toys_read) {num_toys_read_ = num_toys_read;}
 
+    /**
+     *  @brief Setter for number of threads to read fit results with
+     *
+     *  If larger than 1, multiple result files are read in parallel by a pool
+     *  of reader threads.
+     *
+     *  @param num_threads_read new value for num_threads_read_
+     */
+    void set_num_threads_read(int num_threads_read) {num_threads_read_ = num_threads_read;}
+
+    /**
+     *  @brief Setter for maximum number of read fit results kept in memory
+     *
+     *  In parallel reading mode and with streaming evaluation (see 
+     *  set_evaluate_streaming()), readers will wait if this number of fit 
+     *  results is read but not yet handed over via ToyStudyStd::GetFitResult().
+     *
+     *  @param read_queue_max_size new value for read_queue_max_size_ (set to 0 for unlimited)
+     */
+    void set_read_queue_max_size(int read_queue_max_size) {read_queue_max_size_ = read_queue_max_size;}
+
+    /**
+     *  @brief Setter for number of EasyFitResult pairs decoded ahead
+     *
+     *  ToyStudyStd::GetEasyFitResult() decodes EasyFitResults in a background 
+     *  thread (see EasyFitResultPrefetcher). At most this number of decoded 
+     *  pairs is kept in memory.
+     *
+     *  @param easyfit_prefetch_size new value for easyfit_prefetch_size_
+     */
+    void set_easyfit_prefetch_size(int easyfit_prefetch_size) {easyfit_prefetch_size_ = easyfit_prefetch_size;}
+
+    /**
+     *  @brief Setter for streaming evaluation of fit results
+     *
+     *  If set, ToyStudyStd::EvaluateFitResults() does not keep fit results and
+     *  evaluated values in memory, but feeds them into online accumulators 
+     *  (running moments, quantile estimates and fixed-bin histograms) and 
+     *  deletes each fit result right away. Fit results are read in the 
+     *  background (also with a single reader thread) and at most 
+     *  read_queue_max_size() of them are kept in memory, so memory usage does
+     *  not grow with the number of toys unless the queue is set to be 
+     *  unlimited. ToyStudyStd::evaluated_values() will not be 
+     *  available and reference toy analysis is not possible.
+     *
+     *  @param evaluate_streaming new value for evaluate_streaming_
+     */
+    void set_evaluate_streaming(bool evaluate_streaming) {evaluate_streaming_ = evaluate_streaming;}
+
+    /**
+     *  @brief Setter for number of worker processes for fitting parameter distributions
+     *
+     *  If larger than 1, ToyStudyStd::PlotEvaluatedParameters() fits and 
+     *  evaluates the distributions of all parameters in this number of forked
+     *  worker processes before plotting.
+     *
+     *  @param num_cpu_evaluation new value for num_cpu_evaluation_
+     */
+    void set_num_cpu_evaluation(int num_cpu_evaluation) {num_cpu_evaluation_ = num_cpu_evaluation;}
+
+    /**
+     *  @brief Setter for cross-checking Gaussian pull estimates with RooFit fits
+     *
+     *  Mean and width of pull, residual, error and init distributions are 
+     *  determined via the analytic maximum likelihood estimate of a Gaussian 
+     *  truncated to the plotting window (see TruncatedGaussianEstimator). If 
+     *  set, an equivalent unbinned RooFit fit is performed additionally and 
+     *  deviations are reported. This is considerably slower.
+     *
+     *  @param crosscheck_pull_fits_roofit new value for crosscheck_pull_fits_roofit_
+     */
+    void set_crosscheck_pull_fits_roofit(bool crosscheck_pull_fits_roofit) {crosscheck_pull_fits_roofit_ = crosscheck_pull_fits_roofit;}
+
     /**
      *  @brief Add an additional formula/variable for evaluation in toys.
      *
@@ -431,6 +615,24 @@ namespace toy {
      *  @return current value of minos_parameters_
      */
     const config::CommaSeparatedList<std::string>& minos_parameters() const {return minos_parameters_;}
+    
+    /**
+     *  @brief Getter for parameters to read from columnar fit results
+     *
+     *  @return current value of read_parameters_
+     */
+    const config::CommaSeparatedList<std::string>& read_parameters() const {return read_parameters_;}
+    
+    /**
+     *  @brief Setter for parameters to read from columnar fit results
+     *
+     *  Only these parameters are read from columnar fit results and appear 
+     *  in the fit results and the evaluation. If empty, all parameters are 
+     *  read.
+     *
+     *  @param read_parameters comma-separated list of parameter names
+     */
+    void set_read_parameters(const std::string& read_parameters) {read_parameters_.Parse(read_parameters);}
     ///@}
     
    protected:
@@ -502,6 +704,24 @@ namespace toy {
      *  @see ToyStudyStdConfig::set_fit_result2_branch_name()
      */
     std::string fit_result2_branch_name_;
+    /**
+     *  @brief Store fit results as flat columns instead of RooFitResult objects
+     *
+     *  @see ToyStudyStdConfig::set_store_result_columnar()
+     */
+    bool store_result_columnar_;
+    /**
+     *  @brief Store fit results into lock-free shard files
+     *
+     *  @see ToyStudyStdConfig::set_store_result_sharded()
+     */
+    bool store_result_sharded_;
+    /**
+     *  @brief Maintain and use result set manifests
+     *
+     *  @see ToyStudyStdConfig::set_result_manifest()
+     */
+    bool result_manifest_;
     /**
      *  @brief File names and tree names to read fit result from
      */
@@ -576,11 +796,46 @@ namespace toy {
      *  @brief Number of toys to read in
      */
     int num_toys_read_;
+
+    /**
+     *  @brief Number of threads to read fit results with
+     */
+    int num_threads_read_;
+
+    /**
+     *  @brief Maximum number of read fit results kept in memory
+     */
+    int read_queue_max_size_;
+
+    /**
+     *  @brief Number of EasyFitResult pairs decoded ahead
+     */
+    int easyfit_prefetch_size_;
+
+    /**
+     *  @brief Streaming evaluation of fit results
+     */
+    bool evaluate_streaming_;
+
+    /**
+     *  @brief Number of worker processes for fitting parameter distributions
+     */
+    int num_cpu_evaluation_;
+
+    /**
+     *  @brief Cross-check Gaussian pull estimates with RooFit fits
+     */
+    bool crosscheck_pull_fits_roofit_;
     
     /**
      *  @brief List of parameters that MINOS was run on
      */
     config::CommaSeparatedList<std::string> minos_parameters_;
+    
+    /**
+     *  @brief List of parameters to read from columnar fit results
+     */
+    config::CommaSeparatedList<std::string> read_parameters_;
 
     /**
      *  @brief Additional variables to evaluate in toys
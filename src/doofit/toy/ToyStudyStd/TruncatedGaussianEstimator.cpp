@@ -0,0 +1,166 @@
+#include "doofit/toy/ToyStudyStd/TruncatedGaussianEstimator.h"
+
+// STL
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  namespace {
+    const double kSqrt2   = std::sqrt(2.0);
+    const double kSqrt2Pi = 2.5066282746310002;
+
+    // standard normal density (vanishing for infinite arguments)
+    double NormalDensity(double z) {
+      if (std::isinf(z)) return 0.0;
+      return std::exp(-0.5*z*z)/kSqrt2Pi;
+    }
+
+    // z times standard normal density (vanishing for infinite arguments)
+    double NormalDensityTimesZ(double z) {
+      if (std::isinf(z)) return 0.0;
+      return z*NormalDensity(z);
+    }
+
+    // probability content of standard normal in [alpha, beta] (tail-stable)
+    double NormalContent(double alpha, double beta) {
+      if (alpha > 0.0) {
+        return 0.5*(std::erfc(alpha/kSqrt2) - std::erfc(beta/kSqrt2));
+      } else {
+        return 0.5*(std::erfc(-beta/kSqrt2) - std::erfc(-alpha/kSqrt2));
+      }
+    }
+  }
+
+  TruncatedGaussianEstimator::TruncatedGaussianEstimator(double low, double high) :
+  low_(low),
+  high_(high),
+  num_(0),
+  sum_(0.0),
+  sum2_(0.0)
+  {}
+
+  double TruncatedGaussianEstimator::LogLikelihood(double mean, double sigma) const {
+    double n = static_cast<double>(num_);
+    double q = sum2_ - 2.0*mean*sum_ + n*mean*mean;
+    double content = NormalContent((low_-mean)/sigma, (high_-mean)/sigma);
+    if (content <= 0.0) return -std::numeric_limits<double>::max();
+    return -n*std::log(sigma) - q/(2.0*sigma*sigma) - n*std::log(content);
+  }
+
+  void TruncatedGaussianEstimator::Gradient(double mean, double sigma, double& d_mean, double& d_sigma) const {
+    double n = static_cast<double>(num_);
+    double q = sum2_ - 2.0*mean*sum_ + n*mean*mean;
+    double alpha = (low_-mean)/sigma;
+    double beta  = (high_-mean)/sigma;
+    double content = NormalContent(alpha, beta);
+
+    d_mean  = (sum_ - n*mean)/(sigma*sigma) 
+              - n*(NormalDensity(alpha) - NormalDensity(beta))/(sigma*content);
+    d_sigma = -n/sigma + q/(sigma*sigma*sigma) 
+              - n*(NormalDensityTimesZ(alpha) - NormalDensityTimesZ(beta))/(sigma*content);
+  }
+
+  void TruncatedGaussianEstimator::Hessian(double mean, double sigma, double& h_mm, double& h_ms, double& h_ss) const {
+    double h = 1e-4*sigma;
+    double gm_p, gs_p, gm_m, gs_m;
+
+    Gradient(mean+h, sigma, gm_p, gs_p);
+    Gradient(mean-h, sigma, gm_m, gs_m);
+    h_mm = (gm_p - gm_m)/(2.0*h);
+    double h_sm = (gs_p - gs_m)/(2.0*h);
+
+    Gradient(mean, sigma+h, gm_p, gs_p);
+    Gradient(mean, sigma-h, gm_m, gs_m);
+    h_ss = (gs_p - gs_m)/(2.0*h);
+    h_ms = 0.5*(h_sm + (gm_p - gm_m)/(2.0*h));
+  }
+
+  GaussianEstimate TruncatedGaussianEstimator::Estimate() const {
+    GaussianEstimate estimate;
+    estimate.valid          = false;
+    estimate.mean           = 0.0;
+    estimate.mean_error     = 0.0;
+    estimate.sigma          = 0.0;
+    estimate.sigma_error    = 0.0;
+    estimate.num_iterations = 0;
+
+    if (num_ < 2) return estimate;
+
+    double n = static_cast<double>(num_);
+    double mean  = sum_/n;
+    double sigma = std::sqrt(std::max(sum2_/n - mean*mean, 0.0));
+    if (!(sigma > 0.0)) return estimate;
+
+    bool truncated = !std::isinf(low_) || !std::isinf(high_);
+
+    // Newton iteration (not needed for non-truncated case as start values 
+    // are the analytic ML solution)
+    const int max_iterations = 100;
+    int iteration = 0;
+    bool converged = !truncated;
+    double ll = LogLikelihood(mean, sigma);
+    while (!converged && iteration < max_iterations) {
+      ++iteration;
+
+      double g_m, g_s, h_mm, h_ms, h_ss;
+      Gradient(mean, sigma, g_m, g_s);
+      Hessian(mean, sigma, h_mm, h_ms, h_ss);
+      double det = h_mm*h_ss - h_ms*h_ms;
+
+      double step_m, step_s;
+      if (h_mm < 0.0 && det > 0.0) {
+        step_m = -( h_ss*g_m - h_ms*g_s)/det;
+        step_s = -(-h_ms*g_m + h_mm*g_s)/det;
+      } else {
+        // Hessian not negative definite: gradient ascent scaled by the 
+        // inverse Fisher information of an untruncated Gaussian
+        step_m = g_m*sigma*sigma/n;
+        step_s = g_s*sigma*sigma/(2.0*n);
+      }
+
+      // step halving to ensure positive width and increasing likelihood
+      double lambda = 1.0;
+      double mean_new  = mean + step_m;
+      double sigma_new = sigma + step_s;
+      double ll_new    = sigma_new > 0.0 ? LogLikelihood(mean_new, sigma_new) : -std::numeric_limits<double>::max();
+      int num_halvings = 0;
+      while ((sigma_new <= 0.0 || ll_new < ll) && num_halvings < 40) {
+        lambda   *= 0.5;
+        mean_new  = mean + lambda*step_m;
+        sigma_new = sigma + lambda*step_s;
+        ll_new    = sigma_new > 0.0 ? LogLikelihood(mean_new, sigma_new) : -std::numeric_limits<double>::max();
+        ++num_halvings;
+      }
+      if (sigma_new <= 0.0) break;
+
+      converged = std::abs(mean_new - mean) < 1e-10*sigma && std::abs(sigma_new - sigma) < 1e-10*sigma;
+      mean  = mean_new;
+      sigma = sigma_new;
+      ll    = ll_new;
+    }
+    estimate.num_iterations = iteration;
+
+    double h_mm, h_ms, h_ss;
+    Hessian(mean, sigma, h_mm, h_ms, h_ss);
+    double det = h_mm*h_ss - h_ms*h_ms;
+
+    estimate.mean  = mean;
+    estimate.sigma = sigma;
+    if (converged && h_mm < 0.0 && det > 0.0) {
+      estimate.mean_error  = std::sqrt(-h_ss/det);
+      estimate.sigma_error = std::sqrt(-h_mm/det);
+      estimate.valid = true;
+    }
+
+    return estimate;
+  }
+} // namespace toy
+} // namespace doofit
@@ -0,0 +1,107 @@
+#ifndef TRUNCATEDGAUSSIANESTIMATOR_h
+#define TRUNCATEDGAUSSIANESTIMATOR_h
+
+// STL
+#include <vector>
+
+// ROOT
+
+// from RooFit
+
+// from project
+
+namespace doofit {
+namespace toy {
+  /** @struct GaussianEstimate
+   *  @brief Result of TruncatedGaussianEstimator::Estimate()
+   */
+  struct GaussianEstimate {
+    bool   valid;
+    double mean;
+    double mean_error;
+    double sigma;
+    double sigma_error;
+    int    num_iterations;
+  };
+
+  /** @class TruncatedGaussianEstimator
+   *  @brief Unbinned maximum likelihood estimate of a (truncated) Gaussian
+   *
+   *  Estimates mean and width of a Gaussian distribution from values that
+   *  are only observed inside a window [low, high] (e.g. the quantile window
+   *  used for pull plots). The log-likelihood of a truncated Gaussian only
+   *  depends on the number of values, their sum and their sum of squares, so
+   *  the values are only accumulated once and the maximum is found by a
+   *  Newton iteration on two parameters, started from the sample moments.
+   *  Uncertainties are taken from the inverse of the Hessian at the maximum,
+   *  i.e. they match the HESSE errors of an equivalent unbinned RooFit fit.
+   *
+   *  Without truncation (infinite window) the estimate is the analytic
+   *  solution (sample mean and ML width).
+   */
+  class TruncatedGaussianEstimator {
+   public:
+    /**
+     *  @brief Constructor for TruncatedGaussianEstimator
+     *
+     *  @param low lower edge of observation window (-inf for none)
+     *  @param high upper edge of observation window (+inf for none)
+     */
+    TruncatedGaussianEstimator(double low, double high);
+
+    /**
+     *  @brief Add a value (values outside the window are ignored)
+     */
+    void Add(double x) {
+      if (x > low_ && x < high_) {
+        ++num_;
+        sum_  += x;
+        sum2_ += x*x;
+      }
+    }
+
+    /**
+     *  @brief Add a set of values
+     */
+    void Add(const std::vector<double>& values) {
+      for (auto x : values) Add(x);
+    }
+
+    /**
+     *  @brief Number of accepted values
+     */
+    unsigned long long num_values() const { return num_; }
+
+    /**
+     *  @brief Determine maximum likelihood estimate
+     *
+     *  @return estimated mean and width including uncertainties
+     */
+    GaussianEstimate Estimate() const;
+
+   private:
+    /**
+     *  @brief Log-likelihood for given mean and width
+     */
+    double LogLikelihood(double mean, double sigma) const;
+
+    /**
+     *  @brief Gradient of log-likelihood
+     */
+    void Gradient(double mean, double sigma, double& d_mean, double& d_sigma) const;
+
+    /**
+     *  @brief Hessian of log-likelihood (via differences of analytic gradient)
+     */
+    void Hessian(double mean, double sigma, double& h_mm, double& h_ms, double& h_ss) const;
+
+    double low_;
+    double high_;
+    unsigned long long num_;
+    double sum_;
+    double sum2_;
+  };
+} // namespace toy
+} // namespace doofit
+
+#endif // TRUNCATEDGAUSSIANESTIMATOR_h